@@ -134,3 +134,7 @@ endif
 ifneq ($(BOARD_MINIMUM_DISPLAY_BRIGHTNESS),)
     LOCAL_CFLAGS += -DMINIMUM_DISPLAY_BRIGHTNESS=$(BOARD_MINIMUM_DISPLAY_BRIGHTNESS)
 endif
+
+ifneq ($(BOARD_HWC_PPC_MODEL_PATH),)
+    LOCAL_CFLAGS += -DHWC_PPC_MODEL_PATH=\"$(BOARD_HWC_PPC_MODEL_PATH)\"
+endif
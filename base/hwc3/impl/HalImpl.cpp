@@ -222,7 +222,7 @@ int32_t HalImpl::destroyLayer(int64_t display, int64_t layer) {
     ExynosLayer *halLayer;
     RET_IF_ERR(getHalLayer(display, layer, halLayer));
 
-    return halDisplay->destroyLayer(reinterpret_cast<hwc2_layer_t>(halLayer));
+    return halDisplay->destroyLayer(halLayer->mHandle);
 }
 
 int32_t HalImpl::createVirtualDisplay(uint32_t width, uint32_t height, AidlPixelFormat format,
@@ -968,9 +968,13 @@ int32_t HalImpl::validateDisplay(int64_t display, std::vector<int64_t>* outChang
 }
 
 int HalImpl::setExpectedPresentTime(
-        int64_t __unused display, const std::optional<ClockMonotonicTimestamp> __unused expectedPresentTime) {
+        int64_t display, const std::optional<ClockMonotonicTimestamp> expectedPresentTime) {
+    ExynosDisplay* halDisplay;
+    RET_IF_ERR(getHalDisplay(display, halDisplay));
 
-    return HWC2_ERROR_UNSUPPORTED;
+    // Without a time the frame is presented as soon as possible
+    return halDisplay->setExpectedPresentTime(
+            expectedPresentTime.has_value() ? expectedPresentTime->timestampNanos : 0);
 }
 
 } // namespace aidl::android::hardware::graphics::composer3::impl
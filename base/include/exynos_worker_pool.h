@@ -0,0 +1,171 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __EXYNOS_WORKER_POOL_H__
+#define __EXYNOS_WORKER_POOL_H__
+
+#include <deque>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/*
+ * ExynosWorkerPool - Persistent worker threads of the S/W image processing
+ *
+ * The S/W scaler of libscaler and the S/W compositor of libacryl split a job
+ * into bands or tiles that are independent of each other. A caller queues them
+ * as tasks and then runs the queued tasks together with the workers until all
+ * of its tasks are completed. No more than the number of threads requested by
+ * the caller run its tasks at the same time even though the pool has more
+ * workers. The workers are created on demand and live until the process exits.
+ */
+class ExynosWorkerPool {
+public:
+    // maximum number of threads to run tasks including the calling thread
+    enum { MAX_WORKERS = 8 };
+
+    static ExynosWorkerPool &getInstance() {
+        static ExynosWorkerPool pool;
+        return pool;
+    }
+
+    // runs @tasks with at most @workers threads including the calling thread
+    void run(std::vector<std::function<void()>> &tasks, unsigned int workers) {
+        Group group;
+
+        if (workers > MAX_WORKERS)
+            workers = MAX_WORKERS;
+        group.remaining = static_cast<unsigned int>(tasks.size());
+        group.active = 0;
+        group.limit = (workers > 0) ? workers : 1;
+
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            while ((mThreads.size() + 1) < workers)
+                mThreads.emplace_back(&ExynosWorkerPool::threadLoop, this);
+
+            for (auto &func : tasks)
+                mQueue.push_back({func, &group});
+        }
+        mCond.notify_all();
+
+        for (;;) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mLock);
+                auto it = mQueue.end();
+                // the caller runs the tasks of its own group only
+                group.done.wait(lock, [this, &group, &it] {
+                    if (group.remaining == 0)
+                        return true;
+                    it = findRunnable(&group);
+                    return it != mQueue.end();
+                });
+                if (group.remaining == 0)
+                    return;
+                task = *it;
+                mQueue.erase(it);
+                group.active++;
+            }
+
+            task.func();
+            finishTask(task);
+        }
+    }
+private:
+    struct Group {
+        unsigned int remaining;
+        unsigned int active; // number of tasks being run
+        unsigned int limit;  // maximum number of tasks run concurrently
+        std::condition_variable done;
+    };
+    struct Task {
+        std::function<void()> func;
+        Group *group;
+    };
+
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::deque<Task> mQueue;
+    std::vector<std::thread> mThreads;
+    bool mStop;
+
+    ExynosWorkerPool() : mStop(false) { }
+    ~ExynosWorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mStop = true;
+        }
+        mCond.notify_all();
+        for (auto &thread : mThreads)
+            thread.join();
+    }
+
+    // returns the first queued task that its group allows to start, or the
+    // first task of @group only if @group is not null
+    std::deque<Task>::iterator findRunnable(Group *group = nullptr) {
+        for (auto it = mQueue.begin(); it != mQueue.end(); ++it) {
+            if (group && (it->group != group))
+                continue;
+            if (it->group->active < it->group->limit)
+                return it;
+            if (group)
+                break;
+        }
+        return mQueue.end();
+    }
+
+    void finishTask(Task &task) {
+        bool queued;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            task.group->active--;
+            task.group->remaining--;
+            // the caller waits for the completion or for a free slot
+            task.group->done.notify_all();
+            queued = !mQueue.empty();
+        }
+        if (queued)
+            mCond.notify_one();
+    }
+
+    void threadLoop() {
+        for (;;) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mLock);
+                auto it = mQueue.end();
+                mCond.wait(lock, [this, &it] {
+                    it = findRunnable();
+                    return mStop || it != mQueue.end();
+                });
+                if (it == mQueue.end())
+                    return;
+                task = *it;
+                mQueue.erase(it);
+                task.group->active++;
+            }
+
+            task.func();
+            finishTask(task);
+        }
+    }
+};
+
+#endif //__EXYNOS_WORKER_POOL_H__
@@ -35,6 +35,10 @@ else
     LOCAL_CFLAGS += -DLIBACRYL_DEFAULT_BLTER=\"no_default_blter\"
 endif
 
+ifdef BOARD_LIBACRYL_BANDWIDTH_MODEL_DIR
+    LOCAL_CFLAGS += -DLIBACRYL_BANDWIDTH_MODEL_DIR=\"$(BOARD_LIBACRYL_BANDWIDTH_MODEL_DIR)\"
+endif
+
 LOCAL_SHARED_LIBRARIES := liblog libutils libcutils libion_exynos
 ifdef BOARD_LIBACRYL_G2D9810_HDR_PLUGIN
     LOCAL_SHARED_LIBRARIES += $(BOARD_LIBACRYL_G2D9810_HDR_PLUGIN)
@@ -46,13 +50,15 @@ LOCAL_HEADER_LIBRARIES += libexynos_headers
 
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/local_include
 LOCAL_C_INCLUDES += $(LOCAL_PATH)/include
+LOCAL_C_INCLUDES += $(TOP)/hardware/samsung_slsi/graphics/base/include
 
 LOCAL_EXPORT_C_INCLUDE_DIRS := $(LOCAL_PATH)/include
 
-LOCAL_SRC_FILES := acrylic.cpp acrylic_dummy.cpp
+LOCAL_SRC_FILES := acrylic.cpp acrylic_dummy.cpp acrylic_sw.cpp
 LOCAL_SRC_FILES += acrylic_g2d.cpp acrylic_mscl9810.cpp acrylic_g2d9810.cpp acrylic_mscl3830.cpp acrylic_mscl3830_pre.cpp
 LOCAL_SRC_FILES += acrylic_factory.cpp acrylic_layer.cpp acrylic_formats.cpp
-LOCAL_SRC_FILES += acrylic_performance.cpp acrylic_device.cpp
+LOCAL_SRC_FILES += acrylic_performance.cpp acrylic_device.cpp acrylic_transit_pool.cpp
+LOCAL_SRC_FILES += acrylic_bandwidth.cpp
 
 LOCAL_MODULE_TAGS := optional
 LOCAL_MODULE := libacryl
@@ -61,3 +67,5 @@ LOCAL_PROPRIETARY_MODULE := true
 endif
 
 include $(BUILD_SHARED_LIBRARY)
+
+include $(LOCAL_PATH)/test/Android.mk
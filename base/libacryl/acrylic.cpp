@@ -26,6 +26,7 @@
 Acrylic::Acrylic(const HW2DCapability &capability)
     : mCapability(capability), mHasBackgroundColor(false),
       mMaxTargetLuminance(100), mMinTargetLuminance(0), mTargetDisplayInfo(nullptr),
+      mValidateTimeUSec(0), mSortTimeUSec(0), mPrepareTimeUSec(0), mValidated(false),
       mCanvas(this, AcrylicCanvas::CANVAS_TARGET)
 {
     ALOGD_TEST("Created a new Acrylic on %p", this);
@@ -58,6 +59,7 @@ AcrylicLayer *Acrylic::createLayer()
     }
 
     mLayers.push_back(layer);
+    mValidated = false;
 
     ALOGD_TEST("A new Acrylic layer is created. Total %zd layers", mLayers.size());
 
@@ -73,6 +75,7 @@ void Acrylic::removeLayer(AcrylicLayer *layer)
     } else {
         removeTransitData(*it);
         mLayers.erase(it);
+        mValidated = false;
     }
 }
 
@@ -96,10 +99,38 @@ bool Acrylic::setHDRToneMapCoefficients(uint32_t __unused *matrix[2], int __unus
     return true;
 }
 
+bool Acrylic::executeAsync(int *release_fence)
+{
+    *release_fence = -1;
+
+    return execute();
+}
+
 bool Acrylic::validateAllLayers()
 {
+    AcrylicStageTimer timer(&mValidateTimeUSec);
     const HW2DCapability &cap = getCapabilities();
 
+    // The result of the last validation is still valid if nothing but the
+    // buffers and the fences are changed since the last execution.
+    // isSettingOkay() is still checked because a failure in configuration
+    // clears the setting without marking it modified.
+    if (mValidated && mCanvas.isSettingOkay() && !mCanvas.isConfigModified()) {
+        bool modified = false;
+
+        for (auto layer: mLayers) {
+            if (!layer->isSettingOkay() || layer->isConfigModified()) {
+                modified = true;
+                break;
+            }
+        }
+
+        if (!modified)
+            return true;
+    }
+
+    mValidated = false;
+
     if (!mCanvas.isSettingOkay()) {
         ALOGE("Incomplete settting (flags: %#x) on the target layer",
               mCanvas.getSettingFlags());
@@ -178,10 +209,14 @@ bool Acrylic::validateAllLayers()
         return false;
     }
 
+    mValidated = true;
+
     return true;
 }
 
 void Acrylic::sortLayers()
 {
+    AcrylicStageTimer timer(&mSortTimeUSec);
+
     std::sort(std::begin(mLayers), std::end(mLayers), [] (auto l1, auto l2) { return l1->getZOrder() < l2->getZOrder(); });
 }
@@ -0,0 +1,265 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+
+#include <log/log.h>
+
+#include <hardware/hwcomposer.h>
+
+#include "acrylic_internal.h"
+#include "acrylic_bandwidth.h"
+
+AcrylicBandwidthModel::AcrylicBandwidthModel(const char *name)
+    : mName(name), mLoaded(false)
+{
+    reset();
+}
+
+void AcrylicBandwidthModel::reset()
+{
+    mFormatWeight.clear();
+    mScaling = WEIGHT_UNIT / 8;
+    mRotating = 0;
+    mCompressed = 0;
+    mOverlap = 0;
+    mWrite = WEIGHT_UNIT;
+    mWriteYUV420Rotate = WEIGHT_UNIT;
+}
+
+bool AcrylicBandwidthModel::setWeight(const char *feature, int32_t weight)
+{
+    static const struct {
+        const char *name;
+        int32_t AcrylicBandwidthModel::*weight;
+    } features[] = {
+        {"scaling",             &AcrylicBandwidthModel::mScaling},
+        {"rotating",            &AcrylicBandwidthModel::mRotating},
+        {"compressed",          &AcrylicBandwidthModel::mCompressed},
+        {"overlap",             &AcrylicBandwidthModel::mOverlap},
+        {"write",               &AcrylicBandwidthModel::mWrite},
+        {"write_yuv420_rotate", &AcrylicBandwidthModel::mWriteYUV420Rotate},
+    };
+
+    for (size_t i = 0; i < ARRSIZE(features); i++) {
+        if (strcmp(features[i].name, feature) == 0) {
+            this->*features[i].weight = weight;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int32_t AcrylicBandwidthModel::getFormatWeight(uint32_t format) const
+{
+    auto it = mFormatWeight.find(format);
+
+    return (it == mFormatWeight.end()) ? static_cast<int32_t>(WEIGHT_UNIT) : it->second;
+}
+
+bool AcrylicBandwidthModel::load(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return false;
+
+    char line[128];
+    int lineno = 0;
+    bool success = true;
+
+    while (fgets(line, sizeof(line), fp)) {
+        char feature[32];
+        unsigned int format;
+        int weight;
+
+        lineno++;
+
+        char *comment = strchr(line, '#');
+        if (comment)
+            *comment = '\0';
+
+        if (sscanf(line, " %31s", feature) != 1)
+            continue;
+
+        if (strcmp(feature, "format") == 0) {
+            if (sscanf(line, " format %i %i", &format, &weight) == 2) {
+                setFormatWeight(format, weight);
+                continue;
+            }
+        } else if ((sscanf(line, " %*s %i", &weight) == 1) && setWeight(feature, weight)) {
+            continue;
+        }
+
+        ALOGE("Malformed line %d of bandwidth model '%s'", lineno, path);
+        success = false;
+    }
+
+    fclose(fp);
+
+    ALOGD_TEST("Loaded bandwidth model '%s' for %s", path, mName.c_str());
+
+    return success;
+}
+
+void AcrylicBandwidthModel::loadOnce()
+{
+    if (mLoaded)
+        return;
+
+    std::string path = LIBACRYL_BANDWIDTH_MODEL_DIR "/" + mName + ".conf";
+
+    // The default weights are used if no model file is installed
+    load(path.c_str());
+
+    mLoaded = true;
+}
+
+void AcrylicBandwidthModel::describeLayer(const AcrylicPerformanceRequestLayer &layer,
+                                          unsigned int bpp, Layer &desc)
+{
+    uint32_t src_hori = layer.mSourceRect.size.hori;
+    uint32_t src_vert = layer.mSourceRect.size.vert;
+    uint32_t dst_hori = layer.mTargetRect.size.hori;
+    uint32_t dst_vert = layer.mTargetRect.size.vert;
+
+    desc.format = layer.mPixFormat;
+    desc.bpp = bpp;
+    desc.pixelcount = std::max(src_hori * src_vert, dst_hori * dst_vert);
+    desc.window = layer.mTargetRect;
+    desc.flags = 0;
+
+    if (!!(layer.mTransform & HAL_TRANSFORM_ROT_90)) {
+        desc.flags |= LAYER_ROTATING;
+        std::swap(dst_hori, dst_vert);
+    }
+
+    if ((src_hori != dst_hori) || (src_vert != dst_vert))
+        desc.flags |= LAYER_SCALING;
+
+    if (layer.mAttribute & AcrylicCanvas::ATTR_COMPRESSED)
+        desc.flags |= LAYER_COMPRESSED;
+
+    // 8-bit and 10-bit (8+2) YUV420 formats
+    if ((bpp == 12) || (bpp == 15))
+        desc.flags |= LAYER_YUV420;
+}
+
+uint64_t AcrylicBandwidthModel::getOverlappedPixels(const Layer layers[], int count)
+{
+    if (count < 2)
+        return 0;
+
+    std::vector<int32_t> xs, ys;
+    uint64_t total = 0;
+
+    for (int i = 0; i < count; i++) {
+        const hw2d_rect_t &rect = layers[i].window;
+
+        xs.push_back(rect.pos.hori);
+        xs.push_back(rect.pos.hori + rect.size.hori);
+        ys.push_back(rect.pos.vert);
+        ys.push_back(rect.pos.vert + rect.size.vert);
+        total += static_cast<uint64_t>(rect.size.hori) * rect.size.vert;
+    }
+
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+    // The area of the union of the windows on the grid of their edges.
+    // The layers are a few enough to visit all the cells.
+    uint64_t covered = 0;
+    for (size_t y = 0; y + 1 < ys.size(); y++) {
+        for (size_t x = 0; x + 1 < xs.size(); x++) {
+            for (int i = 0; i < count; i++) {
+                const hw2d_rect_t &rect = layers[i].window;
+
+                if ((xs[x] >= rect.pos.hori) && (xs[x + 1] <= rect.pos.hori + rect.size.hori) &&
+                        (ys[y] >= rect.pos.vert) && (ys[y + 1] <= rect.pos.vert + rect.size.vert)) {
+                    covered += static_cast<uint64_t>(xs[x + 1] - xs[x]) * (ys[y + 1] - ys[y]);
+                    break;
+                }
+            }
+        }
+    }
+
+    return total - covered;
+}
+
+void AcrylicBandwidthModel::getFeatures(const Layer layers[], int count, hw2d_coord_t target_size,
+                                        unsigned int target_bpp, Features &features)
+{
+    bool src_yuv420 = false;
+    bool src_rotate = false;
+
+    features.format.clear();
+    features.scaling = 0;
+    features.rotating = 0;
+    features.compressed = 0;
+    features.write_yuv420_rotate = 0;
+
+    for (int i = 0; i < count; i++) {
+        uint64_t bits = static_cast<uint64_t>(layers[i].pixelcount) * layers[i].bpp;
+
+        features.format[layers[i].format] += bits;
+        if (layers[i].flags & LAYER_SCALING)
+            features.scaling += bits;
+        if (layers[i].flags & LAYER_ROTATING) {
+            features.rotating += bits;
+            src_rotate = true;
+        }
+        if (layers[i].flags & LAYER_COMPRESSED)
+            features.compressed += bits;
+        if (layers[i].flags & LAYER_YUV420)
+            src_yuv420 = true;
+    }
+
+    features.overlap = getOverlappedPixels(layers, count) * target_bpp;
+    features.write = static_cast<uint64_t>(target_size.hori) * target_size.vert * target_bpp;
+    if ((target_bpp == 12) && src_yuv420 && src_rotate)
+        features.write_yuv420_rotate = features.write;
+}
+
+uint64_t AcrylicBandwidthModel::getReadCost(const Features &features) const
+{
+    int64_t cost = 0;
+
+    for (auto &format: features.format)
+        cost += static_cast<int64_t>(format.second) * getFormatWeight(format.first);
+
+    cost += static_cast<int64_t>(features.scaling) * mScaling;
+    cost += static_cast<int64_t>(features.rotating) * mRotating;
+    cost += static_cast<int64_t>(features.compressed) * mCompressed;
+    cost += static_cast<int64_t>(features.overlap) * mOverlap;
+
+    return (cost < 0) ? 0 : static_cast<uint64_t>(cost);
+}
+
+uint64_t AcrylicBandwidthModel::getWriteCost(const Features &features) const
+{
+    int64_t cost;
+
+    cost = static_cast<int64_t>(features.write) * mWrite;
+    cost += static_cast<int64_t>(features.write_yuv420_rotate) * mWriteYUV420Rotate;
+
+    return (cost < 0) ? 0 : static_cast<uint64_t>(cost);
+}
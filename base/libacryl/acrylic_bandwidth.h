@@ -0,0 +1,135 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HARDWARE_EXYNOS_ACRYLIC_BANDWIDTH_H__
+#define __HARDWARE_EXYNOS_ACRYLIC_BANDWIDTH_H__
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include <hardware/exynos/acryl.h>
+
+#ifndef LIBACRYL_BANDWIDTH_MODEL_DIR
+#define LIBACRYL_BANDWIDTH_MODEL_DIR "/vendor/etc/libacryl"
+#endif
+
+/*
+ * AcrylicBandwidthModel - Table driven estimation of the memory bandwidth of a frame
+ *
+ * The bandwidth of a frame is the sum of the features of the frame multiplied
+ * by their weights. A feature is the number of bits that a class of the layers
+ * reads or writes:
+ * - format   : bits read from the layers of a pixel format. The weight of a
+ *              format is the read amplification of the format including the
+ *              compression ratio of SBWC and the overhead of the tiled formats.
+ * - scaling  : bits read from the scaled layers
+ * - rotating : bits read from the rotated layers
+ * - compressed: bits read from the AFBC compressed layers. The weight is
+ *              usually negative to reflect the compression ratio.
+ * - overlap  : bits of the target image covered by more than one layer
+ * - write    : bits written to the target image
+ * - write_yuv420_rotate: bits written to the YUV420 target image when a
+ *              YUV420 source layer is rotated
+ * The weights are in the unit of WEIGHT_UNIT. The default weights of the
+ * formats are WEIGHT_UNIT and the default weight of scaling is 1.125 times
+ * WEIGHT_UNIT that is the estimation of libacryl before the model is
+ * introduced. The weights of a compositor are overridden by the model file,
+ * LIBACRYL_BANDWIDTH_MODEL_DIR/<name>.conf if it exists. Each line of the
+ * model file is either of "<feature> <weight>" or "format <halfmt> <weight>".
+ * The model files are generated by libacryl_bwfit from the laptimes of the
+ * compositor.
+ */
+class AcrylicBandwidthModel {
+public:
+    enum {
+        WEIGHT_UNIT = 1000,
+    };
+
+    enum {
+        LAYER_SCALING    = 1 << 0,
+        LAYER_ROTATING   = 1 << 1,
+        LAYER_COMPRESSED = 1 << 2,
+        LAYER_YUV420     = 1 << 3,
+    };
+
+    struct Layer {
+        uint32_t format;
+        unsigned int bpp;
+        // The larger one of the number of pixels of the source and the target
+        uint32_t pixelcount;
+        uint32_t flags;
+        hw2d_rect_t window;
+    };
+
+    struct Features {
+        std::map<uint32_t, uint64_t> format;
+        uint64_t scaling;
+        uint64_t rotating;
+        uint64_t compressed;
+        uint64_t overlap;
+        uint64_t write;
+        uint64_t write_yuv420_rotate;
+    };
+
+    AcrylicBandwidthModel(const char *name);
+
+    // Restore the default weights
+    void reset();
+    /*
+     * Load the weights from @path. The weights not in @path are not changed.
+     * Return false if @path is not found or it has a malformed line.
+     */
+    bool load(const char *path);
+    // Load the model file of this model only once
+    void loadOnce();
+    bool setWeight(const char *feature, int32_t weight);
+    void setFormatWeight(uint32_t format, int32_t weight) { mFormatWeight[format] = weight; }
+    int32_t getFormatWeight(uint32_t format) const;
+    const char *getName() const { return mName.c_str(); }
+
+    static void describeLayer(const AcrylicPerformanceRequestLayer &layer, unsigned int bpp, Layer &desc);
+    static void getFeatures(const Layer layers[], int count, hw2d_coord_t target_size,
+                            unsigned int target_bpp, Features &features);
+    // The number of pixels of the target image covered by more than one layer
+    static uint64_t getOverlappedPixels(const Layer layers[], int count);
+
+    /*
+     * The weighted bits per frame. The bandwidths in kilobytes per second are
+     * the weighted bits * frame rate / (8 * 1024 * WEIGHT_UNIT).
+     */
+    uint64_t getReadCost(const Features &features) const;
+    uint64_t getWriteCost(const Features &features) const;
+
+    static uint32_t toKBytesPerSec(uint64_t cost, int frame_rate)
+    {
+        return static_cast<uint32_t>(cost * frame_rate / (8 * 1024 * WEIGHT_UNIT));
+    }
+private:
+    std::string mName;
+    bool mLoaded;
+
+    std::map<uint32_t, int32_t> mFormatWeight;
+    int32_t mScaling;
+    int32_t mRotating;
+    int32_t mCompressed;
+    int32_t mOverlap;
+    int32_t mWrite;
+    int32_t mWriteYUV420Rotate;
+};
+
+#endif //__HARDWARE_EXYNOS_ACRYLIC_BANDWIDTH_H__
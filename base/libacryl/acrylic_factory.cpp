@@ -22,11 +22,14 @@
 #include <exynos_format.h> // hardware/smasung_slsi/exynos/include
 
 #include "acrylic_internal.h"
+#ifndef LIBACRYL_SW_ONLY
 #include "acrylic_g2d.h"
 #include "acrylic_g2d9810.h"
 #include "acrylic_mscl9810.h"
 #include "acrylic_mscl3830.h"
+#endif
 #include "acrylic_dummy.h"
+#include "acrylic_sw.h"
 
 static uint32_t all_fimg2d_formats[] = {
     HAL_PIXEL_FORMAT_RGBA_8888,
@@ -537,6 +540,30 @@ const static stHW2DCapability __capability_mscl_3830 = {
     .base_align = 4,
 };
 
+// The S/W compositor does not have restrictions except the ones of 16-bit
+// coordinates. It does not convert dataspaces but accepts all of them like G2D.
+const static stHW2DCapability __capability_sw = {
+    .max_upsampling_num = {32767, 32767},
+    .max_downsampling_factor = {32767, 32767},
+    .max_upsizing_num = {32767, 32767},
+    .max_downsizing_factor = {32767, 32767},
+    .min_src_dimension = {1, 1},
+    .max_src_dimension = {8192, 8192},
+    .min_dst_dimension = {1, 1},
+    .max_dst_dimension = {8192, 8192},
+    .min_pix_align = {1, 1},
+    .rescaling_count = 0,
+    .compositing_mode = HW2DCapability::BLEND_NONE | HW2DCapability::BLEND_SRC_COPY | HW2DCapability::BLEND_SRC_OVER,
+    .transform_type = HW2DCapability::TRANSFORM_ALL,
+    .auxiliary_feature = HW2DCapability::FEATURE_PLANE_ALPHA | HW2DCapability::FEATURE_SOLIDCOLOR,
+    .num_formats = ARRSIZE(rgb_formats),
+    .num_dataspaces = ARRSIZE(all_hwc_dataspaces),
+    .max_layers = 16,
+    .pixformats = rgb_formats,
+    .dataspaces = all_hwc_dataspaces,
+    .base_align = 1,
+};
+
 static const HW2DCapability capability_fimg2d_8895(__capability_fimg2d_8895);
 static const HW2DCapability capability_fimg2d_8890(__capability_fimg2d_8890);
 static const HW2DCapability capability_fimg2d_9610(__capability_fimg2d_9610);
@@ -548,6 +575,7 @@ static const HW2DCapability capability_mscl_9810(__capability_mscl_9810);
 static const HW2DCapability capability_mscl_sbwc(__capability_mscl_sbwc);
 static const HW2DCapability capability_mscl_sbwcl(__capability_mscl_sbwcl);
 static const HW2DCapability capability_mscl_3830(__capability_mscl_3830);
+static const HW2DCapability capability_sw(__capability_sw);
 
 Acrylic *Acrylic::createInstance(const char *spec)
 {
@@ -555,6 +583,8 @@ Acrylic *Acrylic::createInstance(const char *spec)
 
     ALOGD_TEST("Creating a new Acrylic instance of '%s'", spec);
 
+    // LIBACRYL_SW_ONLY builds libacryl without the H/W drivers for the host
+#ifndef LIBACRYL_SW_ONLY
     if (strcmp(spec, "fimg2d_8890") == 0) {
         compositor = new AcrylicCompositorM2M1SHOT2_G2D(capability_fimg2d_8890);
     } else if (strcmp(spec, "fimg2d_8895") == 0) {
@@ -579,6 +609,10 @@ Acrylic *Acrylic::createInstance(const char *spec)
         compositor = new AcrylicCompositorMSCL9810(capability_mscl_sbwcl);
     } else if (strcmp(spec, "mscl_3830") == 0) {
         compositor = new AcrylicCompositorMSCL3830(capability_mscl_3830);
+    } else
+#endif
+    if (strcmp(spec, "sw") == 0) {
+        compositor = new AcrylicCompositorSW(capability_sw);
     } else if (strcmp(spec, "dummy") == 0) {
         compositor = new AcrylicCompositorDummy(capability_fimg2d_8895);
     } else {
@@ -16,14 +16,15 @@
  */
 
 #include <cstring>
+#include <algorithm>
 
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <unistd.h>
 
 #include <log/log.h>
-#include <hardware/exynos/ion.h>
 
 #include <hardware/hwcomposer2.h>
 
@@ -71,7 +72,8 @@ static void debug_show_m2m1shot2(const struct m2m1shot2 __unused &desc)
 }
 
 AcrylicCompositorM2M1SHOT2_G2D::AcrylicCompositorM2M1SHOT2_G2D(const HW2DCapability &capability)
-    : Acrylic(capability), mDev("/dev/fimg2d"), mMaxSourceCount(0), mClientION(-1), mPriority(-1)
+    : Acrylic(capability), mDev("/dev/fimg2d"), mDescTargetValid(false), mMaxSourceCount(0), mPriority(-1),
+      mBandwidthModel("g2d")
 {
     memset(&mDesc, 0, sizeof(mDesc));
 
@@ -82,48 +84,15 @@ AcrylicCompositorM2M1SHOT2_G2D::~AcrylicCompositorM2M1SHOT2_G2D()
 {
     delete [] mDesc.sources;
 
-    if (mClientION >= 0)
-        close(mClientION);
-
     ALOGD_TEST("Deleting Acrylic for G2D by m2m1shot2 on %p", this);
 }
 
-int AcrylicCompositorM2M1SHOT2_G2D::preparePrescaleBuffer(size_t len, bool drm_protected)
-{
-    if (mClientION < 0) {
-        mClientION = open("/dev/ion", O_RDWR);
-        if (mClientION < 0) {
-            ALOGERR("Failed to open /dev/ion");
-            return -1;
-        }
-    }
-
-    unsigned int heapmask = drm_protected ? EXYNOS_ION_HEAP_VIDEO_SCALER_MASK : EXYNOS_ION_HEAP_SYSTEM_MASK;
-    unsigned int flags = drm_protected ? ION_FLAG_PROTECTED : ION_FLAG_NOZEROED;
-    int buf_fd;
-
-    buf_fd = exynos_ion_alloc(mClientION, len, heapmask, flags);
-    if (buf_fd < 0) {
-        ALOGERR("Failed to allocate %zu bytes from ION heap mask %#x with flag %#x",
-                len, heapmask, flags);
-        // no need to close mClientION because it is closed on the destruction of this instance
-        return -1;
-    }
-
-    return buf_fd;
-}
-
 bool AcrylicCompositorM2M1SHOT2_G2D::prepareImage(m2m1shot2_image &image, AcrylicCanvas &layer)
 {
     memset(&image, 0, sizeof(image));
 
     hw2d_coord_t xy;
 
-    if (layer.getFence() >= 0) {
-        image.flags |= M2M1SHOT2_IMGFLAG_ACQUIRE_FENCE;
-        image.fence = layer.getFence();
-    }
-
     if (layer.isCompressed())
         image.flags |= M2M1SHOT2_IMGFLAG_COMPRESSED;
 
@@ -150,6 +119,26 @@ bool AcrylicCompositorM2M1SHOT2_G2D::prepareImage(m2m1shot2_image &image, Acryli
     LOGASSERT(image.fmt.pixelformat != 0, "unknown HAL format %#x", layer.getFormat());
 
     image.num_planes = halfmt_plane_count(layer.getFormat());
+
+    if (!prepareBuffer(image, layer))
+        return false;
+
+    image.colorspace = haldataspace_to_v4l2(layer.getDataspace(), xy.hori, xy.vert);
+
+    return true;
+}
+
+// Configure the fence and the buffer to @image that is already configured with @layer
+bool AcrylicCompositorM2M1SHOT2_G2D::prepareBuffer(m2m1shot2_image &image, AcrylicCanvas &layer)
+{
+    image.flags &= ~(M2M1SHOT2_IMGFLAG_ACQUIRE_FENCE | M2M1SHOT2_IMGFLAG_RELEASE_FENCE);
+    image.fence = 0;
+
+    if (layer.getFence() >= 0) {
+        image.flags |= M2M1SHOT2_IMGFLAG_ACQUIRE_FENCE;
+        image.fence = layer.getFence();
+    }
+
     if (layer.getBufferCount() < image.num_planes) {
         ALOGE("HAL format %#x requires %u buffers but %u buffers are configured",
               layer.getFormat(), image.num_planes, layer.getBufferCount());
@@ -173,8 +162,6 @@ bool AcrylicCompositorM2M1SHOT2_G2D::prepareImage(m2m1shot2_image &image, Acryli
         }
     }
 
-    image.colorspace = haldataspace_to_v4l2(layer.getDataspace(), xy.hori, xy.vert);
-
     return true;
 }
 
@@ -291,10 +278,13 @@ AcrylicCompositorM2M1SHOT2_G2D *AcrylicCompositorM2M1SHOT2_G2D::prescaleSource(
     } else {
         prescaler = transit->getCompositor();
         transit_layer = transit->getLayer();
-        // free the existing buffer if it is too small or has different property
+        // return the existing buffer to the pool if it is too small, too large
+        // or has different property
         if (transit->getDmabuf() >= 0) {
-            if ((transit->getBufferLen() < len) || (transit->isProtected() != layer.isProtected())) {
-                transit->setBuffer(-1, 0, false); // free the exiting buffer
+            if ((transit->getBufferLen() < len) ||
+                    (transit->getBufferLen() > AcrylicTransitBufferPool::getBucketSize(len) * 2) ||
+                    (transit->isProtected() != layer.isProtected())) {
+                transit->setBuffer(-1, 0, false, -1); // release the exiting buffer
             } else {
                 transit_buffer_fd = transit->getDmabuf();
             }
@@ -302,35 +292,52 @@ AcrylicCompositorM2M1SHOT2_G2D *AcrylicCompositorM2M1SHOT2_G2D::prescaleSource(
     }
 
     if (transit->getDmabuf() < 0) {
-        transit_buffer_fd = preparePrescaleBuffer(len, layer.isProtected());
+        size_t buflen;
+        int fence;
+
+        // The buffer released by another layer may be still read by a task of
+        // another compositor that is not completed yet.
+        transit_buffer_fd = AcrylicTransitBufferPool::getInstance().acquire(
+                                        len, layer.isProtected(), &buflen, &fence);
         if (transit_buffer_fd < 0) {
             ALOGE("Failed to allocate transit buffer of %dx%d (fmt: %#x)",
                   target_size.hori, target_size.vert, fmt);
             return NULL;
         }
 
-        transit->setBuffer(transit_buffer_fd, len, layer.isProtected());
+        transit->setBuffer(transit_buffer_fd, buflen, layer.isProtected(), fence);
     }
 
     if (!prescaler->setCanvasDimension(transit_image_size.hori, transit_image_size.vert))
         return NULL;
 
-    if (!prescaler->setCanvasBuffer(&transit_buffer_fd, &len, 1, -1,
-                layer.isProtected() ? AcrylicCanvas::ATTR_PROTECTED : AcrylicCanvas::ATTR_NONE))
+    // The prescaler waits for the last task that reads the transit buffer in the driver
+    int transit_fence = transit->takeReleaseFence();
+    if (!prescaler->setCanvasBuffer(&transit_buffer_fd, &len, 1, transit_fence,
+                layer.isProtected() ? AcrylicCanvas::ATTR_PROTECTED : AcrylicCanvas::ATTR_NONE)) {
+        if (transit_fence >= 0)
+            close(transit_fence);
         return NULL;
+    }
 
     if (!prescaler->setCanvasImageType(fmt, dataspace))
         return NULL;
 
     transit_layer->importLayer(layer, upscaling);
 
-    // non blocking execution
-    if (!transit->execute()) {
+    int release_fence;
+
+    // non blocking execution. The release fence of the transit image becomes the
+    // acquire fence of the source image of this compositor so that the driver
+    // starts compositing after the prescaling completes without waking up the caller.
+    if (!transit->execute(&release_fence)) {
         ALOGE("Failed prescaling from %dx%d to %dx%d",
               image_size.hori, image_size.vert, transit_image_size.hori, transit_image_size.vert);
         return NULL;
     }
 
+    prescaler->getCanvas().setFence(release_fence);
+
     ALOGD("Executed prescaling from %dx%d to %dx%d",
           image_size.hori, image_size.vert, transit_image_size.hori, transit_image_size.vert);
 
@@ -338,7 +345,7 @@ AcrylicCompositorM2M1SHOT2_G2D *AcrylicCompositorM2M1SHOT2_G2D::prescaleSource(
 }
 
 bool AcrylicCompositorM2M1SHOT2_G2D::prepareSource(m2m1shot2_image &image, AcrylicLayer &layer,
-                                      uint32_t target_width, uint32_t target_height)
+                                      uint32_t target_width, uint32_t target_height, bool *prescaled)
 {
     // Discover the target image size first than the other tasks because we need
     // to determine if the prescaling is required. Note that the target rect
@@ -351,9 +358,13 @@ bool AcrylicCompositorM2M1SHOT2_G2D::prepareSource(m2m1shot2_image &image, Acryl
 
     uint32_t trf = layer.getTransform();
 
+    *prescaled = false;
+
     if (!(layer.getCompositAttr() & AcrylicLayer::ATTR_NORESAMPLING) &&
             !getCapabilities().supportedHWResampling(
                     layer.getImageRect().size, target_rect.size, layer.getTransform())) {
+        *prescaled = true;
+
         Acrylic *prescaler = prescaleSource(layer, target_rect.size);
         if (!prescaler)
             return false;
@@ -426,7 +437,8 @@ bool AcrylicCompositorM2M1SHOT2_G2D::prepareSource(m2m1shot2_image &image, Acryl
     return true;
 }
 
-bool AcrylicCompositorM2M1SHOT2_G2D::executeG2D(int fence[], unsigned int num_fences, bool nonblocking)
+bool AcrylicCompositorM2M1SHOT2_G2D::executeG2D(int fence[], unsigned int num_fences, bool nonblocking,
+                                                int *target_fence)
 {
     if (!validateAllLayers())
         return false;
@@ -448,17 +460,43 @@ bool AcrylicCompositorM2M1SHOT2_G2D::executeG2D(int fence[], unsigned int num_fe
         mDesc.sources = new m2m1shot2_image[layercount];
         if (!mDesc.sources) {
             ALOGE("Failed to allocate %u source image descriptors", layercount);
+            mMaxSourceCount = 0;
+            mDescLayers.clear();
             return false;
         }
 
         mMaxSourceCount = layercount;
+        mDescLayers.assign(layercount, NULL);
     }
 
     sortLayers();
 
-    if (!prepareImage(mDesc.target, getCanvas())) {
-        ALOGE("Failed to configure the target image");
-        return false;
+    AcrylicStageTimer prepareTimer;
+    // The transit images read by this task
+    std::vector<AcrylicTransitM2M1SHOT2_G2D *> transits;
+
+    // The descriptors of the previous execution are reused with the buffers
+    // and the fences replaced if the configurations of the images are not changed.
+    // The source images refer to the target dimension if no target rect is given.
+    if (!mDescTargetValid || getCanvas().isConfigModified()) {
+        mDescTargetValid = false;
+        mDescLayers.assign(mMaxSourceCount, NULL);
+
+        if (!prepareImage(mDesc.target, getCanvas())) {
+            ALOGE("Failed to configure the target image");
+            return false;
+        }
+
+        mDescTargetValid = true;
+    } else {
+        // m2m1shot2 writes the payload of the target image on completion
+        for (unsigned int i = 0; i < mDesc.target.num_planes; i++)
+            mDesc.target.plane[i].payload = 0;
+
+        if (!prepareBuffer(mDesc.target, getCanvas())) {
+            ALOGE("Failed to configure the buffer of the target image");
+            return false;
+        }
     }
 
     // The output brightness values of the G2D should be multiplied
@@ -488,17 +526,42 @@ bool AcrylicCompositorM2M1SHOT2_G2D::executeG2D(int fence[], unsigned int num_fe
         mDesc.sources[0].ext.fillcolor |= (g & 0xFF00) << 0;
         mDesc.sources[0].ext.fillcolor |= (b & 0xFF00) >> 8;
 
+        mDescLayers[0] = NULL;
+
         baseidx++;
     }
 
     for (unsigned int i = baseidx; i < layercount; i++) {
-        if (!prepareSource(mDesc.sources[i], *getLayer(i - baseidx),
-                mDesc.target.fmt.width, mDesc.target.fmt.height)) {
+        AcrylicLayer *layer = getLayer(i - baseidx);
+
+        if ((mDescLayers[i] == layer) && !layer->isConfigModified()) {
+            if (!prepareBuffer(mDesc.sources[i], *layer)) {
+                ALOGE("Failed to configure the buffer of source layer %u", i - baseidx);
+                return false;
+            }
+
+            continue;
+        }
+
+        bool prescaled;
+
+        mDescLayers[i] = NULL;
+
+        if (!prepareSource(mDesc.sources[i], *layer,
+                mDesc.target.fmt.width, mDesc.target.fmt.height, &prescaled)) {
             ALOGE("Failed to configure source layer %u", i - baseidx);
             return false;
         }
+
+        // The transit image of prescaling is produced in every execution
+        if (!prescaled)
+            mDescLayers[i] = layer;
+        else
+            transits.push_back(reinterpret_cast<AcrylicTransitM2M1SHOT2_G2D *>(layer->getTransit()));
     }
 
+    setPrepareTimeUSec(prepareTimer.elapsedUSec());
+
     mDesc.num_sources = static_cast<uint8_t>(layercount);
 
     if (nonblocking)
@@ -540,6 +603,14 @@ bool AcrylicCompositorM2M1SHOT2_G2D::executeG2D(int fence[], unsigned int num_fe
     while ((fence != NULL) && (fence_idx < num_fences))
         fence[fence_idx++] = -1;
 
+    if (target_fence != NULL)
+        mDesc.target.flags |= M2M1SHOT2_IMGFLAG_RELEASE_FENCE;
+
+    // The transit buffers are free to be written again when this task completes
+    bool transit_fence_only = !transits.empty() && !(mDesc.target.flags & M2M1SHOT2_IMGFLAG_RELEASE_FENCE);
+    if (!transits.empty())
+        mDesc.target.flags |= M2M1SHOT2_IMGFLAG_RELEASE_FENCE;
+
     debug_show_m2m1shot2(mDesc);
 
     if (mDev.ioctl_single(M2M1SHOT2_IOC_PROCESS, &mDesc) < 0) {
@@ -555,15 +626,23 @@ bool AcrylicCompositorM2M1SHOT2_G2D::executeG2D(int fence[], unsigned int num_fe
     }
 
     getCanvas().clearSettingModified();
-    getCanvas().setFence(-1);
 
-    for (unsigned int i = 0; i < (layercount - baseidx); i++) {
-        AcrylicLayer *layer = getLayer(i);
+    for (unsigned int i = 0; i < (layercount - baseidx); i++)
+        getLayer(i)->clearSettingModified();
 
-        layer->clearSettingModified();
-        layer->setFence(-1);
+    clearFences();
+
+    for (auto transit : transits)
+        transit->setReleaseFence(dup(mDesc.target.fence));
+
+    if (transit_fence_only) {
+        close(mDesc.target.fence);
+        mDesc.target.flags &= ~M2M1SHOT2_IMGFLAG_RELEASE_FENCE;
     }
 
+    if (target_fence != NULL)
+        *target_fence = mDesc.target.fence;
+
     if ((fence == NULL) || (num_fences == 0))
         return true;
 
@@ -584,9 +663,20 @@ bool AcrylicCompositorM2M1SHOT2_G2D::execute(int fence[], unsigned int num_fence
     if (!executeG2D(fence, num_fences, true)) {
         // Clearing all acquire fences because their buffers are expired.
         // The clients should configure everything again to start new execution
-        for (unsigned int i = 0; i < layerCount(); i++)
-            getLayer(i)->setFence(-1);
-        getCanvas().setFence(-1);
+        clearFences();
+
+        return false;
+    }
+
+    return true;
+}
+
+bool AcrylicCompositorM2M1SHOT2_G2D::executeAsync(int *release_fence)
+{
+    *release_fence = -1;
+
+    if (!executeG2D(NULL, 0, true, release_fence)) {
+        clearFences();
 
         return false;
     }
@@ -599,9 +689,7 @@ bool AcrylicCompositorM2M1SHOT2_G2D::execute(int *handle)
     if (!executeG2D(NULL, 0, handle ? true : false)) {
         // Clearing all acquire fences because their buffers are expired.
         // The clients should configure everything again to start new execution
-        for (unsigned int i = 0; i < layerCount(); i++)
-            getLayer(i)->setFence(-1);
-        getCanvas().setFence(-1);
+        clearFences();
 
         return false;
     }
@@ -633,8 +721,28 @@ bool AcrylicCompositorM2M1SHOT2_G2D::waitExecution(int __unused handle)
     return true;
 }
 
+void AcrylicCompositorM2M1SHOT2_G2D::clearFences()
+{
+    getCanvas().setFence(-1);
+
+    for (unsigned int i = 0; i < layerCount(); i++) {
+        AcrylicLayer *layer = getLayer(i);
+        AcrylicTransitM2M1SHOT2_G2D *transit;
+
+        layer->setFence(-1);
+
+        // release fence of the prescaling given to this compositor as the acquire fence
+        transit = reinterpret_cast<AcrylicTransitM2M1SHOT2_G2D *>(layer->getTransit());
+        if (transit)
+            transit->getCompositor()->getCanvas().setFence(-1);
+    }
+}
+
 void AcrylicCompositorM2M1SHOT2_G2D::removeTransitData(AcrylicLayer *layer)
 {
+    // Another layer may be created at the same address later
+    std::replace(mDescLayers.begin(), mDescLayers.end(), layer, static_cast<AcrylicLayer *>(NULL));
+
     AcrylicTransitM2M1SHOT2_G2D *transit = reinterpret_cast<AcrylicTransitM2M1SHOT2_G2D *>(layer->getTransit());
     if (transit)
         delete transit;
@@ -745,61 +853,26 @@ bool AcrylicCompositorM2M1SHOT2_G2D::requestPerformanceQoS(AcrylicPerformanceReq
         return true;
     }
 
+    mBandwidthModel.loadOnce();
+
     ALOGD_TEST("Requesting performance: frame count %d:", request->getFrameCount());
     for (int i = 0; i < request->getFrameCount(); i++) {
         AcrylicPerformanceRequestFrame *frame = request->getFrame(i);
-        uint64_t bandwidth = 0;
-        bool src_yuv420;
-        bool src_rotate;
-
-        src_rotate = false;
-        src_yuv420 = false;
+        std::vector<AcrylicBandwidthModel::Layer> layers(frame->getLayerCount());
+        AcrylicBandwidthModel::Features features;
 
-        unsigned int bpp;
         for (int idx = 0; idx < frame->getLayerCount(); idx++) {
             AcrylicPerformanceRequestLayer *layer = &(frame->mLayers[idx]);
-            uint64_t layer_bw;
-            int32_t weight;
-            uint32_t pixelcount, dst_pixcount;
-
-            pixelcount = layer->mSourceRect.size.hori * layer->mSourceRect.size.vert;
-            dst_pixcount = layer->mTargetRect.size.hori * layer->mTargetRect.size.vert;
-            if (pixelcount < dst_pixcount)
-                pixelcount = dst_pixcount;
+            unsigned int bpp = halfmt_bpp(layer->mPixFormat);
 
-            data.frame[i].layer[idx].pixelcount = pixelcount;
+            AcrylicBandwidthModel::describeLayer(*layer, bpp, layers[idx]);
 
-            bpp = halfmt_bpp(layer->mPixFormat);
-            if (bpp == 12)
-                src_yuv420 = true;
-
-
-            layer_bw = pixelcount * bpp;
-            // Below is checking if scaling is involved.
-            // Comparisons are replaced by additions to avoid branches.
-            if (!!(layer->mTransform & HAL_TRANSFORM_ROT_90)) {
-                weight = layer->mSourceRect.size.hori - layer->mTargetRect.size.vert;
-                weight += layer->mSourceRect.size.vert - layer->mTargetRect.size.hori;
-                src_rotate = true;
+            data.frame[i].layer[idx].pixelcount = layers[idx].pixelcount;
+            if (layers[idx].flags & AcrylicBandwidthModel::LAYER_ROTATING)
                 data.frame[i].layer[idx].layer_attr |= M2M1SHOT2_PERF_LAYER_ROTATE;
-            } else {
-                weight = layer->mSourceRect.size.hori - layer->mTargetRect.size.hori;
-                weight += layer->mSourceRect.size.vert - layer->mTargetRect.size.vert;
-            }
-            // Weight to the bandwidth when scaling is involved is 1.125.
-            // It is multiplied by 16 to avoid multiplication with a real number.
-            // We also get benefit from shift instead of multiplication.
-            if (weight == 0) {
-                layer_bw <<= 4; // layer_bw * 16
-                weight = 1000;
-            } else {
-                layer_bw = (layer_bw << 4) + (layer_bw << 1); // layer_bw * 18
-                weight = 1125;
-            }
 
-            bandwidth += layer_bw;
-            ALOGD_TEST("        LAYER[%d]: BW %llu WGT %u FMT %#x(%u) (%dx%d)@(%dx%d)on(%dx%d) --> (%dx%d)@(%dx%d) TRFM %#x",
-                    idx, static_cast<unsigned long long>(layer_bw), weight, layer->mPixFormat, bpp,
+            ALOGD_TEST("        LAYER[%d]: FLAGS %#x FMT %#x(%u) (%dx%d)@(%dx%d)on(%dx%d) --> (%dx%d)@(%dx%d) TRFM %#x",
+                    idx, layers[idx].flags, layer->mPixFormat, bpp,
                     layer->mSourceRect.size.hori, layer->mSourceRect.size.vert,
                     layer->mSourceRect.pos.hori, layer->mSourceRect.pos.vert,
                     layer->mSourceDimension.hori, layer->mSourceDimension.vert,
@@ -807,20 +880,13 @@ bool AcrylicCompositorM2M1SHOT2_G2D::requestPerformanceQoS(AcrylicPerformanceReq
                     layer->mTargetRect.pos.hori, layer->mTargetRect.pos.vert, layer->mTransform);
         }
 
-        bandwidth *= frame->mFrameRate;
-        bandwidth >>= 17; // divide by 16(weight), 8(bpp) and 1024(kilobyte)
-
-        data.frame[i].bandwidth_read = static_cast<uint32_t>(bandwidth);
-
-        bpp = halfmt_bpp(frame->mTargetPixFormat);
-
-        bandwidth = frame->mTargetDimension.hori * frame->mTargetDimension.vert;
-        bandwidth *= frame->mFrameRate * bpp;
+        AcrylicBandwidthModel::getFeatures(layers.data(), frame->getLayerCount(), frame->mTargetDimension,
+                                           halfmt_bpp(frame->mTargetPixFormat), features);
 
-        // RSH 12 : bw * 2 / (bits_per_byte * kilobyte)
-        // RHS 13 : bw * 1 / (bits_per_byte * kilobyte)
-        bandwidth >>= ((bpp == 12) && src_yuv420 && src_rotate) ? 12 : 13;
-        data.frame[i].bandwidth_write = static_cast<uint32_t>(bandwidth);
+        data.frame[i].bandwidth_read = AcrylicBandwidthModel::toKBytesPerSec(
+                                mBandwidthModel.getReadCost(features), frame->mFrameRate);
+        data.frame[i].bandwidth_write = AcrylicBandwidthModel::toKBytesPerSec(
+                                mBandwidthModel.getWriteCost(features), frame->mFrameRate);
 
         if (frame->mHasBackgroundLayer)
             data.frame[i].frame_attr |= M2M1SHOT2_PERF_FRAME_SOLIDCOLORFILL;
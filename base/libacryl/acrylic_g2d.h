@@ -22,7 +22,9 @@
 
 #include <hardware/exynos/acryl.h>
 
+#include "acrylic_bandwidth.h"
 #include "acrylic_device.h"
+#include "acrylic_transit_pool.h"
 
 class AcrylicCompositorM2M1SHOT2_G2D: public Acrylic {
 public:
@@ -31,6 +33,7 @@ public:
     virtual bool execute(int fence[], unsigned int num_fences);
     virtual bool execute(int *handle = NULL);
     virtual bool waitExecution(int handle);
+    virtual bool executeAsync(int *release_fence);
     /*
      * Return -1 on failure in configuring the give priority or the priority is invalid.
      * Return 0 when the priority is configured successfully without any side effect.
@@ -42,19 +45,25 @@ public:
 protected:
     virtual void removeTransitData(AcrylicLayer *layer);
 private:
-    bool executeG2D(int fence[], unsigned int num_fences, bool nonblocking);
+    bool executeG2D(int fence[], unsigned int num_fences, bool nonblocking,
+                    int *target_fence = NULL);
+    void clearFences();
     bool prepareImage(m2m1shot2_image &image, AcrylicCanvas &layer);
+    bool prepareBuffer(m2m1shot2_image &image, AcrylicCanvas &layer);
     bool prepareSource(m2m1shot2_image &image, AcrylicLayer &layer,
-                       uint32_t target_width, uint32_t target_height);
+                       uint32_t target_width, uint32_t target_height, bool *prescaled);
     AcrylicCompositorM2M1SHOT2_G2D *prescaleSource(
                             AcrylicLayer &layer, hw2d_coord_t target_size);
-    int preparePrescaleBuffer(size_t len, bool drm_protected);
 
     AcrylicRedundantDevice mDev;
     struct m2m1shot2 mDesc;
+    // The layers that the source image descriptors in mDesc are configured with.
+    // NULL if the descriptor should be configured again in the next execution.
+    std::vector<AcrylicLayer *> mDescLayers;
+    bool mDescTargetValid;
     unsigned int mMaxSourceCount;
-    int mClientION;
     int mPriority;
+    AcrylicBandwidthModel mBandwidthModel;
 };
 
 class AcrylicTransitM2M1SHOT2_G2D {
@@ -63,23 +72,25 @@ class AcrylicTransitM2M1SHOT2_G2D {
     int mBufferFD;
     bool mIsProtected;
     size_t mBufferLen;
+    // signaled when the last task that accesses the buffer completes
+    int mReleaseFence;
 public:
     AcrylicTransitM2M1SHOT2_G2D()
         : mCompositor(NULL), mLayer(NULL), mBufferFD(-1),
-          mIsProtected(false), mBufferLen(0)
+          mIsProtected(false), mBufferLen(0), mReleaseFence(-1)
     {
     }
 
     AcrylicTransitM2M1SHOT2_G2D(AcrylicTransitM2M1SHOT2_G2D &transit)
         : mCompositor(transit.mCompositor), mLayer(transit.mLayer),
           mBufferFD(transit.mBufferFD), mIsProtected(transit.mIsProtected),
-          mBufferLen(transit.mBufferLen)
+          mBufferLen(transit.mBufferLen), mReleaseFence(transit.mReleaseFence)
     {
     }
 
     ~AcrylicTransitM2M1SHOT2_G2D() {
-        if (mBufferFD >= 0)
-            close(mBufferFD);
+        AcrylicTransitBufferPool::getInstance().release(mBufferFD, mBufferLen, mIsProtected,
+                                                        mReleaseFence);
         if (mLayer)
             delete mLayer;
         if (mCompositor)
@@ -90,6 +101,7 @@ public:
             mBufferFD = -1;
             mLayer = NULL;
             mCompositor = NULL;
+            mReleaseFence = -1;
     }
 
     AcrylicLayer *getLayer() { return mLayer; }
@@ -98,16 +110,29 @@ public:
     size_t getBufferLen() { return mBufferLen; }
     bool isProtected() { return mIsProtected; }
 
-    bool execute() { return mCompositor->execute(NULL, 0); }
+    bool execute(int *release_fence) { return mCompositor->executeAsync(release_fence); }
 
     void setLayer(AcrylicLayer *layer) { mLayer = layer; }
     void setCompositor(AcrylicCompositorM2M1SHOT2_G2D *compositor) { mCompositor = compositor; }
-    void setBuffer(int fd, size_t len, bool is_protected) {
-        if (mBufferFD >= 0)
-            close(mBufferFD);
+    // The buffers are acquired from AcrylicTransitBufferPool and returned to it with their fences
+    void setBuffer(int fd, size_t len, bool is_protected, int fence) {
+        AcrylicTransitBufferPool::getInstance().release(mBufferFD, mBufferLen, mIsProtected,
+                                                        mReleaseFence);
         mBufferFD = fd;
         mBufferLen = len;
         mIsProtected = is_protected;
+        mReleaseFence = fence;
+    }
+    void setReleaseFence(int fence) {
+        if (mReleaseFence >= 0)
+            close(mReleaseFence);
+        mReleaseFence = fence;
+    }
+    // The caller owns the returned fence
+    int takeReleaseFence() {
+        int fence = mReleaseFence;
+        mReleaseFence = -1;
+        return fence;
     }
 };
 
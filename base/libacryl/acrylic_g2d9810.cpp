@@ -20,6 +20,7 @@
 #include <algorithm>
 
 #include <sys/ioctl.h>
+#include <unistd.h>
 
 #include <system/graphics.h>
 #include <log/log.h>
@@ -342,7 +343,7 @@ static g2d_fmt *halfmt_to_g2dfmt(struct g2d_fmt *tbl, size_t tbl_len, uint32_t h
 
 AcrylicCompositorG2D9810::AcrylicCompositorG2D9810(const HW2DCapability &capability, bool newcolormode)
     : Acrylic(capability), mDev((capability.maxLayerCount() > 2) ? "/dev/g2d" : "/dev/fimg2d"),
-      mMaxSourceCount(0), mPriority(-1)
+      mMaxSourceCount(0), mPriority(-1), mBandwidthModel("g2d9810")
 {
     memset(&mTask, 0, sizeof(mTask));
 
@@ -812,7 +813,8 @@ int AcrylicCompositorG2D9810::ioctlG2D(void)
     return 0;
 }
 
-bool AcrylicCompositorG2D9810::executeG2D(int fence[], unsigned int num_fences, bool nonblocking)
+bool AcrylicCompositorG2D9810::executeG2D(int fence[], unsigned int num_fences, bool nonblocking,
+                                          int *target_fence)
 {
     if (!validateAllLayers())
         return false;
@@ -848,6 +850,8 @@ bool AcrylicCompositorG2D9810::executeG2D(int fence[], unsigned int num_fences,
 
     mTask.flags = 0;
 
+    AcrylicStageTimer prepareTimer;
+
     if (!prepareImage(getCanvas(), mTask.target, mTask.commands.target, -1)) {
         ALOGE("Failed to configure the target image");
         return false;
@@ -897,6 +901,8 @@ bool AcrylicCompositorG2D9810::executeG2D(int fence[], unsigned int num_fences,
         mHdrWriter.setLayerOpaqueData(i, layer.getLayerData(), layer.getLayerDataLength());
     }
 
+    setPrepareTimeUSec(prepareTimer.elapsedUSec());
+
     mHdrWriter.setTargetInfo(getCanvas().getDataspace(), getTargetDisplayInfo());
     mHdrWriter.setTargetDisplayLuminance(getMinTargetDisplayLuminance(), getMaxTargetDisplayLuminance());
 
@@ -908,8 +914,14 @@ bool AcrylicCompositorG2D9810::executeG2D(int fence[], unsigned int num_fences,
     if (nonblocking)
         mTask.flags |= G2D_FLAG_NONBLOCK;
 
-    mTask.num_release_fences = num_fences;
-    mTask.release_fence = reinterpret_cast<int *>(alloca(sizeof(int) * num_fences));
+    // The driver returns the release fences in the order of mTask.source followed by the target.
+    // The fence of the background layer is not informed to the users.
+    unsigned int num_requests = (num_fences > 0) ? num_fences + baseidx : 0;
+    if (target_fence != NULL)
+        num_requests = layercount + 1;
+
+    mTask.num_release_fences = num_requests;
+    mTask.release_fence = reinterpret_cast<int *>(alloca(sizeof(int) * num_requests));
 
     mTask.commands.num_extra_regs = cscMatrixWriter.getRegisterCount() + mHdrWriter.getCommandCount();
     mTask.commands.extra = reinterpret_cast<g2d_reg *>(alloca(sizeof(g2d_reg) * mTask.commands.num_extra_regs));
@@ -942,8 +954,16 @@ bool AcrylicCompositorG2D9810::executeG2D(int fence[], unsigned int num_fences,
         getLayer(i)->setFence(-1);
     }
 
-    for (unsigned int i = 0; i < num_fences; i++)
-        fence[i] = mTask.release_fence[i];
+    for (unsigned int i = 0; i < num_requests; i++) {
+        int relfence = mTask.release_fence[i];
+
+        if ((i == layercount) && (target_fence != NULL))
+            *target_fence = relfence;
+        else if ((i >= baseidx) && ((i - baseidx) < num_fences))
+            fence[i - baseidx] = relfence;
+        else if (relfence >= 0)
+            close(relfence);
+    }
 
     return true;
 }
@@ -963,6 +983,23 @@ bool AcrylicCompositorG2D9810::execute(int fence[], unsigned int num_fences)
     return true;
 }
 
+bool AcrylicCompositorG2D9810::executeAsync(int *release_fence)
+{
+    *release_fence = -1;
+
+    if (!executeG2D(NULL, 0, true, release_fence)) {
+        // Clearing all acquire fences because their buffers are expired.
+        // The clients should configure everything again to start new execution
+        for (unsigned int i = 0; i < layerCount(); i++)
+            getLayer(i)->setFence(-1);
+        getCanvas().setFence(-1);
+
+        return false;
+    }
+
+    return true;
+}
+
 bool AcrylicCompositorG2D9810::execute(int *handle)
 {
     if (!executeG2D(NULL, 0, handle ? true : false)) {
@@ -1004,70 +1041,42 @@ bool AcrylicCompositorG2D9810::requestPerformanceQoS(AcrylicPerformanceRequest *
         return true;
     }
 
+    mBandwidthModel.loadOnce();
+
     ALOGD_TEST("Requesting performance: frame count %d:", request->getFrameCount());
     for (int i = 0; i < request->getFrameCount(); i++) {
         AcrylicPerformanceRequestFrame *frame = request->getFrame(i);
-        uint64_t bandwidth = 0;
-        bool src_yuv420;
-        bool src_rotate;
-
-        src_rotate = false;
-        src_yuv420 = false;
-
+        std::vector<AcrylicBandwidthModel::Layer> layers(frame->getLayerCount());
+        AcrylicBandwidthModel::Features features;
         unsigned int bpp;
+
         for (int idx = 0; idx < frame->getLayerCount(); idx++) {
             AcrylicPerformanceRequestLayer *layer = &(frame->mLayers[idx]);
-            uint64_t layer_bw, pixelcount;
-            int32_t is_scaling;
-            uint32_t src_hori = layer->mSourceRect.size.hori;
-            uint32_t src_vert = layer->mSourceRect.size.vert;
-            uint32_t dst_hori = layer->mTargetRect.size.hori;
-            uint32_t dst_vert = layer->mTargetRect.size.vert;
-            pixelcount = std::max(src_hori * src_vert, dst_hori * dst_vert);
-            data.frame[i].layer[idx].crop_width = src_hori;
-            data.frame[i].layer[idx].crop_height = src_vert;
-            data.frame[i].layer[idx].window_width = dst_hori;
-            data.frame[i].layer[idx].window_height = dst_vert;
+            uint32_t flags;
+
+            data.frame[i].layer[idx].crop_width = layer->mSourceRect.size.hori;
+            data.frame[i].layer[idx].crop_height = layer->mSourceRect.size.vert;
+            data.frame[i].layer[idx].window_width = layer->mTargetRect.size.hori;
+            data.frame[i].layer[idx].window_height = layer->mTargetRect.size.vert;
 
             bpp = halfmt_bpp(layer->mPixFormat);
-            if (bpp == 12) {
+            if (bpp == 12)
                 data.frame[i].layer[idx].layer_attr |= G2D_PERF_LAYER_YUV2P;
-                src_yuv420 = true;
-            } else if (bpp == 15) {
+            else if (bpp == 15)
                 data.frame[i].layer[idx].layer_attr |= G2D_PERF_LAYER_YUV2P_82;
-                src_yuv420 = true;
-            }
 
-            layer_bw = pixelcount * bpp;
-            // Below is checking if scaling is involved.
-            // Comparisons are replaced by additions to avoid branches.
-            if (!!(layer->mTransform & HAL_TRANSFORM_ROT_90)) {
-                src_rotate = true;
-                data.frame[i].layer[idx].layer_attr |= G2D_PERF_LAYER_ROTATE;
-
-                is_scaling = src_hori - dst_vert;
-                is_scaling += src_vert - dst_hori;
-            } else {
-                is_scaling = src_hori - dst_hori;
-                is_scaling += src_vert - dst_vert;
-            }
-            // Weight to the bandwidth when scaling is involved is 1.125.
-            // It is multiplied by 16 to avoid multiplication with a real number.
-            // We also get benefit from shift instead of multiplication.
-            if (is_scaling == 0) {
-                layer_bw <<= 4; // layer_bw * 16
-            } else {
-                layer_bw = (layer_bw << 4) + (layer_bw << 1); // layer_bw * 18
+            AcrylicBandwidthModel::describeLayer(*layer, bpp, layers[idx]);
 
+            flags = layers[idx].flags;
+            if (flags & AcrylicBandwidthModel::LAYER_ROTATING)
+                data.frame[i].layer[idx].layer_attr |= G2D_PERF_LAYER_ROTATE;
+            if (flags & AcrylicBandwidthModel::LAYER_SCALING)
                 data.frame[i].layer[idx].layer_attr |= G2D_PERF_LAYER_SCALING;
-            }
-
-            if (layer->mAttribute & AcrylicCanvas::ATTR_COMPRESSED)
+            if (flags & AcrylicBandwidthModel::LAYER_COMPRESSED)
                 data.frame[i].layer[idx].layer_attr |= G2D_PERF_LAYER_COMPRESSED;
 
-            bandwidth += layer_bw;
-            ALOGD_TEST("        LAYER[%d]: BW %llu FMT %#x(%u) (%dx%d)@(%dx%d)on(%dx%d) --> (%dx%d)@(%dx%d) TRFM %#x",
-                    idx, static_cast<unsigned long long>(layer_bw), layer->mPixFormat, bpp,
+            ALOGD_TEST("        LAYER[%d]: FLAGS %#x FMT %#x(%u) (%dx%d)@(%dx%d)on(%dx%d) --> (%dx%d)@(%dx%d) TRFM %#x",
+                    idx, flags, layer->mPixFormat, bpp,
                     layer->mSourceRect.size.hori, layer->mSourceRect.size.vert,
                     layer->mSourceRect.pos.hori, layer->mSourceRect.pos.vert,
                     layer->mSourceDimension.hori, layer->mSourceDimension.vert,
@@ -1075,22 +1084,17 @@ bool AcrylicCompositorG2D9810::requestPerformanceQoS(AcrylicPerformanceRequest *
                     layer->mTargetRect.pos.hori, layer->mTargetRect.pos.vert, layer->mTransform);
         }
 
-        bandwidth *= frame->mFrameRate;
-        bandwidth >>= 17; // divide by 16(weight), 8(bpp) and 1024(kilobyte)
-
-        data.frame[i].bandwidth_read = static_cast<uint32_t>(bandwidth);
-
         bpp = halfmt_bpp(frame->mTargetPixFormat);
         if (bpp == 12)
             data.frame[i].frame_attr |= G2D_PERF_FRAME_YUV2P;
 
-        bandwidth = frame->mTargetDimension.hori * frame->mTargetDimension.vert;
-        bandwidth *= frame->mFrameRate * bpp;
+        AcrylicBandwidthModel::getFeatures(layers.data(), frame->getLayerCount(),
+                                           frame->mTargetDimension, bpp, features);
 
-        // RSH 12 : bw * 2 / (bits_per_byte * kilobyte)
-        // RHS 13 : bw * 1 / (bits_per_byte * kilobyte)
-        bandwidth >>= ((bpp == 12) && src_yuv420 && src_rotate) ? 12 : 13;
-        data.frame[i].bandwidth_write = static_cast<uint32_t>(bandwidth);
+        data.frame[i].bandwidth_read = AcrylicBandwidthModel::toKBytesPerSec(
+                                mBandwidthModel.getReadCost(features), frame->mFrameRate);
+        data.frame[i].bandwidth_write = AcrylicBandwidthModel::toKBytesPerSec(
+                                mBandwidthModel.getWriteCost(features), frame->mFrameRate);
 
         if (frame->mHasBackgroundLayer)
             data.frame[i].frame_attr |= G2D_PERF_FRAME_SOLIDCOLORFILL;
@@ -27,6 +27,7 @@
 #include <uapi/g2d9810.h>
 
 #include "acrylic_internal.h"
+#include "acrylic_bandwidth.h"
 #include "acrylic_device.h"
 
 class G2DHdrWriter {
@@ -119,6 +120,7 @@ public:
     virtual bool execute(int fence[], unsigned int num_fences);
     virtual bool execute(int *handle = NULL);
     virtual bool waitExecution(int handle);
+    virtual bool executeAsync(int *release_fence);
     virtual unsigned int getLaptimeUSec() { return mTask.laptime_in_usec; }
     /*
      * Return -1 on failure in configuring the give priority or the priority is invalid.
@@ -130,7 +132,7 @@ public:
     virtual bool requestPerformanceQoS(AcrylicPerformanceRequest *request);
 private:
     int ioctlG2D(void);
-    bool executeG2D(int fence[], unsigned int num_fences, bool nonblocking);
+    bool executeG2D(int fence[], unsigned int num_fences, bool nonblocking, int *target_fence = NULL);
     bool prepareImage(AcrylicCanvas &layer, struct g2d_layer &image, uint32_t cmd[], int index);
     bool prepareSource(AcrylicLayer &layer, struct g2d_layer &image, uint32_t cmd[], hw2d_coord_t target_size, int index);
     bool prepareSolidLayer(AcrylicCanvas &canvas, struct g2d_layer &image, uint32_t cmd[]);
@@ -143,6 +145,7 @@ private:
     unsigned int  mMaxSourceCount;
     int mPriority;
     unsigned int mVersion;
+    AcrylicBandwidthModel mBandwidthModel;
 
     g2d_fmt *halfmt_to_g2dfmt_tbl;
     size_t len_halfmt_to_g2dfmt_tbl;
@@ -20,6 +20,7 @@
 
 #include <cerrno>
 #include <cstring>
+#include <chrono>
 
 #include <hardware/exynos/acryl.h>
 
@@ -112,6 +113,30 @@ static inline bool area_is_zero(hw2d_rect_t rect)
     return (rect.size.hori == 0) && (rect.size.vert == 0);
 }
 
+/*
+ * Measures the elapsed time from the creation in micro seconds. If @usec is
+ * given, the elapsed time is stored to @usec on destruction.
+ */
+class AcrylicStageTimer {
+public:
+    AcrylicStageTimer(unsigned int *usec = nullptr)
+        : mUSec(usec), mBegin(std::chrono::steady_clock::now()) { }
+    ~AcrylicStageTimer()
+    {
+        if (mUSec)
+            *mUSec = elapsedUSec();
+    }
+
+    unsigned int elapsedUSec()
+    {
+        return static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - mBegin).count());
+    }
+private:
+    unsigned int *mUSec;
+    std::chrono::steady_clock::time_point mBegin;
+};
+
 uint32_t halfmt_to_v4l2(uint32_t halfmt);
 uint32_t halfmt_to_v4l2_deprecated(uint32_t halfmt);
 uint8_t get_block_size_from_halfmt(uint32_t halfmt);
@@ -110,7 +110,7 @@ bool AcrylicCanvas::setImageBuffer(int a, int r, int g, int b, uint32_t attr)
     mMemoryType = MT_EMPTY;
     mNumBuffers = 0;
 
-    mAttributes = (attr & ATTR_ALL_MASK) | ATTR_SOLIDCOLOR;
+    setAttributes((attr & ATTR_ALL_MASK) | ATTR_SOLIDCOLOR);
 
     set(SETTING_BUFFER | SETTING_BUFFER_MODIFIED);
 
@@ -167,7 +167,7 @@ bool AcrylicCanvas::setImageBuffer(int fd[MAX_HW2D_PLANES], size_t len[MAX_HW2D_
     mMemoryType = MT_DMABUF;
     mNumBuffers = num_buffers;
 
-    mAttributes = attr & ATTR_ALL_MASK;
+    setAttributes(attr & ATTR_ALL_MASK);
     ALOGD_TEST("Configured buffer: fence %d, type %d, count %d, attr %#x (type: %s)",
                mFence, mMemoryType, mNumBuffers, mAttributes, canvasTypeName(mCanvasType));
 
@@ -219,7 +219,7 @@ bool AcrylicCanvas::setImageBuffer(void *addr[MAX_HW2D_PLANES], size_t len[MAX_H
     mMemoryType = MT_USERPTR;
     mNumBuffers = num_buffers;
 
-    mAttributes = attr & ATTR_ALL_MASK;
+    setAttributes(attr & ATTR_ALL_MASK);
 
     ALOGD_TEST("Configured buffer: fence %d, type %d, count %d, attr %#x (type: %s)",
                mFence, mMemoryType, mNumBuffers, mAttributes, canvasTypeName(mCanvasType));
@@ -248,7 +248,7 @@ bool AcrylicCanvas::setImageOTFBuffer(uint32_t attr)
     mMemoryType = MT_EMPTY;
     mNumBuffers = 0;
 
-    mAttributes = (attr & ATTR_ALL_MASK) | ATTR_OTF;
+    setAttributes((attr & ATTR_ALL_MASK) | ATTR_OTF);
 
     set(SETTING_BUFFER | SETTING_BUFFER_MODIFIED);
 
@@ -291,6 +291,14 @@ bool AcrylicCanvas::setImageType(uint32_t fmt, int dataspace)
     return true;
 }
 
+void AcrylicCanvas::setAttributes(uint32_t attr)
+{
+    if (mAttributes != attr)
+        set(SETTING_ATTRIBUTE_MODIFIED);
+
+    mAttributes = attr;
+}
+
 void AcrylicCanvas::setFence(int fence)
 {
     if (mFence >= 0)
@@ -302,7 +310,7 @@ void AcrylicCanvas::setFence(int fence)
 AcrylicLayer::AcrylicLayer(Acrylic *compositor)
     : AcrylicCanvas(compositor), mTransitData(nullptr), mLayerData(nullptr),
       mLayerDataLen(0), mBlendingMode(HWC_BLENDING_NONE),
-      mTransform(0), mZOrder(0), mMaxLuminance(100), mMinLuminance(0), mPlaneAlpha(255)
+      mTransform(0), mZOrder(0), mCompositAttr(0), mMaxLuminance(100), mMinLuminance(0), mPlaneAlpha(255)
 {
     // Default settings:
     // - Bleding mode: SRC_OVER
@@ -314,6 +322,7 @@ AcrylicLayer::AcrylicLayer(Acrylic *compositor)
     // - target area: full area of the target image
     mTargetRect.pos = {0, 0};
     mTargetRect.size = {0, 0};
+    mImageRect = mTargetRect;
 }
 
 AcrylicLayer::~AcrylicLayer()
@@ -358,6 +367,9 @@ bool AcrylicLayer::setCompositMode(uint32_t mode, uint8_t alpha, int z_order)
         return false;
     }
 
+    if ((mBlendingMode != mode) || (mZOrder != z_order) || (mPlaneAlpha != alpha))
+        set(SETTING_COMPOSIT_MODIFIED);
+
     mBlendingMode = mode;
 
     mZOrder = z_order;
@@ -455,15 +467,24 @@ bool AcrylicLayer::setCompositArea(hwc_rect_t &src_area, hwc_rect_t &out_area, u
         }
     }
 
-    mTargetRect.pos.hori = static_cast<int16_t>(out_area.left);
-    mTargetRect.pos.vert = static_cast<int16_t>(out_area.top);
-    mTargetRect.size.hori = static_cast<int16_t>(get_width(out_area));
-    mTargetRect.size.vert = static_cast<int16_t>(get_height(out_area));
+    hw2d_rect_t target_rect, image_rect;
+
+    target_rect.pos.hori = static_cast<int16_t>(out_area.left);
+    target_rect.pos.vert = static_cast<int16_t>(out_area.top);
+    target_rect.size.hori = static_cast<int16_t>(get_width(out_area));
+    target_rect.size.vert = static_cast<int16_t>(get_height(out_area));
 
-    mImageRect.pos.hori = static_cast<int16_t>(src_area.left);
-    mImageRect.pos.vert = static_cast<int16_t>(src_area.top);
-    mImageRect.size.hori = static_cast<int16_t>(get_width(src_area));
-    mImageRect.size.vert = static_cast<int16_t>(get_height(src_area));
+    image_rect.pos.hori = static_cast<int16_t>(src_area.left);
+    image_rect.pos.vert = static_cast<int16_t>(src_area.top);
+    image_rect.size.hori = static_cast<int16_t>(get_width(src_area));
+    image_rect.size.vert = static_cast<int16_t>(get_height(src_area));
+
+    if ((mTargetRect != target_rect) || (mImageRect != image_rect) ||
+            (mTransform != transform) || (mCompositAttr != (attr & ATTR_ALL_MASK)))
+        set(SETTING_COMPOSIT_MODIFIED);
+
+    mTargetRect = target_rect;
+    mImageRect = image_rect;
 
     mTransform = transform;
     mCompositAttr = attr & ATTR_ALL_MASK;
@@ -482,8 +503,12 @@ bool AcrylicLayer::setImageDimension(int32_t width, int32_t height)
         return false;
 
     // NOTE: the crop area should be initialized with the new image size
-    mImageRect.pos = {0, 0};
-    mImageRect.size = getImageDimension();
+    hw2d_rect_t image_rect = {{0, 0}, getImageDimension()};
+
+    if (mImageRect != image_rect)
+        set(SETTING_COMPOSIT_MODIFIED);
+
+    mImageRect = image_rect;
 
     ALOGD_TEST("Reset the image rect to %dx%d@0x0", mImageRect.size.hori, mImageRect.size.vert);
 
@@ -547,6 +572,10 @@ void AcrylicLayer::importLayer(AcrylicLayer &other, bool inherit_transform)
     }
 
     other.clearFence();
+
+    if ((mImageRect != other.mImageRect) || (inherit_transform && (mTransform != other.mTransform)))
+        set(SETTING_COMPOSIT_MODIFIED);
+
     mImageRect = other.mImageRect;
     if (inherit_transform)
         mTransform = other.mTransform;
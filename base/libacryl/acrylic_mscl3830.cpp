@@ -775,6 +775,23 @@ bool AcrylicCompositorMSCL3830::execute(int fence[], unsigned int num_fences)
     return queueBuffer(fence, num_fences);
 }
 
+bool AcrylicCompositorMSCL3830::executeAsync(int *release_fence)
+{
+    int fence[NUM_IMAGES];
+
+    *release_fence = -1;
+
+    if (!execute(fence, NUM_IMAGES))
+        return false;
+
+    if (fence[SOURCE] >= 0)
+        close(fence[SOURCE]);
+
+    *release_fence = fence[TARGET];
+
+    return true;
+}
+
 bool AcrylicCompositorMSCL3830::execute(int *handle)
 {
     bool success = execute(NULL, 0);
@@ -0,0 +1,886 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <algorithm>
+
+#include <sys/mman.h>
+#include <poll.h>
+
+#include <log/log.h>
+#include <hardware/hwcomposer2.h>
+#include <exynos_worker_pool.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "acrylic_internal.h"
+#include "acrylic_sw.h"
+
+/*
+ * The pixels are processed in RGBA8888 during composition: R is in the lowest
+ * byte and A is in the highest byte of a 32-bit word in the little endian
+ * memory. All the color values are premultiplied by the alpha value once they
+ * are sampled from the source images.
+ */
+
+namespace {
+
+struct SWImage {
+    uint8_t *base;
+    size_t stride;
+    int width;
+    int height;
+    uint32_t format;
+};
+
+struct SWLayer;
+
+typedef void (*sw_sample_fn)(const SWLayer &layer, int tx, int ty, int count, uint32_t *out);
+
+enum sw_op_t {
+    SW_OP_NONE,        // the color values are already premultiplied
+    SW_OP_OPAQUE,      // the alpha values are ignored
+    SW_OP_PREMULTIPLY, // the color values should be multiplied by the alpha value
+};
+
+struct SWLayer {
+    SWImage image;    // crop area of the source image
+    hw2d_rect_t target;
+    // 16.16 fixed point map from the pixel in the target area to the crop area
+    int64_t ox, oy;
+    int64_t xx, xy;
+    int64_t yx, yy;
+    sw_sample_fn sample;
+    sw_op_t op;
+    uint8_t alpha;
+    bool opaque;
+    bool solid;
+    uint32_t color;
+};
+
+struct SWFrame {
+    SWImage canvas;
+    std::vector<SWLayer> layers;
+    bool has_background;
+    uint32_t background;
+    int tiles_per_row;
+};
+
+/*
+ * Unmaps all dmabufs mapped during a composition.
+ */
+class SWMappings {
+    std::vector<std::pair<void *, size_t>> mMaps;
+public:
+    ~SWMappings() {
+        for (auto &map : mMaps)
+            munmap(map.first, map.second);
+    }
+
+    uint8_t *map(int fd, size_t len, int prot) {
+        void *addr = mmap(NULL, len, prot, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED)
+            return NULL;
+        mMaps.emplace_back(addr, len);
+        return reinterpret_cast<uint8_t *>(addr);
+    }
+};
+
+/* pixel operations on two channels of a pixel at once: R and B or G and A */
+
+// (x * y) / 255 with rounding for 16-bit lanes of (x * y + 128)
+static inline uint32_t div255_lanes(uint32_t v)
+{
+    return ((v + ((v >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+}
+
+static inline uint32_t scale_pixel(uint32_t p, uint32_t f)
+{
+    uint32_t rb = div255_lanes((p & 0x00FF00FF) * f + 0x00800080);
+    uint32_t ga = div255_lanes(((p >> 8) & 0x00FF00FF) * f + 0x00800080);
+
+    return rb | (ga << 8);
+}
+
+static inline uint32_t premultiply_pixel(uint32_t p)
+{
+    return (scale_pixel(p, p >> 24) & 0x00FFFFFF) | (p & 0xFF000000);
+}
+
+// S + D * (1 - Sa) with saturation
+static inline uint32_t blend_pixel(uint32_t d, uint32_t s)
+{
+    uint32_t ia = 255 - (s >> 24);
+    uint32_t rb = div255_lanes((d & 0x00FF00FF) * ia + 0x00800080) + (s & 0x00FF00FF);
+    uint32_t ga = div255_lanes(((d >> 8) & 0x00FF00FF) * ia + 0x00800080) + ((s >> 8) & 0x00FF00FF);
+
+    rb |= (rb & 0x01000100) - ((rb & 0x01000100) >> 8);
+    ga |= (ga & 0x01000100) - ((ga & 0x01000100) >> 8);
+
+    return (rb & 0x00FF00FF) | ((ga & 0x00FF00FF) << 8);
+}
+
+// a * (256 - w) + b * w with w in [0, 256]
+static inline uint32_t lerp_pixel(uint32_t a, uint32_t b, uint32_t w)
+{
+    uint32_t rb = ((((a & 0x00FF00FF) * (256 - w)) + ((b & 0x00FF00FF) * w) + 0x00800080) >> 8) & 0x00FF00FF;
+    uint32_t ga = ((((a >> 8) & 0x00FF00FF) * (256 - w)) + (((b >> 8) & 0x00FF00FF) * w) + 0x00800080) & 0xFF00FF00;
+
+    return rb | ga;
+}
+
+#if defined(__SSE2__) && !defined(__ARM_NEON)
+static inline __m128i div255_epu16(__m128i v)
+{
+    v = _mm_add_epi16(v, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+
+static inline __m128i alpha_epu16(__m128i v)
+{
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xFF), 0xFF);
+}
+#endif
+
+#if defined(__ARM_NEON)
+static inline uint8x8_t div255_u16(uint16x8_t v)
+{
+    return vraddhn_u16(v, vrshrq_n_u16(v, 8));
+}
+#endif
+
+/*
+ * D = S * Pa + D * (1 - Sa * Pa) where S is premultiplied
+ */
+static void blend_row(uint32_t *dst, const uint32_t *src, int count, uint32_t alpha)
+{
+    int i = 0;
+
+#if defined(__ARM_NEON)
+    uint8x8_t pa = vdup_n_u8(static_cast<uint8_t>(alpha));
+
+    for (; (i + 8) <= count; i += 8) {
+        uint8x8x4_t s = vld4_u8(reinterpret_cast<const uint8_t *>(src + i));
+        uint8x8x4_t d = vld4_u8(reinterpret_cast<const uint8_t *>(dst + i));
+
+        if (alpha != 255) {
+            for (int c = 0; c < 4; c++)
+                s.val[c] = div255_u16(vmull_u8(s.val[c], pa));
+        }
+
+        uint8x8_t ia = vmvn_u8(s.val[3]);
+        for (int c = 0; c < 4; c++)
+            d.val[c] = vqadd_u8(s.val[c], div255_u16(vmull_u8(d.val[c], ia)));
+
+        vst4_u8(reinterpret_cast<uint8_t *>(dst + i), d);
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i v255 = _mm_set1_epi16(255);
+    const __m128i pa = _mm_set1_epi16(static_cast<int16_t>(alpha));
+
+    for (; (i + 4) <= count; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        __m128i slo = _mm_unpacklo_epi8(s, zero);
+        __m128i shi = _mm_unpackhi_epi8(s, zero);
+
+        if (alpha != 255) {
+            slo = div255_epu16(_mm_mullo_epi16(slo, pa));
+            shi = div255_epu16(_mm_mullo_epi16(shi, pa));
+        }
+
+        __m128i dlo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(v255, alpha_epu16(slo)));
+        __m128i dhi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(v255, alpha_epu16(shi)));
+
+        dlo = _mm_add_epi16(div255_epu16(dlo), slo);
+        dhi = _mm_add_epi16(div255_epu16(dhi), shi);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(dlo, dhi));
+    }
+#endif
+
+    for (; i < count; i++)
+        dst[i] = blend_pixel(dst[i], (alpha == 255) ? src[i] : scale_pixel(src[i], alpha));
+}
+
+static void premultiply_row(uint32_t *row, int count)
+{
+    int i = 0;
+
+#if defined(__ARM_NEON)
+    for (; (i + 8) <= count; i += 8) {
+        uint8x8x4_t p = vld4_u8(reinterpret_cast<const uint8_t *>(row + i));
+
+        for (int c = 0; c < 3; c++)
+            p.val[c] = div255_u16(vmull_u8(p.val[c], p.val[3]));
+
+        vst4_u8(reinterpret_cast<uint8_t *>(row + i), p);
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    // multiplying alpha by 255 keeps alpha as it is
+    const __m128i amask = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+    for (; (i + 4) <= count; i += 4) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        __m128i plo = _mm_unpacklo_epi8(p, zero);
+        __m128i phi = _mm_unpackhi_epi8(p, zero);
+
+        plo = div255_epu16(_mm_mullo_epi16(plo, _mm_or_si128(alpha_epu16(plo), amask)));
+        phi = div255_epu16(_mm_mullo_epi16(phi, _mm_or_si128(alpha_epu16(phi), amask)));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(row + i), _mm_packus_epi16(plo, phi));
+    }
+#endif
+
+    for (; i < count; i++)
+        row[i] = premultiply_pixel(row[i]);
+}
+
+static void opaque_row(uint32_t *row, int count)
+{
+    for (int i = 0; i < count; i++)
+        row[i] |= 0xFF000000;
+}
+
+/* source pixel formats */
+
+static inline uint32_t fetch_rgba8888(const uint8_t *row, int x)
+{
+    uint32_t p;
+    memcpy(&p, row + x * 4, 4);
+    return p;
+}
+
+static inline uint32_t fetch_rgbx8888(const uint8_t *row, int x)
+{
+    return fetch_rgba8888(row, x) | 0xFF000000;
+}
+
+static inline uint32_t fetch_bgra8888(const uint8_t *row, int x)
+{
+    uint32_t p = fetch_rgba8888(row, x);
+    return (p & 0xFF00FF00) | ((p >> 16) & 0xFF) | ((p & 0xFF) << 16);
+}
+
+static inline uint32_t fetch_rgb888(const uint8_t *row, int x)
+{
+    const uint8_t *p = row + x * 3;
+    return p[0] | (p[1] << 8) | (p[2] << 16) | 0xFF000000;
+}
+
+static inline uint32_t fetch_rgb565(const uint8_t *row, int x)
+{
+    uint16_t v;
+    memcpy(&v, row + x * 2, 2);
+
+    uint32_t r = (v >> 11) & 0x1F;
+    uint32_t g = (v >> 5) & 0x3F;
+    uint32_t b = v & 0x1F;
+
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+
+    return r | (g << 8) | (b << 16) | 0xFF000000;
+}
+
+static inline void store_rgba8888(uint8_t *row, int x, uint32_t p)
+{
+    memcpy(row + x * 4, &p, 4);
+}
+
+static inline void store_bgra8888(uint8_t *row, int x, uint32_t p)
+{
+    store_rgba8888(row, x, fetch_bgra8888(reinterpret_cast<uint8_t *>(&p), 0));
+}
+
+static inline void store_rgb888(uint8_t *row, int x, uint32_t p)
+{
+    uint8_t *d = row + x * 3;
+    d[0] = p & 0xFF;
+    d[1] = (p >> 8) & 0xFF;
+    d[2] = (p >> 16) & 0xFF;
+}
+
+static inline void store_rgb565(uint8_t *row, int x, uint32_t p)
+{
+    uint16_t v = static_cast<uint16_t>(((p & 0xF8) << 8) | ((p >> 5) & 0x07E0) | ((p >> 19) & 0x1F));
+    memcpy(row + x * 2, &v, 2);
+}
+
+typedef uint32_t (*sw_fetch_fn)(const uint8_t *row, int x);
+
+/* samplers of the source images */
+
+template <sw_fetch_fn FETCH>
+static void sample_copy(const SWLayer &layer, int tx, int ty, int count, uint32_t *out)
+{
+    const uint8_t *row = layer.image.base + layer.image.stride * ty;
+
+    for (int i = 0; i < count; i++)
+        out[i] = FETCH(row, tx + i);
+}
+
+template <sw_fetch_fn FETCH>
+static void sample_nearest(const SWLayer &layer, int tx, int ty, int count, uint32_t *out)
+{
+    int64_t sx = layer.ox + layer.xx * tx + layer.xy * ty + 0x8000;
+    int64_t sy = layer.oy + layer.yx * tx + layer.yy * ty + 0x8000;
+    int w = layer.image.width - 1;
+    int h = layer.image.height - 1;
+
+    for (int i = 0; i < count; i++) {
+        int x = std::min(std::max(static_cast<int>(sx >> 16), 0), w);
+        int y = std::min(std::max(static_cast<int>(sy >> 16), 0), h);
+
+        out[i] = FETCH(layer.image.base + layer.image.stride * y, x);
+
+        sx += layer.xx;
+        sy += layer.yx;
+    }
+}
+
+static inline void bilinear_clamp(int64_t pos, int limit, int &p0, int &p1, uint32_t &weight)
+{
+    p0 = static_cast<int>(pos >> 16);
+    weight = static_cast<uint32_t>((pos >> 8) & 0xFF);
+    if (p0 < 0) {
+        p0 = 0;
+        weight = 0;
+    } else if (p0 >= limit) {
+        p0 = limit;
+        weight = 0;
+    }
+    p1 = std::min(p0 + 1, limit);
+}
+
+template <sw_fetch_fn FETCH, bool PREMULTIPLY>
+static inline uint32_t fetch_texel(const uint8_t *row, int x)
+{
+    return PREMULTIPLY ? premultiply_pixel(FETCH(row, x)) : FETCH(row, x);
+}
+
+/*
+ * Texels are premultiplied before interpolation if required. Otherwise
+ * the colors of the transparent texels leak into the opaque texels.
+ */
+template <sw_fetch_fn FETCH, bool PREMULTIPLY>
+static void sample_bilinear(const SWLayer &layer, int tx, int ty, int count, uint32_t *out)
+{
+    int64_t sx = layer.ox + layer.xx * tx + layer.xy * ty;
+    int64_t sy = layer.oy + layer.yx * tx + layer.yy * ty;
+    int w = layer.image.width - 1;
+    int h = layer.image.height - 1;
+
+    for (int i = 0; i < count; i++) {
+        int x0, x1, y0, y1;
+        uint32_t wx, wy;
+
+        bilinear_clamp(sx, w, x0, x1, wx);
+        bilinear_clamp(sy, h, y0, y1, wy);
+
+        const uint8_t *row0 = layer.image.base + layer.image.stride * y0;
+        const uint8_t *row1 = layer.image.base + layer.image.stride * y1;
+        uint32_t top = lerp_pixel(fetch_texel<FETCH, PREMULTIPLY>(row0, x0),
+                                  fetch_texel<FETCH, PREMULTIPLY>(row0, x1), wx);
+        uint32_t bottom = lerp_pixel(fetch_texel<FETCH, PREMULTIPLY>(row1, x0),
+                                     fetch_texel<FETCH, PREMULTIPLY>(row1, x1), wx);
+
+        out[i] = lerp_pixel(top, bottom, wy);
+
+        sx += layer.xx;
+        sy += layer.yx;
+    }
+}
+
+struct SWFormat {
+    uint32_t format;
+    unsigned int bpp;
+    bool alpha;
+    sw_fetch_fn fetch;
+    sw_sample_fn copy;
+    sw_sample_fn nearest;
+    sw_sample_fn bilinear;
+    sw_sample_fn bilinear_premultiply;
+};
+
+#define SW_FORMAT(fmt, bpp, alpha, fetch) \
+    {fmt, bpp, alpha, fetch, sample_copy<fetch>, sample_nearest<fetch>, \
+     sample_bilinear<fetch, false>, sample_bilinear<fetch, true>}
+
+static const SWFormat sw_formats[] = {
+    SW_FORMAT(HAL_PIXEL_FORMAT_RGBA_8888, 4, true,  fetch_rgba8888),
+    SW_FORMAT(HAL_PIXEL_FORMAT_BGRA_8888, 4, true,  fetch_bgra8888),
+    SW_FORMAT(HAL_PIXEL_FORMAT_RGBX_8888, 4, false, fetch_rgbx8888),
+    SW_FORMAT(HAL_PIXEL_FORMAT_RGB_888,   3, false, fetch_rgb888),
+    SW_FORMAT(HAL_PIXEL_FORMAT_RGB_565,   2, false, fetch_rgb565),
+};
+
+static const SWFormat *find_sw_format(uint32_t fmt)
+{
+    for (auto &swfmt: sw_formats)
+        if (swfmt.format == fmt)
+            return &swfmt;
+    return NULL;
+}
+
+static void load_row(const SWImage &image, int x, int y, int count, uint32_t *out)
+{
+    const uint8_t *row = image.base + image.stride * y;
+
+    if (image.format == HAL_PIXEL_FORMAT_RGBA_8888) {
+        memcpy(out, row + x * 4, count * 4);
+        return;
+    }
+
+    sw_fetch_fn fetch = find_sw_format(image.format)->fetch;
+    for (int i = 0; i < count; i++)
+        out[i] = fetch(row, x + i);
+}
+
+static void store_row(const SWImage &image, int x, int y, int count, const uint32_t *in)
+{
+    uint8_t *row = image.base + image.stride * y;
+
+    switch (image.format) {
+    case HAL_PIXEL_FORMAT_RGBA_8888:
+    case HAL_PIXEL_FORMAT_RGBX_8888:
+        memcpy(row + x * 4, in, count * 4);
+        break;
+    case HAL_PIXEL_FORMAT_BGRA_8888:
+        for (int i = 0; i < count; i++)
+            store_bgra8888(row, x + i, in[i]);
+        break;
+    case HAL_PIXEL_FORMAT_RGB_888:
+        for (int i = 0; i < count; i++)
+            store_rgb888(row, x + i, in[i]);
+        break;
+    case HAL_PIXEL_FORMAT_RGB_565:
+        for (int i = 0; i < count; i++)
+            store_rgb565(row, x + i, in[i]);
+        break;
+    }
+}
+
+static bool map_image(AcrylicCanvas &canvas, hw2d_rect_t rect, SWImage &image, SWMappings &maps, int prot)
+{
+    const SWFormat *swfmt = find_sw_format(canvas.getFormat());
+    if (!swfmt) {
+        ALOGE("Format %#x is not supported by the S/W compositor", canvas.getFormat());
+        return false;
+    }
+
+    if (canvas.isProtected()) {
+        ALOGE("S/W compositor is not able to access protected buffers");
+        return false;
+    }
+
+    hw2d_coord_t xy = canvas.getImageDimension();
+    size_t stride = static_cast<size_t>(xy.hori) * swfmt->bpp;
+    size_t len = canvas.getBufferLength(0);
+    uint8_t *base;
+
+    if (canvas.getBufferType() == AcrylicCanvas::MT_DMABUF) {
+        if (canvas.getOffset(0) >= len) {
+            ALOGE("Offset %u is beyond the buffer length %zu", canvas.getOffset(0), len);
+            return false;
+        }
+
+        base = maps.map(canvas.getDmabuf(0), len, prot);
+        if (!base) {
+            ALOGERR("Failed to map dmabuf %d of %zu bytes", canvas.getDmabuf(0), len);
+            return false;
+        }
+
+        base += canvas.getOffset(0);
+        len -= canvas.getOffset(0);
+    } else if (canvas.getBufferType() == AcrylicCanvas::MT_USERPTR) {
+        base = reinterpret_cast<uint8_t *>(canvas.getUserptr(0));
+    } else {
+        ALOGE("Unknown buffer type %d", canvas.getBufferType());
+        return false;
+    }
+
+    if (len < stride * xy.vert) {
+        ALOGE("Too small buffer %zu bytes for %dx%d of format %#x",
+              len, xy.hori, xy.vert, canvas.getFormat());
+        return false;
+    }
+
+    image.base = base + stride * rect.pos.vert + swfmt->bpp * rect.pos.hori;
+    image.stride = stride;
+    image.width = rect.size.hori;
+    image.height = rect.size.vert;
+    image.format = canvas.getFormat();
+
+    return true;
+}
+
+static bool wait_fence(AcrylicCanvas &canvas)
+{
+    if (canvas.getFence() < 0)
+        return true;
+
+    // same as sync_wait() of libsync that is not available on the host
+    struct pollfd fds = {canvas.getFence(), POLLIN, 0};
+    int ret;
+
+    do {
+        ret = poll(&fds, 1, AcrylicCompositorSW::FENCE_TIMEOUT_MSEC);
+    } while ((ret < 0) && ((errno == EINTR) || (errno == EAGAIN)));
+
+    if (ret <= 0) {
+        if (ret == 0)
+            errno = ETIME;
+        ALOGERR("Failed to wait for fence %d", canvas.getFence());
+        return false;
+    }
+
+    if (!!(fds.revents & (POLLERR | POLLNVAL))) {
+        ALOGE("Fence %d is signaled with an error", canvas.getFence());
+        return false;
+    }
+
+    canvas.setFence(-1);
+
+    return true;
+}
+
+static sw_op_t blending_op(uint32_t mode)
+{
+    switch (mode) {
+    case HWC_BLENDING_NONE:
+    case HWC2_BLEND_MODE_NONE:
+        return SW_OP_OPAQUE;
+    case HWC_BLENDING_COVERAGE:
+    case HWC2_BLEND_MODE_COVERAGE:
+        return SW_OP_PREMULTIPLY;
+    }
+
+    return SW_OP_NONE;
+}
+
+/*
+ * Build the map from the target area to the crop area. The transform of HAL
+ * flips the image first and then rotates it. So the rotation is undone first.
+ * Every coordinate is the center of a pixel.
+ */
+static void setup_transform(SWLayer &swlayer, uint32_t transform)
+{
+    // (constant, coefficient of tx / tw, coefficient of ty / th)
+    int u[3] = {0, 1, 0};
+    int v[3] = {0, 0, 1};
+
+    if (!!(transform & HAL_TRANSFORM_ROT_90)) {
+        u[0] = 0; u[1] = 0; u[2] = 1;
+        v[0] = 1; v[1] = -1; v[2] = 0;
+    }
+
+    if (!!(transform & HAL_TRANSFORM_FLIP_H)) {
+        u[0] = 1 - u[0]; u[1] = -u[1]; u[2] = -u[2];
+    }
+
+    if (!!(transform & HAL_TRANSFORM_FLIP_V)) {
+        v[0] = 1 - v[0]; v[1] = -v[1]; v[2] = -v[2];
+    }
+
+    double sw = swlayer.image.width;
+    double sh = swlayer.image.height;
+    double tw = swlayer.target.size.hori;
+    double th = swlayer.target.size.vert;
+
+    swlayer.xx = llround(sw * u[1] / tw * 65536.0);
+    swlayer.xy = llround(sw * u[2] / th * 65536.0);
+    swlayer.ox = llround((sw * (u[0] + u[1] * 0.5 / tw + u[2] * 0.5 / th) - 0.5) * 65536.0);
+    swlayer.yx = llround(sh * v[1] / tw * 65536.0);
+    swlayer.yy = llround(sh * v[2] / th * 65536.0);
+    swlayer.oy = llround((sh * (v[0] + v[1] * 0.5 / tw + v[2] * 0.5 / th) - 0.5) * 65536.0);
+}
+
+static bool prepare_layer(AcrylicLayer &layer, hw2d_coord_t canvas_xy, SWLayer &swlayer, SWMappings &maps)
+{
+    swlayer.target = layer.getTargetRect();
+    if (area_is_zero(swlayer.target)) {
+        swlayer.target.pos = {0, 0};
+        swlayer.target.size = canvas_xy;
+    }
+
+    swlayer.op = blending_op(layer.getCompositingMode());
+    swlayer.alpha = layer.getPlaneAlpha();
+    swlayer.solid = layer.isSolidColor();
+
+    if (swlayer.solid) {
+        uint32_t argb = layer.getSolidColor();
+        uint32_t color = (argb & 0xFF00FF00) | ((argb >> 16) & 0xFF) | ((argb & 0xFF) << 16);
+
+        if (swlayer.op == SW_OP_OPAQUE)
+            color |= 0xFF000000;
+        else if (swlayer.op == SW_OP_PREMULTIPLY)
+            color = premultiply_pixel(color);
+
+        swlayer.color = color;
+        swlayer.opaque = (color >> 24) == 0xFF;
+        swlayer.sample = NULL;
+    } else {
+        if (!map_image(layer, layer.getImageRect(), swlayer.image, maps, PROT_READ))
+            return false;
+
+        const SWFormat *swfmt = find_sw_format(swlayer.image.format);
+        uint32_t transform = layer.getTransform();
+        hw2d_coord_t crop = layer.getImageRect().size;
+        hw2d_coord_t target = swlayer.target.size;
+
+        if (!swfmt->alpha)
+            swlayer.op = SW_OP_NONE;
+
+        if (!!(transform & HAL_TRANSFORM_ROT_90))
+            target.swap();
+
+        setup_transform(swlayer, transform);
+
+        bool resampling = crop != target;
+
+        if (!resampling && ((transform & (HAL_TRANSFORM_ROT_90 | HAL_TRANSFORM_FLIP_H | HAL_TRANSFORM_FLIP_V)) == 0))
+            swlayer.sample = swfmt->copy;
+        else if (!resampling || !!(layer.getCompositAttr() & AcrylicLayer::ATTR_NORESAMPLING))
+            swlayer.sample = swfmt->nearest;
+        else if (swlayer.op == SW_OP_PREMULTIPLY)
+            swlayer.sample = swfmt->bilinear_premultiply;
+        else
+            swlayer.sample = swfmt->bilinear;
+
+        // bilinear_premultiply does not require premultiplication after sampling
+        if (swlayer.sample == swfmt->bilinear_premultiply)
+            swlayer.op = SW_OP_NONE;
+
+        swlayer.opaque = !swfmt->alpha || (swlayer.op == SW_OP_OPAQUE);
+    }
+
+    swlayer.opaque = swlayer.opaque && (swlayer.alpha == 255);
+
+    return true;
+}
+
+static void compose_tile(const SWFrame &frame, int index)
+{
+    uint32_t acc[AcrylicCompositorSW::TILE_WIDTH];
+    uint32_t buf[AcrylicCompositorSW::TILE_WIDTH];
+    const SWImage &canvas = frame.canvas;
+    int left = (index % frame.tiles_per_row) * AcrylicCompositorSW::TILE_WIDTH;
+    int top = (index / frame.tiles_per_row) * AcrylicCompositorSW::TILE_HEIGHT;
+    int right = std::min(left + static_cast<int>(AcrylicCompositorSW::TILE_WIDTH), canvas.width);
+    int bottom = std::min(top + static_cast<int>(AcrylicCompositorSW::TILE_HEIGHT), canvas.height);
+    int width = right - left;
+
+    for (int y = top; y < bottom; y++) {
+        bool touched = frame.has_background;
+
+        if (frame.has_background)
+            std::fill(acc, acc + width, frame.background);
+        else
+            load_row(canvas, left, y, width, acc);
+
+        for (auto &layer: frame.layers) {
+            int ty = y - layer.target.pos.vert;
+            if ((ty < 0) || (ty >= layer.target.size.vert))
+                continue;
+
+            int x0 = std::max(left, static_cast<int>(layer.target.pos.hori));
+            int x1 = std::min(right, layer.target.pos.hori + layer.target.size.hori);
+            if (x0 >= x1)
+                continue;
+
+            uint32_t *out = acc + x0 - left;
+            int count = x1 - x0;
+
+            if (layer.solid) {
+                if (layer.opaque) {
+                    std::fill(out, out + count, layer.color);
+                } else {
+                    std::fill(buf, buf + count, layer.color);
+                    blend_row(out, buf, count, layer.alpha);
+                }
+            } else {
+                // opaque layers are sampled into the accumulator directly
+                uint32_t *dst = layer.opaque ? out : buf;
+
+                layer.sample(layer, x0 - layer.target.pos.hori, ty, count, dst);
+
+                if (layer.op == SW_OP_OPAQUE)
+                    opaque_row(dst, count);
+                else if (layer.op == SW_OP_PREMULTIPLY)
+                    premultiply_row(dst, count);
+
+                if (!layer.opaque)
+                    blend_row(out, buf, count, layer.alpha);
+            }
+
+            touched = true;
+        }
+
+        if (touched)
+            store_row(canvas, left, y, width, acc);
+    }
+}
+
+} // namespace
+
+AcrylicCompositorSW::AcrylicCompositorSW(const HW2DCapability &capability)
+    : Acrylic(capability), mWorkers(0), mLaptimeUSec(0)
+{
+    ALOGD_TEST("Created a new Acrylic for S/W compositor on %p", this);
+}
+
+AcrylicCompositorSW::~AcrylicCompositorSW()
+{
+    ALOGD_TEST("Deleting Acrylic for S/W compositor %p", this);
+}
+
+bool AcrylicCompositorSW::executeSW()
+{
+    if (!validateAllLayers())
+        return false;
+
+    sortLayers();
+
+    SWMappings maps;
+    SWFrame frame;
+    AcrylicCanvas &canvas = getCanvas();
+    hw2d_coord_t xy = canvas.getImageDimension();
+    hw2d_rect_t rect = {{0, 0}, xy};
+    AcrylicStageTimer prepareTimer;
+
+    if (!map_image(canvas, rect, frame.canvas, maps, PROT_READ | PROT_WRITE))
+        return false;
+
+    frame.layers.resize(layerCount());
+    for (unsigned int i = 0; i < layerCount(); i++) {
+        if (!prepare_layer(*getLayer(i), xy, frame.layers[i], maps))
+            return false;
+    }
+
+    frame.has_background = hasBackgroundColor();
+    if (frame.has_background) {
+        uint16_t r, g, b, a;
+
+        getBackgroundColor(&r, &g, &b, &a);
+        frame.background = (r >> 8) | ((g >> 8) << 8) | ((b >> 8) << 16) | ((a >> 8) << 24);
+    }
+
+    setPrepareTimeUSec(prepareTimer.elapsedUSec());
+
+    // Waiting for the fences after the parameters are verified
+    for (unsigned int i = 0; i < layerCount(); i++) {
+        if (!wait_fence(*getLayer(i)))
+            return false;
+    }
+
+    if (!wait_fence(canvas))
+        return false;
+
+    AcrylicStageTimer composeTimer;
+
+    frame.tiles_per_row = (xy.hori + TILE_WIDTH - 1) / TILE_WIDTH;
+
+    int num_tiles = frame.tiles_per_row * ((xy.vert + TILE_HEIGHT - 1) / TILE_HEIGHT);
+    unsigned int workers = mWorkers;
+
+    if (workers == 0)
+        workers = std::max(std::thread::hardware_concurrency(), 1U);
+    workers = std::min(workers, static_cast<unsigned int>(MAX_WORKERS));
+    workers = std::min(workers, static_cast<unsigned int>(num_tiles));
+
+    if (workers > 1) {
+        std::vector<std::function<void()>> tasks;
+
+        tasks.reserve(num_tiles);
+        for (int i = 0; i < num_tiles; i++)
+            tasks.emplace_back([&frame, i] { compose_tile(frame, i); });
+
+        ExynosWorkerPool::getInstance().run(tasks, workers);
+    } else {
+        for (int i = 0; i < num_tiles; i++)
+            compose_tile(frame, i);
+    }
+
+    mLaptimeUSec = composeTimer.elapsedUSec();
+
+    ALOGD_TEST("Composited %u layers to %dx%d with %u workers in %u usec",
+               layerCount(), xy.hori, xy.vert, workers, mLaptimeUSec);
+
+    getCanvas().clearSettingModified();
+    getCanvas().setFence(-1);
+
+    for (unsigned int i = 0; i < layerCount(); i++) {
+        getLayer(i)->clearSettingModified();
+        getLayer(i)->setFence(-1);
+    }
+
+    return true;
+}
+
+bool AcrylicCompositorSW::execute(int fence[], unsigned int num_fences)
+{
+    if (!executeSW()) {
+        // Clearing all acquire fences because their buffers are expired.
+        // The clients should configure everything again to start new execution
+        for (unsigned int i = 0; i < layerCount(); i++)
+            getLayer(i)->setFence(-1);
+        getCanvas().setFence(-1);
+
+        return false;
+    }
+
+    // The composition is already completed. No release fence is required.
+    for (unsigned int i = 0; i < num_fences; i++)
+        fence[i] = -1;
+
+    return true;
+}
+
+bool AcrylicCompositorSW::execute(int *handle)
+{
+    if (!executeSW()) {
+        for (unsigned int i = 0; i < layerCount(); i++)
+            getLayer(i)->setFence(-1);
+        getCanvas().setFence(-1);
+
+        return false;
+    }
+
+    if (handle != NULL)
+        *handle = 0;
+
+    return true;
+}
+
+bool AcrylicCompositorSW::waitExecution(int __unused handle)
+{
+    ALOGD_TEST("Waiting for execution of S/W compositor by handle %d", handle);
+
+    return true;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HARDWARE_EXYNOS_HW2DCOMPOSITOR_SW_H__
+#define __HARDWARE_EXYNOS_HW2DCOMPOSITOR_SW_H__
+
+#include <hardware/exynos/acryl.h>
+
+/*
+ * AcrylicCompositorSW - Compositor that runs on the CPU
+ *
+ * It blends the source layers into the target image in the z-order with the
+ * same blending equations as G2D. The target image is divided into tiles
+ * and the tiles are composited by a pool of worker threads. It reads and
+ * writes RGB images only and it does not convert dataspaces.
+ * execute() does not return until the composition completes. Therefore the
+ * release fences given by execute() are always -1.
+ */
+class AcrylicCompositorSW: public Acrylic {
+public:
+    enum {
+        TILE_WIDTH = 256,
+        TILE_HEIGHT = 32,
+        MAX_WORKERS = 4,
+        FENCE_TIMEOUT_MSEC = 1000,
+    };
+
+    AcrylicCompositorSW(const HW2DCapability &capability);
+    virtual ~AcrylicCompositorSW();
+    virtual bool execute(int fence[], unsigned int num_fences);
+    virtual bool execute(int *handle = NULL);
+    virtual bool waitExecution(int handle);
+    virtual unsigned int getLaptimeUSec() { return mLaptimeUSec; }
+
+    /*
+     * Configure the number of threads that composite the tiles including the
+     * thread that calls execute(). 0 selects the number of CPUs up to MAX_WORKERS.
+     */
+    void setWorkers(unsigned int workers) { mWorkers = workers; }
+private:
+    bool executeSW();
+
+    unsigned int mWorkers;
+    unsigned int mLaptimeUSec;
+};
+
+#endif /* __HARDWARE_EXYNOS_HW2DCOMPOSITOR_SW_H__ */
@@ -0,0 +1,264 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <log/log.h>
+#include <hardware/exynos/ion.h>
+#include <hardware/exynos/acryl.h>
+
+#include "acrylic_internal.h"
+#include "acrylic_transit_pool.h"
+
+AcrylicTransitBufferPool &AcrylicTransitBufferPool::getInstance()
+{
+    // Never destroyed to allow the compositors destroyed during the process
+    // termination to return their buffers.
+    static AcrylicTransitBufferPool *pool = new AcrylicTransitBufferPool();
+
+    return *pool;
+}
+
+AcrylicTransitBufferPool::AcrylicTransitBufferPool()
+    : mStamp(0), mClientION(-1)
+{
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+AcrylicTransitBufferPool::~AcrylicTransitBufferPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        evictLocked(mStats.bytesHeld - mStats.bytesIdle);
+    }
+
+    if (mClientION >= 0)
+        close(mClientION);
+}
+
+size_t AcrylicTransitBufferPool::getBucketSize(size_t len)
+{
+    size_t octave = MIN_BUCKET_SIZE;
+
+    if (len <= octave)
+        return octave;
+
+    while (octave < len)
+        octave <<= 1;
+
+    // four buckets between octave / 2 and octave
+    size_t step = octave / 8;
+    size_t bucket = octave / 2;
+
+    while (bucket < len)
+        bucket += step;
+
+    return bucket;
+}
+
+int AcrylicTransitBufferPool::allocate(size_t len, bool drm_protected)
+{
+    if (mClientION < 0) {
+        mClientION = open("/dev/ion", O_RDWR);
+        if (mClientION < 0) {
+            ALOGERR("Failed to open /dev/ion");
+            return -1;
+        }
+    }
+
+    unsigned int heapmask = drm_protected ? EXYNOS_ION_HEAP_VIDEO_SCALER_MASK : EXYNOS_ION_HEAP_SYSTEM_MASK;
+    unsigned int flags = drm_protected ? ION_FLAG_PROTECTED : ION_FLAG_NOZEROED;
+    int buf_fd;
+
+    buf_fd = exynos_ion_alloc(mClientION, len, heapmask, flags);
+    if (buf_fd < 0)
+        ALOGERR("Failed to allocate %zu bytes from ION heap mask %#x with flag %#x",
+                len, heapmask, flags);
+
+    return buf_fd;
+}
+
+int AcrylicTransitBufferPool::acquire(size_t len, bool drm_protected, size_t *buflen, int *fence)
+{
+    size_t bucket = getBucketSize(len);
+    std::lock_guard<std::mutex> lock(mLock);
+    std::list<Buffer> &arena = mArena[drm_protected ? 1 : 0];
+
+    *fence = -1;
+
+    trimLocked(std::chrono::steady_clock::now());
+
+    // Choose the smallest idle buffer that is not more than twice larger than
+    // the bucket. The buffers in the list are few enough to scan them all.
+    auto found = arena.end();
+    for (auto it = arena.begin(); it != arena.end(); ++it) {
+        if ((it->len < bucket) || (it->len > bucket * 2))
+            continue;
+        if ((found == arena.end()) || (it->len < found->len))
+            found = it;
+    }
+
+    if (found != arena.end()) {
+        int fd = found->fd;
+
+        *buflen = found->len;
+        *fence = found->fence;
+        mStats.bytesIdle -= found->len;
+        mStats.buffersIdle--;
+        mStats.hits++;
+        arena.erase(found);
+
+        ALOGD_TEST("Reused transit buffer fd %d of %zu bytes for %zu bytes (fence %d)",
+                   fd, *buflen, len, *fence);
+
+        return fd;
+    }
+
+    mStats.misses++;
+
+    // Make room for the new buffer with the idle buffers not suitable for this request
+    evictLocked((MAX_BYTES > bucket) ? (MAX_BYTES - bucket) : 0);
+
+    int fd = allocate(bucket, drm_protected);
+    if (fd < 0)
+        return -1;
+
+    *buflen = bucket;
+    mStats.bytesHeld += bucket;
+    if (mStats.bytesHeld > mStats.bytesPeak)
+        mStats.bytesPeak = mStats.bytesHeld;
+
+    ALOGD_TEST("Allocated transit buffer fd %d of %zu bytes for %zu bytes (held %zu bytes)",
+               fd, bucket, len, mStats.bytesHeld);
+
+    return fd;
+}
+
+void AcrylicTransitBufferPool::release(int fd, size_t buflen, bool drm_protected, int fence)
+{
+    if (fd < 0) {
+        if (fence >= 0)
+            close(fence);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+    auto now = std::chrono::steady_clock::now();
+
+    mArena[drm_protected ? 1 : 0].push_front({fd, buflen, mStamp++, now, fence});
+    mStats.bytesIdle += buflen;
+    mStats.buffersIdle++;
+
+    evictLocked(MAX_BYTES);
+    trimLocked(now);
+}
+
+void AcrylicTransitBufferPool::freeBuffer(Buffer &buf)
+{
+    ALOGD_TEST("Freeing transit buffer fd %d of %zu bytes", buf.fd, buf.len);
+
+    if (buf.fence >= 0)
+        close(buf.fence);
+    close(buf.fd);
+    mStats.bytesHeld -= buf.len;
+    mStats.bytesIdle -= buf.len;
+    mStats.buffersIdle--;
+}
+
+void AcrylicTransitBufferPool::evictLocked(size_t max_bytes)
+{
+    while ((mStats.bytesHeld > max_bytes) && (mStats.buffersIdle > 0)) {
+        std::list<Buffer> *victim;
+
+        // The least recently released buffer is at the back of the arenas
+        if (mArena[0].empty())
+            victim = &mArena[1];
+        else if (mArena[1].empty())
+            victim = &mArena[0];
+        else
+            victim = (mArena[0].back().stamp < mArena[1].back().stamp) ? &mArena[0] : &mArena[1];
+
+        freeBuffer(victim->back());
+        mStats.evictions++;
+        victim->pop_back();
+    }
+}
+
+unsigned int AcrylicTransitBufferPool::trimLocked(std::chrono::steady_clock::time_point now)
+{
+    auto timeout = std::chrono::milliseconds(TRIM_TIMEOUT_MSEC);
+    unsigned int next = 0;
+
+    for (auto &arena : mArena) {
+        while (!arena.empty()) {
+            Buffer &buf = arena.back();
+            auto expire = buf.releaseTime + timeout;
+
+            if (expire > now) {
+                unsigned int msec = static_cast<unsigned int>(
+                        std::chrono::duration_cast<std::chrono::milliseconds>(expire - now).count()) + 1;
+                if ((next == 0) || (msec < next))
+                    next = msec;
+                break;
+            }
+
+            freeBuffer(buf);
+            mStats.trimmed++;
+            arena.pop_back();
+        }
+    }
+
+    return next;
+}
+
+unsigned int AcrylicTransitBufferPool::trim()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    return trimLocked(std::chrono::steady_clock::now());
+}
+
+void AcrylicTransitBufferPool::dump(std::string &result)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    char buf[256];
+
+    snprintf(buf, sizeof(buf),
+             "libacryl transit buffers: held %zu bytes (peak %zu, max %d), %u idle of %zu bytes\n"
+             "\thits %" PRIu64 ", misses %" PRIu64 ", evictions %" PRIu64 ", trimmed %" PRIu64 "\n",
+             mStats.bytesHeld, mStats.bytesPeak, MAX_BYTES, mStats.buffersIdle, mStats.bytesIdle,
+             mStats.hits, mStats.misses, mStats.evictions, mStats.trimmed);
+    result += buf;
+}
+
+unsigned int Acrylic::trimTransitBuffers()
+{
+    return AcrylicTransitBufferPool::getInstance().trim();
+}
+
+void Acrylic::dumpTransitBuffers(std::string &result)
+{
+    AcrylicTransitBufferPool::getInstance().dump(result);
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HARDWARE_EXYNOS_ACRYLIC_TRANSIT_POOL_H__
+#define __HARDWARE_EXYNOS_ACRYLIC_TRANSIT_POOL_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <string>
+
+/*
+ * AcrylicTransitBufferPool - Pool of the intermediate buffers for prescaling
+ *
+ * The buffers are allocated from ION in the size of buckets. There are four
+ * buckets in a power of two range so that a buffer of a bucket is reused for
+ * the images of slightly different sizes without wasting more than a quarter
+ * of the buffer. The idle buffers are kept in two arenas, one for the DRM
+ * protected buffers and the other for the normal buffers. The least recently
+ * released buffers are freed first when the total size of the buffers held by
+ * the pool exceeds MAX_BYTES. The buffers idle longer than TRIM_TIMEOUT_MSEC
+ * are freed by trim() that is called on every access and by the users that
+ * wake up periodically.
+ * A buffer is kept with the fence of the last task that accesses it because
+ * the tasks of different compositors may complete out of order. The next
+ * user of the buffer should not write to it before the fence is signaled.
+ * The pool is shared by all compositor instances in the process.
+ */
+class AcrylicTransitBufferPool {
+public:
+    enum {
+        MIN_BUCKET_SIZE = 64 * 1024,
+        MAX_BYTES = 64 * 1024 * 1024,
+        TRIM_TIMEOUT_MSEC = 3000,
+    };
+
+    struct Stats {
+        uint64_t hits;          // acquire() returned an idle buffer
+        uint64_t misses;        // acquire() allocated a new buffer
+        uint64_t evictions;     // idle buffers freed to keep MAX_BYTES
+        uint64_t trimmed;       // idle buffers freed by the timeout
+        size_t bytesHeld;       // both of the idle buffers and the buffers in use
+        size_t bytesIdle;
+        size_t bytesPeak;       // the peak of bytesHeld
+        unsigned int buffersIdle;
+    };
+
+    static AcrylicTransitBufferPool &getInstance();
+
+    /*
+     * Return a dmabuf fd of a buffer not smaller than @len or -1 on failure.
+     * The actual length of the buffer is stored to @buflen. The buffer should
+     * be returned with release() with the same @buflen and @drm_protected.
+     * @fence is the fence of the last task that accessed the buffer or -1.
+     * The caller owns *@fence and should wait for it before writing the buffer.
+     */
+    int acquire(size_t len, bool drm_protected, size_t *buflen, int *fence);
+    /*
+     * Return @fd to the pool. @fence is signaled when the last task that
+     * accesses the buffer completes. The pool owns @fence.
+     */
+    void release(int fd, size_t buflen, bool drm_protected, int fence);
+    /*
+     * Free the buffers idle longer than TRIM_TIMEOUT_MSEC. Return the time in
+     * milliseconds until the next idle buffer expires or 0 if no buffer is idle.
+     */
+    unsigned int trim();
+    void dump(std::string &result);
+
+    static size_t getBucketSize(size_t len);
+private:
+    struct Buffer {
+        int fd;
+        size_t len;
+        uint64_t stamp;
+        std::chrono::steady_clock::time_point releaseTime;
+        int fence;
+    };
+
+    AcrylicTransitBufferPool();
+    ~AcrylicTransitBufferPool();
+
+    int allocate(size_t len, bool drm_protected);
+    void freeBuffer(Buffer &buf);
+    // Free the least recently released buffers until the pool holds no more than @max_bytes
+    void evictLocked(size_t max_bytes);
+    unsigned int trimLocked(std::chrono::steady_clock::time_point now);
+
+    std::mutex mLock;
+    // The most recently released buffer is at the front
+    std::list<Buffer> mArena[2];
+    uint64_t mStamp;
+    int mClientION;
+    Stats mStats;
+};
+
+#endif //__HARDWARE_EXYNOS_ACRYLIC_TRANSIT_POOL_H__
@@ -17,6 +17,7 @@
 #ifndef __HARDWARE_EXYNOS_ACRYLIC_H__
 #define __HARDWARE_EXYNOS_ACRYLIC_H__
 
+#include <string>
 #include <vector>
 #include <cstdint>
 #include <unistd.h>
@@ -471,6 +472,15 @@ public:
      *                            it is not applied to HW yet.
      * - SETTING_DIMENSION_MODIFIED: Image dimension information is configured by users
      *                               and it is not applied to HW yet.
+     * - SETTING_ATTRIBUTE_MODIFIED: The attributes of the buffer like ATTR_PROTECTED are
+     *                               changed and it is not applied to HW yet.
+     * - SETTING_COMPOSIT_MODIFIED: The compositing properties of AcrylicLayer including
+     *                              the crop, the window, the transform, the blending mode,
+     *                              the plane alpha and the z-order are changed and it is
+     *                              not applied to HW yet.
+     * Unlike the other modified flags, SETTING_ATTRIBUTE_MODIFIED and
+     * SETTING_COMPOSIT_MODIFIED are set only if the configured value is
+     * different from the previous value.
      */
     enum setting_check_t {
         SETTING_TYPE = 1,
@@ -480,7 +490,11 @@ public:
         SETTING_TYPE_MODIFIED = 16,
         SETTING_BUFFER_MODIFIED = 32,
         SETTING_DIMENSION_MODIFIED = 64,
-        SETTIMG_MODIFIED_MASK = SETTING_TYPE_MODIFIED | SETTING_BUFFER_MODIFIED | SETTING_DIMENSION_MODIFIED,
+        SETTING_ATTRIBUTE_MODIFIED = 128,
+        SETTING_COMPOSIT_MODIFIED = 256,
+        SETTIMG_MODIFIED_MASK = SETTING_TYPE_MODIFIED | SETTING_BUFFER_MODIFIED | SETTING_DIMENSION_MODIFIED |
+                                SETTING_ATTRIBUTE_MODIFIED | SETTING_COMPOSIT_MODIFIED,
+        SETTING_CONFIG_MODIFIED_MASK = SETTIMG_MODIFIED_MASK & ~SETTING_BUFFER_MODIFIED,
     };
 
     /*
@@ -646,10 +660,15 @@ public:
      */
     void clearSettingModified()
     {
-        unset(SETTING_TYPE_MODIFIED |
-              SETTING_BUFFER_MODIFIED |
-              SETTING_DIMENSION_MODIFIED);
+        unset(SETTIMG_MODIFIED_MASK);
     }
+    /*
+     * Determine if any configuration other than the buffer and the fence is
+     * modified since the last execution. If not, the implementations of Acrylic
+     * may reuse the result of the validation and the H/W descriptors of the
+     * previous execution with the buffer and the fence replaced.
+     */
+    bool isConfigModified() { return !!(mSettingFlags & SETTING_CONFIG_MODIFIED_MASK); }
     /*
      * Obtain the flags that indicates the configuration status
      */
@@ -679,6 +698,7 @@ private:
      * that no Acrylic has a reference to it.
      */
     void disconnectLayer() { mCompositor = NULL; }
+    void setAttributes(uint32_t attr);
 
     hw2d_coord_t mImageDimension;
     uint32_t mPixFormat;
@@ -965,6 +985,15 @@ public:
     static Acrylic *createCompositor();
     static Acrylic *createScaler();
     static Acrylic *createBlter();
+    /*
+     * The intermediate buffers of multi-pass processing like prescaling are
+     * shared by all instances in the process and kept idle for reuse.
+     * trimTransitBuffers() frees the buffers idle for long and returns the time
+     * in milliseconds until it should be called again or 0 if no buffer is idle.
+     * dumpTransitBuffers() appends the statistics of the buffers to @result.
+     */
+    static unsigned int trimTransitBuffers();
+    static void dumpTransitBuffers(std::string &result);
 
     Acrylic(const HW2DCapability &capability);
     virtual ~Acrylic();
@@ -1130,11 +1159,31 @@ public:
      * is released after the wait completes.
      */
     virtual bool waitExecution(int handle) = 0;
+    /*
+     * Run HW 2D without waiting for the completion and store the fence that
+     * is signaled when the target image is written by HW 2D to @release_fence.
+     * The release fences of the source images are not provided. The caller
+     * should close *release_fence if it is not -1.
+     * The implementations that are not able to give the release fence of the
+     * target image do not return until HW 2D completes the processing. Then,
+     * *release_fence is -1.
+     */
+    virtual bool executeAsync(int *release_fence);
     /*
      * Return the last execution time of the H/W in micro seconds.
      * It is only vaild when the last call to execute() succeeded.
      */
     virtual unsigned int getLaptimeUSec() { return 0; }
+    /*
+     * Return the time in micro seconds spent by the CPU in the last execute()
+     * to validate the layers, to sort the layers and to prepare the images
+     * for the H/W. They show the overhead of libacryl apart from the H/W
+     * processing time given by getLaptimeUSec(). An implementation that does
+     * not prepare the images separately returns 0 for getPrepareTimeUSec().
+     */
+    unsigned int getValidateTimeUSec() { return mValidateTimeUSec; }
+    unsigned int getSortTimeUSec() { return mSortTimeUSec; }
+    unsigned int getPrepareTimeUSec() { return mPrepareTimeUSec; }
     /*
      * Configure the priority of the image processing tasks requested
      * to this compositor object. The default priority is -1 and the
@@ -1199,6 +1248,7 @@ protected:
     uint16_t getMaxTargetDisplayLuminance() { return mMaxTargetLuminance; }
     uint16_t getMinTargetDisplayLuminance() { return mMinTargetLuminance; }
     void *getTargetDisplayInfo() { return mTargetDisplayInfo; }
+    void setPrepareTimeUSec(unsigned int usec) { mPrepareTimeUSec = usec; }
 private:
     std::vector<AcrylicLayer *> mLayers;
     const HW2DCapability &mCapability;
@@ -1212,6 +1262,10 @@ private:
     uint16_t mMaxTargetLuminance;
     uint16_t mMinTargetLuminance;
     void *mTargetDisplayInfo;
+    unsigned int mValidateTimeUSec;
+    unsigned int mSortTimeUSec;
+    unsigned int mPrepareTimeUSec;
+    bool mValidated;
     AcrylicCanvas mCanvas;
 };
 
@@ -0,0 +1,61 @@
+# Copyright (C) 2016 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+#### Benchmark of the compositors of libacryl ####
+
+LOCAL_PATH:= $(call my-dir)
+
+# against the compositors of the device
+include $(CLEAR_VARS)
+LOCAL_CFLAGS += -DLOG_TAG=\"libacryl_bench\"
+LOCAL_SHARED_LIBRARIES := liblog libacryl
+LOCAL_HEADER_LIBRARIES := libexynos_headers
+LOCAL_SRC_FILES := acrylic_bench.cpp
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := libacryl_bench
+ifeq ($(BOARD_USES_VENDORIMAGE), true)
+LOCAL_PROPRIETARY_MODULE := true
+endif
+include $(BUILD_EXECUTABLE)
+
+# against the S/W and the dummy compositors on the host
+include $(CLEAR_VARS)
+LOCAL_CFLAGS += -O2 -DLOG_TAG=\"libacryl_bench\" -DLIBACRYL_SW_ONLY
+LOCAL_CFLAGS += -DLIBACRYL_DEFAULT_COMPOSITOR=\"sw\"
+LOCAL_CFLAGS += -DLIBACRYL_DEFAULT_SCALER=\"sw\"
+LOCAL_CFLAGS += -DLIBACRYL_DEFAULT_BLTER=\"sw\"
+LOCAL_LDLIBS := -lpthread
+LOCAL_SHARED_LIBRARIES := liblog
+LOCAL_HEADER_LIBRARIES := libhardware_headers libsystem_headers
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/.. $(LOCAL_PATH)/../include $(LOCAL_PATH)/../local_include
+LOCAL_C_INCLUDES += $(TOP)/hardware/samsung_slsi/exynos/include
+LOCAL_C_INCLUDES += $(TOP)/hardware/samsung_slsi/graphics/base/include
+LOCAL_SRC_FILES := acrylic_bench.cpp
+LOCAL_SRC_FILES += ../acrylic.cpp ../acrylic_layer.cpp ../acrylic_factory.cpp
+LOCAL_SRC_FILES += ../acrylic_dummy.cpp ../acrylic_sw.cpp
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := libacryl_bench_host
+include $(BUILD_HOST_EXECUTABLE)
+
+# calibration of the bandwidth model of the compositors on the host
+include $(CLEAR_VARS)
+LOCAL_CFLAGS += -DLOG_TAG=\"libacryl_bwfit\"
+LOCAL_SHARED_LIBRARIES := liblog
+LOCAL_HEADER_LIBRARIES := libhardware_headers libsystem_headers
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/.. $(LOCAL_PATH)/../include $(LOCAL_PATH)/../local_include
+LOCAL_C_INCLUDES += $(TOP)/hardware/samsung_slsi/exynos/include
+LOCAL_SRC_FILES := acrylic_bwfit.cpp ../acrylic_bandwidth.cpp
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := libacryl_bwfit
+include $(BUILD_HOST_EXECUTABLE)
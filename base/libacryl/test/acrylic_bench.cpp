@@ -0,0 +1,413 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+#include <unistd.h>
+
+#include <hardware/hwcomposer.h>
+#include <hardware/exynos/acryl.h>
+
+#include <exynos_format.h> // hardware/smasung_slsi/exynos/include
+
+/*
+ * Benchmark of the compositors of libacryl.
+ * It composites synthetic layer stacks with the compositor created by
+ * Acrylic::createInstance(spec) and reports the CPU time of each stage of
+ * execute() in JSON. The scenarios vary one of the layer count, the source
+ * format, the scaling ratio, the rotation and AFBC from the base scenario of
+ * 4 layers of RGBA8888 without scaling and rotation. Scenarios that are not
+ * supported by the compositor are reported with "unsupported" status.
+ * The host build runs against the "sw" and "dummy" compositors.
+ *
+ * usage: libacryl_bench [-s spec] [-n frames] [-t WxH] [-o output.json]
+ */
+
+#define ALIGN_UP(v, a) ((((v) + (a) - 1) / (a)) * (a))
+
+struct BenchFormat {
+    uint32_t fmt;
+    const char *name;
+    unsigned int planes;
+    unsigned int bpp[MAX_HW2D_PLANES]; // bits per pixel of each plane with extra for padding
+};
+
+// the formats in all_fimg2d_formats of acrylic_factory.cpp
+static const BenchFormat formats[] = {
+    {HAL_PIXEL_FORMAT_RGBA_8888,                        "RGBA_8888",         1, {32}},
+    {HAL_PIXEL_FORMAT_BGRA_8888,                        "BGRA_8888",         1, {32}},
+    {HAL_PIXEL_FORMAT_RGBX_8888,                        "RGBX_8888",         1, {32}},
+    {HAL_PIXEL_FORMAT_RGB_888,                          "RGB_888",           1, {24}},
+    {HAL_PIXEL_FORMAT_RGB_565,                          "RGB_565",           1, {16}},
+    {HAL_PIXEL_FORMAT_YCrCb_420_SP,                     "NV21",              1, {12}},
+    {HAL_PIXEL_FORMAT_EXYNOS_YCrCb_420_SP_M,            "NV21M",             2, {8, 4}},
+    {HAL_PIXEL_FORMAT_EXYNOS_YCrCb_420_SP_M_FULL,       "NV21M_FULL",        2, {8, 4}},
+    {HAL_PIXEL_FORMAT_EXYNOS_YCbCr_420_SP,              "NV12",              1, {12}},
+    {HAL_PIXEL_FORMAT_EXYNOS_YCbCr_420_SPN,             "NV12N",             1, {16}},
+    {HAL_PIXEL_FORMAT_EXYNOS_YCbCr_420_SP_M,            "NV12M",             2, {8, 4}},
+    {HAL_PIXEL_FORMAT_EXYNOS_YCbCr_420_SP_M_PRIV,       "NV12M_PRIV",        3, {8, 4, 8}},
+    {HAL_PIXEL_FORMAT_EXYNOS_YCbCr_420_SPN_S10B,        "NV12N_S10B",        1, {24}},
+    {HAL_PIXEL_FORMAT_EXYNOS_YCbCr_420_SP_M_S10B,       "NV12M_S10B",        2, {16, 8}},
+    {HAL_PIXEL_FORMAT_YCbCr_422_I,                      "YUYV",              1, {16}},
+    {HAL_PIXEL_FORMAT_EXYNOS_YCrCb_422_I,               "YVYU",              1, {16}},
+    {HAL_PIXEL_FORMAT_YCbCr_422_SP,                     "NV16",              1, {16}},
+};
+
+struct Scenario {
+    unsigned int layers;
+    const BenchFormat *format;
+    double scale; // source size divided by target size
+    unsigned int rotation;
+    bool afbc;
+};
+
+struct Stat {
+    double mean;
+    unsigned int min, p50, p95, max;
+};
+
+static Stat getStat(std::vector<unsigned int> &samples)
+{
+    Stat stat = {0, 0, 0, 0, 0};
+
+    if (samples.empty())
+        return stat;
+
+    std::sort(samples.begin(), samples.end());
+
+    for (auto sample: samples)
+        stat.mean += sample;
+    stat.mean /= samples.size();
+    stat.min = samples.front();
+    stat.p50 = samples[samples.size() / 2];
+    stat.p95 = samples[std::min(samples.size() - 1, (samples.size() * 95) / 100)];
+    stat.max = samples.back();
+
+    return stat;
+}
+
+class Buffer {
+public:
+    Buffer(const BenchFormat &fmt, unsigned int width, unsigned int height, unsigned int seed)
+        : mCount(fmt.planes)
+    {
+        size_t pixels = ALIGN_UP(width, 64) * ALIGN_UP(height, 64);
+
+        for (unsigned int i = 0; i < mCount; i++) {
+            mPlanes[i].resize(pixels * fmt.bpp[i] / 8);
+            // deterministic contents to compare the outputs between builds
+            for (size_t j = 0; j < mPlanes[i].size(); j++) {
+                seed = seed * 1103515245 + 12345;
+                mPlanes[i][j] = static_cast<uint8_t>(seed >> 16);
+            }
+        }
+    }
+
+    bool attach(AcrylicCanvas &canvas, uint32_t attr = AcrylicCanvas::ATTR_NONE)
+    {
+        void *addr[MAX_HW2D_PLANES];
+        size_t len[MAX_HW2D_PLANES];
+
+        for (unsigned int i = 0; i < mCount; i++) {
+            addr[i] = mPlanes[i].data();
+            len[i] = mPlanes[i].size();
+        }
+
+        return canvas.setImageBuffer(addr, len, mCount, attr);
+    }
+
+    uint32_t hash()
+    {
+        uint32_t hash = 2166136261U;
+
+        for (unsigned int i = 0; i < mCount; i++)
+            for (auto byte: mPlanes[i])
+                hash = (hash ^ byte) * 16777619U;
+
+        return hash;
+    }
+private:
+    unsigned int mCount;
+    std::vector<uint8_t> mPlanes[MAX_HW2D_PLANES];
+};
+
+static uint32_t halTransform(unsigned int rotation)
+{
+    switch (rotation) {
+    case 90:
+        return HAL_TRANSFORM_ROT_90;
+    case 180:
+        return HAL_TRANSFORM_ROT_180;
+    case 270:
+        return HAL_TRANSFORM_ROT_270;
+    }
+
+    return 0;
+}
+
+class Bench {
+public:
+    Bench(const char *spec, unsigned int frames, unsigned int width, unsigned int height, FILE *out)
+        : mSpec(spec), mFrames(frames), mWidth(width), mHeight(height), mOut(out), mCount(0) { }
+
+    void begin()
+    {
+        fprintf(mOut, "{\n  \"spec\": \"%s\",\n", mSpec);
+        fprintf(mOut, "  \"target\": {\"width\": %u, \"height\": %u, \"format\": \"%s\"},\n",
+                mWidth, mHeight, formats[0].name);
+        fprintf(mOut, "  \"frames\": %u,\n  \"scenarios\": [", mFrames);
+    }
+
+    void end()
+    {
+        fprintf(mOut, "\n  ]\n}\n");
+    }
+
+    bool run(const Scenario &scn);
+private:
+    void report(const Scenario &scn, const char *status)
+    {
+        fprintf(mOut, "%s\n    {\"name\": \"%s\", \"layers\": %u, \"format\": \"%s\", \"scale\": %.2f, "
+                "\"rotation\": %u, \"afbc\": %s, \"status\": \"%s\"",
+                mCount++ ? "," : "", name(scn).c_str(), scn.layers, scn.format->name,
+                scn.scale, scn.rotation, scn.afbc ? "true" : "false", status);
+    }
+
+    void reportStat(const char *key, std::vector<unsigned int> &samples)
+    {
+        Stat stat = getStat(samples);
+
+        fprintf(mOut, ",\n     \"%s\": {\"mean\": %.1f, \"min\": %u, \"p50\": %u, \"p95\": %u, \"max\": %u}",
+                key, stat.mean, stat.min, stat.p50, stat.p95, stat.max);
+    }
+
+    std::string name(const Scenario &scn)
+    {
+        char buf[128];
+
+        snprintf(buf, sizeof(buf), "%ux%s-x%.2f-rot%u%s", scn.layers, scn.format->name,
+                 scn.scale, scn.rotation, scn.afbc ? "-afbc" : "");
+
+        return buf;
+    }
+
+    const char *mSpec;
+    unsigned int mFrames;
+    unsigned int mWidth;
+    unsigned int mHeight;
+    FILE *mOut;
+    unsigned int mCount;
+};
+
+bool Bench::run(const Scenario &scn)
+{
+    Acrylic *acrylic = Acrylic::createInstance(mSpec);
+    if (!acrylic) {
+        fprintf(stderr, "Failed to create Acrylic of '%s'\n", mSpec);
+        return false;
+    }
+
+    const HW2DCapability &cap = acrylic->getCapabilities();
+    uint32_t transform = halTransform(scn.rotation);
+
+    // every layer is placed on a 3/4 sized window from the different positions
+    hw2d_coord_t window = {static_cast<int16_t>(mWidth * 3 / 4), static_cast<int16_t>(mHeight * 3 / 4)};
+    hw2d_coord_t crop = window;
+    if (!!(transform & HAL_TRANSFORM_ROT_90))
+        crop.swap();
+    crop.hori = static_cast<int16_t>(ALIGN_UP(std::max(static_cast<int>(crop.hori * scn.scale), 2), 2));
+    crop.vert = static_cast<int16_t>(ALIGN_UP(std::max(static_cast<int>(crop.vert * scn.scale), 2), 2));
+
+    if ((scn.layers > cap.maxLayerCount()) || !cap.isFormatSupported(scn.format->fmt) ||
+            (scn.afbc && !cap.isFeatureSupported(HW2DCapability::FEATURE_AFBC_DECODE)) ||
+            ((transform & cap.getHWCTransformMask()) != transform) ||
+            !cap.supportedResampling(crop, window, transform)) {
+        report(scn, "unsupported");
+        fprintf(mOut, "}");
+        delete acrylic;
+        return true;
+    }
+
+    Buffer target(formats[0], mWidth, mHeight, 0);
+    std::vector<Buffer *> sources;
+    std::vector<AcrylicLayer *> layers;
+
+    for (unsigned int i = 0; i < scn.layers; i++) {
+        sources.push_back(new Buffer(*scn.format, crop.hori, crop.vert, i + 1));
+        layers.push_back(acrylic->createLayer());
+    }
+
+    std::vector<unsigned int> config, validate, sort, prepare, execute, hw;
+    const unsigned int warmup = 2;
+    const char *status = "ok";
+
+    AcrylicCanvas &canvas = acrylic->getCanvas();
+    canvas.setImageDimension(mWidth, mHeight);
+    canvas.setImageType(formats[0].fmt, HAL_DATASPACE_SRGB);
+
+    for (unsigned int frame = 0; frame < (mFrames + warmup); frame++) {
+        auto begin = std::chrono::steady_clock::now();
+
+        // the configuration of every frame by HWC
+        bool okay = target.attach(canvas);
+        for (unsigned int i = 0; okay && (i < scn.layers); i++) {
+            int offset_x = (mWidth / 4) * i / scn.layers;
+            int offset_y = (mHeight / 4) * i / scn.layers;
+            hwc_rect_t src = {0, 0, crop.hori, crop.vert};
+            hwc_rect_t dst = {offset_x, offset_y, offset_x + window.hori, offset_y + window.vert};
+
+            okay = layers[i]->setImageDimension(crop.hori, crop.vert) &&
+                   layers[i]->setImageType(scn.format->fmt, 0) &&
+                   sources[i]->attach(*layers[i], scn.afbc ? AcrylicCanvas::ATTR_COMPRESSED : 0) &&
+                   layers[i]->setCompositArea(src, dst, transform) &&
+                   layers[i]->setCompositMode((i == 0) ? HWC_BLENDING_NONE : HWC_BLENDING_PREMULT,
+                                              255, static_cast<int>(i));
+        }
+
+        auto configured = std::chrono::steady_clock::now();
+
+        okay = okay && acrylic->execute();
+
+        auto executed = std::chrono::steady_clock::now();
+
+        if (!okay) {
+            status = "failed";
+            break;
+        }
+
+        if (frame < warmup)
+            continue;
+
+        config.push_back(static_cast<unsigned int>(
+                std::chrono::duration_cast<std::chrono::microseconds>(configured - begin).count()));
+        execute.push_back(static_cast<unsigned int>(
+                std::chrono::duration_cast<std::chrono::microseconds>(executed - configured).count()));
+        validate.push_back(acrylic->getValidateTimeUSec());
+        sort.push_back(acrylic->getSortTimeUSec());
+        prepare.push_back(acrylic->getPrepareTimeUSec());
+        hw.push_back(acrylic->getLaptimeUSec());
+    }
+
+    report(scn, status);
+    reportStat("config_usec", config);
+    reportStat("validate_usec", validate);
+    reportStat("sort_usec", sort);
+    reportStat("prepare_usec", prepare);
+    reportStat("execute_usec", execute);
+    reportStat("hw_usec", hw);
+    fprintf(mOut, ",\n     \"output_hash\": \"0x%08x\"}", target.hash());
+
+    for (auto layer: layers)
+        delete layer;
+
+    for (auto source: sources)
+        delete source;
+
+    delete acrylic;
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *spec = "sw";
+    const char *output = NULL;
+    unsigned int frames = 30;
+    unsigned int width = 1920;
+    unsigned int height = 1080;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:n:t:o:")) != -1) {
+        switch (opt) {
+        case 's':
+            spec = optarg;
+            break;
+        case 'n':
+            frames = std::max(atoi(optarg), 1);
+            break;
+        case 't':
+            if (sscanf(optarg, "%ux%u", &width, &height) != 2) {
+                fprintf(stderr, "Invalid target size '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s spec] [-n frames] [-t WxH] [-o output.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Failed to open '%s'\n", output);
+        return 1;
+    }
+
+    const Scenario base = {4, &formats[0], 1.0, 0, false};
+    std::vector<Scenario> scenarios;
+
+    for (unsigned int layers: {1, 2, 8, 16}) {
+        scenarios.push_back(base);
+        scenarios.back().layers = layers;
+    }
+
+    scenarios.push_back(base);
+
+    for (auto &fmt: formats) {
+        if (&fmt == base.format)
+            continue;
+        scenarios.push_back(base);
+        scenarios.back().format = &fmt;
+    }
+
+    for (double scale: {0.25, 0.5, 1.5, 2.0}) {
+        scenarios.push_back(base);
+        scenarios.back().scale = scale;
+    }
+
+    for (unsigned int rotation: {90, 180, 270}) {
+        scenarios.push_back(base);
+        scenarios.back().rotation = rotation;
+    }
+
+    scenarios.push_back(base);
+    scenarios.back().afbc = true;
+
+    Bench bench(spec, frames, width, height, out);
+
+    bench.begin();
+    for (auto &scn: scenarios) {
+        if (!bench.run(scn))
+            return 1;
+    }
+    bench.end();
+
+    if (out != stdout)
+        fclose(out);
+
+    return 0;
+}
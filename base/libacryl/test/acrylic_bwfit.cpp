@@ -0,0 +1,343 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <unistd.h>
+
+#include <hardware/exynos/acryl.h>
+
+#include "acrylic_bandwidth.h"
+
+/*
+ * Calibration of the bandwidth model of libacryl.
+ * It fits the weights of AcrylicBandwidthModel to the laptimes of a compositor
+ * given by Acrylic::getLaptimeUSec() with the linear least squares, assuming
+ * that the laptime is proportional to the weighted bits of the job. The weight
+ * of "write" is fixed to WEIGHT_UNIT to determine the scale of the weights.
+ * The features that no sample has keep the default weights and they are not
+ * written to the model file.
+ * Each line of the samples is a job composited by the compositor:
+ *   laptime_usec,target_fmt,target_bpp,target_w,target_h,layer_count,<layer>...
+ * and each <layer> is:
+ *   fmt,bpp,src_w,src_h,dst_x,dst_y,dst_w,dst_h,transform,attribute
+ * The formats are HAL pixel formats, and bpp is halfmt_bpp() of the format.
+ * The lines that start with '#' are ignored.
+ *
+ * usage: libacryl_bwfit [-i samples.csv] [-o model.conf]
+ */
+
+#define SAMPLE_FIELDS 6
+#define LAYER_FIELDS 10
+
+struct Sample {
+    double laptime;
+    AcrylicBandwidthModel::Features features;
+};
+
+static bool parseSample(const char *line, Sample &sample)
+{
+    std::vector<long> fields;
+    const char *p = line;
+
+    while (*p) {
+        char *end;
+        long val = strtol(p, &end, 0);
+
+        if (end == p)
+            return false;
+
+        fields.push_back(val);
+
+        p = end + strspn(end, " \t\r\n");
+        if (*p == ',')
+            p++;
+        else if (*p != '\0')
+            return false;
+    }
+
+    if ((fields.size() < SAMPLE_FIELDS) ||
+            (fields.size() != SAMPLE_FIELDS + static_cast<size_t>(fields[5]) * LAYER_FIELDS))
+        return false;
+
+    int count = static_cast<int>(fields[5]);
+    std::vector<AcrylicBandwidthModel::Layer> layers(count);
+
+    for (int i = 0; i < count; i++) {
+        const long *f = &fields[SAMPLE_FIELDS + i * LAYER_FIELDS];
+        AcrylicPerformanceRequestLayer layer;
+
+        memset(&layer, 0, sizeof(layer));
+        layer.mPixFormat = static_cast<uint32_t>(f[0]);
+        layer.mSourceRect.size.hori = static_cast<int16_t>(f[2]);
+        layer.mSourceRect.size.vert = static_cast<int16_t>(f[3]);
+        layer.mTargetRect.pos.hori = static_cast<int16_t>(f[4]);
+        layer.mTargetRect.pos.vert = static_cast<int16_t>(f[5]);
+        layer.mTargetRect.size.hori = static_cast<int16_t>(f[6]);
+        layer.mTargetRect.size.vert = static_cast<int16_t>(f[7]);
+        layer.mTransform = static_cast<uint32_t>(f[8]);
+        layer.mAttribute = static_cast<uint32_t>(f[9]);
+
+        AcrylicBandwidthModel::describeLayer(layer, static_cast<unsigned int>(f[1]), layers[i]);
+    }
+
+    hw2d_coord_t target_size;
+
+    target_size.hori = static_cast<int16_t>(fields[3]);
+    target_size.vert = static_cast<int16_t>(fields[4]);
+
+    sample.laptime = static_cast<double>(fields[0]);
+    AcrylicBandwidthModel::getFeatures(layers.data(), count, target_size,
+                                       static_cast<unsigned int>(fields[2]), sample.features);
+
+    return true;
+}
+
+struct Column {
+    std::string name;
+    uint32_t format;    // valid if name is "format"
+};
+
+static double getFeature(const Sample &sample, const Column &column)
+{
+    const AcrylicBandwidthModel::Features &features = sample.features;
+
+    if (column.name == "format") {
+        auto it = features.format.find(column.format);
+        return (it == features.format.end()) ? 0.0 : static_cast<double>(it->second);
+    }
+    if (column.name == "scaling")
+        return static_cast<double>(features.scaling);
+    if (column.name == "rotating")
+        return static_cast<double>(features.rotating);
+    if (column.name == "compressed")
+        return static_cast<double>(features.compressed);
+    if (column.name == "overlap")
+        return static_cast<double>(features.overlap);
+    if (column.name == "write")
+        return static_cast<double>(features.write);
+    return static_cast<double>(features.write_yuv420_rotate);
+}
+
+// Solve A x = b with the gaussian elimination with partial pivoting
+static bool solve(std::vector<std::vector<double>> &a, std::vector<double> &b, std::vector<double> &x)
+{
+    size_t n = b.size();
+
+    for (size_t col = 0; col < n; col++) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < n; row++)
+            if (std::fabs(a[row][col]) > std::fabs(a[pivot][col]))
+                pivot = row;
+
+        if (std::fabs(a[pivot][col]) < 1e-12)
+            return false;
+
+        std::swap(a[col], a[pivot]);
+        std::swap(b[col], b[pivot]);
+
+        for (size_t row = col + 1; row < n; row++) {
+            double ratio = a[row][col] / a[col][col];
+            for (size_t k = col; k < n; k++)
+                a[row][k] -= ratio * a[col][k];
+            b[row] -= ratio * b[col];
+        }
+    }
+
+    x.assign(n, 0.0);
+    for (size_t col = n; col-- > 0; ) {
+        double sum = b[col];
+        for (size_t k = col + 1; k < n; k++)
+            sum -= a[col][k] * x[k];
+        x[col] = sum / a[col][col];
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *input = NULL;
+    const char *output = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:o:")) != -1) {
+        switch (opt) {
+        case 'i':
+            input = optarg;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-i samples.csv] [-o model.conf]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    FILE *in = input ? fopen(input, "r") : stdin;
+    if (!in) {
+        fprintf(stderr, "Failed to open '%s'\n", input);
+        return 1;
+    }
+
+    std::vector<Sample> samples;
+    char line[4096];
+    int lineno = 0;
+
+    while (fgets(line, sizeof(line), in)) {
+        lineno++;
+
+        const char *p = line + strspn(line, " \t");
+        if ((*p == '#') || (*p == '\n') || (*p == '\0'))
+            continue;
+
+        Sample sample;
+        if (!parseSample(p, sample)) {
+            fprintf(stderr, "Ignoring malformed sample at line %d\n", lineno);
+            continue;
+        }
+
+        samples.push_back(sample);
+    }
+
+    if (in != stdin)
+        fclose(in);
+
+    // Every feature that at least one sample has is a column of the least squares
+    std::vector<Column> columns;
+    std::vector<uint32_t> formats;
+
+    for (auto &sample: samples)
+        for (auto &format: sample.features.format)
+            if (std::find(formats.begin(), formats.end(), format.first) == formats.end())
+                formats.push_back(format.first);
+    std::sort(formats.begin(), formats.end());
+
+    for (auto format: formats)
+        columns.push_back({"format", format});
+
+    const char *features[] = {"scaling", "rotating", "compressed", "overlap", "write", "write_yuv420_rotate"};
+    for (auto name: features) {
+        Column column = {name, 0};
+
+        for (auto &sample: samples) {
+            if (getFeature(sample, column) != 0.0) {
+                columns.push_back(column);
+                break;
+            }
+        }
+    }
+
+    size_t write_col = columns.size();
+    for (size_t i = 0; i < columns.size(); i++)
+        if (columns[i].name == "write")
+            write_col = i;
+
+    if ((samples.size() < columns.size()) || (write_col == columns.size())) {
+        fprintf(stderr, "%zu samples are too few to fit %zu weights\n", samples.size(), columns.size());
+        return 1;
+    }
+
+    // The features are normalized by their largest values for the numerical stability
+    size_t n = columns.size();
+    std::vector<double> scale(n, 0.0);
+
+    for (size_t i = 0; i < n; i++)
+        for (auto &sample: samples)
+            scale[i] = std::max(scale[i], std::fabs(getFeature(sample, columns[i])));
+
+    // The normal equations, (X^T X) theta = X^T y
+    std::vector<std::vector<double>> xtx(n, std::vector<double>(n, 0.0));
+    std::vector<double> xty(n, 0.0);
+
+    for (auto &sample: samples) {
+        std::vector<double> x(n);
+
+        for (size_t i = 0; i < n; i++)
+            x[i] = getFeature(sample, columns[i]) / scale[i];
+
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++)
+                xtx[i][j] += x[i] * x[j];
+            xty[i] += x[i] * sample.laptime;
+        }
+    }
+
+    std::vector<double> theta;
+    if (!solve(xtx, xty, theta)) {
+        fprintf(stderr, "The samples do not distinguish the features. Vary the layers of the samples.\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        theta[i] /= scale[i];
+
+    if (theta[write_col] <= 0.0) {
+        fprintf(stderr, "Failed to fit: non-positive cost of the write\n");
+        return 1;
+    }
+
+    double unit = theta[write_col] / AcrylicBandwidthModel::WEIGHT_UNIT;
+    double sq_err = 0.0, sq_sum = 0.0, mean = 0.0;
+
+    for (auto &sample: samples)
+        mean += sample.laptime;
+    mean /= samples.size();
+
+    for (auto &sample: samples) {
+        double predicted = 0.0;
+
+        for (size_t i = 0; i < n; i++)
+            predicted += theta[i] * getFeature(sample, columns[i]);
+
+        sq_err += (predicted - sample.laptime) * (predicted - sample.laptime);
+        sq_sum += (sample.laptime - mean) * (sample.laptime - mean);
+    }
+
+    fprintf(stderr, "Fitted %zu weights to %zu samples: RMS error %.1f usec, R^2 %.4f\n",
+            n, samples.size(), std::sqrt(sq_err / samples.size()),
+            (sq_sum > 0.0) ? 1.0 - sq_err / sq_sum : 1.0);
+
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Failed to open '%s'\n", output);
+        return 1;
+    }
+
+    fprintf(out, "# generated by libacryl_bwfit from %zu samples\n", samples.size());
+    for (size_t i = 0; i < n; i++) {
+        long weight = std::lround(theta[i] / unit);
+
+        if (columns[i].name == "format")
+            fprintf(out, "format %#x %ld\n", columns[i].format, weight);
+        else
+            fprintf(out, "%s %ld\n", columns[i].name.c_str(), weight);
+    }
+
+    if (out != stdout)
+        fclose(out);
+
+    return 0;
+}
@@ -64,6 +64,8 @@ LOCAL_SRC_FILES := \
 	libdevice/ExynosLayer.cpp \
 	libmaindisplay/ExynosPrimaryDisplay.cpp \
 	libresource/ExynosMPP.cpp \
+	libresource/ExynosMPPBufferPool.cpp \
+	libresource/ExynosPPCModel.cpp \
 	libresource/ExynosResourceManager.cpp \
 	libexternaldisplay/ExynosExternalDisplay.cpp \
 	libvirtualdisplay/ExynosVirtualDisplay.cpp \
@@ -185,3 +187,6 @@ LOCAL_MODULE_TAGS := optional
 include $(TOP)/hardware/samsung_slsi/graphics/base/BoardConfigCFlags.mk
 include $(BUILD_SHARED_LIBRARY)
 
+################################################################################
+
+include $(TOP)/hardware/samsung_slsi/graphics/base/libhwc2.1/tools/Android.mk
@@ -254,7 +254,7 @@ int32_t exynos_destroyLayer(hwc2_device_t *dev, hwc2_display_t display,
         if (exynosDisplay) {
             ExynosLayer *exynosLayer = checkLayer(exynosDisplay, layer);
             if (exynosLayer)
-                return exynosDisplay->destroyLayer((hwc2_layer_t)exynosLayer);
+                return exynosDisplay->destroyLayer(exynosLayer->mHandle);
             else
                 return HWC2_ERROR_BAD_LAYER;
         }
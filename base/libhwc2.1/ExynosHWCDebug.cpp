@@ -131,10 +131,11 @@ int32_t saveFenceTrace(ExynosDisplay *display) {
             ((tv.tv_sec * 1000) + (tv.tv_usec / 1000)));
 
     if (device != NULL) {
-        for (auto it = device->mFenceInfo.begin(); it != device->mFenceInfo.end(); ++it) {
-            uint32_t i = it->first;
+        uint32_t limit = device->mFenceTracer.getFdLimit();
+        for (uint32_t i = 0; i < limit; i++) {
+            hwc_fence_info_t info;
 
-            hwc_fence_info_t info = device->mFenceInfo.at(i);
+            if (!device->mFenceTracer.read(i, info)) continue;
 
             if (info.usage >= 1) {
                 saveString.appendFormat("FD hwc : %d, usage %d, pending : %d\n", i, info.usage, (int)info.pendingAllowed);
@@ -145,14 +146,7 @@ int32_t saveFenceTrace(ExynosDisplay *display) {
                             GET_STRING(fence_ip_map, seq->ip), GET_STRING(fence_type_map, seq->type),
                             seq->curFlag, seq->usage, (int)seq->isLast);
 
-                    tv = seq->time;
-                    localTime = (struct tm*)localtime((time_t*)&tv.tv_sec);
-
-                    saveString.appendFormat(" - time:%02d-%02d %02d:%02d:%02d.%03lu(%lu)\n",
-                            localTime->tm_mon+1, localTime->tm_mday,
-                            localTime->tm_hour, localTime->tm_min,
-                            localTime->tm_sec, tv.tv_usec/1000,
-                            ((tv.tv_sec * 1000) + (tv.tv_usec / 1000)));
+                    saveString.appendFormat(" - time:%s\n", getFenceTraceTime(seq->time).string());
                 }
             }
         }
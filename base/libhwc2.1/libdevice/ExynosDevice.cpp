@@ -16,6 +16,9 @@
 
 #include <sched.h>
 #include <dlfcn.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 
 #include "ExynosDevice.h"
 #include "ExynosDisplay.h"
@@ -50,6 +53,9 @@ GrallocWrapper::Allocator* ExynosDevice::mAllocator = NULL;
 ExynosDevice::ExynosDevice()
     : mGeometryChanged(0),
     mDRThread(0),
+    mDRThreadStatus(0),
+    mDRLoopStatus(false),
+    mIdleEventFd(-1),
     mVsyncDisplayId(getDisplayId(HWC_DISPLAY_PRIMARY, 0)),
     mTimestamp(0),
     mDisplayMode(0),
@@ -75,9 +81,7 @@ ExynosDevice::ExynosDevice()
     exynosHWCControl.sysFenceLogging = false;
     exynosHWCControl.useDynamicRecomp = false;
 
-    mFenceInfo.clear();
-
-    ALOGD("HWC2 : %s : %d , %lu", __func__, __LINE__, (unsigned long)mFenceInfo.size());
+    mFenceTracer.clear();
 
     mResourceManager = new ExynosResourceManagerModule(this);
 
@@ -123,6 +127,10 @@ ExynosDevice::ExynosDevice()
 
     memset(mCallbackInfos, 0, sizeof(mCallbackInfos));
 
+    mIdleEventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (mIdleEventFd < 0)
+        ALOGE("%s:: failed to create eventfd of the idle timer (%s)", __func__, strerror(errno));
+
     dynamicRecompositionThreadCreate();
 
     hwcDebug = 0;
@@ -222,8 +230,9 @@ ExynosDevice::~ExynosDevice() {
     ExynosDisplay *primary_display = getDisplay(getDisplayId(HWC_DISPLAY_PRIMARY,0));
 
     /* TODO kill threads here */
-    pthread_kill(mDRThread, SIGTERM);
-    pthread_join(mDRThread, NULL);
+    dynamicRecompositionThreadStop();
+    if (mIdleEventFd >= 0)
+        close(mIdleEventFd);
 
     if (mMapper != NULL)
         delete mMapper;
@@ -353,73 +362,126 @@ void ExynosDevice::checkDynamicRecompositionThread()
 {
     // If thread was destroyed, create thread and run. (resume status)
     if (isDynamicRecompositionThreadAlive() == false) {
-        for (uint32_t i = 0; i < mDisplays.size(); i++) {
-            if (mDisplays[i]->mDREnable) {
-                dynamicRecompositionThreadCreate();
-                return;
-            }
-        }
+        if (needIdleTimerThread())
+            dynamicRecompositionThreadCreate();
     } else {
-    // If thread is running and all displays turnned off DR, destroy the thread.
-        for (uint32_t i = 0; i < mDisplays.size(); i++) {
-            if (mDisplays[i]->mDREnable)
-                return;
-        }
-        mDRLoopStatus = false;
-        pthread_join(mDRThread, 0);
+    // If thread is running and all displays turnned off DR and the idle timer, destroy the thread.
+        if (needIdleTimerThread())
+            return;
+        dynamicRecompositionThreadStop();
     }
 }
 
+bool ExynosDevice::needIdleTimerThread()
+{
+    for (uint32_t i = 0; i < mDisplays.size(); i++) {
+        if (mDisplays[i]->needIdleTimer())
+            return true;
+    }
+    return false;
+}
+
 void ExynosDevice::dynamicRecompositionThreadCreate()
 {
-    if (exynosHWCControl.useDynamicRecomp == true) {
+    /* Reap the thread that has exited by itself */
+    dynamicRecompositionThreadStop();
+
+    if ((mIdleEventFd >= 0) && needIdleTimerThread()) {
         /* pthread_create shouldn't have been failed. But, ignore if some error was occurred */
+        mDRLoopStatus = true;
         if (pthread_create(&mDRThread, NULL, dynamicRecompositionThreadLoop, this) != 0) {
             ALOGE("%s: failed to start hwc_dynamicrecomp_thread thread:", __func__);
             mDRLoopStatus = false;
-        } else {
-            mDRLoopStatus = true;
         }
     }
 }
 
+void ExynosDevice::dynamicRecompositionThreadStop()
+{
+    if (mDRLoopStatus == false)
+        return;
+
+    mDRLoopStatus = false;
+    wakeIdleTimer();
+    pthread_join(mDRThread, 0);
+}
+
+void ExynosDevice::wakeIdleTimer()
+{
+    uint64_t count = 1;
+
+    if (write(mIdleEventFd, &count, sizeof(count)) != sizeof(count))
+        ALOGE("%s:: failed to wake the idle timer (%s)", __func__, strerror(errno));
+}
+
+/*
+ * The displays set mIdleDeadline on every update. The thread sleeps until
+ * the earliest deadline instead of polling the displays periodically.
+ * It does not wake up while all displays are idle and they have checked
+ * the dynamic recomposition and the idle timer.
+ */
 void *ExynosDevice::dynamicRecompositionThreadLoop(void *data)
 {
     ExynosDevice *dev = (ExynosDevice *)data;
-    ExynosDisplay *display[dev->mDisplays.size()];
-    uint64_t event_cnt[dev->mDisplays.size()];
 
-    for (uint32_t i = 0; i < dev->mDisplays.size(); i++) {
-        display[i] = dev->mDisplays[i];
-        event_cnt[i] = 0;
+    int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (timerFd < 0) {
+        ALOGE("%s:: failed to create timerfd (%s)", __func__, strerror(errno));
+        return NULL;
     }
+
     android_atomic_inc(&(dev->mDRThreadStatus));
 
+    struct pollfd fds[2];
+    fds[0].fd = timerFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = dev->mIdleEventFd;
+    fds[1].events = POLLIN;
+
     while (dev->mDRLoopStatus) {
+        nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t nextDeadline = 0;
         uint32_t result = 0;
-        for (uint32_t i = 0; i < dev->mDisplays.size(); i++)
-            event_cnt[i] = display[i]->mUpdateEventCnt;
 
-        /*
-         * If there is no update for more than 100ms, favor the 3D composition mode.
-         * If all other conditions are met, mode will be switched to 3D composition.
-         */
-        usleep(100000);
         for (uint32_t i = 0; i < dev->mDisplays.size(); i++) {
-            if (display[i]->mDREnable &&
-                display[i]->mPlugState == true &&
-                event_cnt[i] == display[i]->mUpdateEventCnt) {
-                if (display[i]->checkDynamicReCompMode() == DEVICE_2_CLIENT) {
-                    display[i]->mUpdateEventCnt = 0;
-                    display[i]->setGeometryChanged(GEOMETRY_DISPLAY_DYNAMIC_RECOMPOSITION);
+            ExynosDisplay *display = dev->mDisplays[i];
+            nsecs_t deadline = display->mIdleDeadline;
+
+            if ((deadline != 0) && (deadline <= now)) {
+                if (display->handleIdleTimeout(now))
                     result = 1;
-                }
+                deadline = display->mIdleDeadline;
             }
+
+            if ((deadline != 0) && ((nextDeadline == 0) || (deadline < nextDeadline)))
+                nextDeadline = deadline;
         }
         if (result)
             dev->invalidate();
+
+        /* Zero disarms the timer */
+        struct itimerspec spec;
+        memset(&spec, 0, sizeof(spec));
+        spec.it_value.tv_sec = nextDeadline / s2ns(1);
+        spec.it_value.tv_nsec = nextDeadline % s2ns(1);
+        if (timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, NULL) < 0)
+            ALOGE("%s:: failed to arm timerfd (%s)", __func__, strerror(errno));
+
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if ((poll(fds, 2, -1) < 0) && (errno != EINTR)) {
+            ALOGE("%s:: failed to poll (%s)", __func__, strerror(errno));
+            break;
+        }
+
+        uint64_t count;
+        if (fds[0].revents & POLLIN)
+            read(timerFd, &count, sizeof(count));
+        if (fds[1].revents & POLLIN)
+            read(dev->mIdleEventFd, &count, sizeof(count));
     }
 
+    close(timerFd);
     android_atomic_dec(&(dev->mDRThreadStatus));
 
     return NULL;
@@ -506,6 +568,14 @@ void ExynosDevice::dump(uint32_t *outSize, char *outBuffer) {
             display->dump(result);
     }
 
+    result.append("\n");
+    ExynosMPPBufferPool::getInstance().dump(result);
+    {
+        std::string acrylDump;
+        Acrylic::dumpTransitBuffers(acrylDump);
+        result.append(acrylDump.c_str());
+    }
+
     if (outBuffer == NULL) {
         *outSize = (uint32_t)result.length();
     } else {
@@ -175,6 +175,12 @@ class ExynosDevice {
         pthread_t mDRThread;
         volatile int32_t mDRThreadStatus;
         bool mDRLoopStatus;
+        /**
+         * The dynamic recomposition thread sleeps on a timerfd armed at
+         * the earliest mIdleDeadline of the displays. This eventfd wakes it
+         * up when a deadline is moved earlier or the thread should exit.
+         */
+        int mIdleEventFd;
         bool mPrimaryBlank;
 
         bool isBootFinished;
@@ -202,7 +208,7 @@ class ExynosDevice {
         bool mIsDumpRequest;
 
         // Variable for fence tracer
-        std::unordered_map<int32_t, hwc_fence_info> mFenceInfo;
+        ExynosFenceTracer mFenceTracer;
 
         /**
          * This will be initialized with differnt class
@@ -226,6 +232,9 @@ class ExynosDevice {
 
         void dynamicRecompositionThreadCreate();
         static void* dynamicRecompositionThreadLoop(void *data);
+        void dynamicRecompositionThreadStop();
+        bool needIdleTimerThread();
+        void wakeIdleTimer();
 
 
         /**
@@ -24,6 +24,8 @@
 #include <hardware/hwcomposer_defs.h>
 #include <android/sync.h>
 #include <cmath>
+#include <inttypes.h>
+#include <time.h>
 
 #include <map>
 #include "ExynosDisplay.h"
@@ -127,6 +129,171 @@ int32_t ExynosLowFpsLayerInfo::addLowFpsLayer(uint32_t layerIndex)
     return NO_ERROR;
 }
 
+ExynosPostProcessingDispatcher::ExynosPostProcessingDispatcher()
+    : mNextGroup(0),
+    mPendingGroups(0),
+    mExit(false),
+    mWorkerCount(0)
+{
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+ExynosPostProcessingDispatcher::~ExynosPostProcessingDispatcher()
+{
+    {
+        Mutex::Autolock lock(mMutex);
+        mExit = true;
+        mWorkCondition.broadcast();
+    }
+
+    for (uint32_t i = 0; i < mWorkerCount; i++)
+        mWorkers[i]->requestExitAndWait();
+}
+
+size_t ExynosPostProcessingDispatcher::submit(ExynosMPP *mpp, std::function<int32_t()> job)
+{
+    mJobs.push_back({mpp, job, NO_ERROR, 0});
+    return mJobs.size() - 1;
+}
+
+bool ExynosPostProcessingDispatcher::startWorkers()
+{
+    /*
+     * The MPPs allocate their destination buffers with the allocator of
+     * ExynosDevice. Create it here not to create it on the workers at once.
+     */
+    GrallocWrapper::Mapper *mapper;
+    GrallocWrapper::Allocator *allocator;
+    ExynosDevice::getAllocator(&mapper, &allocator);
+
+    while (mWorkerCount < MAX_WORKERS) {
+        sp<WorkerThread> worker = new WorkerThread(this);
+        if (worker->run("HWCPostProcessing", PRIORITY_URGENT_DISPLAY) != NO_ERROR) {
+            ALOGE("%s:: failed to run the post-processing worker %u", __func__, mWorkerCount);
+            break;
+        }
+        mWorkers[mWorkerCount++] = worker;
+    }
+
+    return (mWorkerCount > 0);
+}
+
+void ExynosPostProcessingDispatcher::runGroup(size_t group)
+{
+    for (size_t index : mGroups[group]) {
+        Job &job = mJobs[index];
+        ATRACE_NAME(job.mpp->mName.string());
+        nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+        job.ret = job.func();
+        job.duration = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+    }
+}
+
+bool ExynosPostProcessingDispatcher::runWorker()
+{
+    size_t group;
+    {
+        Mutex::Autolock lock(mMutex);
+        while (!mExit && (mNextGroup >= mGroups.size()))
+            mWorkCondition.wait(mMutex);
+        if (mExit)
+            return false;
+        group = mNextGroup++;
+    }
+
+    runGroup(group);
+
+    Mutex::Autolock lock(mMutex);
+    if (--mPendingGroups == 0)
+        mDoneCondition.signal();
+
+    return true;
+}
+
+void ExynosPostProcessingDispatcher::join()
+{
+    if (mJobs.size() == 0)
+        return;
+
+    ATRACE_CALL();
+    nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    std::vector<std::vector<size_t>> groups;
+    std::vector<ExynosMPP*> groupMPPs;
+    for (size_t i = 0; i < mJobs.size(); i++) {
+        ExynosMPP *mpp = mJobs[i].mpp;
+        size_t group = 0;
+        /* The logical MPPs of a physical MPP share the H/W */
+        while ((group < groupMPPs.size()) &&
+               ((groupMPPs[group]->mPhysicalType != mpp->mPhysicalType) ||
+                (groupMPPs[group]->mPhysicalIndex != mpp->mPhysicalIndex)))
+            group++;
+        if (group == groupMPPs.size()) {
+            groupMPPs.push_back(mpp);
+            groups.push_back(std::vector<size_t>());
+        }
+        groups[group].push_back(i);
+    }
+
+    if ((groups.size() == 1) || !startWorkers()) {
+        {
+            /* The workers of the previous frames should not take the groups */
+            Mutex::Autolock lock(mMutex);
+            mGroups.swap(groups);
+            mNextGroup = mGroups.size();
+        }
+        for (size_t i = 0; i < mGroups.size(); i++)
+            runGroup(i);
+    } else {
+        Mutex::Autolock lock(mMutex);
+        mGroups.swap(groups);
+        mNextGroup = 0;
+        mPendingGroups = mGroups.size();
+        mWorkCondition.broadcast();
+
+        /* The caller runs the groups with the workers */
+        while (mNextGroup < mGroups.size()) {
+            size_t group = mNextGroup++;
+            mMutex.unlock();
+            runGroup(group);
+            mMutex.lock();
+            mPendingGroups--;
+        }
+        while (mPendingGroups > 0)
+            mDoneCondition.wait(mMutex);
+        mStats.parallelFrames++;
+    }
+
+    nsecs_t serialTime = 0;
+    for (auto &job : mJobs)
+        serialTime += job.duration;
+
+    mStats.frames++;
+    mStats.lastSerialTime = serialTime;
+    mStats.lastCriticalTime = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+    mStats.totalSerialTime += mStats.lastSerialTime;
+    mStats.totalCriticalTime += mStats.lastCriticalTime;
+    ATRACE_INT("M2M serial time(us)", (int32_t)ns2us(mStats.lastSerialTime));
+    ATRACE_INT("M2M critical time(us)", (int32_t)ns2us(mStats.lastCriticalTime));
+
+    {
+        Mutex::Autolock lock(mMutex);
+        mGroups.clear();
+        mNextGroup = 0;
+    }
+    mJobs.clear();
+}
+
+void ExynosPostProcessingDispatcher::dump(String8& result)
+{
+    result.appendFormat("post-processing: frames %" PRIu64 " (parallel %" PRIu64 "), workers %u\n",
+            mStats.frames, mStats.parallelFrames, mWorkerCount);
+    result.appendFormat("\tlast frame: serial %" PRId64 " us, critical path %" PRId64 " us\n",
+            ns2us(mStats.lastSerialTime), ns2us(mStats.lastCriticalTime));
+    result.appendFormat("\ttotal: serial %" PRId64 " us, critical path %" PRId64 " us\n",
+            ns2us(mStats.totalSerialTime), ns2us(mStats.totalCriticalTime));
+}
+
 ExynosCompositionInfo::ExynosCompositionInfo(uint32_t type)
     : ExynosMPPSource(MPP_SOURCE_COMPOSITION_TARGET, this),
     mType(type),
@@ -155,13 +322,7 @@ ExynosCompositionInfo::ExynosCompositionInfo(uint32_t type)
     else
         mCompressed = true;
 
-    memset(&mSkipSrcInfo, 0, sizeof(mSkipSrcInfo));
-    for (int i = 0; i < NUM_SKIP_STATIC_LAYER; i++) {
-        mSkipSrcInfo.srcInfo[i].acquireFenceFd = -1;
-        mSkipSrcInfo.srcInfo[i].releaseFenceFd = -1;
-        mSkipSrcInfo.dstInfo[i].acquireFenceFd = -1;
-        mSkipSrcInfo.dstInfo[i].releaseFenceFd = -1;
-    }
+    mSkipSrcInfo.clear();
 
     if(type == COMPOSITION_CLIENT)
         mEnableSkipStatic = true;
@@ -311,6 +472,8 @@ ExynosDisplay::ExynosDisplay(uint32_t index, ExynosDevice *device)
     mDRDefault(false),
     mErrorFrameCount(0),
     mUpdateEventCnt(0),
+    mIdleDeadline(0),
+    mExpectedPresentTime(0),
     mDumpCount(0),
     mDefaultDMA(MAX_DECON_DMA_TYPE),
     mLastRetireFence(-1),
@@ -339,6 +502,12 @@ ExynosDisplay::ExynosDisplay(uint32_t index, ExynosDevice *device)
     mConfigRequestState(hwc_request_state_t::SET_CONFIG_STATE_NONE),
     mDisplayInterface(NULL)
 {
+    memset(&mLayerLookupCount, 0, sizeof(mLayerLookupCount));
+    memset(&mLastFrameLayerLookupCount, 0, sizeof(mLastFrameLayerLookupCount));
+    mMaxFrameLayerLookups = 0;
+    memset(&mResourceAssignCount, 0, sizeof(mResourceAssignCount));
+    memset(&mPresentHoldCount, 0, sizeof(mPresentHoldCount));
+
     mDisplayControl.enableCompositionCrop = true;
     mDisplayControl.enableExynosCompositionOptimization = true;
     mDisplayControl.enableClientCompositionOptimization = true;
@@ -347,6 +516,7 @@ ExynosDisplay::ExynosDisplay(uint32_t index, ExynosDevice *device)
     mDisplayControl.earlyStartMPP = true;
     mDisplayControl.adjustDisplayFrame = false;
     mDisplayControl.cursorSupport = false;
+    mDisplayControl.holdUntilExpectedPresent = true;
 
     mDisplayConfigs.clear();
 
@@ -401,13 +571,7 @@ void ExynosDisplay::initDisplay() {
     mClientCompositionInfo.mEnableSkipStatic = true;
     mClientCompositionInfo.mSkipStaticInitFlag = false;
     mClientCompositionInfo.mSkipFlag = false;
-    memset(&mClientCompositionInfo.mSkipSrcInfo, 0x0, sizeof(mClientCompositionInfo.mSkipSrcInfo));
-    for (int i = 0; i < NUM_SKIP_STATIC_LAYER; i++) {
-        mClientCompositionInfo.mSkipSrcInfo.srcInfo[i].acquireFenceFd = -1;
-        mClientCompositionInfo.mSkipSrcInfo.srcInfo[i].releaseFenceFd = -1;
-        mClientCompositionInfo.mSkipSrcInfo.dstInfo[i].acquireFenceFd = -1;
-        mClientCompositionInfo.mSkipSrcInfo.dstInfo[i].releaseFenceFd = -1;
-    }
+    mClientCompositionInfo.mSkipSrcInfo.clear();
     memset(&mClientCompositionInfo.mLastWinConfigData, 0x0, sizeof(mClientCompositionInfo.mLastWinConfigData));
     mClientCompositionInfo.mLastWinConfigData.acq_fence = -1;
     mClientCompositionInfo.mLastWinConfigData.rel_fence = -1;
@@ -416,13 +580,7 @@ void ExynosDisplay::initDisplay() {
     mExynosCompositionInfo.mEnableSkipStatic = false;
     mExynosCompositionInfo.mSkipStaticInitFlag = false;
     mExynosCompositionInfo.mSkipFlag = false;
-    memset(&mExynosCompositionInfo.mSkipSrcInfo, 0x0, sizeof(mExynosCompositionInfo.mSkipSrcInfo));
-    for (int i = 0; i < NUM_SKIP_STATIC_LAYER; i++) {
-        mExynosCompositionInfo.mSkipSrcInfo.srcInfo[i].acquireFenceFd = -1;
-        mExynosCompositionInfo.mSkipSrcInfo.srcInfo[i].releaseFenceFd = -1;
-        mExynosCompositionInfo.mSkipSrcInfo.dstInfo[i].acquireFenceFd = -1;
-        mExynosCompositionInfo.mSkipSrcInfo.dstInfo[i].releaseFenceFd = -1;
-    }
+    mExynosCompositionInfo.mSkipSrcInfo.clear();
 
     memset(&mExynosCompositionInfo.mLastWinConfigData, 0x0, sizeof(mExynosCompositionInfo.mLastWinConfigData));
     mExynosCompositionInfo.mLastWinConfigData.acq_fence = -1;
@@ -468,12 +626,14 @@ void ExynosDisplay::initDisplay() {
 int32_t ExynosDisplay::destroyLayer(hwc2_layer_t outLayer) {
 
     Mutex::Autolock lock(mDRMutex);
-    ExynosLayer *layer = (ExynosLayer *)outLayer;
+    ExynosLayer *layer = checkLayer(outLayer);
 
     if (layer == nullptr) {
         return HWC2_ERROR_BAD_LAYER;
     }
 
+    freeLayerHandle(layer);
+
     if (mLayers.remove(layer) < 0) {
         auto it = std::find(mIgnoreLayers.begin(), mIgnoreLayers.end(), layer);
         if (it == mIgnoreLayers.end()) {
@@ -503,34 +663,73 @@ void ExynosDisplay::destroyLayers() {
     for (uint32_t index = 0; index < mLayers.size();) {
         ExynosLayer *layer = mLayers[index];
         mLayers.removeAt(index);
+        freeLayerHandle(layer);
         delete layer;
     }
 
     for (auto it = mIgnoreLayers.begin(); it != mIgnoreLayers.end();) {
         ExynosLayer *layer = *it;
         it = mIgnoreLayers.erase(it);
+        freeLayerHandle(layer);
         delete layer;
     }
 }
 
-ExynosLayer *ExynosDisplay::checkLayer(hwc2_layer_t addr) {
-    ExynosLayer *temp = (ExynosLayer *)addr;
-    if (!mLayers.isEmpty()) {
-        for (size_t i = 0; i < mLayers.size(); i++) {
-            if (mLayers[i] == temp)
-                return mLayers[i];
-        }
-    }
+ExynosLayer *ExynosDisplay::checkLayer(hwc2_layer_t handle) {
+    uint32_t slot = static_cast<uint32_t>(handle & 0xFFFFFFFF);
+    uint32_t generation = static_cast<uint32_t>(handle >> 32);
 
-    if (mIgnoreLayers.size()) {
-        auto it = std::find(mIgnoreLayers.begin(), mIgnoreLayers.end(), temp);
-        return (it == mIgnoreLayers.end()) ? NULL : *it;
-    }
+    mLayerLookupCount.lookups++;
+
+    if ((slot > 0) && (slot <= mLayerSlots.size()) &&
+        (mLayerSlots[slot - 1].generation == generation) &&
+        (mLayerSlots[slot - 1].layer != NULL))
+        return mLayerSlots[slot - 1].layer;
+
+    mLayerLookupCount.failures++;
 
     ALOGE("HWC2 : %s : %d, wrong layer request!", __func__, __LINE__);
     return NULL;
 }
 
+hwc2_layer_t ExynosDisplay::allocLayerHandle(ExynosLayer *layer) {
+    uint32_t slot;
+
+    if (mFreeLayerSlots.empty()) {
+        slot = static_cast<uint32_t>(mLayerSlots.size());
+        mLayerSlots.push_back({NULL, 1});
+    } else {
+        slot = mFreeLayerSlots.back();
+        mFreeLayerSlots.pop_back();
+    }
+
+    mLayerSlots[slot].layer = layer;
+    layer->mHandle = (static_cast<hwc2_layer_t>(mLayerSlots[slot].generation) << 32) | (slot + 1);
+
+    return layer->mHandle;
+}
+
+void ExynosDisplay::freeLayerHandle(ExynosLayer *layer) {
+    uint32_t slot = static_cast<uint32_t>(layer->mHandle & 0xFFFFFFFF);
+
+    if ((slot == 0) || (slot > mLayerSlots.size()) ||
+        (mLayerSlots[slot - 1].layer != layer))
+        return;
+
+    mLayerSlots[slot - 1].layer = NULL;
+    /* 0 is never a valid generation */
+    if (++mLayerSlots[slot - 1].generation == 0)
+        mLayerSlots[slot - 1].generation = 1;
+    mFreeLayerSlots.push_back(slot - 1);
+    layer->mHandle = 0;
+}
+
+void ExynosDisplay::updateLayerLookupCount() {
+    mLastFrameLayerLookupCount = mLayerLookupCount;
+    mMaxFrameLayerLookups = max(mMaxFrameLayerLookups, mLayerLookupCount.lookups);
+    memset(&mLayerLookupCount, 0, sizeof(mLayerLookupCount));
+}
+
 void ExynosDisplay::checkIgnoreLayers() {
     for (auto it = mIgnoreLayers.begin(); it != mIgnoreLayers.end();) {
         ExynosLayer *layer = *it;
@@ -708,6 +907,7 @@ int ExynosDisplay::checkDynamicReCompMode() {
     uint64_t TimeStampDiff;
     uint64_t w = 0, h = 0, incomingPixels = 0;
     uint64_t maxFps = 0, layerFps = 0;
+    nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
 
     Mutex::Autolock lock(mDRMutex);
 
@@ -762,7 +962,7 @@ int ExynosDisplay::checkDynamicReCompMode() {
      * There will be at least one composition call per one minute (because of time update)
      * To minimize the analysis overhead, just analyze it once in a second
      */
-    TimeStampDiff = systemTime(SYSTEM_TIME_MONOTONIC) - mLastModeSwitchTimeStamp;
+    TimeStampDiff = now - mLastModeSwitchTimeStamp;
 
     /*
      * previous CompModeSwitch was CLIENT_2_DEVICE: check fps every 250ms from mLastModeSwitchTimeStamp
@@ -778,7 +978,7 @@ int ExynosDisplay::checkDynamicReCompMode() {
         updateFps = HWC_FPS_TH;
     } else {
         for (uint32_t i = 0; i < mLayers.size(); i++) {
-            layerFps = mLayers[i]->getFps();
+            layerFps = mLayers[i]->getFps(now);
             if (maxFps < layerFps)
                 maxFps = layerFps;
         }
@@ -812,6 +1012,127 @@ int ExynosDisplay::checkDynamicReCompMode() {
     return 0;
 }
 
+bool ExynosDisplay::needIdleTimer() {
+    return exynosHWCControl.useDynamicRecomp && mDREnable;
+}
+
+nsecs_t ExynosDisplay::getIdleDeadline(nsecs_t now) {
+    nsecs_t deadline = 0;
+
+    if (exynosHWCControl.useDynamicRecomp && mDREnable && mPlugState &&
+        (mDynamicReCompMode != DEVICE_2_CLIENT) && (mLastUpdateTimeStamp != 0)) {
+        /* The fps of all layers drop below HWC_FPS_TH after this */
+        deadline = mLastUpdateTimeStamp + s2ns(1) / HWC_FPS_TH + ms2ns(1);
+        /* checkDynamicReCompMode() does not switch the mode again until this */
+        deadline = max(deadline, (nsecs_t)(mLastModeSwitchTimeStamp + VSYNC_INTERVAL * 15));
+        if (deadline <= now)
+            deadline = 0;
+    }
+
+    return deadline;
+}
+
+void ExynosDisplay::updateIdleDeadline() {
+    if (!needIdleTimer())
+        return;
+
+    setIdleDeadline(getIdleDeadline(mLastUpdateTimeStamp));
+}
+
+void ExynosDisplay::setIdleDeadline(nsecs_t deadline) {
+    nsecs_t prevDeadline = mIdleDeadline.exchange(deadline);
+
+    /* The idle timer thread sleeps until prevDeadline */
+    if ((deadline != 0) && ((prevDeadline == 0) || (deadline < prevDeadline)))
+        mDevice->wakeIdleTimer();
+}
+
+bool ExynosDisplay::handleIdleTimeout(nsecs_t now) {
+    bool refresh = false;
+
+    /*
+     * The display is not idle if a frame is in progress. setPowerMode()
+     * also holds mDisplayMutex while it waits for the idle timer thread.
+     */
+    if (mDisplayMutex.tryLock() != NO_ERROR) {
+        nsecs_t deadline = mIdleDeadline;
+        mIdleDeadline.compare_exchange_strong(deadline, now + (nsecs_t)VSYNC_INTERVAL);
+        return false;
+    }
+
+    if (exynosHWCControl.useDynamicRecomp && mDREnable && mPlugState &&
+        (checkDynamicReCompMode() == DEVICE_2_CLIENT)) {
+        mUpdateEventCnt = 0;
+        setGeometryChanged(GEOMETRY_DISPLAY_DYNAMIC_RECOMPOSITION);
+        refresh = true;
+    }
+
+    mIdleDeadline = getIdleDeadline(now);
+
+    mDisplayMutex.unlock();
+
+    return refresh;
+}
+
+int32_t ExynosDisplay::setExpectedPresentTime(nsecs_t expectedPresentTime) {
+    if (expectedPresentTime < 0)
+        return HWC2_ERROR_BAD_PARAMETER;
+
+    Mutex::Autolock lock(mDisplayMutex);
+    mExpectedPresentTime = expectedPresentTime;
+
+    return HWC2_ERROR_NONE;
+}
+
+void ExynosDisplay::waitForExpectedPresentTime() {
+    nsecs_t commitTime;
+    nsecs_t hold;
+
+    {
+        Mutex::Autolock lock(mDisplayMutex);
+        nsecs_t expectedPresentTime = mExpectedPresentTime;
+
+        /* The time is for this frame only */
+        mExpectedPresentTime = 0;
+        mPresentHoldCount.frames++;
+
+        if (!mDisplayControl.holdUntilExpectedPresent || (expectedPresentTime == 0) ||
+            (mPowerModeState != HWC2_POWER_MODE_ON))
+            return;
+
+        /*
+         * The frame is latched by the first vsync after the commit. Committing
+         * it in the middle of the previous vsync period keeps it from being
+         * latched one vsync early and still leaves enough time to the target.
+         */
+        nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+        commitTime = expectedPresentTime - mVsyncPeriod / EXPECTED_PRESENT_COMMIT_RATIO;
+        hold = commitTime - now;
+
+        if (hold <= 0)
+            return;
+
+        if (hold > EXPECTED_PRESENT_MAX_HOLD) {
+            DISPLAY_LOGD(eDebugDefault, "%s:: expected present time is %" PRId64 " ns later",
+                    __func__, expectedPresentTime - now);
+            return;
+        }
+    }
+
+    ATRACE_NAME("waitForExpectedPresentTime");
+
+    /* mDisplayMutex is not held while sleeping not to block the other calls */
+    struct timespec ts;
+    ts.tv_sec = commitTime / s2ns(1);
+    ts.tv_nsec = commitTime % s2ns(1);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+
+    Mutex::Autolock lock(mDisplayMutex);
+    mPresentHoldCount.held++;
+    mPresentHoldCount.lastHold = hold;
+}
+
 /**
  * @return int
  */
@@ -911,67 +1232,81 @@ int ExynosDisplay::handleStaticLayers(ExynosCompositionInfo& compositionInfo)
     return NO_ERROR;
 }
 
+static inline void hashCombine(size_t &seed, size_t value)
+{
+    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+void ExynosLayerSignature::set(const exynos_image &src, const exynos_image &dst)
+{
+    bufferHandle = src.bufferHandle;
+    srcX = src.x;
+    srcY = src.y;
+    srcW = src.w;
+    srcH = src.h;
+    dstX = dst.x;
+    dstY = dst.y;
+    dstW = dst.w;
+    dstH = dst.h;
+    dataSpace = src.dataSpace;
+    blending = src.blending;
+    transform = src.transform;
+    planeAlpha = src.planeAlpha;
+
+    hash = std::hash<const void *>()(bufferHandle);
+    hashCombine(hash, ((size_t)srcX << 16) ^ srcY);
+    hashCombine(hash, ((size_t)srcW << 16) ^ srcH);
+    hashCombine(hash, ((size_t)dstX << 16) ^ dstY);
+    hashCombine(hash, ((size_t)dstW << 16) ^ dstH);
+    hashCombine(hash, (size_t)dataSpace);
+    hashCombine(hash, ((size_t)blending << 16) ^ transform);
+    hashCombine(hash, std::hash<float>()(planeAlpha));
+}
+
+bool ExynosLayerSignature::operator==(const ExynosLayerSignature &rhs) const
+{
+    return (hash == rhs.hash) &&
+        (bufferHandle == rhs.bufferHandle) &&
+        (srcX == rhs.srcX) && (srcY == rhs.srcY) &&
+        (srcW == rhs.srcW) && (srcH == rhs.srcH) &&
+        (dstX == rhs.dstX) && (dstY == rhs.dstY) &&
+        (dstW == rhs.dstW) && (dstH == rhs.dstH) &&
+        (dataSpace == rhs.dataSpace) && (blending == rhs.blending) &&
+        (transform == rhs.transform) && (planeAlpha == rhs.planeAlpha);
+}
+
 bool ExynosDisplay::skipStaticLayerChanged(ExynosCompositionInfo& compositionInfo)
 {
-    if ((int)compositionInfo.mSkipSrcInfo.srcNum !=
-            (compositionInfo.mLastIndex - compositionInfo.mFirstIndex + 1)) {
-        DISPLAY_LOGD(eDebugSkipStaicLayer, "Client composition number is changed (%d -> %d)",
-                compositionInfo.mSkipSrcInfo.srcNum,
-                compositionInfo.mLastIndex - compositionInfo.mFirstIndex + 1);
+    ExynosFrameInfo &frameInfo = compositionInfo.mSkipSrcInfo;
+    size_t srcNum = compositionInfo.mLastIndex - compositionInfo.mFirstIndex + 1;
+
+    if (frameInfo.layers.size() != srcNum) {
+        DISPLAY_LOGD(eDebugSkipStaicLayer, "Client composition number is changed (%zu -> %zu)",
+                frameInfo.layers.size(), srcNum);
         return true;
     }
 
-    bool isChanged = false;
     for (size_t i = (size_t)compositionInfo.mFirstIndex; i <= (size_t)compositionInfo.mLastIndex; i++) {
         ExynosLayer *layer = mLayers[i];
-        size_t index = i - compositionInfo.mFirstIndex;
-        if ((layer->mLayerBuffer == NULL) ||
-            (compositionInfo.mSkipSrcInfo.srcInfo[index].bufferHandle != layer->mLayerBuffer))
-        {
-            isChanged = true;
-            DISPLAY_LOGD(eDebugSkipStaicLayer, "layer[%zu] handle is changed"\
-                    " handle(%p -> %p), layerFlag(0x%8x)",
-                    i, compositionInfo.mSkipSrcInfo.srcInfo[index].bufferHandle,
-                    layer->mLayerBuffer, layer->mLayerFlag);
-            break;
-        } else if ((compositionInfo.mSkipSrcInfo.srcInfo[index].x != layer->mSrcImg.x) ||
-                (compositionInfo.mSkipSrcInfo.srcInfo[index].y != layer->mSrcImg.y) ||
-                (compositionInfo.mSkipSrcInfo.srcInfo[index].w != layer->mSrcImg.w) ||
-                (compositionInfo.mSkipSrcInfo.srcInfo[index].h != layer->mSrcImg.h) ||
-                (compositionInfo.mSkipSrcInfo.srcInfo[index].dataSpace != layer->mSrcImg.dataSpace) ||
-                (compositionInfo.mSkipSrcInfo.srcInfo[index].blending != layer->mSrcImg.blending) ||
-                (compositionInfo.mSkipSrcInfo.srcInfo[index].transform != layer->mSrcImg.transform) ||
-                (compositionInfo.mSkipSrcInfo.srcInfo[index].planeAlpha != layer->mSrcImg.planeAlpha))
-        {
-            isChanged = true;
-            DISPLAY_LOGD(eDebugSkipStaicLayer, "layer[%zu] source info is changed, "\
-                    "x(%d->%d), y(%d->%d), w(%d->%d), h(%d->%d), dataSpace(%d->%d), "\
-                    "blending(%d->%d), transform(%d->%d), planeAlpha(%3.1f->%3.1f)", i,
-                    compositionInfo.mSkipSrcInfo.srcInfo[index].x, layer->mSrcImg.x,
-                    compositionInfo.mSkipSrcInfo.srcInfo[index].y, layer->mSrcImg.y,
-                    compositionInfo.mSkipSrcInfo.srcInfo[index].w,  layer->mSrcImg.w,
-                    compositionInfo.mSkipSrcInfo.srcInfo[index].h,  layer->mSrcImg.h,
-                    compositionInfo.mSkipSrcInfo.srcInfo[index].dataSpace, layer->mSrcImg.dataSpace,
-                    compositionInfo.mSkipSrcInfo.srcInfo[index].blending, layer->mSrcImg.blending,
-                    compositionInfo.mSkipSrcInfo.srcInfo[index].transform, layer->mSrcImg.transform,
-                    compositionInfo.mSkipSrcInfo.srcInfo[index].planeAlpha, layer->mSrcImg.planeAlpha);
-            break;
-        } else if ((compositionInfo.mSkipSrcInfo.dstInfo[index].x != layer->mDstImg.x) ||
-                (compositionInfo.mSkipSrcInfo.dstInfo[index].y != layer->mDstImg.y) ||
-                (compositionInfo.mSkipSrcInfo.dstInfo[index].w != layer->mDstImg.w) ||
-                (compositionInfo.mSkipSrcInfo.dstInfo[index].h != layer->mDstImg.h))
-        {
-            isChanged = true;
-            DISPLAY_LOGD(eDebugSkipStaicLayer, "layer[%zu] dst info is changed, "\
-                    "x(%d->%d), y(%d->%d), w(%d->%d), h(%d->%d)", i,
-                    compositionInfo.mSkipSrcInfo.dstInfo[index].x, layer->mDstImg.x,
-                    compositionInfo.mSkipSrcInfo.dstInfo[index].y, layer->mDstImg.y,
-                    compositionInfo.mSkipSrcInfo.dstInfo[index].w, layer->mDstImg.w,
-                    compositionInfo.mSkipSrcInfo.dstInfo[index].h, layer->mDstImg.h);
-            break;
+        const ExynosLayerSignature &last = frameInfo.layers[i - compositionInfo.mFirstIndex];
+        ExynosLayerSignature signature;
+
+        if (layer->mLayerBuffer == NULL) {
+            DISPLAY_LOGD(eDebugSkipStaicLayer, "layer[%zu] has no buffer, layerFlag(0x%8x)",
+                    i, layer->mLayerFlag);
+            return true;
+        }
+
+        signature.set(layer->mSrcImg, layer->mDstImg);
+        if (signature != last) {
+            DISPLAY_LOGD(eDebugSkipStaicLayer, "layer[%zu] is changed, "\
+                    "handle(%p -> %p), hash(%zx -> %zx), layerFlag(0x%8x)",
+                    i, last.bufferHandle, signature.bufferHandle,
+                    last.hash, signature.hash, layer->mLayerFlag);
+            return true;
         }
     }
-    return isChanged;
+    return false;
 }
 
 /**
@@ -995,8 +1330,7 @@ int ExynosDisplay::skipStaticLayers(ExynosCompositionInfo& compositionInfo)
 
     if ((compositionInfo.mHasCompositionLayer == false) ||
         (compositionInfo.mFirstIndex < 0) ||
-        (compositionInfo.mLastIndex < 0) ||
-        ((compositionInfo.mLastIndex - compositionInfo.mFirstIndex + 1) > NUM_SKIP_STATIC_LAYER)) {
+        (compositionInfo.mLastIndex < 0)) {
         DISPLAY_LOGD(eDebugSkipStaicLayer, "mHasCompositionLayer(%d), mFirstIndex(%d), mLastIndex(%d)",
                 compositionInfo.mHasCompositionLayer,
                 compositionInfo.mFirstIndex, compositionInfo.mLastIndex);
@@ -1004,13 +1338,9 @@ int ExynosDisplay::skipStaticLayers(ExynosCompositionInfo& compositionInfo)
         return NO_ERROR;
     }
 
-    if (compositionInfo.mSkipStaticInitFlag) {
-        bool isChanged = skipStaticLayerChanged(compositionInfo);
-        if (isChanged == true) {
-            compositionInfo.mSkipStaticInitFlag = false;
-            return NO_ERROR;
-        }
-
+    /* The signatures of this frame are cached right away if any layer is changed */
+    if (compositionInfo.mSkipStaticInitFlag &&
+        (skipStaticLayerChanged(compositionInfo) == false)) {
         for (size_t i = (size_t)compositionInfo.mFirstIndex; i <= (size_t)compositionInfo.mLastIndex; i++) {
             ExynosLayer *layer = mLayers[i];
             if (layer->mValidateCompositionType == COMPOSITION_CLIENT) {
@@ -1033,23 +1363,17 @@ int ExynosDisplay::skipStaticLayers(ExynosCompositionInfo& compositionInfo)
     }
 
     compositionInfo.mSkipStaticInitFlag = true;
-    memset(&compositionInfo.mSkipSrcInfo, 0, sizeof(compositionInfo.mSkipSrcInfo));
-    for (int i = 0; i < NUM_SKIP_STATIC_LAYER; i++) {
-        compositionInfo.mSkipSrcInfo.srcInfo[i].acquireFenceFd = -1;
-        compositionInfo.mSkipSrcInfo.srcInfo[i].releaseFenceFd = -1;
-        compositionInfo.mSkipSrcInfo.dstInfo[i].acquireFenceFd = -1;
-        compositionInfo.mSkipSrcInfo.dstInfo[i].releaseFenceFd = -1;
-    }
+    compositionInfo.mSkipSrcInfo.clear();
 
     for (size_t i = (size_t)compositionInfo.mFirstIndex; i <= (size_t)compositionInfo.mLastIndex; i++) {
         ExynosLayer *layer = mLayers[i];
-        size_t index = i - compositionInfo.mFirstIndex;
-        compositionInfo.mSkipSrcInfo.srcInfo[index] = layer->mSrcImg;
-        compositionInfo.mSkipSrcInfo.dstInfo[index] = layer->mDstImg;
-        DISPLAY_LOGD(eDebugSkipStaicLayer, "mSkipSrcInfo.srcInfo[%zu] is initialized, %p",
-                index, layer->mSrcImg.bufferHandle);
+        ExynosLayerSignature signature;
+
+        signature.set(layer->mSrcImg, layer->mDstImg);
+        compositionInfo.mSkipSrcInfo.layers.push_back(signature);
+        DISPLAY_LOGD(eDebugSkipStaicLayer, "mSkipSrcInfo.layers[%zu] is initialized, %p",
+                i - compositionInfo.mFirstIndex, layer->mSrcImg.bufferHandle);
     }
-    compositionInfo.mSkipSrcInfo.srcNum = (compositionInfo.mLastIndex - compositionInfo.mFirstIndex + 1);
     return NO_ERROR;
 }
 
@@ -1111,79 +1435,164 @@ bool ExynosDisplay::validateExynosCompositionLayer()
 }
 
 /**
+ * Updates the source images of exynos composition before doPostProcessing()
+ * of mExynosCompositionInfo.mM2mMPP
  * @return int
  */
-int ExynosDisplay::doExynosComposition() {
+int ExynosDisplay::prepareExynosComposition() {
+    if (mExynosCompositionInfo.mM2mMPP == NULL) {
+        DISPLAY_LOGE("mExynosCompositionInfo.mM2mMPP is NULL");
+        return -EINVAL;
+    }
+    mExynosCompositionInfo.mM2mMPP->requestHWStateChange(MPP_HW_STATE_RUNNING);
+    /* mAcquireFence is updated, Update image info */
+    for (int32_t i = mExynosCompositionInfo.mFirstIndex; i <= mExynosCompositionInfo.mLastIndex; i++) {
+        /* break when only framebuffer target is assigned on ExynosCompositor */
+        if (i == -1)
+            break;
+
+        struct exynos_image srcImg, dstImg;
+        mLayers[i]->setSrcExynosImage(&srcImg);
+        dumpExynosImage(eDebugFence, srcImg);
+        mLayers[i]->setDstExynosImage(&dstImg);
+        mLayers[i]->setExynosImage(srcImg, dstImg);
+    }
+
+    /* For debugging */
+    if (validateExynosCompositionLayer() == false) {
+        DISPLAY_LOGE("mExynosCompositionInfo is not valid");
+        return -EINVAL;
+    }
+
+    return NO_ERROR;
+}
+
+/**
+ * Sets the output of exynos composition to the composition target
+ * after doPostProcessing() of mExynosCompositionInfo.mM2mMPP succeeded
+ * @return int
+ */
+int ExynosDisplay::finishExynosComposition() {
     int ret = NO_ERROR;
     exynos_image src_img;
     exynos_image dst_img;
 
-    if (mExynosCompositionInfo.mHasCompositionLayer) {
-        if (mExynosCompositionInfo.mM2mMPP == NULL) {
-            DISPLAY_LOGE("mExynosCompositionInfo.mM2mMPP is NULL");
-            return -EINVAL;
-        }
-        mExynosCompositionInfo.mM2mMPP->requestHWStateChange(MPP_HW_STATE_RUNNING);
-        /* mAcquireFence is updated, Update image info */
-        for (int32_t i = mExynosCompositionInfo.mFirstIndex; i <= mExynosCompositionInfo.mLastIndex; i++) {
-            /* break when only framebuffer target is assigned on ExynosCompositor */
-            if (i == -1)
-                break;
+    for (int32_t i = mExynosCompositionInfo.mFirstIndex; i <= mExynosCompositionInfo.mLastIndex; i++) {
+        /* break when only framebuffer target is assigned on ExynosCompositor */
+        if (i == -1)
+            break;
+        /* This should be closed by resource lib (libmpp or libacryl) */
+        mLayers[i]->mAcquireFence = -1;
+    }
 
-            struct exynos_image srcImg, dstImg;
-            mLayers[i]->setSrcExynosImage(&srcImg);
-            dumpExynosImage(eDebugFence, srcImg);
-            mLayers[i]->setDstExynosImage(&dstImg);
-            mLayers[i]->setExynosImage(srcImg, dstImg);
-        }
+    exynos_image outImage;
+    if ((ret = mExynosCompositionInfo.mM2mMPP->getDstImageInfo(&outImage)) != NO_ERROR) {
+        DISPLAY_LOGE("exynosComposition getDstImageInfo fail ret(%d)", ret);
+        return ret;
+    }
 
-        /* For debugging */
-        if (validateExynosCompositionLayer() == false) {
-            DISPLAY_LOGE("mExynosCompositionInfo is not valid");
-            return -EINVAL;
-        }
+    android_dataspace dataspace = HAL_DATASPACE_UNKNOWN;
+    if (mColorMode != HAL_COLOR_MODE_NATIVE)
+        dataspace = colorModeToDataspace(mColorMode);
+    mExynosCompositionInfo.setTargetBuffer(this, outImage.bufferHandle,
+            outImage.acquireFenceFd, dataspace);
+    /*
+     * buffer handle, dataspace can be changed by setTargetBuffer()
+     * ExynosImage should be set again according to changed handle and dataspace
+     */
+    setCompositionTargetExynosImage(COMPOSITION_EXYNOS, &src_img, &dst_img);
+    mExynosCompositionInfo.setExynosImage(src_img, dst_img);
 
-        if ((ret = mExynosCompositionInfo.mM2mMPP->doPostProcessing(mExynosCompositionInfo.mSrcImg,
-                mExynosCompositionInfo.mDstImg)) != NO_ERROR) {
-            DISPLAY_LOGE("exynosComposition doPostProcessing fail ret(%d)", ret);
-            return ret;
-        }
+    DISPLAY_LOGD(eDebugFence, "mExynosCompositionInfo acquireFencefd(%d)",
+            mExynosCompositionInfo.mAcquireFence);
+    // Test..
+    // setFenceInfo(mExynosCompositionInfo.mAcquireFence, this, "G2D_DST_ACQ", FENCE_FROM);
 
-        for (int32_t i = mExynosCompositionInfo.mFirstIndex; i <= mExynosCompositionInfo.mLastIndex; i++) {
-            /* break when only framebuffer target is assigned on ExynosCompositor */
-            if (i == -1)
-                break;
-            /* This should be closed by resource lib (libmpp or libacryl) */
-            mLayers[i]->mAcquireFence = -1;
-        }
+    if ((ret =  mExynosCompositionInfo.mM2mMPP->resetDstAcquireFence()) != NO_ERROR)
+    {
+        DISPLAY_LOGE("exynosComposition resetDstAcquireFence fail ret(%d)", ret);
+        return ret;
+    }
+
+    return ret;
+}
 
-        exynos_image outImage;
-        if ((ret = mExynosCompositionInfo.mM2mMPP->getDstImageInfo(&outImage)) != NO_ERROR) {
-            DISPLAY_LOGE("exynosComposition getDstImageInfo fail ret(%d)", ret);
+/**
+ * Runs exynos composition and the M2M post-processing of the device layers
+ * on mPostProcessingDispatcher. The jobs of the different MPPs run
+ * concurrently and all of them are done when this function returns.
+ * @param validated : select the layers by mValidateCompositionType instead of
+ *                    mExynosCompositionType
+ * @return int32_t
+ */
+int32_t ExynosDisplay::dispatchPostProcessing(bool validated, String8 &errString) {
+    ATRACE_CALL();
+    int32_t ret = NO_ERROR;
+    ExynosPostProcessingDispatcher &dispatcher = mPostProcessingDispatcher;
+    bool exynosComposition = mExynosCompositionInfo.mHasCompositionLayer;
+    size_t exynosCompositionJob = 0;
+    /* index of the job of each layer */
+    std::vector<ssize_t> layerJobs(mLayers.size(), -1);
+
+    if (exynosComposition) {
+        if ((ret = prepareExynosComposition()) != NO_ERROR) {
+            errString.appendFormat("exynosComposition fail (%d)\n", ret);
             return ret;
         }
+        ExynosMPP *m2mMpp = mExynosCompositionInfo.mM2mMPP;
+        exynosCompositionJob = dispatcher.submit(m2mMpp, [this, m2mMpp]() {
+            return m2mMpp->doPostProcessing(mExynosCompositionInfo.mSrcImg,
+                    mExynosCompositionInfo.mDstImg);
+        });
+    }
 
-        android_dataspace dataspace = HAL_DATASPACE_UNKNOWN;
-        if (mColorMode != HAL_COLOR_MODE_NATIVE)
-            dataspace = colorModeToDataspace(mColorMode);
-        mExynosCompositionInfo.setTargetBuffer(this, outImage.bufferHandle,
-                outImage.acquireFenceFd, dataspace);
-        /*
-         * buffer handle, dataspace can be changed by setTargetBuffer()
-         * ExynosImage should be set again according to changed handle and dataspace
-         */
-        setCompositionTargetExynosImage(COMPOSITION_EXYNOS, &src_img, &dst_img);
-        mExynosCompositionInfo.setExynosImage(src_img, dst_img);
+    for (size_t i = 0; i < mLayers.size(); i++) {
+        int32_t type = validated ? mLayers[i]->mValidateCompositionType :
+                                   mLayers[i]->mExynosCompositionType;
+        if ((type != HWC2_COMPOSITION_DEVICE) || (mLayers[i]->mM2mMPP == NULL))
+            continue;
 
-        DISPLAY_LOGD(eDebugFence, "mExynosCompositionInfo acquireFencefd(%d)",
-                mExynosCompositionInfo.mAcquireFence);
-        // Test..
-        // setFenceInfo(mExynosCompositionInfo.mAcquireFence, this, "G2D_DST_ACQ", FENCE_FROM);
+        /* mAcquireFence is updated, Update image info */
+        struct exynos_image srcImg, dstImg;
+        mLayers[i]->setSrcExynosImage(&srcImg);
+        mLayers[i]->setDstExynosImage(&dstImg);
+        mLayers[i]->setExynosImage(srcImg, dstImg);
+        ExynosMPP *m2mMpp = mLayers[i]->mM2mMPP;
+        m2mMpp->requestHWStateChange(MPP_HW_STATE_RUNNING);
+        /* doPostProcessing() updates the images that are the copies of the layer */
+        layerJobs[i] = dispatcher.submit(m2mMpp, [m2mMpp, src = mLayers[i]->mSrcImg,
+                mid = mLayers[i]->mMidImg]() mutable {
+            return m2mMpp->doPostProcessing(src, mid);
+        });
+    }
 
-        if ((ret =  mExynosCompositionInfo.mM2mMPP->resetDstAcquireFence()) != NO_ERROR)
-        {
-            DISPLAY_LOGE("exynosComposition resetDstAcquireFence fail ret(%d)", ret);
-            return ret;
+    dispatcher.join();
+
+    if (exynosComposition) {
+        if ((ret = dispatcher.getResult(exynosCompositionJob)) != NO_ERROR)
+            DISPLAY_LOGE("exynosComposition doPostProcessing fail ret(%d)", ret);
+        else
+            ret = finishExynosComposition();
+
+        if (ret != NO_ERROR)
+            errString.appendFormat("exynosComposition fail (%d)\n", ret);
+    }
+
+    for (size_t i = 0; i < mLayers.size(); i++) {
+        if (layerJobs[i] < 0)
+            continue;
+
+        int32_t jobRet = dispatcher.getResult(layerJobs[i]);
+        if (jobRet != NO_ERROR) {
+            DISPLAY_LOGE("%s:: doPostProcessing() failed, layer(%zu), ret(%d)",
+                    __func__, i, jobRet);
+            errString.appendFormat("%s:: doPostProcessing() failed, layer(%zu), ret(%d)\n",
+                    __func__, i, jobRet);
+            if (ret == NO_ERROR)
+                ret = jobRet;
+        } else {
+            /* This should be closed by lib for each resource */
+            mLayers[i]->mAcquireFence = -1;
         }
     }
 
@@ -1826,13 +2235,12 @@ void ExynosDisplay::printDebugInfos(String8 &reason)
     /* Fence Tracer Information */
     ExynosDevice *device = mDevice;
     if (device != NULL) {
-        for (auto it = device->mFenceInfo.begin(); it != device->mFenceInfo.end(); ++it) {
-
-            uint32_t i = it->first;
+        uint32_t limit = device->mFenceTracer.getFdLimit();
+        for (uint32_t i = 0; i < limit; i++) {
+            hwc_fence_info_t info;
 
-            if (device->mFenceInfo.count(i) == 0 ) continue;
+            if (!device->mFenceTracer.read(i, info)) continue;
 
-            hwc_fence_info_t info = device->mFenceInfo.at(i);
             if (info.usage >= 1 && !info.pendingAllowed) {
                 result.appendFormat("\nFD hwc : %d, usage %d, pending : %d\n", i, info.usage, (int)info.pendingAllowed);
                 for (int j = 0; j < MAX_FENCE_SEQUENCE; j++) {
@@ -1842,14 +2250,7 @@ void ExynosDisplay::printDebugInfos(String8 &reason)
                             GET_STRING(fence_ip_map, seq->ip), GET_STRING(fence_type_map, seq->type),
                             seq->curFlag, seq->usage, (int)seq->isLast);
 
-                    tv = seq->time;
-                    localTime = (struct tm*)localtime((time_t*)&tv.tv_sec);
-
-                    result.appendFormat(" - time:%02d-%02d %02d:%02d:%02d.%03lu(%lu)\n",
-                            localTime->tm_mon+1, localTime->tm_mday,
-                            localTime->tm_hour, localTime->tm_min,
-                            localTime->tm_sec, tv.tv_usec/1000,
-                            ((tv.tv_sec * 1000) + (tv.tv_usec / 1000)));
+                    result.appendFormat(" - time:%s\n", getFenceTraceTime(seq->time).string());
                     if (pFile != NULL) {
                         fwrite(result.string(), 1, result.size(), pFile);
                     }
@@ -2341,7 +2742,7 @@ int32_t ExynosDisplay::createLayer(hwc2_layer_t* outLayer) {
     /* TODO : Sort sequence should be added to somewhere */
     mLayers.add((ExynosLayer*)layer);
 
-    *outLayer = (hwc2_layer_t)layer;
+    *outLayer = allocLayerHandle(layer);
     setGeometryChanged(GEOMETRY_DISPLAY_LAYER_ADDED);
 
     return HWC2_ERROR_NONE;
@@ -2407,7 +2808,7 @@ int32_t ExynosDisplay::getChangedCompositionTypes(
             count++;
         } else {
             if (count < num) {
-                out_layers[count] = (hwc2_layer_t)layer;
+                out_layers[count] = layer->mHandle;
                 out_types[count] = type;
                 count++;
             } else {
@@ -2556,7 +2957,7 @@ int32_t ExynosDisplay::getDisplayRequests(
                                 __func__, requestNum, *outNumElements);
                         goto err;
                     }
-                    outLayers[requestNum] = (hwc2_layer_t)layer;
+                    outLayers[requestNum] = layer->mHandle;
                     outLayerRequests[requestNum] = HWC2_LAYER_REQUEST_CLEAR_CLIENT_TARGET;
                 }
                 requestNum++;
@@ -2618,7 +3019,7 @@ int32_t ExynosDisplay::getReleaseFences(
                 if (deviceLayerNum < *outNumElements) {
                     // transfer fence ownership to the caller
                     setFenceName(mLayers[i]->mReleaseFence, FENCE_LAYER_RELEASE_DPP);
-                    outLayers[deviceLayerNum] = (hwc2_layer_t)mLayers[i];
+                    outLayers[deviceLayerNum] = mLayers[i]->mHandle;
                     outFences[deviceLayerNum] = mLayers[i]->mReleaseFence;
                     mLayers[i]->mReleaseFence = -1;
 
@@ -2802,8 +3203,12 @@ int32_t ExynosDisplay::presentDisplay(int32_t* outRetireFence) {
         setTaskProfileDone = true;
     }
 
+    waitForExpectedPresentTime();
+
     Mutex::Autolock lock(mDisplayMutex);
 
+    updateLayerLookupCount();
+
     if (mResChanged && !isFullScreenComposition()) {
         ALOGD("presentDisplay: drop invalid frame during resolution switch");
         mNeedSkipPresent = true;
@@ -2906,15 +3311,14 @@ int32_t ExynosDisplay::presentDisplay(int32_t* outRetireFence) {
     }
 
     if ((mDisplayControl.earlyStartMPP == false) &&
-        ((ret = doExynosComposition()) != NO_ERROR)) {
-        errString.appendFormat("exynosComposition fail (%d)\n", ret);
+        ((ret = dispatchPostProcessing(false, errString)) != NO_ERROR)) {
         goto err;
     }
 
     // loop for all layer
     for (size_t i=0; i < mLayers.size(); i++) {
         /* mAcquireFence is updated, Update image info */
-        struct exynos_image srcImg, dstImg, midImg;
+        struct exynos_image srcImg, dstImg;
         mLayers[i]->setSrcExynosImage(&srcImg);
         mLayers[i]->setDstExynosImage(&dstImg);
         mLayers[i]->setExynosImage(srcImg, dstImg);
@@ -2930,25 +3334,6 @@ int32_t ExynosDisplay::presentDisplay(int32_t* outRetireFence) {
             if (mLayers[i]->mOtfMPP != NULL) {
                 mLayers[i]->mOtfMPP->requestHWStateChange(MPP_HW_STATE_RUNNING);
             }
-
-            if ((mDisplayControl.earlyStartMPP == false) &&
-                (mLayers[i]->mExynosCompositionType == HWC2_COMPOSITION_DEVICE) &&
-                (mLayers[i]->mM2mMPP != NULL)) {
-                ExynosMPP *m2mMpp = mLayers[i]->mM2mMPP;
-                srcImg = mLayers[i]->mSrcImg;
-                midImg = mLayers[i]->mMidImg;
-                m2mMpp->requestHWStateChange(MPP_HW_STATE_RUNNING);
-                if ((ret = m2mMpp->doPostProcessing(srcImg, midImg)) != NO_ERROR) {
-                    HWC_LOGE(this, "%s:: doPostProcessing() failed, layer(%zu), ret(%d)",
-                            __func__, i, ret);
-                    errString.appendFormat("%s:: doPostProcessing() failed, layer(%zu), ret(%d)\n",
-                            __func__, i, ret);
-                    goto err;
-                } else {
-                    /* This should be closed by lib for each resource */
-                    mLayers[i]->mAcquireFence = -1;
-                }
-            }
         }
     }
 
@@ -3623,6 +4008,7 @@ int32_t ExynosDisplay::forceSkipValidateDisplay(
     int ret = 0;
     mUpdateEventCnt++;
     mLastUpdateTimeStamp = systemTime(SYSTEM_TIME_MONOTONIC);
+    updateIdleDeadline();
 
     HDEBUGLOGD(eDebugResourceManager,
             "%s validate is forced to be skipped",
@@ -3679,6 +4065,7 @@ int32_t ExynosDisplay::validateDisplay(
     checkLayerFps();
     if (exynosHWCControl.useDynamicRecomp == true && mDREnable)
         checkDynamicReCompMode();
+    updateIdleDeadline();
 
     if (exynosHWCControl.useDynamicRecomp == true &&
         mDevice->isDynamicRecompositionThreadAlive() == false &&
@@ -3787,36 +4174,9 @@ int32_t ExynosDisplay::startPostProcessing()
         return -EINVAL;
     }
 
-    if ((ret = doExynosComposition()) != NO_ERROR) {
-        errString.appendFormat("exynosComposition fail (%d)\n", ret);
+    if ((ret = dispatchPostProcessing(true, errString)) != NO_ERROR)
         goto err;
-    }
 
-    // loop for all layer
-    for (size_t i=0; i < mLayers.size(); i++) {
-        if((mLayers[i]->mValidateCompositionType == HWC2_COMPOSITION_DEVICE) &&
-           (mLayers[i]->mM2mMPP != NULL)) {
-            /* mAcquireFence is updated, Update image info */
-            struct exynos_image srcImg, dstImg, midImg;
-            mLayers[i]->setSrcExynosImage(&srcImg);
-            mLayers[i]->setDstExynosImage(&dstImg);
-            mLayers[i]->setExynosImage(srcImg, dstImg);
-            ExynosMPP *m2mMpp = mLayers[i]->mM2mMPP;
-            srcImg = mLayers[i]->mSrcImg;
-            midImg = mLayers[i]->mMidImg;
-            m2mMpp->requestHWStateChange(MPP_HW_STATE_RUNNING);
-            if ((ret = m2mMpp->doPostProcessing(srcImg, midImg)) != NO_ERROR) {
-                DISPLAY_LOGE("%s:: doPostProcessing() failed, layer(%zu), ret(%d)",
-                        __func__, i, ret);
-                errString.appendFormat("%s:: doPostProcessing() failed, layer(%zu), ret(%d)\n",
-                        __func__, i, ret);
-                goto err;
-            } else {
-                /* This should be closed by lib for each resource */
-                mLayers[i]->mAcquireFence = -1;
-            }
-        }
-    }
     return ret;
 err:
     printDebugInfos(errString);
@@ -3878,6 +4238,16 @@ void ExynosDisplay::dump(String8& result)
             layer->dump(result);
         }
     }
+    result.appendFormat("layer lookups: last frame %u (failed %u), max %u, handle slots %zu (free %zu)\n",
+            mLastFrameLayerLookupCount.lookups, mLastFrameLayerLookupCount.failures,
+            mMaxFrameLayerLookups, mLayerSlots.size(), mFreeLayerSlots.size());
+    result.appendFormat("resource assignment: full %" PRIu64 ", incremental %" PRIu64 " (last reused layers %u)\n",
+            mResourceAssignCount.full, mResourceAssignCount.incremental,
+            mResourceAssignCount.lastReusedLayers);
+    result.appendFormat("expected present time: %" PRIu64 " frames, %" PRIu64 " held (last %" PRId64 " us)\n",
+            mPresentHoldCount.frames, mPresentHoldCount.held,
+            ns2us(mPresentHoldCount.lastHold));
+    mPostProcessingDispatcher.dump(result);
     result.appendFormat("\n");
 }
 
@@ -17,7 +17,9 @@
 #ifndef _EXYNOSDISPLAY_H
 #define _EXYNOSDISPLAY_H
 
+#include <atomic>
 #include <fstream>
+#include <functional>
 
 #include <utils/Vector.h>
 #include <utils/KeyedVector.h>
@@ -42,6 +44,18 @@
 #define HWC_PRINT_FRAME_NUM     10
 
 #define LOW_FPS_THRESHOLD     5
+/* Weight of the latest frame interval in the rolling fps of a layer */
+#define FPS_AVERAGE_WEIGHT    4
+#define FPS_MAX_INTERVAL      ms2ns(250)
+
+/*
+ * presentDisplay() commits a frame for an expected present time this much of
+ * the vsync period before it so that the frame is latched by that vsync and
+ * not by the previous one.
+ */
+#define EXPECTED_PRESENT_COMMIT_RATIO   2
+/* The longest time that presentDisplay() holds a frame */
+#define EXPECTED_PRESENT_MAX_HOLD       ms2ns(100)
 
 #if defined(HDR_CAPABILITIES_NUM)
 #define SET_HDR_CAPABILITIES_NUM HDR_CAPABILITIES_NUM
@@ -114,12 +128,32 @@ class AssignedResourceVector : public android::SortedVector< resource_set_t* > {
         virtual int do_compare(const void* lhs, const void* rhs) const;
 };
 
-#define NUM_SKIP_STATIC_LAYER  5
+/*
+ * The attributes of a layer that the client target is composited from.
+ * hash rejects most of the changed layers without comparing the fields.
+ */
+struct ExynosLayerSignature
+{
+    private_handle_t *bufferHandle;
+    uint32_t srcX, srcY, srcW, srcH;
+    uint32_t dstX, dstY, dstW, dstH;
+    android_dataspace dataSpace;
+    uint32_t blending;
+    uint32_t transform;
+    float planeAlpha;
+    size_t hash;
+
+    void set(const exynos_image &src, const exynos_image &dst);
+    bool operator==(const ExynosLayerSignature &rhs) const;
+    bool operator!=(const ExynosLayerSignature &rhs) const { return !(*this == rhs); }
+};
+
+/* The signatures of the client composition layers in z-order */
 struct ExynosFrameInfo
 {
-    uint32_t srcNum;
-    exynos_image srcInfo[NUM_SKIP_STATIC_LAYER];
-    exynos_image dstInfo[NUM_SKIP_STATIC_LAYER];
+    std::vector<ExynosLayerSignature> layers;
+
+    void clear() { layers.clear(); }
 };
 
 struct exynos_readback_info
@@ -334,6 +368,8 @@ struct DisplayControl {
     bool cursorSupport;
     /** readback support **/
     bool readbackSupport = false;
+    /** Hold the commit of a frame until its expected present time **/
+    bool holdUntilExpectedPresent;
 };
 
 typedef struct hiberState {
@@ -341,6 +377,77 @@ typedef struct hiberState {
     bool exitRequested = false;
 } hiberState_t;
 
+/**
+ * Runs the M2M post-processing jobs of a frame concurrently.
+ * The jobs are grouped by the physical MPP. The groups run on the worker
+ * threads and on the caller of join() at the same time while the jobs of a
+ * group run in the order of submission. join() returns when all jobs are
+ * done so that the caller handles the results as if the jobs ran serially.
+ */
+class ExynosPostProcessingDispatcher {
+    public:
+        enum {
+            MAX_WORKERS = 2,
+        };
+
+        struct Stats {
+            uint64_t frames;
+            /* frames having more than one group */
+            uint64_t parallelFrames;
+            /* sum of the durations of the jobs of the last frame */
+            nsecs_t lastSerialTime;
+            /* duration of join() of the last frame */
+            nsecs_t lastCriticalTime;
+            nsecs_t totalSerialTime;
+            nsecs_t totalCriticalTime;
+        };
+
+        ExynosPostProcessingDispatcher();
+        ~ExynosPostProcessingDispatcher();
+
+        /* @return index of the job to get the result with getResult() */
+        size_t submit(ExynosMPP *mpp, std::function<int32_t()> job);
+        void join();
+        /* valid until the next submit() after join() */
+        int32_t getResult(size_t index) { return mJobs[index].ret; }
+        size_t getJobCount() { return mJobs.size(); }
+        void dump(String8& result);
+
+    private:
+        class WorkerThread: public Thread {
+            public:
+                WorkerThread(ExynosPostProcessingDispatcher *dispatcher)
+                    : mDispatcher(dispatcher) {};
+                virtual bool threadLoop() { return mDispatcher->runWorker(); };
+            private:
+                ExynosPostProcessingDispatcher *mDispatcher;
+        };
+
+        struct Job {
+            ExynosMPP *mpp;
+            std::function<int32_t()> func;
+            int32_t ret;
+            nsecs_t duration;
+        };
+
+        bool startWorkers();
+        bool runWorker();
+        void runGroup(size_t group);
+
+        std::vector<Job> mJobs;
+        /* indexes of mJobs of each physical MPP */
+        std::vector<std::vector<size_t>> mGroups;
+        size_t mNextGroup;
+        size_t mPendingGroups;
+        bool mExit;
+        Mutex mMutex;
+        Condition mWorkCondition;
+        Condition mDoneCondition;
+        sp<WorkerThread> mWorkers[MAX_WORKERS];
+        uint32_t mWorkerCount;
+        Stats mStats;
+};
+
 class ExynosDisplay {
     public:
         uint32_t mDisplayId;
@@ -386,6 +493,43 @@ class ExynosDisplay {
         ExynosSortedLayer mLayers;
         std::vector<ExynosLayer*> mIgnoreLayers;
 
+        /**
+         * Layer handle table
+         * hwc2_layer_t given to the composer is (generation << 32) | (slot index + 1).
+         * The generation of a slot is increased when its layer is destroyed
+         * so that the stale handles are rejected after the slot is reused.
+         */
+        struct LayerSlot {
+            ExynosLayer *layer;
+            uint32_t generation;
+        };
+        std::vector<LayerSlot> mLayerSlots;
+        std::vector<uint32_t> mFreeLayerSlots;
+
+        /**
+         * Layer lookups by the layer commands between two presentDisplay()
+         */
+        struct LayerLookupCount {
+            uint32_t lookups;
+            uint32_t failures;
+        };
+        LayerLookupCount mLayerLookupCount;
+        LayerLookupCount mLastFrameLayerLookupCount;
+        uint32_t mMaxFrameLayerLookups;
+
+        /**
+         * Validates that assigned the resources. The incremental ones
+         * reused the last assignment of the unchanged layers.
+         */
+        struct ResourceAssignCount {
+            uint64_t full;
+            uint64_t incremental;
+            uint32_t lastReusedLayers;
+        };
+        ResourceAssignCount mResourceAssignCount;
+
+        ExynosPostProcessingDispatcher mPostProcessingDispatcher;
+
         ExynosResourceManager *mResourceManager;
 
         /**
@@ -442,6 +586,21 @@ class ExynosDisplay {
         uint64_t mLastModeSwitchTimeStamp;
         uint64_t mLastUpdateTimeStamp;
         uint64_t mUpdateEventCnt;
+
+        /**
+         * The idle timer thread of ExynosDevice checks this display at
+         * mIdleDeadline for the dynamic recomposition.
+         * 0 if there is nothing to check.
+         */
+        std::atomic<nsecs_t> mIdleDeadline;
+
+        /* CLOCK_MONOTONIC time to present the next frame at, 0 if as soon as possible */
+        nsecs_t mExpectedPresentTime;
+        struct presentHoldCount {
+            uint64_t frames;
+            uint64_t held;
+            nsecs_t lastHold;
+        } mPresentHoldCount;
         uint32_t mDumpCount;
 
         /* default DMA for the display */
@@ -549,7 +708,10 @@ class ExynosDisplay {
 
         void destroyLayers();
 
-        ExynosLayer *checkLayer(hwc2_layer_t addr);
+        ExynosLayer *checkLayer(hwc2_layer_t handle);
+        hwc2_layer_t allocLayerHandle(ExynosLayer *layer);
+        void freeLayerHandle(ExynosLayer *layer);
+        void updateLayerLookupCount();
 
         void checkIgnoreLayers();
         virtual void doPreProcessing();
@@ -558,6 +720,22 @@ class ExynosDisplay {
 
         int checkDynamicReCompMode();
 
+        bool needIdleTimer();
+        /* Called with mDisplayMutex on every update of the display */
+        void updateIdleDeadline();
+        void setIdleDeadline(nsecs_t deadline);
+        /* The earliest deadline later than @now or 0 */
+        nsecs_t getIdleDeadline(nsecs_t now);
+        /* Return true if the display should be refreshed */
+        bool handleIdleTimeout(nsecs_t now);
+
+        int32_t setExpectedPresentTime(nsecs_t expectedPresentTime);
+        /*
+         * Sleep until the vsync before mExpectedPresentTime has passed.
+         * It should be called without mDisplayMutex held.
+         */
+        void waitForExpectedPresentTime();
+
         int handleDynamicReCompMode();
 
         /**
@@ -568,7 +746,9 @@ class ExynosDisplay {
 
         int doPostProcessing();
 
-        int doExynosComposition();
+        int prepareExynosComposition();
+        int finishExynosComposition();
+        int32_t dispatchPostProcessing(bool validated, String8 &errString);
 
         int32_t configureOverlay(ExynosLayer *layer, exynos_win_config_data &cfg);
         int32_t configureOverlay(ExynosCompositionInfo &compositionInfo);
@@ -51,8 +51,8 @@ ExynosLayer::ExynosLayer(ExynosDisplay* display)
     mPrevAcquireFence(-1),
     mReleaseFence(-1),
     mFrameCount(0),
-    mLastFrameCount(0),
-    mLastFpsTime(0),
+    mFrameInterval(0),
+    mLastFrameTime(0),
     mLastLayerBuffer(NULL),
     mLayerBuffer(NULL),
     mDamageNum(0),
@@ -65,7 +65,8 @@ ExynosLayer::ExynosLayer(ExynosDisplay* display)
     mIsDimLayer(false),
     mIsHdrLayer(false),
     mBufferHasMetaParcel(false),
-    mMetaParcelFd(-1)
+    mMetaParcelFd(-1),
+    mHandle(0)
 {
     memset(&mDisplayFrame, 0, sizeof(mDisplayFrame));
     memset(&mSourceCrop, 0, sizeof(mSourceCrop));
@@ -73,6 +74,10 @@ ExynosLayer::ExynosLayer(ExynosDisplay* display)
     mVisibleRegionScreen.rects = NULL;
     memset(&mColor, 0, sizeof(mColor));
     memset(&mPreprocessedInfo, 0, sizeof(mPreprocessedInfo));
+    mLastAssignment.valid = false;
+    mLastAssignment.compositionType = HWC2_COMPOSITION_INVALID;
+    mLastAssignment.otfMPP = NULL;
+    mLastAssignment.m2mMPP = NULL;
     mCheckMPPFlag.clear();
     mCheckMPPFlag.reserve(MPP_LOGICAL_TYPE_NUM);
     mMetaParcel = NULL;
@@ -108,23 +113,24 @@ ExynosLayer::~ExynosLayer() {
  * @return uint32_t
  */
 uint32_t ExynosLayer::checkFps() {
-    uint32_t frameDiff;
     bool wasLowFps = (mFps < LOW_FPS_THRESHOLD) ? true:false;
+    nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+
     if (mLastLayerBuffer != mLayerBuffer) {
         mFrameCount++;
+        if (mLastFrameTime != 0) {
+            /* A long pause should not hide the fps of the following frames */
+            nsecs_t interval = min(now - mLastFrameTime, FPS_MAX_INTERVAL);
+
+            if (mFrameInterval == 0)
+                mFrameInterval = interval;
+            else
+                mFrameInterval += (interval - mFrameInterval) / FPS_AVERAGE_WEIGHT;
+        }
+        mLastFrameTime = now;
     }
-    nsecs_t now = systemTime();
-    nsecs_t diff = now - mLastFpsTime;
-    if (mFrameCount >= mLastFrameCount)
-        frameDiff = (mFrameCount - mLastFrameCount);
-    else
-        frameDiff = (mFrameCount + (UINT_MAX - mLastFrameCount));
 
-    if (diff >= ms2ns(250)) {
-        mFps = (uint32_t)(frameDiff * float(s2ns(1))) / diff;
-        mLastFrameCount = mFrameCount;
-        mLastFpsTime = now;
-    }
+    mFps = getFps(now);
     bool nowLowFps = (mFps < LOW_FPS_THRESHOLD) ? true:false;
 
     if ((mDisplay->mDisplayControl.handleLowFpsLayers) &&
@@ -141,6 +147,15 @@ uint32_t ExynosLayer::getFps() {
     return mFps;
 }
 
+uint32_t ExynosLayer::getFps(nsecs_t now) {
+    if ((mLastFrameTime == 0) || (mFrameInterval == 0))
+        return 0;
+
+    nsecs_t interval = max(mFrameInterval, now - mLastFrameTime);
+
+    return (uint32_t)(s2ns(1) / interval);
+}
+
 int32_t ExynosLayer::doPreProcess()
 {
     overlay_priority priority = ePriorityLow;
@@ -153,8 +153,13 @@ class ExynosLayer : public ExynosMPPSource {
         int32_t mReleaseFence;
 
         uint32_t mFrameCount;
-        uint32_t mLastFrameCount;
-        nsecs_t mLastFpsTime;
+        /**
+         * Rolling average of the intervals between the buffer updates.
+         * mFps is updated with it on every checkFps() instead of
+         * sampling the frame count periodically.
+         */
+        nsecs_t mFrameInterval;
+        nsecs_t mLastFrameTime;
 
         /**
          * Previous buffer's handle
@@ -235,6 +240,25 @@ class ExynosLayer : public ExynosMPPSource {
         bool mBufferHasMetaParcel;
         int mMetaParcelFd;
 
+        /**
+         * Handle of this layer given to the composer
+         */
+        hwc2_layer_t mHandle;
+
+        /**
+         * Resources assigned by the last assignResource().
+         * They are checked and assigned again without searching all MPPs
+         * if the geometry of the layer is not changed.
+         */
+        struct LastAssignment {
+            bool valid;
+            int32_t compositionType;
+            ExynosMPP *otfMPP;
+            ExynosMPP *m2mMPP;
+            exynos_image midImg;
+        };
+        LastAssignment mLastAssignment;
+
         /**
          * @param type
          */
@@ -243,6 +267,8 @@ class ExynosLayer : public ExynosMPPSource {
         uint32_t checkFps();
 
         uint32_t getFps();
+        /* fps decayed by the time since the last buffer update at @now */
+        uint32_t getFps(nsecs_t now);
 
         int32_t doPreProcess();
 
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 #include <utils/Errors.h>
+#include <inttypes.h>
 #include <linux/videodev2.h>
 #include <sys/mman.h>
 #include <utils/CallStack.h>
@@ -744,9 +745,7 @@ void writeFenceInfo(uint32_t fd, hwc_fence_info_t *info,
     info->pendingAllowed = pendingAllowed;
 
     /* time */
-    struct timeval tv;
-    gettimeofday(&seq->time, NULL);
-    tv = seq->time;
+    seq->time = systemTime(SYSTEM_TIME_MONOTONIC);
 }
 
 void setFenceInfo(uint32_t fd, ExynosDisplay* display,
@@ -757,56 +756,55 @@ void setFenceInfo(uint32_t fd, ExynosDisplay* display,
     ExynosDevice* device = display->mDevice;
     if (device == NULL) return;
 
-    /* init or recevice(from previous) trace info */
-    hwc_fence_info_t info;
-    if (device->mFenceInfo.count(fd) == 0) {
-        memset(&info, 0, sizeof(hwc_fence_info_t));
-    } else
-        info = device->mFenceInfo.at(fd);
+    int32_t usage = 0;
 
-    info.displayId = display->mDisplayId;
+    /* init or update the trace info in place */
+    device->mFenceTracer.update(fd, [&](hwc_fence_info_t &info) {
+        info.displayId = display->mDisplayId;
 
-    writeFenceInfo(fd, &info, type, ip, direction, pendingAllowed);
+        writeFenceInfo(fd, &info, type, ip, direction, pendingAllowed);
 
-    fenceTrace_t *seq = &info.seq[info.seq_no];
-    /* update usage count */
-    if ((seq->dir == FENCE_FROM) || (seq->dir == FENCE_DUP)) {
-        info.usage++;
-    } else if ((seq->dir == FENCE_TO) || (seq->dir == FENCE_CLOSE)) {
-        info.usage--;
-        if ((seq->dir == FENCE_CLOSE) && (info.usage < 0)) info.usage = 0;
-    } else
-        ALOGE("Fence trace : Undefined direction!");
+        fenceTrace_t *seq = &info.seq[info.seq_no];
+        /* update usage count */
+        if ((seq->dir == FENCE_FROM) || (seq->dir == FENCE_DUP)) {
+            info.usage++;
+        } else if ((seq->dir == FENCE_TO) || (seq->dir == FENCE_CLOSE)) {
+            info.usage--;
+            if ((seq->dir == FENCE_CLOSE) && (info.usage < 0)) info.usage = 0;
+        } else
+            ALOGE("Fence trace : Undefined direction!");
 
-    seq->usage = info.usage;
+        seq->usage = info.usage;
 
-    // Fence's usage count shuld be zero at end of frame(present done).
-    // This flag means usage count of the fence can be pended over frame.
-    if (info.usage == 0)
-        info.pendingAllowed = false;
+        // Fence's usage count shuld be zero at end of frame(present done).
+        // This flag means usage count of the fence can be pended over frame.
+        if (info.usage == 0)
+            info.pendingAllowed = false;
 
-    /* last direction */
-    info.last_dir = direction;
+        /* last direction */
+        info.last_dir = direction;
 
-    FT_LOGI("FD : %d, direction : %d, type : %d, ip : %d, usage : %d (%s)",
-            fd, direction, seq->type, seq->ip, info.usage, __func__);
+        usage = info.usage;
+    });
 
-    device->mFenceInfo[fd] = info;
+    FT_LOGI("FD : %d, direction : %d, type : %d, ip : %d, usage : %d (%s)",
+            fd, direction, type, ip, usage, __func__);
+}
 
+String8 getFenceTraceTime(nsecs_t time) {
+    return String8::format("%" PRId64 ".%06" PRId64, time / 1000000000, (time / 1000) % 1000000);
 }
 
 void printLastFenceInfo(uint32_t fd, ExynosDisplay* display) {
 
-    struct timeval tv;
-
     if (!fence_valid(fd)) return;
 
     ExynosDevice* device = display->mDevice;
 
-    if (device->mFenceInfo.count(fd) == 0)
+    hwc_fence_info_t info;
+    if (!device->mFenceTracer.read(fd, info))
         return;
 
-    hwc_fence_info_t info = device->mFenceInfo.at(fd);
     FT_LOGD("---- Fence FD : %d, Display(%d), usage(%d) ----", fd, info.displayId, info.usage);
 
     for (int i = 0; i < MAX_FENCE_SEQUENCE; i++) {
@@ -816,14 +814,7 @@ void printLastFenceInfo(uint32_t fd, ExynosDisplay* display) {
                 GET_STRING(fence_ip_map, seq->ip), GET_STRING(fence_type_map, seq->type),
                 seq->curFlag, seq->usage, (int)seq->isLast);
 
-        tv = seq->time;
-        struct tm* localTime = getLocalTime(tv);
-
-        FT_LOGD("time:%02d-%02d %02d:%02d:%02d.%03lu(%lu)",
-                localTime->tm_mon+1, localTime->tm_mday,
-                localTime->tm_hour, localTime->tm_min,
-                localTime->tm_sec, tv.tv_usec/1000,
-                ((tv.tv_sec * 1000) + (tv.tv_usec / 1000)));
+        FT_LOGD("time:%s", getFenceTraceTime(seq->time).string());
     }
 
 }
@@ -831,12 +822,12 @@ void printLastFenceInfo(uint32_t fd, ExynosDisplay* display) {
 void dumpFenceInfo(ExynosDisplay *display, int32_t __unused depth) {
 
     ExynosDevice* device = display->mDevice;
+    uint32_t limit = device->mFenceTracer.getFdLimit();
 
     FT_LOGD("Dump fence ++");
-    for (auto it = device->mFenceInfo.begin(); it != device->mFenceInfo.end(); ++it) {
-        uint32_t i = it->first;
-        hwc_fence_info_t info = device->mFenceInfo.at(i);
-        if (device->mFenceInfo.count(i) == 0) continue;
+    for (uint32_t i = 0; i < limit; i++) {
+        hwc_fence_info_t info;
+        if (!device->mFenceTracer.read(i, info)) continue;
         if ((info.usage >= 1 || info.usage <= -1) && (!info.pendingAllowed))
             printLastFenceInfo(i, display);
     }
@@ -846,6 +837,7 @@ void dumpFenceInfo(ExynosDisplay *display, int32_t __unused depth) {
 void printLeakFds(ExynosDisplay *display){
 
     ExynosDevice* device = display->mDevice;
+    uint32_t limit = device->mFenceTracer.getFdLimit();
 
     int cnt = 1;
 
@@ -854,9 +846,9 @@ void printLeakFds(ExynosDisplay *display){
 
     errStringPlus.appendFormat("Leak Fds (1) :\n");
 
-    for (auto it = device->mFenceInfo.begin(); it != device->mFenceInfo.end(); ++it) {
-        uint32_t i = it->first;
-        hwc_fence_info_t info = device->mFenceInfo.at(i);
+    for (uint32_t i = 0; i < limit; i++) {
+        hwc_fence_info_t info;
+        if (!device->mFenceTracer.read(i, info)) continue;
         if(info.usage >= 1) {
             errStringPlus.appendFormat("%d,", i);
             if(cnt++%10 == 0)
@@ -868,9 +860,9 @@ void printLeakFds(ExynosDisplay *display){
     errStringMinus.appendFormat("Leak Fds (-1) :\n");
 
     cnt = 1;
-    for (auto it = device->mFenceInfo.begin(); it != device->mFenceInfo.end(); ++it) {
-        uint32_t i = it->first;
-        hwc_fence_info_t info = device->mFenceInfo.at(i);
+    for (uint32_t i = 0; i < limit; i++) {
+        hwc_fence_info_t info;
+        if (!device->mFenceTracer.read(i, info)) continue;
         if(info.usage < 0) {
             errStringMinus.appendFormat("%d,", i);
             if(cnt++%10 == 0)
@@ -883,11 +875,12 @@ void printLeakFds(ExynosDisplay *display){
 void dumpNCheckLeak(ExynosDisplay *display, int32_t __unused depth) {
 
     ExynosDevice* device = display->mDevice;
+    uint32_t limit = device->mFenceTracer.getFdLimit();
 
     FT_LOGD("Dump leaking fence ++");
-    for (auto it = device->mFenceInfo.begin(); it != device->mFenceInfo.end(); ++it) {
-        uint32_t i = it->first;
-        hwc_fence_info_t info = device->mFenceInfo.at(i);
+    for (uint32_t i = 0; i < limit; i++) {
+        hwc_fence_info_t info;
+        if (!device->mFenceTracer.read(i, info)) continue;
         if ((info.usage >= 1 || info.usage <= -1) && (!info.pendingAllowed))
             // leak is occured in this frame first
             if (!info.leaking) {
@@ -908,10 +901,11 @@ bool fenceWarn(ExynosDisplay *display, uint32_t threshold) {
 
     uint32_t cnt = 0, r_cnt = 0;
     ExynosDevice* device = display->mDevice;
+    uint32_t limit = device->mFenceTracer.getFdLimit();
 
-    for (auto it = device->mFenceInfo.begin(); it != device->mFenceInfo.end(); ++it) {
-        uint32_t i = it->first;
-        hwc_fence_info_t info = device->mFenceInfo.at(i);
+    for (uint32_t i = 0; i < limit; i++) {
+        hwc_fence_info_t info;
+        if (!device->mFenceTracer.read(i, info)) continue;
         if(info.usage >= 1 || info.usage <= -1)
             cnt++;
     }
@@ -929,16 +923,17 @@ bool fenceWarn(ExynosDisplay *display, uint32_t threshold) {
 
 void resetFenceCurFlag(ExynosDisplay *display) {
     ExynosDevice* device = display->mDevice;
-    FT_LOGD("%s ++", __func__);
-    for (auto it = device->mFenceInfo.begin(); it != device->mFenceInfo.end(); ++it) {
-        uint32_t i = it->first;
-        hwc_fence_info_t info = device->mFenceInfo.at(i);
+    uint32_t limit = device->mFenceTracer.getFdLimit();
 
-        if (device->mFenceInfo.count(i) == 0) continue;
+    FT_LOGD("%s ++", __func__);
+    for (uint32_t i = 0; i < limit; i++) {
+        hwc_fence_info_t info;
+        if (!device->mFenceTracer.read(i, info)) continue;
 
         if (info.usage == 0) {
-            hwc_fence_info_t *info_ = &device->mFenceInfo[i];
-            for(int j=0; j<MAX_FENCE_SEQUENCE; j++) info_->seq[j].curFlag = 0;
+            device->mFenceTracer.update(i, [](hwc_fence_info_t &info_) {
+                for(int j=0; j<MAX_FENCE_SEQUENCE; j++) info_.seq[j].curFlag = 0;
+            });
         } else if (!info.pendingAllowed)
             FT_LOGE("usage mismatched fd %d, usage %d, pending %d", i,
                     info.usage, info.pendingAllowed);
@@ -950,10 +945,11 @@ bool validateFencePerFrame(ExynosDisplay *display) {
 
     bool ret = true;
     ExynosDevice* device = display->mDevice;
+    uint32_t limit = device->mFenceTracer.getFdLimit();
 
-    for (auto it = device->mFenceInfo.begin(); it != device->mFenceInfo.end(); ++it) {
-        uint32_t i = it->first;
-        hwc_fence_info_t info = device->mFenceInfo.at(i);
+    for (uint32_t i = 0; i < limit; i++) {
+        hwc_fence_info_t info;
+        if (!device->mFenceTracer.read(i, info)) continue;
         if (info.displayId != display->mDisplayId)
             continue;
         if ((info.usage >= 1 || info.usage <= -1) &&
@@ -980,21 +976,13 @@ void changeFenceInfoState(uint32_t fd, ExynosDisplay *display,
     ExynosDevice* device = display->mDevice;
     if (device == NULL) return;
 
-    /* init or recevice(from previous) trace info */
-    hwc_fence_info_t info;
-    if (device->mFenceInfo.count(fd) == 0) {
-        memset(&info, 0, sizeof(hwc_fence_info_t));
-        info.seq_no = 0;
-    } else
-        info = device->mFenceInfo.at(fd);
-
-    info.displayId = display->mDisplayId;
+    device->mFenceTracer.update(fd, [&](hwc_fence_info_t &info) {
+        info.displayId = display->mDisplayId;
 
-    writeFenceInfo(fd, &info, type, ip, direction, pendingAllowed);
+        writeFenceInfo(fd, &info, type, ip, direction, pendingAllowed);
+    });
 
     FT_LOGD("FD : %d, direction : %d, type(%d), ip(%d) (%s)", fd, direction, type, ip, __func__);
-
-    device->mFenceInfo[fd] = info;
 }
 
 String8 getMPPStr(int typeId) {
@@ -17,7 +17,11 @@
 #define _EXYNOSHWCHELPER_H
 
 #include <utils/String8.h>
+#include <utils/Timers.h>
 #include <hardware/hwcomposer2.h>
+#include <sched.h>
+#include <atomic>
+#include <cstring>
 #include <map>
 #ifdef GRALLOC_VERSION1
 #include "gralloc1_priv.h"
@@ -479,7 +483,7 @@ typedef struct fenceTrace {
     uint32_t dir;
     hwc_fdebug_fence_type type;
     hwc_fdebug_ip_type ip;
-    struct timeval time;
+    nsecs_t time; // SYSTEM_TIME_MONOTONIC
     int32_t curFlag;
     int32_t usage;
     bool isLast;
@@ -488,13 +492,113 @@ typedef struct fenceTrace {
 typedef struct hwc_fence_info {
     uint32_t displayId;
     fenceTrace_t seq[MAX_FENCE_SEQUENCE];
-    uint32_t seq_no = 0;
+    uint32_t seq_no;
     uint32_t last_dir;
     int32_t usage;
-    bool pendingAllowed = false;
-    bool leaking = false;
+    bool pendingAllowed;
+    bool leaking;
 } hwc_fence_info_t;
 
+/*
+ * Fence trace store indexed by fd
+ * The traces are preallocated for the fds less than MAX_FENCE_FD and the fds
+ * beyond are not traced. Each trace is guarded by a sequence counter: the
+ * writers update a trace in place while the counter is odd and the readers
+ * retry if the counter changes while they copy the trace. Therefore dumping
+ * the traces never blocks the composer.
+ */
+class ExynosFenceTracer {
+    public:
+        enum {
+            MAX_FENCE_FD = 2048,
+            MAX_READ_RETRY = 8,
+        };
+
+        ExynosFenceTracer() : mMaxFd(-1) {
+            clear();
+        }
+
+        void clear() {
+            for (uint32_t fd = 0; fd < MAX_FENCE_FD; fd++) {
+                mTraces[fd].seq.store(0, std::memory_order_relaxed);
+                mTraces[fd].used.store(false, std::memory_order_relaxed);
+            }
+            mMaxFd.store(-1, std::memory_order_release);
+        }
+
+        /*
+         * Update the trace of @fd in place with update(hwc_fence_info_t &).
+         * The trace is zeroed before the first update.
+         * Returns false if @fd is not traced.
+         */
+        template <typename Update>
+        bool update(uint32_t fd, Update update) {
+            if (fd >= MAX_FENCE_FD)
+                return false;
+
+            Trace &trace = mTraces[fd];
+            uint32_t seq = trace.seq.load(std::memory_order_relaxed);
+            do {
+                while (seq & 1) {
+                    sched_yield();
+                    seq = trace.seq.load(std::memory_order_relaxed);
+                }
+            } while (!trace.seq.compare_exchange_weak(seq, seq + 1,
+                        std::memory_order_acquire, std::memory_order_relaxed));
+
+            if (!trace.used.load(std::memory_order_relaxed)) {
+                memset(&trace.info, 0, sizeof(trace.info));
+                trace.used.store(true, std::memory_order_relaxed);
+                int32_t maxFd = mMaxFd.load(std::memory_order_relaxed);
+                while ((maxFd < (int32_t)fd) &&
+                        !mMaxFd.compare_exchange_weak(maxFd, (int32_t)fd,
+                            std::memory_order_release, std::memory_order_relaxed));
+            }
+
+            update(trace.info);
+
+            trace.seq.store(seq + 2, std::memory_order_release);
+            return true;
+        }
+
+        /*
+         * Copy the trace of @fd to @info.
+         * Returns false if @fd has never been traced or it is kept being updated.
+         */
+        bool read(uint32_t fd, hwc_fence_info_t &info) const {
+            if (fd >= MAX_FENCE_FD)
+                return false;
+
+            const Trace &trace = mTraces[fd];
+            for (int retry = 0; retry < MAX_READ_RETRY; retry++) {
+                uint32_t seq = trace.seq.load(std::memory_order_acquire);
+                if (seq & 1)
+                    continue;
+                bool used = trace.used.load(std::memory_order_relaxed);
+                memcpy(&info, &trace.info, sizeof(info));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (trace.seq.load(std::memory_order_relaxed) == seq)
+                    return used;
+            }
+            return false;
+        }
+
+        /* Upper bound of the traced fds to iterate */
+        uint32_t getFdLimit() const {
+            return (uint32_t)(mMaxFd.load(std::memory_order_acquire) + 1);
+        }
+
+    private:
+        struct Trace {
+            std::atomic<uint32_t> seq;
+            std::atomic<bool> used;
+            hwc_fence_info_t info;
+        };
+
+        Trace mTraces[MAX_FENCE_FD];
+        std::atomic<int32_t> mMaxFd;
+};
+
 
 void setFenceName(int fenceFd, hwc_fence_type fenceType);
 void changeFenceInfoState(uint32_t fd, ExynosDisplay *display,
@@ -504,6 +608,7 @@ void setFenceInfo(uint32_t fd, ExynosDisplay *display,
         hwc_fdebug_fence_type type, hwc_fdebug_ip_type ip,
         uint32_t direction, bool pendingAllowed = false);
 void printFenceInfo(uint32_t fd, hwc_fence_info_t* info);
+String8 getFenceTraceTime(nsecs_t time);
 void dumpFenceInfo(ExynosDisplay *display, int32_t __unused depth);
 bool fenceWarn(hwc_fence_info_t **info, uint32_t threshold);
 void resetFenceCurFlag(ExynosDisplay *display);
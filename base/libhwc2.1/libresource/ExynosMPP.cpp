@@ -151,8 +151,11 @@ ExynosMPP::ExynosMPP(ExynosResourceManager* resourceManager,
     mAcrylicHandle(NULL),
     mUseM2MSrcFence(false),
     mAttr(0),
+    mSupportCacheHits(0),
+    mSupportCacheMisses(0),
     mNeedSolidColorLayer(false)
 {
+    clearSupportCache();
 
     for (int i=0; i<RESTRICTION_MAX; i++){
         memset(&mSrcSizeRestrictions[i], 0, sizeof(restriction_size));
@@ -768,7 +771,15 @@ bool ExynosMPP::ResourceManageThread::threadLoop()
         Mutex::Autolock lock(mMutex);
         while((mFreedBuffers.size() == 0) &&
                 (mStateFences.size() == 0)) {
-            mCondition.wait(mMutex);
+            /* Wake up to free the expired buffers of the pools */
+            nsecs_t trimTimeout = ExynosMPPBufferPool::getInstance().trim();
+            nsecs_t acrylTimeout = ms2ns(Acrylic::trimTransitBuffers());
+            if ((acrylTimeout > 0) && ((trimTimeout == 0) || (acrylTimeout < trimTimeout)))
+                trimTimeout = acrylTimeout;
+            if (trimTimeout > 0)
+                mCondition.waitRelative(mMutex, trimTimeout);
+            else
+                mCondition.wait(mMutex);
         }
 
         if ((mExynosMPP->mHWState == MPP_HW_STATE_RUNNING) &&
@@ -805,6 +816,10 @@ void ExynosMPP::ResourceManageThread::freeBuffers()
         exynos_mpp_img_info freeBuffer = (exynos_mpp_img_info)(*it);
         HDEBUGLOGD(eDebugMPP|eDebugFence|eDebugBuf, "freebufNum: %d, buffer: %p", freebufNum, freeBuffer.bufferHandle);
         dumpExynosMPPImgInfo(eDebugMPP|eDebugFence|eDebugBuf, freeBuffer);
+        /* The pool keeps the buffer until the fences are signaled */
+        ExynosMPPBufferPool::getInstance().release(mExynosMPP->mMapper,
+                freeBuffer.bufferHandle, freeBuffer.allocKey,
+                freeBuffer.acrylicAcquireFenceFd, freeBuffer.acrylicReleaseFenceFd);
         if (fence_valid(freeBuffer.acrylicAcquireFenceFd)) {
             freeBuffer.acrylicAcquireFenceFd =
                 fence_close(freeBuffer.acrylicAcquireFenceFd, mExynosMPP->mAssignedDisplay,
@@ -815,7 +830,6 @@ void ExynosMPP::ResourceManageThread::freeBuffers()
                 fence_close(freeBuffer.acrylicReleaseFenceFd, mExynosMPP->mAssignedDisplay,
                         FENCE_TYPE_SRC_RELEASE, FENCE_IP_ALL);
         }
-        mExynosMPP->mMapper->freeBuffer(freeBuffer.bufferHandle);
         it = mFreedBuffers.erase(it);
     }
 }
@@ -900,7 +914,17 @@ int32_t ExynosMPP::allocOutBuf(uint32_t w, uint32_t h, uint32_t format, uint64_t
     info.usage = allocUsage;
     GrallocWrapper::Error error = GrallocWrapper::Error::NONE;
 
-    {
+    exynos_mpp_buffer_key allocKey = {};
+    allocKey.width = w;
+    allocKey.height = h;
+    allocKey.format = format;
+    allocKey.usage = allocUsage;
+    allocKey.secure = (getBufferType(usage) == MPP_BUFFER_SECURE_DRM);
+
+    dstBuffer = ExynosMPPBufferPool::getInstance().acquire(allocKey);
+    if (dstBuffer != NULL) {
+        MPP_LOGD(eDebugMPP|eDebugBuf, "\tdstBuffer(%p) is recycled", dstBuffer);
+    } else {
         ATRACE_CALL();
         error = mAllocator->allocate(info, &dstStride, &dstBuffer);
     }
@@ -917,6 +941,7 @@ int32_t ExynosMPP::allocOutBuf(uint32_t w, uint32_t h, uint32_t format, uint64_t
     mDstImgs[index].bufferHandle = private_handle_t::dynamicCast(dstBuffer);
     mDstImgs[index].bufferType = getBufferType(usage);
     mDstImgs[index].format = format;
+    mDstImgs[index].allocKey = allocKey;
 
     MPP_LOGD(eDebugMPP|eDebugBuf, "free outbuf[%d] %p", index, freeDstBuf.bufferHandle);
     if (freeDstBuf.bufferHandle != NULL)
@@ -1503,6 +1528,8 @@ int32_t ExynosMPP::doPostProcessingInternal()
         mDstImgs[mCurrentDstBuf].acrylicAcquireFenceFd = -1;
         ret = -EPERM;
     } else {
+        if (hwcCheckDebugMessages(eDebugCapacity))
+            logPPCSample();
 
         // set fence informations from acryl
         if (mPhysicalType == MPP_G2D) {
@@ -1911,6 +1938,7 @@ int32_t ExynosMPP::requestHWStateChange(uint32_t state)
                 } else {
                     mDstImgs[i].bufferHandle = freeDstBuf.bufferHandle;
                     mDstImgs[i].bufferType = freeDstBuf.bufferType;
+                    mDstImgs[i].allocKey = freeDstBuf.allocKey;
                 }
             }
         }
@@ -1951,6 +1979,8 @@ int32_t ExynosMPP::setupRestriction() {
 
     MPP_LOGD(eDebugMPP, "mPhysicalType(%d)", mPhysicalType);
 
+    clearSupportCache();
+
     for (uint32_t i = 0; i < RESTRICTION_MAX; i++) {
         const restriction_size_element *restriction_size_table = mResourceManager->mSizeRestrictions[i];
         for (uint32_t j = 0; j < mResourceManager->mSizeRestrictionCnt[i]; j++) {
@@ -1993,7 +2023,71 @@ int32_t ExynosMPP::setupRestriction() {
     return NO_ERROR;
 }
 
+static void setSupportCacheImage(const exynos_image &img, ExynosMPP::SupportCacheImage &cacheImg)
+{
+    cacheImg.fullWidth = img.fullWidth;
+    cacheImg.fullHeight = img.fullHeight;
+    cacheImg.x = img.x;
+    cacheImg.y = img.y;
+    cacheImg.w = img.w;
+    cacheImg.h = img.h;
+    cacheImg.format = img.format;
+    cacheImg.usageFlags = img.usageFlags;
+    cacheImg.layerFlags = img.layerFlags;
+    cacheImg.dataSpace = img.dataSpace;
+    cacheImg.blending = img.blending;
+    cacheImg.transform = img.transform;
+    cacheImg.compressed = img.compressed;
+    cacheImg.metaType = img.metaType;
+}
+
 int64_t ExynosMPP::isSupported(ExynosDisplay &display, struct exynos_image &src, struct exynos_image &dst)
+{
+    SupportCacheKey key;
+
+    /* The padding of the key is compared and hashed as well */
+    memset(&key, 0, sizeof(key));
+    key.display = &display;
+    key.displayType = display.mType;
+    key.xres = display.mXres;
+    key.yres = display.mYres;
+    if (mResourceManager != NULL)
+        key.layerState = (mResourceManager->hasHdrLayer ? 0x1 : 0) |
+                         (mResourceManager->hasDrmLayer ? 0x2 : 0);
+    setSupportCacheImage(src, key.src);
+    setSupportCacheImage(dst, key.dst);
+
+    /* FNV-1a */
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&key);
+    for (size_t i = 0; i < sizeof(key); i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    SupportCacheEntry &entry = mSupportCache[hash % SUPPORT_CACHE_SIZE];
+    if (entry.valid && (entry.hash == hash) &&
+        (memcmp(&entry.key, &key, sizeof(key)) == 0)) {
+        mSupportCacheHits++;
+        return entry.result;
+    }
+
+    mSupportCacheMisses++;
+    entry.result = checkSupported(display, src, dst);
+    entry.hash = hash;
+    entry.key = key;
+    entry.valid = true;
+
+    return entry.result;
+}
+
+void ExynosMPP::clearSupportCache()
+{
+    for (uint32_t i = 0; i < SUPPORT_CACHE_SIZE; i++)
+        mSupportCache[i].valid = false;
+}
+
+int64_t ExynosMPP::checkSupported(ExynosDisplay &display, struct exynos_image &src, struct exynos_image &dst)
 {
     uint32_t maxSrcWidth = getSrcMaxWidth(src);
     uint32_t maxSrcHeight = getSrcMaxHeight(src);
@@ -2396,7 +2490,7 @@ float ExynosMPP::getPPC(struct exynos_image &src, struct exynos_image &dst, stru
 
     if ((mPhysicalType == MPP_G2D) &&
         (src.layerFlags & EXYNOS_HWC_DIM_LAYER))
-        return G2D_BASE_PPC_COLORFILL;
+        return getColorfillPPC();
 
     getPPCIndex(src, dst, formatIndex, rotIndex, scaleIndex, criteria);
 
@@ -2405,11 +2499,8 @@ float ExynosMPP::getPPC(struct exynos_image &src, struct exynos_image &dst, stru
         rotIndex = PPC_ROT;
     }
 
-    if (mPhysicalType == MPP_G2D || mPhysicalType == MPP_MSC) {
-        if (ppc_table_map.count(PPC_IDX(mPhysicalType, formatIndex, rotIndex)) != 0) {
-            PPC = ppc_table_map.at(PPC_IDX(mPhysicalType, formatIndex, rotIndex)).ppcList[scaleIndex];
-        }
-    }
+    if (mPhysicalType == MPP_G2D || mPhysicalType == MPP_MSC)
+        PPC = getTablePPC(src, dst, criteria, formatIndex, rotIndex, scaleIndex);
 
     if (PPC == 0) {
         MPP_LOGE("%s:: mPhysicalType(%d), formatIndex(%d), rotIndex(%d), scaleIndex(%d), PPC(%f) is not valid",
@@ -2424,6 +2515,38 @@ float ExynosMPP::getPPC(struct exynos_image &src, struct exynos_image &dst, stru
     return PPC;
 }
 
+float ExynosMPP::getTablePPC(struct exynos_image &src, struct exynos_image &dst, struct exynos_image &criteria,
+        uint32_t formatIndex, uint32_t rotIndex, uint32_t scaleIndex)
+{
+    ExynosPPCModel &model = ExynosPPCModel::getInstance();
+    uint32_t srcResolution = src.w * src.h;
+    uint32_t dstResolution = dst.w * dst.h;
+    float PPC = 0;
+
+    if (model.isLoaded() && (srcResolution != 0) && (dstResolution != 0)) {
+        /* AFBC is the compression axis of the model, not a format */
+        uint32_t format = (formatIndex == PPC_FORMAT_AFBC) ? PPC_FORMAT_RGB32 : formatIndex;
+        uint32_t mpp = (mPhysicalType == MPP_G2D) ?
+            ExynosPPCModel::PPC_MPP_G2D : ExynosPPCModel::PPC_MPP_MSC;
+
+        if (model.getPPC(mpp, format, rotIndex, criteria.compressed == 1,
+                    (float)dstResolution / srcResolution, PPC))
+            return PPC;
+    }
+
+    if (ppc_table_map.count(PPC_IDX(mPhysicalType, formatIndex, rotIndex)) != 0)
+        PPC = ppc_table_map.at(PPC_IDX(mPhysicalType, formatIndex, rotIndex)).ppcList[scaleIndex];
+
+    return PPC;
+}
+
+float ExynosMPP::getColorfillPPC()
+{
+    float PPC = ExynosPPCModel::getInstance().getColorfillPPC();
+
+    return (PPC > 0) ? PPC : G2D_BASE_PPC_COLORFILL;
+}
+
 float ExynosMPP::getAssignedCapacity()
 {
     float capacity = 0;
@@ -2451,9 +2574,9 @@ float ExynosMPP::getAssignedCapacity()
     /* PPC of layers that were added before should be changed */
     /* Check cycles of all assigned layers again */
     if ((mAssignedDisplay != NULL) && (mMaxSrcLayerNum > 1)) {
-        baseCycles += ((mAssignedDisplay->mXres * mAssignedDisplay->mYres) / G2D_BASE_PPC_COLORFILL);
+        baseCycles += ((mAssignedDisplay->mXres * mAssignedDisplay->mYres) / getColorfillPPC());
         MPP_LOGD(eDebugCapacity, "colorfill cycles: %f, total cycles: %f",
-                ((mAssignedDisplay->mXres * mAssignedDisplay->mYres) / G2D_BASE_PPC_COLORFILL), baseCycles);
+                ((mAssignedDisplay->mXres * mAssignedDisplay->mYres) / getColorfillPPC()), baseCycles);
     }
 
     for (uint32_t i = 0; i < mAssignedSources.size(); i++) {
@@ -2467,15 +2590,14 @@ float ExynosMPP::getAssignedCapacity()
         float PPC = 0;
 
         if (mAssignedSources[i]->mSrcImg.layerFlags & EXYNOS_HWC_DIM_LAYER) {
-            PPC = G2D_BASE_PPC_COLORFILL;
+            PPC = getColorfillPPC();
         } else {
             getPPCIndex(mAssignedSources[i]->mSrcImg,
                     mAssignedSources[i]->mMidImg,
                     formatIndex, tmpRotIndex, scaleIndex, mAssignedSources[i]->mSrcImg);
 
-            if (ppc_table_map.count(PPC_IDX(mPhysicalType, formatIndex, rotIndex)) != 0) {
-                PPC = ppc_table_map.at(PPC_IDX(mPhysicalType, formatIndex, rotIndex)).ppcList[scaleIndex];
-            }
+            PPC = getTablePPC(mAssignedSources[i]->mSrcImg, mAssignedSources[i]->mMidImg,
+                    mAssignedSources[i]->mSrcImg, formatIndex, rotIndex, scaleIndex);
         }
         srcCycles = maxResolution/PPC;
 
@@ -2520,7 +2642,7 @@ float ExynosMPP::getRequiredCapacity(ExynosDisplay *display, struct exynos_image
             /* Just add cycles for current layer */
             if ((mAssignedSources.size() == 0) &&
                 (display != NULL) && (mMaxSrcLayerNum > 1)) {
-                curBaseCycles = ((display->mXres * display->mYres) / G2D_BASE_PPC_COLORFILL);
+                curBaseCycles = ((display->mXres * display->mYres) / getColorfillPPC());
                 MPP_LOGD(eDebugCapacity, "There is no assigned layer. Colorfill cycles: %f should be added",
                         curBaseCycles);
             }
@@ -2535,9 +2657,9 @@ float ExynosMPP::getRequiredCapacity(ExynosDisplay *display, struct exynos_image
             /* PPC of layers that were added before should be changed */
             /* Check cycles of all assigned layers again */
             if ((display != NULL) && (mMaxSrcLayerNum > 1)) {
-                baseCycles += ((display->mXres * display->mYres) / G2D_BASE_PPC_COLORFILL);
+                baseCycles += ((display->mXres * display->mYres) / getColorfillPPC());
                 MPP_LOGD(eDebugCapacity, "colorfill cycles: %f, total cycles: %f",
-                        ((display->mXres * display->mYres) / G2D_BASE_PPC_COLORFILL), cycles);
+                        ((display->mXres * display->mYres) / getColorfillPPC()), cycles);
             }
 
             for (uint32_t i = 0; i < mAssignedSources.size(); i++) {
@@ -2627,9 +2749,9 @@ bool ExynosMPP::addCapacity(ExynosMPPSource* mppSource)
             if (mAssignedDisplay != NULL) {
                 /* This will be the first mppSource that is assigned to the ExynosMPP */
                 /* Add capacity for background */
-                mUsedBaseCycles += ((mAssignedDisplay->mXres * mAssignedDisplay->mYres) / G2D_BASE_PPC_COLORFILL);
+                mUsedBaseCycles += ((mAssignedDisplay->mXres * mAssignedDisplay->mYres) / getColorfillPPC());
                 MPP_LOGD(eDebugCapacity, "\tcolorfill cycles: %f, total cycles: %f",
-                        ((mAssignedDisplay->mXres * mAssignedDisplay->mYres) / G2D_BASE_PPC_COLORFILL), mUsedBaseCycles);
+                        ((mAssignedDisplay->mXres * mAssignedDisplay->mYres) / getColorfillPPC()), mUsedBaseCycles);
             } else {
                 MPP_LOGE("mAssignedDisplay is null");
             }
@@ -2727,9 +2849,9 @@ int32_t ExynosMPP::updateUsedCapacity()
         float cycles = 0;
 
         if (mMaxSrcLayerNum > 1) {
-            cycles += ((mAssignedDisplay->mXres * mAssignedDisplay->mYres) / G2D_BASE_PPC_COLORFILL);
+            cycles += ((mAssignedDisplay->mXres * mAssignedDisplay->mYres) / getColorfillPPC());
             MPP_LOGD(eDebugCapacity, "\tcolorfill cycles: %f, total cycles: %f",
-                    ((mAssignedDisplay->mXres * mAssignedDisplay->mYres) / G2D_BASE_PPC_COLORFILL), cycles);
+                    ((mAssignedDisplay->mXres * mAssignedDisplay->mYres) / getColorfillPPC()), cycles);
         }
         for (uint32_t i = 0; i < mAssignedSources.size(); i++) {
             uint32_t srcResolution = mAssignedSources[i]->mSrcImg.w * mAssignedSources[i]->mSrcImg.h;
@@ -2774,6 +2896,43 @@ uint32_t ExynosMPP::getMPPClock()
         return 0;
 }
 
+void ExynosMPP::logPPCSample()
+{
+    unsigned int laptime = mAcrylicHandle->getLaptimeUSec();
+    uint32_t colorfillPixels = 0;
+
+    /* The compositor does not measure the H/W */
+    if (laptime == 0)
+        return;
+
+    if ((mPhysicalType == MPP_G2D) && (mMaxSrcLayerNum > 1) && (mAssignedDisplay != NULL))
+        colorfillPixels = mAssignedDisplay->mXres * mAssignedDisplay->mYres;
+
+    String8 sample;
+    sample.appendFormat("%s,%u,%u,%u,%zu",
+            ExynosPPCModel::getMPPName((mPhysicalType == MPP_G2D) ?
+                ExynosPPCModel::PPC_MPP_G2D : ExynosPPCModel::PPC_MPP_MSC),
+            laptime, getMPPClock(), colorfillPixels, mAssignedSources.size());
+
+    for (size_t i = 0; i < mAssignedSources.size(); i++) {
+        exynos_image &src = mAssignedSources[i]->mSrcImg;
+        exynos_image &mid = mAssignedSources[i]->mMidImg;
+        uint32_t formatIndex, rotIndex, scaleIndex;
+
+        getPPCIndex(src, mid, formatIndex, rotIndex, scaleIndex, src);
+        if (formatIndex == PPC_FORMAT_AFBC)
+            formatIndex = PPC_FORMAT_RGB32;
+
+        sample.appendFormat(",%s,%s,%s,%u,%u,%u,%u",
+                ExynosPPCModel::getFormatName(formatIndex),
+                (src.compressed == 1) ? "afbc" : "none",
+                (src.transform & HAL_TRANSFORM_ROT_90) ? "rot" : "norot",
+                src.w, src.h, mid.w, mid.h);
+    }
+
+    ALOGD("ppc sample: %s", sample.string());
+}
+
 uint32_t ExynosMPP::getRestrictionClassification(struct exynos_image &img)
 {
     return !!(isFormatRgb(img.format) == false);
@@ -2859,7 +3018,18 @@ void ExynosMPP::dump(String8& result)
             mPrevAssignedState, mPrevAssignedDisplayType, mReservedDisplay);
     result.appendFormat("\tassinedSourceNum(%zu), Capacity(%f), CapaUsed(%f), mCurrentDstBuf(%d)\n",
             mAssignedSources.size(), mCapacity, mUsedCapacity, mCurrentDstBuf);
-
+    uint64_t supportChecks = mSupportCacheHits + mSupportCacheMisses;
+    result.appendFormat("\tsupport cache: hits(%" PRIu64 "), misses(%" PRIu64 "), hit ratio(%.1f%%)\n",
+            mSupportCacheHits, mSupportCacheMisses,
+            supportChecks ? (100.0 * mSupportCacheHits / supportChecks) : 0.0);
+    if ((mPhysicalType == MPP_G2D) || (mPhysicalType == MPP_MSC)) {
+        ExynosPPCModel &model = ExynosPPCModel::getInstance();
+        if (model.isLoaded())
+            result.appendFormat("\tPPC model: %s (%zu curves), colorfill PPC(%f)\n",
+                    model.getPath(), model.getCurveCount(), getColorfillPPC());
+        else
+            result.appendFormat("\tPPC model: built-in\n");
+    }
 }
 
 void ExynosMPP::closeFences()
@@ -2893,6 +3063,7 @@ void ExynosMPP::updateAttr()
     if (iter != mResourceManager->mMPPAttrs.end()) {
         mAttr = iter->second;
         MPP_LOGD(eDebugAttrSetting, "After mAttr(0x%" PRIx64 ")", mAttr);
+        clearSupportCache();
     }
 }
 
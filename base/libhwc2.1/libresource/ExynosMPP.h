@@ -35,6 +35,8 @@
 #include "ExynosHWCHelper.h"
 #include "GrallocWrapper.h"
 #include "ExynosMPPType.h"
+#include "ExynosPPCModel.h"
+#include "ExynosMPPBufferPool.h"
 
 class ExynosDisplay;
 class ExynosMPP;
@@ -230,6 +232,8 @@ typedef struct exynos_mpp_img_info {
     AcrylicLayer *mppLayer;
     int acrylicAcquireFenceFd;
     int acrylicReleaseFenceFd;
+    /* The request of allocOutBuf() to recycle the buffer */
+    exynos_mpp_buffer_key allocKey;
 } exynos_mpp_img_info_t;
 
 typedef enum {
@@ -243,22 +247,6 @@ typedef enum {
     PPC_SCALE_MAX
 } scaling_index_t;
 
-typedef enum {
-    PPC_FORMAT_YUV420   =   0,
-    PPC_FORMAT_YUV422,
-    PPC_FORMAT_RGB32,
-    PPC_FORMAT_YUV8_2,
-    PPC_FORMAT_P010,
-    PPC_FORMAT_AFBC,
-    PPC_FORMAT_FORMAT_MAX
-} format_index_t;
-
-typedef enum {
-    PPC_ROT_NO   =   0,
-    PPC_ROT,
-    PPC_ROT_MAX
-} rot_index_t;
-
 typedef struct ppc_list_for_scaling {
     float ppcList[PPC_SCALE_MAX];
 } ppc_list_for_scaling_t;
@@ -558,6 +546,51 @@ public:
     /* MPP's attribute bit (supported feature bit) */
     uint64_t    mAttr;
 
+    /**
+     * Results of isSupported() keyed by the fields of the images and the
+     * display state that the restriction checks refer to.
+     * The cache is direct mapped by the hash of the key. It is cleared
+     * when the restrictions or the attribute of the MPP are updated.
+     */
+    enum {
+        SUPPORT_CACHE_SIZE = 64,
+    };
+    struct SupportCacheImage {
+        uint32_t fullWidth;
+        uint32_t fullHeight;
+        uint32_t x;
+        uint32_t y;
+        uint32_t w;
+        uint32_t h;
+        uint32_t format;
+        uint64_t usageFlags;
+        uint32_t layerFlags;
+        uint32_t dataSpace;
+        uint32_t blending;
+        uint32_t transform;
+        uint32_t compressed;
+        uint32_t metaType;
+    };
+    struct SupportCacheKey {
+        ExynosDisplay *display;
+        uint32_t displayType;
+        uint32_t xres;
+        uint32_t yres;
+        /* hasHdrLayer and hasDrmLayer of ExynosResourceManager */
+        uint32_t layerState;
+        SupportCacheImage src;
+        SupportCacheImage dst;
+    };
+    struct SupportCacheEntry {
+        bool valid;
+        uint64_t hash;
+        SupportCacheKey key;
+        int64_t result;
+    };
+    SupportCacheEntry mSupportCache[SUPPORT_CACHE_SIZE];
+    uint64_t mSupportCacheHits;
+    uint64_t mSupportCacheMisses;
+
     bool mNeedSolidColorLayer;
 
     ExynosMPP(ExynosResourceManager* resourceManager,
@@ -579,6 +612,8 @@ public:
     int32_t requestHWStateChange(uint32_t state);
     int32_t setHWStateFence(int32_t fence);
     virtual int64_t isSupported(ExynosDisplay &display, struct exynos_image &src, struct exynos_image &dst);
+    int64_t checkSupported(ExynosDisplay &display, struct exynos_image &src, struct exynos_image &dst);
+    void clearSupportCache();
 
     bool isDataspaceSupportedByMPP(struct exynos_image &src, struct exynos_image &dst);
     bool isSupportedHDR10Plus(struct exynos_image &src, struct exynos_image &dst);
@@ -691,6 +726,15 @@ protected:
     /* format and rotation index are defined by indexImage */
     void getPPCIndex(struct exynos_image &indexImage, struct exynos_image &refImage,
             uint32_t &formatIndex, uint32_t &rotIndex, uint32_t &scaleIndex, struct exynos_image &criteria);
+    /*
+     * PPC of the class of layers given by getPPCIndex(). The curve of
+     * ExynosPPCModel is used if the table file has it, otherwise ppc_table_map.
+     */
+    float getTablePPC(struct exynos_image &src, struct exynos_image &dst, struct exynos_image &criteria,
+            uint32_t formatIndex, uint32_t rotIndex, uint32_t scaleIndex);
+    float getColorfillPPC();
+    /* Log the laptime of the last job with its layers for hwc_ppcfit */
+    void logPPCSample();
 
     float getRequiredBaseCycles(struct exynos_image &src, struct exynos_image &dst);
     bool addCapacity(ExynosMPPSource* mppSource);
@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <inttypes.h>
+#include <android/sync.h>
+#include <log/log.h>
+#include "ExynosMPPBufferPool.h"
+#include "GrallocWrapper.h"
+#include "gralloc_priv.h"
+
+using namespace android;
+
+static const char *partitionNames[ExynosMPPBufferPool::PARTITION_MAX] = {"normal", "secure"};
+
+ExynosMPPBufferPool::ExynosMPPBufferPool()
+    : mTrimTimeout(ms2ns(MPP_DST_POOL_TRIM_TIMEOUT_MS)),
+    mMapper(NULL)
+{
+    for (uint32_t i = 0; i < PARTITION_MAX; i++)
+        memset(&mPartitions[i].stats, 0, sizeof(Stats));
+
+    mPartitions[PARTITION_NORMAL].capacity = MPP_DST_POOL_MAX_SIZE;
+    mPartitions[PARTITION_SECURE].capacity = MPP_DST_POOL_SECURE_MAX_SIZE;
+}
+
+ExynosMPPBufferPool &ExynosMPPBufferPool::getInstance()
+{
+    /* The buffers are shared by the MPPs until the process exits */
+    static ExynosMPPBufferPool *pool = new ExynosMPPBufferPool();
+
+    return *pool;
+}
+
+size_t ExynosMPPBufferPool::getBufferSize(private_handle_t *handle)
+{
+    return static_cast<size_t>(handle->size) + handle->size1 + handle->size2;
+}
+
+bool ExynosMPPBufferPool::isIdle(const Buffer &buffer)
+{
+    if ((buffer.acquireFence >= 0) && (sync_wait(buffer.acquireFence, 0) < 0))
+        return false;
+    if ((buffer.releaseFence >= 0) && (sync_wait(buffer.releaseFence, 0) < 0))
+        return false;
+    return true;
+}
+
+void ExynosMPPBufferPool::closeFences(Buffer &buffer)
+{
+    if (buffer.acquireFence >= 0)
+        close(buffer.acquireFence);
+    if (buffer.releaseFence >= 0)
+        close(buffer.releaseFence);
+    buffer.acquireFence = -1;
+    buffer.releaseFence = -1;
+}
+
+void ExynosMPPBufferPool::setCapacity(uint32_t partition, size_t capacity)
+{
+    if (partition >= PARTITION_MAX)
+        return;
+
+    std::vector<Buffer> freed;
+    {
+        Mutex::Autolock lock(mMutex);
+        mPartitions[partition].capacity = capacity;
+        evictLocked(mPartitions[partition], freed);
+    }
+    freeBuffers(freed);
+}
+
+size_t ExynosMPPBufferPool::getCapacity(uint32_t partition) const
+{
+    if (partition >= PARTITION_MAX)
+        return 0;
+
+    Mutex::Autolock lock(mMutex);
+    return mPartitions[partition].capacity;
+}
+
+private_handle_t *ExynosMPPBufferPool::acquire(const exynos_mpp_buffer_key &key)
+{
+    private_handle_t *handle = NULL;
+    std::vector<Buffer> freed;
+    {
+        Mutex::Autolock lock(mMutex);
+        Partition &partition = mPartitions[key.secure ? PARTITION_SECURE : PARTITION_NORMAL];
+        bool busy = false;
+
+        /* The oldest buffer is the most likely to be released by H/W */
+        for (auto it = partition.buffers.begin(); it != partition.buffers.end(); it++) {
+            if (!(it->key == key))
+                continue;
+            if (!isIdle(*it)) {
+                busy = true;
+                continue;
+            }
+
+            handle = it->handle;
+            closeFences(*it);
+            partition.stats.bytes -= it->size;
+            partition.stats.count--;
+            partition.stats.hits++;
+            partition.buffers.erase(it);
+            break;
+        }
+
+        if (handle == NULL) {
+            if (busy)
+                partition.stats.busy++;
+            else
+                partition.stats.misses++;
+        }
+
+        trimLocked(systemTime(SYSTEM_TIME_MONOTONIC), freed);
+    }
+    freeBuffers(freed);
+
+    return handle;
+}
+
+void ExynosMPPBufferPool::release(GrallocWrapper::Mapper *mapper, private_handle_t *handle,
+        const exynos_mpp_buffer_key &key, int acquireFence, int releaseFence)
+{
+    if (handle == NULL)
+        return;
+
+    if (key.width == 0) {
+        mapper->freeBuffer(handle);
+        return;
+    }
+
+    Buffer buffer;
+    buffer.handle = handle;
+    buffer.key = key;
+    buffer.size = getBufferSize(handle);
+    buffer.releaseTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    buffer.acquireFence = (acquireFence >= 0) ? dup(acquireFence) : -1;
+    buffer.releaseFence = (releaseFence >= 0) ? dup(releaseFence) : -1;
+
+    std::vector<Buffer> freed;
+    {
+        Mutex::Autolock lock(mMutex);
+        Partition &partition = mPartitions[key.secure ? PARTITION_SECURE : PARTITION_NORMAL];
+
+        if (mMapper == NULL)
+            mMapper = mapper;
+
+        partition.buffers.push_back(buffer);
+        partition.stats.bytes += buffer.size;
+        partition.stats.count++;
+        partition.stats.recycled++;
+
+        evictLocked(partition, freed);
+        if (partition.stats.bytes > partition.stats.highWater)
+            partition.stats.highWater = partition.stats.bytes;
+
+        trimLocked(buffer.releaseTime, freed);
+    }
+    freeBuffers(freed);
+}
+
+nsecs_t ExynosMPPBufferPool::trim()
+{
+    nsecs_t next;
+    std::vector<Buffer> freed;
+    {
+        Mutex::Autolock lock(mMutex);
+        next = trimLocked(systemTime(SYSTEM_TIME_MONOTONIC), freed);
+    }
+    freeBuffers(freed);
+
+    return next;
+}
+
+void ExynosMPPBufferPool::evictLocked(Partition &partition, std::vector<Buffer> &freed)
+{
+    while (partition.stats.bytes > partition.capacity) {
+        Buffer &buffer = partition.buffers.front();
+        partition.stats.bytes -= buffer.size;
+        partition.stats.count--;
+        partition.stats.evicted++;
+        freed.push_back(buffer);
+        partition.buffers.pop_front();
+    }
+}
+
+nsecs_t ExynosMPPBufferPool::trimLocked(nsecs_t now, std::vector<Buffer> &freed)
+{
+    nsecs_t next = 0;
+
+    for (uint32_t i = 0; i < PARTITION_MAX; i++) {
+        Partition &partition = mPartitions[i];
+        while (!partition.buffers.empty()) {
+            Buffer &buffer = partition.buffers.front();
+            nsecs_t expire = buffer.releaseTime + mTrimTimeout;
+            if (expire > now) {
+                if ((next == 0) || ((expire - now) < next))
+                    next = expire - now;
+                break;
+            }
+            partition.stats.bytes -= buffer.size;
+            partition.stats.count--;
+            partition.stats.trimmed++;
+            freed.push_back(buffer);
+            partition.buffers.pop_front();
+        }
+    }
+
+    return next;
+}
+
+void ExynosMPPBufferPool::freeBuffers(std::vector<Buffer> &freed)
+{
+    for (auto &buffer : freed) {
+        closeFences(buffer);
+        mMapper->freeBuffer(buffer.handle);
+    }
+    freed.clear();
+}
+
+void ExynosMPPBufferPool::getStats(uint32_t partition, Stats &stats)
+{
+    if (partition >= PARTITION_MAX)
+        return;
+
+    Mutex::Autolock lock(mMutex);
+    stats = mPartitions[partition].stats;
+}
+
+void ExynosMPPBufferPool::dump(String8 &result)
+{
+    Mutex::Autolock lock(mMutex);
+
+    result.appendFormat("MPP destination buffer pool (trim timeout %" PRId64 " ms)\n",
+            ns2ms(mTrimTimeout));
+    for (uint32_t i = 0; i < PARTITION_MAX; i++) {
+        Stats &stats = mPartitions[i].stats;
+        result.appendFormat("\t[%s] %zu buffers, %zu / %zu bytes, high water %zu bytes\n",
+                partitionNames[i], stats.count, stats.bytes, mPartitions[i].capacity,
+                stats.highWater);
+        result.appendFormat("\t\thits %" PRIu64 ", misses %" PRIu64 ", busy %" PRIu64
+                ", recycled %" PRIu64 ", evicted %" PRIu64 ", trimmed %" PRIu64 "\n",
+                stats.hits, stats.misses, stats.busy, stats.recycled, stats.evicted,
+                stats.trimmed);
+        for (auto &buffer : mPartitions[i].buffers) {
+            result.appendFormat("\t\t%p: %ux%u format 0x%x usage 0x%" PRIx64 " %zu bytes\n",
+                    buffer.handle, buffer.key.width, buffer.key.height, buffer.key.format,
+                    buffer.key.usage, buffer.size);
+        }
+    }
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _EXYNOSMPPBUFFERPOOL_H
+#define _EXYNOSMPPBUFFERPOOL_H
+
+#include <stdint.h>
+#include <list>
+#include <vector>
+#include <utils/Mutex.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+
+struct private_handle_t;
+
+namespace android {
+namespace GrallocWrapper {
+class Mapper;
+}
+}
+
+/* Total bytes of the idle buffers kept by each partition of the pool */
+#ifndef MPP_DST_POOL_MAX_SIZE
+#define MPP_DST_POOL_MAX_SIZE (64 * 1024 * 1024)
+#endif
+#ifndef MPP_DST_POOL_SECURE_MAX_SIZE
+#define MPP_DST_POOL_SECURE_MAX_SIZE (32 * 1024 * 1024)
+#endif
+/* An idle buffer is freed if it is not recycled for this time */
+#ifndef MPP_DST_POOL_TRIM_TIMEOUT_MS
+#define MPP_DST_POOL_TRIM_TIMEOUT_MS 3000
+#endif
+
+/*
+ * The allocation request of a destination buffer of ExynosMPP::allocOutBuf().
+ * @usage is the gralloc usage given to the allocator. The compression of the
+ * buffer is decided by gralloc with the format and the usage so that a buffer
+ * of the same request is the same layout. @width is 0 if the buffer is not
+ * allocated by allocOutBuf().
+ */
+typedef struct exynos_mpp_buffer_key {
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+    uint64_t usage;
+    bool secure;
+
+    bool operator==(const exynos_mpp_buffer_key &key) const {
+        return (width == key.width) && (height == key.height) &&
+            (format == key.format) && (usage == key.usage) &&
+            (secure == key.secure);
+    }
+} exynos_mpp_buffer_key_t;
+
+/*
+ * ExynosMPPBufferPool - Idle destination buffers shared by all M2M MPPs
+ *
+ * The destination buffers freed by the MPPs are kept in the pool instead of
+ * being freed to gralloc and allocOutBuf() recycles a buffer of the same
+ * request. It saves the allocation, the page zeroing and the IOMMU mapping of
+ * large buffers on a resolution change, a display mode change or the
+ * reassignment of the MPPs.
+ * A buffer is recycled only if its acquire and release fences are signaled.
+ * The pool keeps the duplicates of the fences given with the buffer.
+ * The secure buffers are kept in a separate partition. Each partition keeps
+ * the idle buffers up to its capacity and frees the oldest ones on overflow.
+ * The buffers idle longer than MPP_DST_POOL_TRIM_TIMEOUT_MS are freed by
+ * trim() that is called on every access and by the idle ResourceManageThread.
+ */
+class ExynosMPPBufferPool {
+public:
+    enum {
+        PARTITION_NORMAL = 0,
+        PARTITION_SECURE,
+        PARTITION_MAX
+    };
+
+    struct Stats {
+        uint64_t hits;      /* acquire() returned a pooled buffer */
+        uint64_t misses;    /* acquire() found no buffer of the request */
+        uint64_t busy;      /* acquire() found buffers of the request in use by H/W only */
+        uint64_t recycled;  /* buffers kept by release() */
+        uint64_t evicted;   /* buffers freed to keep the capacity */
+        uint64_t trimmed;   /* buffers freed by the timeout */
+        size_t bytes;       /* bytes of the idle buffers */
+        size_t highWater;   /* the peak of bytes */
+        size_t count;       /* the number of the idle buffers */
+    };
+
+    ExynosMPPBufferPool();
+
+    static ExynosMPPBufferPool &getInstance();
+
+    /* @capacity of 0 disables the partition and frees the pooled buffers */
+    void setCapacity(uint32_t partition, size_t capacity);
+    size_t getCapacity(uint32_t partition) const;
+    void setTrimTimeout(nsecs_t timeout) { mTrimTimeout = timeout; }
+
+    /*
+     * Return an idle buffer of @key that is removed from the pool.
+     * Return NULL if there is none. The caller should allocate a buffer then.
+     */
+    private_handle_t *acquire(const exynos_mpp_buffer_key &key);
+    /*
+     * Keep @handle allocated with @key by @mapper. The caller still owns
+     * @acquireFence and @releaseFence. @handle is freed if @key is invalid or
+     * the buffer is larger than the capacity of the partition.
+     */
+    void release(android::GrallocWrapper::Mapper *mapper, private_handle_t *handle,
+            const exynos_mpp_buffer_key &key, int acquireFence, int releaseFence);
+    /*
+     * Free the buffers idle longer than the trim timeout.
+     * Return the time until the next buffer expires or 0 if the pool is empty.
+     */
+    nsecs_t trim();
+
+    void getStats(uint32_t partition, Stats &stats);
+    void dump(android::String8 &result);
+private:
+    struct Buffer {
+        private_handle_t *handle;
+        exynos_mpp_buffer_key key;
+        size_t size;
+        nsecs_t releaseTime;
+        int acquireFence;
+        int releaseFence;
+    };
+
+    struct Partition {
+        /* The oldest buffer is the front */
+        std::list<Buffer> buffers;
+        size_t capacity;
+        Stats stats;
+    };
+
+    static size_t getBufferSize(private_handle_t *handle);
+    static bool isIdle(const Buffer &buffer);
+    static void closeFences(Buffer &buffer);
+
+    /* Move the buffers to free out of the pool to @freed */
+    void evictLocked(Partition &partition, std::vector<Buffer> &freed);
+    nsecs_t trimLocked(nsecs_t now, std::vector<Buffer> &freed);
+    /* Free @freed out of mMutex not to block acquire() */
+    void freeBuffers(std::vector<Buffer> &freed);
+
+    mutable android::Mutex mMutex;
+    Partition mPartitions[PARTITION_MAX];
+    nsecs_t mTrimTimeout;
+    /* The mapper of all the buffers given to release() */
+    android::GrallocWrapper::Mapper *mMapper;
+};
+
+#endif //_EXYNOSMPPBUFFERPOOL_H
@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <log/log.h>
+#include "ExynosPPCModel.h"
+
+static const char *mppNames[ExynosPPCModel::PPC_MPP_MAX] = {"msc", "g2d"};
+/* PPC_FORMAT_AFBC is the compression of the model */
+static const char *formatNames[PPC_FORMAT_AFBC] = {"yuv420", "yuv422", "rgb32", "yuv8_2", "p010"};
+
+ExynosPPCModel::ExynosPPCModel()
+{
+    reset();
+}
+
+ExynosPPCModel &ExynosPPCModel::getInstance()
+{
+    static ExynosPPCModel *model = []() {
+        ExynosPPCModel *m = new ExynosPPCModel();
+        /* The built-in ppc_table_map is used if no table file is installed */
+        m->load(HWC_PPC_MODEL_PATH);
+        return m;
+    }();
+
+    return *model;
+}
+
+void ExynosPPCModel::reset()
+{
+    mLoaded = false;
+    mPath.clear();
+    mColorfillPPC = 0;
+    mCurves.clear();
+}
+
+const char *ExynosPPCModel::getMPPName(uint32_t mpp)
+{
+    return (mpp < PPC_MPP_MAX) ? mppNames[mpp] : "unknown";
+}
+
+const char *ExynosPPCModel::getFormatName(uint32_t format)
+{
+    return (format < PPC_FORMAT_AFBC) ? formatNames[format] : "unknown";
+}
+
+int32_t ExynosPPCModel::findMPP(const char *name)
+{
+    for (uint32_t i = 0; i < PPC_MPP_MAX; i++) {
+        if (strcmp(mppNames[i], name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+int32_t ExynosPPCModel::findFormat(const char *name)
+{
+    for (uint32_t i = 0; i < PPC_FORMAT_AFBC; i++) {
+        if (strcmp(formatNames[i], name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+bool ExynosPPCModel::setCurve(uint32_t mpp, uint32_t format, uint32_t rot, bool compressed,
+        std::vector<Point> points)
+{
+    if ((mpp >= PPC_MPP_MAX) || (format >= PPC_FORMAT_AFBC) || (rot >= PPC_ROT_MAX) ||
+        points.empty())
+        return false;
+
+    std::sort(points.begin(), points.end(),
+            [](const Point &a, const Point &b) { return a.scale < b.scale; });
+
+    for (size_t i = 0; i < points.size(); i++) {
+        if (!(points[i].scale > 0) || !(points[i].ppc > 0))
+            return false;
+        if ((i > 0) && (points[i].scale == points[i - 1].scale))
+            return false;
+    }
+
+    mCurves[getKey(mpp, format, rot, compressed)] = points;
+
+    return true;
+}
+
+const std::vector<ExynosPPCModel::Point> *ExynosPPCModel::getCurve(uint32_t mpp,
+        uint32_t format, uint32_t rot, bool compressed) const
+{
+    auto it = mCurves.find(getKey(mpp, format, rot, compressed));
+
+    return (it == mCurves.end()) ? NULL : &it->second;
+}
+
+void ExynosPPCModel::getInterpolation(const std::vector<Point> &points, float scale,
+        size_t &lower, size_t &upper, float &weight)
+{
+    lower = 0;
+    upper = 0;
+    weight = 0;
+
+    if (points.empty() || (scale <= points.front().scale))
+        return;
+
+    if (scale >= points.back().scale) {
+        lower = upper = points.size() - 1;
+        return;
+    }
+
+    while (points[upper].scale < scale)
+        upper++;
+    lower = upper - 1;
+
+    weight = log2f(scale / points[lower].scale) /
+        log2f(points[upper].scale / points[lower].scale);
+}
+
+bool ExynosPPCModel::getPPC(uint32_t mpp, uint32_t format, uint32_t rot, bool compressed,
+        float scale, float &ppc) const
+{
+    const std::vector<Point> *points = getCurve(mpp, format, rot, compressed);
+
+    if (points == NULL)
+        return false;
+
+    size_t lower, upper;
+    float weight;
+
+    getInterpolation(*points, scale, lower, upper, weight);
+
+    float cyclesPerPixel = (1 - weight) / (*points)[lower].ppc + weight / (*points)[upper].ppc;
+    ppc = 1 / cyclesPerPixel;
+
+    return true;
+}
+
+bool ExynosPPCModel::parseCurve(char *line)
+{
+    char *saveptr = NULL;
+    const char *mppName = strtok_r(line, " \t\r\n", &saveptr);
+    const char *formatName = strtok_r(NULL, " \t\r\n", &saveptr);
+    const char *rotName = strtok_r(NULL, " \t\r\n", &saveptr);
+    const char *compressionName = strtok_r(NULL, " \t\r\n", &saveptr);
+
+    if ((mppName == NULL) || (formatName == NULL) ||
+        (rotName == NULL) || (compressionName == NULL))
+        return false;
+
+    int32_t mpp = findMPP(mppName);
+    int32_t format = findFormat(formatName);
+    uint32_t rot;
+    bool compressed;
+
+    if ((mpp < 0) || (format < 0))
+        return false;
+
+    if (strcmp(rotName, "rot") == 0)
+        rot = PPC_ROT;
+    else if (strcmp(rotName, "norot") == 0)
+        rot = PPC_ROT_NO;
+    else
+        return false;
+
+    if (strcmp(compressionName, "afbc") == 0)
+        compressed = true;
+    else if (strcmp(compressionName, "none") == 0)
+        compressed = false;
+    else
+        return false;
+
+    std::vector<Point> points;
+    char *token;
+
+    while ((token = strtok_r(NULL, " \t\r\n", &saveptr)) != NULL) {
+        Point point;
+        char *end;
+
+        point.scale = strtof(token, &end);
+        if ((end == token) || (*end != ':'))
+            return false;
+        token = end + 1;
+        point.ppc = strtof(token, &end);
+        if ((end == token) || (*end != '\0'))
+            return false;
+
+        points.push_back(point);
+    }
+
+    return setCurve(mpp, format, rot, compressed, points);
+}
+
+bool ExynosPPCModel::load(const char *path)
+{
+    reset();
+
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+        return false;
+
+    char line[1024];
+    int lineno = 0;
+    int version = -1;
+    bool success = true;
+
+    while (success && fgets(line, sizeof(line), fp)) {
+        char keyword[16];
+        float ppc;
+
+        lineno++;
+
+        char *comment = strchr(line, '#');
+        if (comment)
+            *comment = '\0';
+
+        int offset = 0;
+        if (sscanf(line, " %15s%n", keyword, &offset) != 1)
+            continue;
+
+        if (version < 0) {
+            if ((strcmp(keyword, "version") != 0) || (sscanf(line + offset, "%d", &version) != 1)) {
+                success = false;
+            } else if (version != VERSION) {
+                ALOGE("%s:: unsupported version %d of PPC model '%s'", __func__, version, path);
+                fclose(fp);
+                return false;
+            }
+        } else if (strcmp(keyword, "colorfill") == 0) {
+            success = (sscanf(line + offset, "%f", &ppc) == 1) && (ppc > 0);
+            mColorfillPPC = ppc;
+        } else if (strcmp(keyword, "ppc") == 0) {
+            success = parseCurve(line + offset);
+        } else {
+            success = false;
+        }
+    }
+
+    fclose(fp);
+
+    if (!success || (version < 0)) {
+        ALOGE("%s:: malformed line %d of PPC model '%s'", __func__, lineno, path);
+        reset();
+        return false;
+    }
+
+    mLoaded = true;
+    mPath = path;
+
+    ALOGI("%s:: loaded %zu curves of PPC model '%s'", __func__, mCurves.size(), path);
+
+    return true;
+}
+
+bool ExynosPPCModel::save(FILE *fp) const
+{
+    fprintf(fp, "version %d\n", VERSION);
+    if (mColorfillPPC > 0)
+        fprintf(fp, "colorfill %.3f\n", mColorfillPPC);
+
+    for (auto &curve: mCurves) {
+        uint32_t key = curve.first;
+
+        fprintf(fp, "ppc %s %s %s %s", getMPPName(key & 0xff), getFormatName((key >> 8) & 0xff),
+                ((key >> 16) & 0xff) ? "rot" : "norot", ((key >> 24) & 0xff) ? "afbc" : "none");
+        for (auto &point: curve.second)
+            fprintf(fp, " %g:%.3f", point.scale, point.ppc);
+        fprintf(fp, "\n");
+    }
+
+    return ferror(fp) == 0;
+}
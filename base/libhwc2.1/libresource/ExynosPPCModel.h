@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _EXYNOSPPCMODEL_H
+#define _EXYNOSPPCMODEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifndef HWC_PPC_MODEL_PATH
+#define HWC_PPC_MODEL_PATH "/vendor/etc/hwc/ppc_model.conf"
+#endif
+
+typedef enum {
+    PPC_FORMAT_YUV420   =   0,
+    PPC_FORMAT_YUV422,
+    PPC_FORMAT_RGB32,
+    PPC_FORMAT_YUV8_2,
+    PPC_FORMAT_P010,
+    PPC_FORMAT_AFBC,
+    PPC_FORMAT_FORMAT_MAX
+} format_index_t;
+
+typedef enum {
+    PPC_ROT_NO   =   0,
+    PPC_ROT,
+    PPC_ROT_MAX
+} rot_index_t;
+
+/*
+ * ExynosPPCModel - Pixels per cycle of M2M MPPs loaded from a table file
+ *
+ * A curve of the model gives the PPC of a class of layers as a function of
+ * the scale ratio, the number of destination pixels per source pixel.
+ * The class of layers is the MPP type, the format class, the rotation and
+ * the compression. The PPC between two points of a curve is interpolated
+ * in log2 of the scale ratio. It is linear in the cycles per pixel, 1/PPC
+ * so that the cycles of a layer are a linear combination of the points.
+ * The PPC outside the curve is the PPC of the nearest point.
+ *
+ * The table file is HWC_PPC_MODEL_PATH that is configured per SoC with
+ * BOARD_HWC_PPC_MODEL_PATH. The first line of the file should be
+ * "version 1" and each of the other lines is one of:
+ *   colorfill <ppc>
+ *   ppc <mpp> <format> <rotation> <compression> <scale>:<ppc> ...
+ * <mpp> is g2d or msc, <format> is yuv420, yuv422, rgb32, yuv8_2 or p010,
+ * <rotation> is rot or norot and <compression> is afbc or none.
+ * A text after '#' is a comment. The whole file is ignored if it has a
+ * malformed line. The classes of layers without a curve keep the built-in
+ * ppc_table_map of the SoC. hwc_ppcfit generates the table file from the
+ * samples of G2D and MSC captured with the eDebugCapacity logs.
+ */
+class ExynosPPCModel {
+public:
+    enum {
+        VERSION = 1,
+    };
+
+    enum {
+        PPC_MPP_MSC = 0,
+        PPC_MPP_G2D,
+        PPC_MPP_MAX
+    };
+
+    struct Point {
+        float scale;
+        float ppc;
+    };
+
+    ExynosPPCModel();
+
+    /* The model of HWC_PPC_MODEL_PATH loaded on the first call */
+    static ExynosPPCModel &getInstance();
+
+    void reset();
+    /*
+     * Load the curves from @path replacing the current ones.
+     * Return false and keep no curve if @path is not found or invalid.
+     */
+    bool load(const char *path);
+    bool isLoaded() const { return mLoaded; }
+    const char *getPath() const { return mPath.c_str(); }
+    size_t getCurveCount() const { return mCurves.size(); }
+
+    /* @points are sorted by the scale ratio. Return false if they are invalid. */
+    bool setCurve(uint32_t mpp, uint32_t format, uint32_t rot, bool compressed,
+            std::vector<Point> points);
+    const std::vector<Point> *getCurve(uint32_t mpp, uint32_t format, uint32_t rot,
+            bool compressed) const;
+    /* Return false if there is no curve of the class of layers */
+    bool getPPC(uint32_t mpp, uint32_t format, uint32_t rot, bool compressed,
+            float scale, float &ppc) const;
+
+    void setColorfillPPC(float ppc) { mColorfillPPC = ppc; }
+    /* 0 if the table file does not have it */
+    float getColorfillPPC() const { return mColorfillPPC; }
+
+    /*
+     * The cycles per pixel at @scale are (1 - @weight) / points[@lower].ppc +
+     * @weight / points[@upper].ppc.
+     */
+    static void getInterpolation(const std::vector<Point> &points, float scale,
+            size_t &lower, size_t &upper, float &weight);
+
+    static const char *getMPPName(uint32_t mpp);
+    static const char *getFormatName(uint32_t format);
+    static int32_t findMPP(const char *name);
+    static int32_t findFormat(const char *name);
+
+    bool save(FILE *fp) const;
+private:
+    static uint32_t getKey(uint32_t mpp, uint32_t format, uint32_t rot, bool compressed)
+    {
+        return mpp | (format << 8) | (rot << 16) | ((compressed ? 1 : 0) << 24);
+    }
+    bool parseCurve(char *line);
+
+    bool mLoaded;
+    std::string mPath;
+    float mColorfillPPC;
+    std::map<uint32_t, std::vector<Point>> mCurves;
+};
+
+#endif //_EXYNOSPPCMODEL_H
@@ -380,8 +380,22 @@ int32_t ExynosResourceManager::assignResource(ExynosDisplay *display)
         return NO_ERROR;
     }
 
+    /* The support checks depend on the configuration of the displays */
+    if (mDevice->mGeometryChanged & (GEOMETRY_DISPLAY_CONFIG_CHANGED |
+                                     GEOMETRY_DISPLAY_RESOLUTION_CHANGED |
+                                     GEOMETRY_DEVICE_CONFIG_CHANGED))
+        clearSupportCaches();
+
+    mReuseAssignment = canReuseAssignment(display);
+    mReuseFailed = false;
+    mReusedLayerNum = 0;
+    HDEBUGLOGD(eDebugResourceManager|eDebugSkipResourceAssign, "reuse last assignment(%d)",
+            mReuseAssignment);
+
     for (uint32_t i = 0; i < display->mLayers.size(); i++) {
         display->mLayers[i]->resetValidateData();
+        if (mReuseAssignment == false)
+            display->mLayers[i]->mLastAssignment.valid = false;
     }
 
     display->initializeValidateInfos();
@@ -463,9 +477,101 @@ int32_t ExynosResourceManager::assignResource(ExynosDisplay *display)
         }
     }
 
+    saveAssignment(display);
+    if (mReuseAssignment)
+        display->mResourceAssignCount.incremental++;
+    else
+        display->mResourceAssignCount.full++;
+    display->mResourceAssignCount.lastReusedLayers = mReusedLayerNum;
+
     return NO_ERROR;
 }
 
+/**
+ * The last assignment of the unchanged layers can be reused only if
+ * the layers are changed in place. The changes of the layer list, the
+ * display or the device need all layers to be reassigned.
+ */
+bool ExynosResourceManager::canReuseAssignment(ExynosDisplay *display)
+{
+    const uint64_t inPlaceChanges = GEOMETRY_LAYER_DATASPACE_CHANGED |
+                                    GEOMETRY_LAYER_DISPLAYFRAME_CHANGED |
+                                    GEOMETRY_LAYER_SOURCECROP_CHANGED |
+                                    GEOMETRY_LAYER_TRANSFORM_CHANGED |
+                                    GEOMETRY_LAYER_COMPRESSED_CHANGED |
+                                    GEOMETRY_LAYER_BLEND_CHANGED |
+                                    GEOMETRY_LAYER_FORMAT_CHANGED;
+
+    if ((mDevice->mGeometryChanged & ~inPlaceChanges) != 0)
+        return false;
+
+    for (uint32_t i = 0; i < display->mLayers.size(); i++) {
+        if (display->mLayers[i]->mLastAssignment.valid)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @return composition type of the last assignment of the layer if the
+ * resources of the last assignment are still assignable,
+ * HWC2_COMPOSITION_INVALID otherwise
+ */
+int32_t ExynosResourceManager::getLastAssignment(ExynosDisplay *display, ExynosLayer *layer,
+        exynos_image &src_img, exynos_image &dst_img,
+        exynos_image &m2m_out_img, ExynosMPP **m2mMPP, ExynosMPP **otfMPP)
+{
+    ExynosLayer::LastAssignment &last = layer->mLastAssignment;
+
+    if (last.compositionType == HWC2_COMPOSITION_DEVICE) {
+        if (last.m2mMPP == NULL) {
+            if (((layer->mSupportedMPPFlag & last.otfMPP->mLogicalType) == 0) ||
+                (last.otfMPP->isAssignable(display, src_img, dst_img) == false))
+                return HWC2_COMPOSITION_INVALID;
+        } else {
+            exynos_image otf_src_img = last.midImg;
+            exynos_image otf_dst_img = dst_img;
+            otf_dst_img.format = DEFAULT_MPP_DST_FORMAT;
+            otf_dst_img.transform = 0;
+
+            if (((layer->mSupportedMPPFlag & last.m2mMPP->mLogicalType) == 0) ||
+                (last.m2mMPP->isAssignableState(display, src_img, dst_img) == false) ||
+                (last.m2mMPP->hasEnoughCapa(display, src_img, otf_src_img) == false) ||
+                (last.otfMPP->isAssignable(display, otf_src_img, otf_dst_img) == false))
+                return HWC2_COMPOSITION_INVALID;
+            m2m_out_img = otf_src_img;
+        }
+    } else if (last.compositionType == HWC2_COMPOSITION_EXYNOS) {
+        if (((layer->mSupportedMPPFlag & last.m2mMPP->mLogicalType) == 0) ||
+            (last.m2mMPP->isAssignableState(display, src_img, dst_img) == false) ||
+            (last.m2mMPP->hasEnoughCapa(display, src_img, dst_img) == false))
+            return HWC2_COMPOSITION_INVALID;
+    } else {
+        return HWC2_COMPOSITION_INVALID;
+    }
+
+    *m2mMPP = last.m2mMPP;
+    *otfMPP = last.otfMPP;
+
+    return last.compositionType;
+}
+
+void ExynosResourceManager::saveAssignment(ExynosDisplay *display)
+{
+    for (uint32_t i = 0; i < display->mLayers.size(); i++) {
+        ExynosLayer *layer = display->mLayers[i];
+        ExynosLayer::LastAssignment &last = layer->mLastAssignment;
+
+        last.compositionType = layer->mValidateCompositionType;
+        last.otfMPP = layer->mOtfMPP;
+        last.m2mMPP = layer->mM2mMPP;
+        last.midImg = layer->mMidImg;
+        last.valid = ((last.compositionType == HWC2_COMPOSITION_DEVICE) && (last.otfMPP != NULL)) ||
+                     ((last.compositionType == HWC2_COMPOSITION_EXYNOS) && (last.m2mMPP != NULL));
+    }
+}
+
 int32_t ExynosResourceManager::setResourcePriority(ExynosDisplay *display)
 {
     int ret = NO_ERROR;
@@ -561,6 +667,12 @@ int32_t ExynosResourceManager::assignResourceInternal(ExynosDisplay *display)
     }
 
     do {
+        /*
+         * Falling back to the full assignment when the last assignment is not
+         * assignable anymore is not a retry.
+         */
+        bool reuseAssignment = mReuseAssignment;
+
         HDEBUGLOGD(eDebugResourceAssigning, "%s:: retry_count(%d)", __func__, retry_count);
         if ((ret = resetAssignedResources(display)) != NO_ERROR)
             return ret;
@@ -572,7 +684,8 @@ int32_t ExynosResourceManager::assignResourceInternal(ExynosDisplay *display)
 
         if ((ret = assignLayers(display, ePriorityMax)) != NO_ERROR) {
             if (ret == EXYNOS_ERROR_CHANGED) {
-                retry_count++;
+                if (reuseAssignment == mReuseAssignment)
+                    retry_count++;
                 continue;
             } else {
                 HWC_LOGE(display, "%s:: Fail to assign resource for ePriorityMax layer",
@@ -583,7 +696,8 @@ int32_t ExynosResourceManager::assignResourceInternal(ExynosDisplay *display)
 
         if ((ret = assignLayers(display, ePriorityHigh)) != NO_ERROR) {
             if (ret == EXYNOS_ERROR_CHANGED) {
-                retry_count++;
+                if (reuseAssignment == mReuseAssignment)
+                    retry_count++;
                 continue;
             } else {
                 HWC_LOGE(display, "%s:: Fail to assign resource for ePriorityHigh layer",
@@ -630,7 +744,8 @@ int32_t ExynosResourceManager::assignResourceInternal(ExynosDisplay *display)
         if (ret == NO_ERROR) {
             ret = setResourcePriority(display);
         }
-        retry_count++;
+        if (reuseAssignment == mReuseAssignment)
+            retry_count++;
     } while((ret == EXYNOS_ERROR_CHANGED) && (retry_count < ASSIGN_RESOURCE_TRY_COUNT));
 
     if (retry_count == ASSIGN_RESOURCE_TRY_COUNT) {
@@ -1317,6 +1432,20 @@ int32_t ExynosResourceManager::assignLayer(ExynosDisplay *display, ExynosLayer *
         layer->printLayer();
     }
 
+    if (mReuseAssignment && (validateFlag == NO_ERROR) &&
+        (layer->mLastAssignment.valid) && (layer->mGeometryChanged == 0)) {
+        int32_t compositionType = getLastAssignment(display, layer, src_img, dst_img,
+                m2m_out_img, m2mMPP, otfMPP);
+        if (compositionType != HWC2_COMPOSITION_INVALID) {
+            HDEBUGLOGD(eDebugResourceAssigning, "\t\t[%d] layer: last assignment is reused", layer_index);
+            mReusedLayerNum++;
+            return compositionType;
+        }
+        /* Capacity or window of the last assignment is taken by the changed layers */
+        mReuseFailed = true;
+        return HWC2_COMPOSITION_INVALID;
+    }
+
     if ((validateFlag == NO_ERROR) || (validateFlag == eInsufficientWindow) ||
         (validateFlag == eDimLayer) || (validateFlag == eSourceOverBelow)) {
         bool isAssignable = false;
@@ -1480,6 +1609,10 @@ int32_t ExynosResourceManager::assignLayers(ExynosDisplay * display, uint32_t pr
         layer->setExynosMidImage(dst_img);
 
         compositionType = assignLayer(display, layer, i, m2m_out_img, &m2mMPP, &otfMPP, validateFlag);
+        if (mReuseFailed) {
+            HDEBUGLOGD(eDebugResourceManager, "\t[%d] layer: last assignment is not assignable, reassign all layers", i);
+            break;
+        }
         if (compositionType == HWC2_COMPOSITION_DEVICE) {
             if (otfMPP != NULL) {
                 if ((ret = otfMPP->assignMPP(display, layer)) != NO_ERROR)
@@ -1561,7 +1694,7 @@ int32_t ExynosResourceManager::assignLayers(ExynosDisplay * display, uint32_t pr
                 return ret;
         }
     }
-    if (needReAssign) {
+    if (needReAssign || mReuseFailed) {
         if ((display->mClientCompositionInfo.mHasCompositionLayer) &&
                 (display->mClientCompositionInfo.mOtfMPP != NULL))
             display->mClientCompositionInfo.mOtfMPP->resetAssignedState();
@@ -1574,7 +1707,14 @@ int32_t ExynosResourceManager::assignLayers(ExynosDisplay * display, uint32_t pr
         }
 
         display->initializeValidateInfos();
-        display->mLowFpsLayerInfo.initializeInfos();
+        if (needReAssign)
+            display->mLowFpsLayerInfo.initializeInfos();
+        if (mReuseFailed) {
+            /* Fall back to the full assignment */
+            mReuseAssignment = false;
+            mReuseFailed = false;
+            mReusedLayerNum = 0;
+        }
         return EXYNOS_ERROR_CHANGED;
     }
     return ret;
@@ -2781,6 +2921,14 @@ void ExynosResourceManager::updateRestrictions() {
     }
 }
 
+void ExynosResourceManager::clearSupportCaches()
+{
+    for (uint32_t i = 0; i < mOtfMPPs.size(); i++)
+        mOtfMPPs[i]->clearSupportCache();
+    for (uint32_t i = 0; i < mM2mMPPs.size(); i++)
+        mM2mMPPs[i]->clearSupportCache();
+}
+
 uint32_t ExynosResourceManager::getFeatureTableSize()
 {
     return sizeof(feature_table)/sizeof(feature_support_t);
@@ -157,6 +157,11 @@ class ExynosResourceManager {
         int32_t assignLayers(ExynosDisplay *display, uint32_t priority);
         virtual int32_t assignLayer(ExynosDisplay *display, ExynosLayer *layer, uint32_t layer_index,
                 exynos_image &m2m_out_img, ExynosMPP **m2mMPP, ExynosMPP **otfMPP, uint32_t &overlayInfo);
+        bool canReuseAssignment(ExynosDisplay *display);
+        int32_t getLastAssignment(ExynosDisplay *display, ExynosLayer *layer,
+                exynos_image &src_img, exynos_image &dst_img,
+                exynos_image &m2m_out_img, ExynosMPP **m2mMPP, ExynosMPP **otfMPP);
+        void saveAssignment(ExynosDisplay *display);
 
         /* If product needs specific assign policy, describe at their module codes */
         virtual int32_t checkExceptionScenario(ExynosDisplay __unused *display) { return NO_ERROR; };
@@ -186,6 +191,7 @@ class ExynosResourceManager {
         void makeFormatRestrictions(restriction_key_t table, int deviceFormat);
 
         void updateRestrictions();
+        void clearSupportCaches();
 
         mpp_phycal_type_t getPhysicalType(int ch);
         uint32_t getFeatureTableSize();
@@ -211,6 +217,11 @@ class ExynosResourceManager {
 
     private:
         uint32_t mUseDpuDisplayNum = 0;
+        /* The last assignment of the unchanged layers is reused in this validate */
+        bool mReuseAssignment = false;
+        /* A reused assignment is not assignable anymore */
+        bool mReuseFailed = false;
+        uint32_t mReusedLayerNum = 0;
         displayEnableMap_t mDisplayEnableState = 1;
         int32_t changeLayerFromClientToDevice(ExynosDisplay *display, ExynosLayer *layer,
                 uint32_t layer_index, exynos_image m2m_out_img, ExynosMPP *m2mMPP, ExynosMPP *otfMPP);
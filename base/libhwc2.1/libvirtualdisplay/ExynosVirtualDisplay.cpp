@@ -38,6 +38,8 @@ ExynosVirtualDisplay::ExynosVirtualDisplay(uint32_t index, ExynosDevice *device)
     mDisplayId = getDisplayId(mType, mIndex);
 
     mDisplayControl.earlyStartMPP = false;
+    /* There is no vsync to latch the frame */
+    mDisplayControl.holdUntilExpectedPresent = false;
 
     mOutputBufferAcquireFenceFd = -1;
     mOutputBufferReleaseFenceFd = -1;
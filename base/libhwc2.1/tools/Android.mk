@@ -0,0 +1,25 @@
+# Copyright (C) 2012 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+LOCAL_PATH:= $(call my-dir)
+
+# calibration of the PPC model of the M2M MPPs on the host
+include $(CLEAR_VARS)
+LOCAL_CFLAGS += -DLOG_TAG=\"hwc_ppcfit\"
+LOCAL_SHARED_LIBRARIES := liblog
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../libresource
+LOCAL_SRC_FILES := hwc_ppcfit.cpp ../libresource/ExynosPPCModel.cpp
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := hwc_ppcfit
+include $(BUILD_HOST_EXECUTABLE)
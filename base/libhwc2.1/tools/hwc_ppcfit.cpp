@@ -0,0 +1,531 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "ExynosPPCModel.h"
+
+/*
+ * Calibration and validation of the PPC model of the M2M MPPs.
+ * It replays the layer stacks of G2D and MSC jobs captured by
+ * ExynosMPP::logPPCSample() when eDebugCapacity is enabled. The logcat
+ * output is accepted as it is. Each sample is:
+ *   mpp,laptime_usec,clock_khz,colorfill_pixels,layer_count,<layer>...
+ * and each <layer> is:
+ *   format,afbc|none,rot|norot,src_w,src_h,dst_w,dst_h
+ * The cycles of a job are the laptime multiplied by the clock, and they are
+ * estimated like ExynosMPP::getAssignedCapacity() does: the colorfill pixels
+ * divided by the colorfill PPC plus the larger of the source and the
+ * destination pixels of each layer divided by the PPC of the layer. All layers
+ * of a G2D job use the curves of the rotation if a layer is rotated.
+ *
+ * With -o, the points of the curves at the scale ratios of -s and the
+ * colorfill PPC are fitted to the samples with the linear least squares in
+ * the cycles per pixel. The curves and the points that no sample covers are
+ * not written. The curves of -m that are not fitted are kept.
+ * Without -o, the table file of -m is validated against the samples.
+ * Either way, the estimation errors of the resulting model are reported.
+ * An underestimated job overbooks the MPP and may miss the vsync, and an
+ * overestimated job sends layers to GLES needlessly.
+ *
+ * usage: hwc_ppcfit [-i samples] [-m model.conf] [-o model.conf] [-s scale,...]
+ */
+
+#define SAMPLE_FIELDS 5
+#define LAYER_FIELDS 7
+#define SAMPLE_TAG "ppc sample: "
+/* The error that is regarded as a misestimation */
+#define ERROR_MARGIN 0.1
+
+struct Layer {
+    uint32_t format;
+    bool compressed;
+    uint32_t rot;
+    uint32_t srcResolution;
+    uint32_t dstResolution;
+};
+
+struct Sample {
+    uint32_t mpp;
+    double laptime;
+    double clock;
+    double colorfillPixels;
+    std::vector<Layer> layers;
+
+    /* The cycles measured by the compositor */
+    double getCycles() const { return laptime * clock / 1000; }
+};
+
+static bool parseUInt(const char *token, uint32_t &val)
+{
+    char *end;
+
+    if (token == NULL)
+        return false;
+
+    val = static_cast<uint32_t>(strtoul(token, &end, 0));
+    return (end != token) && (*end == '\0');
+}
+
+static bool parseSample(char *line, Sample &sample)
+{
+    std::vector<char *> fields;
+    char *saveptr = NULL;
+    char *token;
+
+    line[strcspn(line, "\r\n")] = '\0';
+
+    for (token = strtok_r(line, ",", &saveptr); token; token = strtok_r(NULL, ",", &saveptr))
+        fields.push_back(token + strspn(token, " \t"));
+
+    uint32_t mpp, laptime, clock, colorfill, count;
+
+    if ((fields.size() < SAMPLE_FIELDS) ||
+        (ExynosPPCModel::findMPP(fields[0]) < 0) ||
+        !parseUInt(fields[1], laptime) || !parseUInt(fields[2], clock) ||
+        !parseUInt(fields[3], colorfill) || !parseUInt(fields[4], count) ||
+        (fields.size() != SAMPLE_FIELDS + static_cast<size_t>(count) * LAYER_FIELDS) ||
+        (laptime == 0) || (clock == 0) || (count == 0))
+        return false;
+
+    mpp = ExynosPPCModel::findMPP(fields[0]);
+
+    sample.mpp = mpp;
+    sample.laptime = laptime;
+    sample.clock = clock;
+    sample.colorfillPixels = colorfill;
+    sample.layers.clear();
+
+    bool rotated = false;
+
+    for (uint32_t i = 0; i < count; i++) {
+        char **f = &fields[SAMPLE_FIELDS + i * LAYER_FIELDS];
+        uint32_t srcW, srcH, dstW, dstH;
+        Layer layer;
+
+        int32_t format = ExynosPPCModel::findFormat(f[0]);
+        if ((format < 0) ||
+            !parseUInt(f[3], srcW) || !parseUInt(f[4], srcH) ||
+            !parseUInt(f[5], dstW) || !parseUInt(f[6], dstH))
+            return false;
+
+        layer.format = format;
+
+        if (strcmp(f[1], "afbc") == 0)
+            layer.compressed = true;
+        else if (strcmp(f[1], "none") == 0)
+            layer.compressed = false;
+        else
+            return false;
+
+        if (strcmp(f[2], "rot") == 0)
+            layer.rot = PPC_ROT;
+        else if (strcmp(f[2], "norot") == 0)
+            layer.rot = PPC_ROT_NO;
+        else
+            return false;
+
+        layer.srcResolution = srcW * srcH;
+        layer.dstResolution = dstW * dstH;
+        if ((layer.srcResolution == 0) || (layer.dstResolution == 0))
+            return false;
+
+        rotated = rotated || (layer.rot == PPC_ROT);
+        sample.layers.push_back(layer);
+    }
+
+    if ((mpp == ExynosPPCModel::PPC_MPP_G2D) && rotated) {
+        for (auto &layer: sample.layers)
+            layer.rot = PPC_ROT;
+    }
+
+    return true;
+}
+
+static float getScale(const Layer &layer)
+{
+    return static_cast<float>(layer.dstResolution) / layer.srcResolution;
+}
+
+static double getPixels(const Layer &layer)
+{
+    return std::max(layer.srcResolution, layer.dstResolution);
+}
+
+/* Return false if the model does not cover the sample */
+static bool estimateCycles(const ExynosPPCModel &model, const Sample &sample, double &cycles)
+{
+    cycles = 0;
+
+    if (sample.colorfillPixels > 0) {
+        if (model.getColorfillPPC() <= 0)
+            return false;
+        cycles += sample.colorfillPixels / model.getColorfillPPC();
+    }
+
+    for (auto &layer: sample.layers) {
+        float ppc;
+
+        if (!model.getPPC(sample.mpp, layer.format, layer.rot, layer.compressed, getScale(layer), ppc))
+            return false;
+        cycles += getPixels(layer) / ppc;
+    }
+
+    return true;
+}
+
+static void validate(const ExynosPPCModel &model, const std::vector<Sample> &samples)
+{
+    size_t covered = 0, under = 0, over = 0;
+    double sqErr = 0, relErr = 0;
+
+    for (auto &sample: samples) {
+        double cycles;
+
+        if (!estimateCycles(model, sample, cycles))
+            continue;
+
+        double error = cycles - sample.getCycles();
+
+        covered++;
+        sqErr += (error * 1000 / sample.clock) * (error * 1000 / sample.clock);
+        relErr += fabs(error) / sample.getCycles();
+        if (error < -ERROR_MARGIN * sample.getCycles())
+            under++;
+        else if (error > ERROR_MARGIN * sample.getCycles())
+            over++;
+    }
+
+    fprintf(stderr, "%zu of %zu samples are covered by the model\n", covered, samples.size());
+    if (covered == 0)
+        return;
+
+    fprintf(stderr, "RMS error %.1f usec, mean error %.1f%%\n",
+            sqrt(sqErr / covered), 100 * relErr / covered);
+    fprintf(stderr, "underestimated by more than %d%%: %zu (overbooking)\n",
+            static_cast<int>(ERROR_MARGIN * 100), under);
+    fprintf(stderr, "overestimated by more than %d%%: %zu (needless GLES)\n",
+            static_cast<int>(ERROR_MARGIN * 100), over);
+}
+
+/* Solve A x = b with the gaussian elimination with partial pivoting */
+static bool solve(std::vector<std::vector<double>> &a, std::vector<double> &b, std::vector<double> &x)
+{
+    size_t n = b.size();
+
+    for (size_t col = 0; col < n; col++) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < n; row++)
+            if (fabs(a[row][col]) > fabs(a[pivot][col]))
+                pivot = row;
+
+        if (fabs(a[pivot][col]) < 1e-12)
+            return false;
+
+        std::swap(a[col], a[pivot]);
+        std::swap(b[col], b[pivot]);
+
+        for (size_t row = col + 1; row < n; row++) {
+            double ratio = a[row][col] / a[col][col];
+            for (size_t k = col; k < n; k++)
+                a[row][k] -= ratio * a[col][k];
+            b[row] -= ratio * b[col];
+        }
+    }
+
+    x.assign(n, 0.0);
+    for (size_t col = n; col-- > 0; ) {
+        double sum = b[col];
+        for (size_t k = col + 1; k < n; k++)
+            sum -= a[col][k] * x[k];
+        x[col] = sum / a[col][col];
+    }
+
+    return true;
+}
+
+struct CurveKey {
+    uint32_t mpp;
+    uint32_t format;
+    uint32_t rot;
+    bool compressed;
+
+    bool operator<(const CurveKey &other) const
+    {
+        if (mpp != other.mpp)
+            return mpp < other.mpp;
+        if (format != other.format)
+            return format < other.format;
+        if (rot != other.rot)
+            return rot < other.rot;
+        return compressed < other.compressed;
+    }
+};
+
+/* A column of the least squares is the cycles per pixel of a point of a curve */
+typedef std::pair<CurveKey, size_t> Column;
+
+static bool fit(ExynosPPCModel &model, const std::vector<Sample> &samples,
+        const std::vector<ExynosPPCModel::Point> &grid)
+{
+    std::map<Column, size_t> columns;
+    bool hasColorfill = false;
+
+    /* colorfill is the column 0 if any sample has it */
+    for (auto &sample: samples)
+        hasColorfill = hasColorfill || (sample.colorfillPixels > 0);
+
+    std::vector<std::map<size_t, double>> rows;
+
+    for (auto &sample: samples) {
+        std::map<size_t, double> row;
+
+        if (sample.colorfillPixels > 0)
+            row[0] = sample.colorfillPixels;
+
+        for (auto &layer: sample.layers) {
+            CurveKey key = {sample.mpp, layer.format, layer.rot, layer.compressed};
+            size_t lower, upper;
+            float weight;
+
+            ExynosPPCModel::getInterpolation(grid, getScale(layer), lower, upper, weight);
+
+            size_t points[2] = {lower, upper};
+            double weights[2] = {1.0 - weight, weight};
+
+            for (size_t i = 0; i < 2; i++) {
+                if (weights[i] <= 0)
+                    continue;
+
+                Column column(key, points[i]);
+                if (columns.count(column) == 0) {
+                    size_t index = columns.size() + (hasColorfill ? 1 : 0);
+                    columns[column] = index;
+                }
+                row[columns[column]] += getPixels(layer) * weights[i];
+            }
+        }
+
+        rows.push_back(row);
+    }
+
+    size_t n = columns.size() + (hasColorfill ? 1 : 0);
+
+    if (samples.size() < n) {
+        fprintf(stderr, "%zu samples are too few to fit %zu points\n", samples.size(), n);
+        return false;
+    }
+
+    /* The columns are normalized by their largest values for the numerical stability */
+    std::vector<double> scale(n, 0.0);
+
+    for (auto &row: rows)
+        for (auto &x: row)
+            scale[x.first] = std::max(scale[x.first], x.second);
+
+    /* The normal equations, (X^T X) theta = X^T y */
+    std::vector<std::vector<double>> xtx(n, std::vector<double>(n, 0.0));
+    std::vector<double> xty(n, 0.0);
+
+    for (size_t s = 0; s < rows.size(); s++) {
+        for (auto &xi: rows[s]) {
+            for (auto &xj: rows[s])
+                xtx[xi.first][xj.first] += (xi.second / scale[xi.first]) * (xj.second / scale[xj.first]);
+            xty[xi.first] += (xi.second / scale[xi.first]) * samples[s].getCycles();
+        }
+    }
+
+    std::vector<double> theta;
+    if (!solve(xtx, xty, theta)) {
+        fprintf(stderr, "The samples do not distinguish the points. Vary the layers of the samples.\n");
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        theta[i] /= scale[i];
+
+    if (hasColorfill) {
+        if (theta[0] > 0)
+            model.setColorfillPPC(static_cast<float>(1 / theta[0]));
+        else
+            fprintf(stderr, "Ignoring non-positive cycles per pixel of colorfill\n");
+    }
+
+    std::map<CurveKey, std::vector<ExynosPPCModel::Point>> curves;
+
+    for (auto &column: columns) {
+        const CurveKey &key = column.first.first;
+        ExynosPPCModel::Point point = grid[column.first.second];
+        double cyclesPerPixel = theta[column.second];
+
+        if (cyclesPerPixel <= 0) {
+            fprintf(stderr, "Ignoring non-positive cycles per pixel of %s %s %s %s at scale %g\n",
+                    ExynosPPCModel::getMPPName(key.mpp), ExynosPPCModel::getFormatName(key.format),
+                    (key.rot == PPC_ROT) ? "rot" : "norot", key.compressed ? "afbc" : "none",
+                    point.scale);
+            continue;
+        }
+
+        point.ppc = static_cast<float>(1 / cyclesPerPixel);
+        curves[key].push_back(point);
+    }
+
+    for (auto &curve: curves)
+        model.setCurve(curve.first.mpp, curve.first.format, curve.first.rot,
+                curve.first.compressed, curve.second);
+
+    fprintf(stderr, "Fitted %zu points of %zu curves to %zu samples\n",
+            n, curves.size(), samples.size());
+
+    return true;
+}
+
+static bool parseGrid(const char *arg, std::vector<ExynosPPCModel::Point> &grid)
+{
+    std::vector<char> buf(arg, arg + strlen(arg) + 1);
+    char *saveptr = NULL;
+
+    grid.clear();
+    for (char *token = strtok_r(buf.data(), ",", &saveptr); token;
+            token = strtok_r(NULL, ",", &saveptr)) {
+        char *end;
+        ExynosPPCModel::Point point = {strtof(token, &end), 0};
+
+        if ((end == token) || (*end != '\0') || !(point.scale > 0))
+            return false;
+        grid.push_back(point);
+    }
+
+    std::sort(grid.begin(), grid.end(),
+            [](const ExynosPPCModel::Point &a, const ExynosPPCModel::Point &b) {
+                return a.scale < b.scale; });
+
+    return !grid.empty();
+}
+
+int main(int argc, char *argv[])
+{
+    const char *input = NULL;
+    const char *base = NULL;
+    const char *output = NULL;
+    /* finer than the scale buckets of ppc_table_map */
+    const char *scales = "0.0625,0.111,0.25,0.5,1,2,4";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:m:o:s:")) != -1) {
+        switch (opt) {
+        case 'i':
+            input = optarg;
+            break;
+        case 'm':
+            base = optarg;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 's':
+            scales = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-i samples] [-m model.conf] [-o model.conf] [-s scale,...]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<ExynosPPCModel::Point> grid;
+    if (!parseGrid(scales, grid)) {
+        fprintf(stderr, "Invalid scale ratios '%s'\n", scales);
+        return 1;
+    }
+
+    ExynosPPCModel model;
+    if (base && !model.load(base)) {
+        fprintf(stderr, "Failed to load the model '%s'\n", base);
+        return 1;
+    }
+
+    if (!base && !output) {
+        fprintf(stderr, "Nothing to validate. Give the model with -m or fit one with -o.\n");
+        return 1;
+    }
+
+    FILE *in = input ? fopen(input, "r") : stdin;
+    if (!in) {
+        fprintf(stderr, "Failed to open '%s'\n", input);
+        return 1;
+    }
+
+    std::vector<Sample> samples;
+    char line[4096];
+    int lineno = 0;
+
+    while (fgets(line, sizeof(line), in)) {
+        lineno++;
+
+        char *p = strstr(line, SAMPLE_TAG);
+        if (p) {
+            p += strlen(SAMPLE_TAG);
+        } else {
+            p = line + strspn(line, " \t");
+            if ((*p == '#') || (*p == '\n') || (*p == '\0'))
+                continue;
+        }
+
+        Sample sample;
+        if (!parseSample(p, sample)) {
+            fprintf(stderr, "Ignoring malformed sample at line %d\n", lineno);
+            continue;
+        }
+
+        samples.push_back(sample);
+    }
+
+    if (in != stdin)
+        fclose(in);
+
+    if (output) {
+        if (!fit(model, samples, grid))
+            return 1;
+
+        FILE *out = fopen(output, "w");
+        if (!out) {
+            fprintf(stderr, "Failed to open '%s'\n", output);
+            return 1;
+        }
+
+        fprintf(out, "# generated by hwc_ppcfit from %zu samples\n", samples.size());
+        bool saved = model.save(out);
+        fclose(out);
+
+        if (!saved) {
+            fprintf(stderr, "Failed to write '%s'\n", output);
+            return 1;
+        }
+    }
+
+    validate(model, samples);
+
+    return 0;
+}
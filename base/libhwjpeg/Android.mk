@@ -25,7 +25,8 @@ LOCAL_EXPORT_C_INCLUDE_DIRS := $(LOCAL_PATH)/include
 
 LOCAL_SRC_FILES := hwjpeg-base.cpp hwjpeg-v4l2.cpp ExynosJpegEncoder.cpp \
                    LibScalerForJpeg.cpp AppMarkerWriter.cpp ExynosJpegEncoderForCamera.cpp \
-                   libhwjpeg-exynos.cpp ThumbnailScaler.cpp GiantThumbnailScaler.cpp
+                   libhwjpeg-exynos.cpp ThumbnailScaler.cpp GiantThumbnailScaler.cpp \
+                   ThumbnailWorker.cpp
 
 LOCAL_MODULE := libhwjpeg
 LOCAL_MODULE_TAGS := optional
@@ -35,3 +36,5 @@ ifeq ($(BOARD_USES_VENDORIMAGE), true)
 endif
 
 include $(BUILD_SHARED_LIBRARY)
+
+include $(LOCAL_PATH)/test/Android.mk
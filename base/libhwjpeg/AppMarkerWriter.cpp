@@ -75,6 +75,11 @@ void CAppMarkerWriter::Init()
     m_nExifIFDFields = 0;
     m_nGPSIFDFields = 0;
 
+    m_nExifIFDOffset = 0;
+    m_nInteropIFDOffset = 0;
+    m_nGPSIFDOffset = 0;
+    m_n1stIFDOffset = 0;
+
     m_szMake = 0;
     m_szSoftware = 0;
     m_szModel = 0;
@@ -85,6 +90,12 @@ void CAppMarkerWriter::Init()
     m_pThumbSizePlaceholder = NULL;
 }
 
+// Offset from the TIFF header of the position at @applen bytes from the APP1 length field
+static inline uint32_t TiffOffset(size_t applen)
+{
+    return static_cast<uint32_t>(applen - JPEG_SEGMENT_LENFIELD_SIZE - ARRSIZE(ExifIdentifierCode));
+}
+
 void CAppMarkerWriter::PrepareAppWriter(char *base, exif_attribute_t *exif, extra_appinfo_t *extra)
 {
     m_pAppBase = base;
@@ -157,6 +168,7 @@ void CAppMarkerWriter::PrepareAppWriter(char *base, exif_attribute_t *exif, extr
          * SubIFD: 1
          * - Interoperability IFD
          */
+        m_nExifIFDOffset = TiffOffset(applen);
         m_nExifIFDFields = 28; // rational fields and fields withouth data offset
         applen += IFD_FIELDCOUNT_SIZE + IFD_VALOFF_SIZE;
         applen += IFD_FIELD_SIZE * m_nExifIFDFields;
@@ -193,9 +205,11 @@ void CAppMarkerWriter::PrepareAppWriter(char *base, exif_attribute_t *exif, extr
         }
 
         // Interoperability SubIFD
+        // It is placed after all values of Exif sub IFD
         m_nExifIFDFields++; // Interoperability is sub IFD of Exif sub IFD
-        applen += IFD_FIELD_SIZE +
-                  IFD_FIELDCOUNT_SIZE + IFD_VALOFF_SIZE + IFD_FIELD_SIZE * 2;
+        applen += IFD_FIELD_SIZE;
+        m_nInteropIFDOffset = TiffOffset(applen);
+        applen += IFD_FIELDCOUNT_SIZE + IFD_VALOFF_SIZE + IFD_FIELD_SIZE * 2;
 
         if (m_pExif->enableGps) {
             size_t len;
@@ -208,6 +222,7 @@ void CAppMarkerWriter::PrepareAppWriter(char *base, exif_attribute_t *exif, extr
              * ASCII or Undefined fields: 2
              * - PGSProcessingMethod, GPSDateStamp
              */
+            m_nGPSIFDOffset = TiffOffset(applen);
             m_nGPSIFDFields = 8;
             applen += IFD_FIELDCOUNT_SIZE + IFD_VALOFF_SIZE;
             applen += IFD_FIELD_SIZE * m_nGPSIFDFields;
@@ -238,15 +253,25 @@ void CAppMarkerWriter::PrepareAppWriter(char *base, exif_attribute_t *exif, extr
                 return;
             }
 
+            m_n1stIFDOffset = TiffOffset(applen);
             m_n1stIFDFields = 6;
             applen += IFD_FIELDCOUNT_SIZE + IFD_VALOFF_SIZE;
             applen += IFD_FIELD_SIZE * m_n1stIFDFields;
 
-            m_pThumbBase = m_pAppBase + JPEG_MARKER_SIZE + applen;
-            m_szMaxThumbSize = JPEG_MAX_SEGMENT_SIZE - applen - JPEG_APP1_OEM_RESERVED;
+            if ((applen + JPEG_APP1_OEM_RESERVED) < JPEG_MAX_SEGMENT_SIZE) {
+                m_pThumbBase = m_pAppBase + JPEG_MARKER_SIZE + applen;
+                m_szMaxThumbSize = JPEG_MAX_SEGMENT_SIZE - applen - JPEG_APP1_OEM_RESERVED;
+            }
         }
 
-        m_szApp1 = applen;
+        if ((applen > JPEG_MAX_SEGMENT_SIZE) || (m_pExif->enableThumb && !m_pThumbBase)) {
+            // Large maker note or user comment. The stream is left without Exif
+            ALOGE("Too large APP1 segment, %zu bytes", applen);
+            Init();
+            m_pExif = NULL;
+        } else {
+            m_szApp1 = applen;
+        }
     }
 
     if (extra) {
@@ -357,143 +382,135 @@ char *CAppMarkerWriter::WriteAPP1(char *current, bool reserve_thumbnail_space, b
     for (size_t i = 0; i < ARRSIZE(TiffHeader); i++)
         *current++ = TiffHeader[i];
 
+    // All IFDs are written in a single pass at the offsets computed by
+    // PrepareAppWriter(). The fields of an IFD are in ascending order of tags
+    // because the offsets of the sub IFDs are known in advance.
     CIFDWriter writer(tiffheader, current, m_n0thIFDFields);
 
-    writer.WriteShort(EXIF_TAG_ORIENTATION, 1, &m_pExif->orientation);
-    writer.WriteShort(EXIF_TAG_YCBCR_POSITIONING, 1, &m_pExif->ycbcr_positioning);
-    writer.WriteRational(EXIF_TAG_X_RESOLUTION, 1, &m_pExif->x_resolution);
-    writer.WriteRational(EXIF_TAG_Y_RESOLUTION, 1, &m_pExif->y_resolution);
-    writer.WriteShort(EXIF_TAG_RESOLUTION_UNIT, 1, &m_pExif->resolution_unit);
     if (m_szMake > 0)
         writer.WriteASCII(EXIF_TAG_MAKE, m_szMake + 1, m_pExif->maker);
     if (m_szModel > 0)
         writer.WriteASCII(EXIF_TAG_MODEL, m_szModel + 1, m_pExif->model);
+    writer.WriteShort(EXIF_TAG_ORIENTATION, 1, &m_pExif->orientation);
+    writer.WriteRational(EXIF_TAG_X_RESOLUTION, 1, &m_pExif->x_resolution);
+    writer.WriteRational(EXIF_TAG_Y_RESOLUTION, 1, &m_pExif->y_resolution);
+    writer.WriteShort(EXIF_TAG_RESOLUTION_UNIT, 1, &m_pExif->resolution_unit);
     if (m_szSoftware > 0)
         writer.WriteASCII(EXIF_TAG_SOFTWARE, m_szSoftware + 1, m_pExif->software);
     writer.WriteCString(EXIF_TAG_DATE_TIME, EXIF_DATETIME_LENGTH, m_pExif->date_time);
+    writer.WriteShort(EXIF_TAG_YCBCR_POSITIONING, 1, &m_pExif->ycbcr_positioning);
+    writer.WriteSubIFD(EXIF_TAG_EXIF_IFD_POINTER, m_nExifIFDOffset);
+    if (m_pExif->enableGps)
+        writer.WriteSubIFD(EXIF_TAG_GPS_IFD_POINTER, m_nGPSIFDOffset);
 
-    char *pSubIFDBase = writer.BeginSubIFD(EXIF_TAG_EXIF_IFD_POINTER);
-    if (pSubIFDBase) { // This should be always true!!
-        CIFDWriter exifwriter(tiffheader, pSubIFDBase, m_nExifIFDFields);
-        exifwriter.WriteRational(EXIF_TAG_EXPOSURE_TIME, 1, &m_pExif->exposure_time);
-        exifwriter.WriteRational(EXIF_TAG_FNUMBER, 1, &m_pExif->fnumber);
-        exifwriter.WriteShort(EXIF_TAG_EXPOSURE_PROGRAM, 1, &m_pExif->exposure_program);
-        exifwriter.WriteShort(EXIF_TAG_ISO_SPEED_RATING, 1, &m_pExif->iso_speed_rating);
-        exifwriter.WriteUndef(EXIF_TAG_EXIF_VERSION, 4, reinterpret_cast<unsigned char *>(m_pExif->exif_version));
-        exifwriter.WriteCString(EXIF_TAG_DATE_TIME_ORG, EXIF_DATETIME_LENGTH, m_pExif->date_time);
-        exifwriter.WriteCString(EXIF_TAG_DATE_TIME_DIGITIZE, EXIF_DATETIME_LENGTH, m_pExif->date_time);
-        exifwriter.WriteSRational(EXIF_TAG_SHUTTER_SPEED, 1, &m_pExif->shutter_speed);
-        exifwriter.WriteRational(EXIF_TAG_APERTURE, 1, &m_pExif->aperture);
-        exifwriter.WriteSRational(EXIF_TAG_BRIGHTNESS, 1, &m_pExif->brightness);
-        exifwriter.WriteSRational(EXIF_TAG_EXPOSURE_BIAS, 1, &m_pExif->exposure_bias);
-        exifwriter.WriteRational(EXIF_TAG_MAX_APERTURE, 1, &m_pExif->max_aperture);
-        exifwriter.WriteShort(EXIF_TAG_METERING_MODE, 1, &m_pExif->metering_mode);
-        exifwriter.WriteShort(EXIF_TAG_FLASH, 1, &m_pExif->flash);
-        exifwriter.WriteUndef(EXIF_TAG_FLASHPIX_VERSION, 4, reinterpret_cast<const unsigned char *>("0100"));
-        exifwriter.WriteUndef(EXIF_TAG_COMPONENTS_CONFIGURATION, 4, ComponentsConfiguration);
-        exifwriter.WriteRational(EXIF_TAG_FOCAL_LENGTH, 1, &m_pExif->focal_length);
-        exifwriter.WriteCString(EXIF_TAG_SUBSEC_TIME, EXIF_SUBSECTIME_LENGTH, m_pExif->sec_time);
-        exifwriter.WriteCString(EXIF_TAG_SUBSEC_TIME_ORIG, EXIF_SUBSECTIME_LENGTH, m_pExif->sec_time);
-        exifwriter.WriteCString(EXIF_TAG_SUBSEC_TIME_DIG, EXIF_SUBSECTIME_LENGTH, m_pExif->sec_time);
-        if (m_pExif->maker_note_size > 0)
-            exifwriter.WriteUndef(EXIF_TAG_MAKER_NOTE, m_pExif->maker_note_size, m_pExif->maker_note);
-        if (m_pExif->user_comment_size > 0)
-            exifwriter.WriteUndef(EXIF_TAG_USER_COMMENT, m_pExif->user_comment_size, m_pExif->user_comment);
-        exifwriter.WriteShort(EXIF_TAG_COLOR_SPACE, 1, &m_pExif->color_space);
-        exifwriter.WriteLong(EXIF_TAG_PIXEL_X_DIMENSION, 1, &m_pExif->width);
-        exifwriter.WriteLong(EXIF_TAG_PIXEL_Y_DIMENSION, 1, &m_pExif->height);
-        exifwriter.WriteUndef(EXIF_TAG_SCENE_TYPE, sizeof(SceneType), SceneType);
-        exifwriter.WriteShort(EXIF_TAG_CUSTOM_RENDERED, 1, &m_pExif->custom_rendered);
-        exifwriter.WriteShort(EXIF_TAG_EXPOSURE_MODE, 1, &m_pExif->exposure_mode);
-        exifwriter.WriteShort(EXIF_TAG_WHITE_BALANCE, 1, &m_pExif->white_balance);
-        exifwriter.WriteRational(EXIF_TAG_DIGITAL_ZOOM_RATIO, 1, &m_pExif->digital_zoom_ratio);
-        exifwriter.WriteShort(EXIF_TAG_FOCA_LENGTH_IN_35MM_FILM, 1, &m_pExif->focal_length_in_35mm_length);
-        exifwriter.WriteShort(EXIF_TAG_SCENCE_CAPTURE_TYPE, 1, &m_pExif->scene_capture_type);
-        exifwriter.WriteShort(EXIF_TAG_CONTRAST, 1, &m_pExif->contrast);
-        exifwriter.WriteShort(EXIF_TAG_SATURATION, 1, &m_pExif->saturation);
-        exifwriter.WriteShort(EXIF_TAG_SHARPNESS, 1, &m_pExif->sharpness);
-        if (m_szUniqueID > 0)
-            exifwriter.WriteASCII(EXIF_TAG_IMAGE_UNIQUE_ID, m_szUniqueID + 1, m_pExif->unique_id);
-        pSubIFDBase = exifwriter.BeginSubIFD(EXIF_TAG_INTEROPERABILITY);
-        if (pSubIFDBase) {
-            CIFDWriter interopwriter(tiffheader, pSubIFDBase, 2);
-            interopwriter.WriteASCII(EXIF_TAG_INTEROPERABILITY_INDEX, 4,
-                                     m_pExif->interoperability_index ? "THM" : "R98");
-            interopwriter.WriteUndef(EXIF_TAG_INTEROPERABILITY_VERSION, 4,
-                                     reinterpret_cast<const unsigned char *>("0100"));
-            interopwriter.Finish(true);
-            exifwriter.EndSubIFD(interopwriter.GetNextIFDBase());
-        } else {
-            exifwriter.CancelSubIFD();
-        }
-        exifwriter.Finish(true);
-        writer.EndSubIFD(exifwriter.GetNextIFDBase());
-    } else {
-        writer.CancelSubIFD();
-    }
+    // thumbnail and the next IFD pointer is never updated.
+    if (!updating)
+        writer.Finish(m_pExif->enableThumb ? m_n1stIFDOffset : 0);
+
+    CIFDWriter exifwriter(tiffheader, tiffheader + m_nExifIFDOffset, m_nExifIFDFields);
+    exifwriter.WriteRational(EXIF_TAG_EXPOSURE_TIME, 1, &m_pExif->exposure_time);
+    exifwriter.WriteRational(EXIF_TAG_FNUMBER, 1, &m_pExif->fnumber);
+    exifwriter.WriteShort(EXIF_TAG_EXPOSURE_PROGRAM, 1, &m_pExif->exposure_program);
+    exifwriter.WriteShort(EXIF_TAG_ISO_SPEED_RATING, 1, &m_pExif->iso_speed_rating);
+    exifwriter.WriteUndef(EXIF_TAG_EXIF_VERSION, 4, reinterpret_cast<unsigned char *>(m_pExif->exif_version));
+    exifwriter.WriteCString(EXIF_TAG_DATE_TIME_ORG, EXIF_DATETIME_LENGTH, m_pExif->date_time);
+    exifwriter.WriteCString(EXIF_TAG_DATE_TIME_DIGITIZE, EXIF_DATETIME_LENGTH, m_pExif->date_time);
+    exifwriter.WriteUndef(EXIF_TAG_COMPONENTS_CONFIGURATION, 4, ComponentsConfiguration);
+    exifwriter.WriteSRational(EXIF_TAG_SHUTTER_SPEED, 1, &m_pExif->shutter_speed);
+    exifwriter.WriteRational(EXIF_TAG_APERTURE, 1, &m_pExif->aperture);
+    exifwriter.WriteSRational(EXIF_TAG_BRIGHTNESS, 1, &m_pExif->brightness);
+    exifwriter.WriteSRational(EXIF_TAG_EXPOSURE_BIAS, 1, &m_pExif->exposure_bias);
+    exifwriter.WriteRational(EXIF_TAG_MAX_APERTURE, 1, &m_pExif->max_aperture);
+    exifwriter.WriteShort(EXIF_TAG_METERING_MODE, 1, &m_pExif->metering_mode);
+    exifwriter.WriteShort(EXIF_TAG_FLASH, 1, &m_pExif->flash);
+    exifwriter.WriteRational(EXIF_TAG_FOCAL_LENGTH, 1, &m_pExif->focal_length);
+    if (m_pExif->maker_note_size > 0)
+        exifwriter.WriteUndef(EXIF_TAG_MAKER_NOTE, m_pExif->maker_note_size, m_pExif->maker_note);
+    if (m_pExif->user_comment_size > 0)
+        exifwriter.WriteUndef(EXIF_TAG_USER_COMMENT, m_pExif->user_comment_size, m_pExif->user_comment);
+    exifwriter.WriteCString(EXIF_TAG_SUBSEC_TIME, EXIF_SUBSECTIME_LENGTH, m_pExif->sec_time);
+    exifwriter.WriteCString(EXIF_TAG_SUBSEC_TIME_ORIG, EXIF_SUBSECTIME_LENGTH, m_pExif->sec_time);
+    exifwriter.WriteCString(EXIF_TAG_SUBSEC_TIME_DIG, EXIF_SUBSECTIME_LENGTH, m_pExif->sec_time);
+    exifwriter.WriteUndef(EXIF_TAG_FLASHPIX_VERSION, 4, reinterpret_cast<const unsigned char *>("0100"));
+    exifwriter.WriteShort(EXIF_TAG_COLOR_SPACE, 1, &m_pExif->color_space);
+    exifwriter.WriteLong(EXIF_TAG_PIXEL_X_DIMENSION, 1, &m_pExif->width);
+    exifwriter.WriteLong(EXIF_TAG_PIXEL_Y_DIMENSION, 1, &m_pExif->height);
+    exifwriter.WriteSubIFD(EXIF_TAG_INTEROPERABILITY, m_nInteropIFDOffset);
+    exifwriter.WriteUndef(EXIF_TAG_SCENE_TYPE, sizeof(SceneType), SceneType);
+    exifwriter.WriteShort(EXIF_TAG_CUSTOM_RENDERED, 1, &m_pExif->custom_rendered);
+    exifwriter.WriteShort(EXIF_TAG_EXPOSURE_MODE, 1, &m_pExif->exposure_mode);
+    exifwriter.WriteShort(EXIF_TAG_WHITE_BALANCE, 1, &m_pExif->white_balance);
+    exifwriter.WriteRational(EXIF_TAG_DIGITAL_ZOOM_RATIO, 1, &m_pExif->digital_zoom_ratio);
+    exifwriter.WriteShort(EXIF_TAG_FOCA_LENGTH_IN_35MM_FILM, 1, &m_pExif->focal_length_in_35mm_length);
+    exifwriter.WriteShort(EXIF_TAG_SCENCE_CAPTURE_TYPE, 1, &m_pExif->scene_capture_type);
+    exifwriter.WriteShort(EXIF_TAG_CONTRAST, 1, &m_pExif->contrast);
+    exifwriter.WriteShort(EXIF_TAG_SATURATION, 1, &m_pExif->saturation);
+    exifwriter.WriteShort(EXIF_TAG_SHARPNESS, 1, &m_pExif->sharpness);
+    if (m_szUniqueID > 0)
+        exifwriter.WriteASCII(EXIF_TAG_IMAGE_UNIQUE_ID, m_szUniqueID + 1, m_pExif->unique_id);
+    exifwriter.Finish(0);
+
+    ALOG_ASSERT(exifwriter.GetNextIFDBase() == tiffheader + m_nInteropIFDOffset);
+
+    CIFDWriter interopwriter(tiffheader, tiffheader + m_nInteropIFDOffset, 2);
+    interopwriter.WriteASCII(EXIF_TAG_INTEROPERABILITY_INDEX, 4,
+                             m_pExif->interoperability_index ? "THM" : "R98");
+    interopwriter.WriteUndef(EXIF_TAG_INTEROPERABILITY_VERSION, 4,
+                             reinterpret_cast<const unsigned char *>("0100"));
+    interopwriter.Finish(0);
 
     if (m_pExif->enableGps) {
-        pSubIFDBase = writer.BeginSubIFD(EXIF_TAG_GPS_IFD_POINTER);
-        if (pSubIFDBase) { // This should be always true!!
-            CIFDWriter gpswriter(tiffheader, pSubIFDBase, m_nGPSIFDFields);
-            gpswriter.WriteByte(EXIF_TAG_GPS_VERSION_ID, 4, m_pExif->gps_version_id);
-            gpswriter.WriteASCII(EXIF_TAG_GPS_LATITUDE_REF, 2, m_pExif->gps_latitude_ref);
-            gpswriter.WriteRational(EXIF_TAG_GPS_LATITUDE, 3, m_pExif->gps_latitude);
-            gpswriter.WriteASCII(EXIF_TAG_GPS_LONGITUDE_REF, 2, m_pExif->gps_longitude_ref);
-            gpswriter.WriteRational(EXIF_TAG_GPS_LONGITUDE, 3, m_pExif->gps_longitude);
-            gpswriter.WriteByte(EXIF_TAG_GPS_ALTITUDE_REF, 1, &m_pExif->gps_altitude_ref);
-            gpswriter.WriteRational(EXIF_TAG_GPS_ALTITUDE, 1, &m_pExif->gps_altitude);
-            gpswriter.WriteCString(EXIF_TAG_GPS_DATESTAMP, EXIF_GPSDATESTAMP_LENGTH,
-                                   m_pExif->gps_datestamp);
-            gpswriter.WriteRational(EXIF_TAG_GPS_TIMESTAMP, 3, m_pExif->gps_timestamp);
-            size_t len = strlen(m_pExif->gps_processing_method);
-            if (len > 0) {
-                size_t idx;
-                len = min(len, static_cast<size_t>(99UL));
-                unsigned char buf[sizeof(ExifAsciiPrefix) + len + 1];
-                for (idx = 0; idx < sizeof(ExifAsciiPrefix); idx++)
-                    buf[idx] = ExifAsciiPrefix[idx];
-                strncpy(reinterpret_cast<char *>(buf) + idx, m_pExif->gps_processing_method, len + 1);
-                len += idx;
-                buf[len] = '\0';
-                gpswriter.WriteUndef(EXIF_TAG_GPS_PROCESSING_METHOD, len + 1, buf);
-            }
-            gpswriter.Finish(true);
-            writer.EndSubIFD(gpswriter.GetNextIFDBase());
-        } else {
-            writer.CancelSubIFD();
+        CIFDWriter gpswriter(tiffheader, tiffheader + m_nGPSIFDOffset, m_nGPSIFDFields);
+        gpswriter.WriteByte(EXIF_TAG_GPS_VERSION_ID, 4, m_pExif->gps_version_id);
+        gpswriter.WriteASCII(EXIF_TAG_GPS_LATITUDE_REF, 2, m_pExif->gps_latitude_ref);
+        gpswriter.WriteRational(EXIF_TAG_GPS_LATITUDE, 3, m_pExif->gps_latitude);
+        gpswriter.WriteASCII(EXIF_TAG_GPS_LONGITUDE_REF, 2, m_pExif->gps_longitude_ref);
+        gpswriter.WriteRational(EXIF_TAG_GPS_LONGITUDE, 3, m_pExif->gps_longitude);
+        gpswriter.WriteByte(EXIF_TAG_GPS_ALTITUDE_REF, 1, &m_pExif->gps_altitude_ref);
+        gpswriter.WriteRational(EXIF_TAG_GPS_ALTITUDE, 1, &m_pExif->gps_altitude);
+        gpswriter.WriteRational(EXIF_TAG_GPS_TIMESTAMP, 3, m_pExif->gps_timestamp);
+        size_t len = strlen(m_pExif->gps_processing_method);
+        if (len > 0) {
+            size_t idx;
+            len = min(len, static_cast<size_t>(99UL));
+            unsigned char buf[sizeof(ExifAsciiPrefix) + len + 1];
+            for (idx = 0; idx < sizeof(ExifAsciiPrefix); idx++)
+                buf[idx] = ExifAsciiPrefix[idx];
+            strncpy(reinterpret_cast<char *>(buf) + idx, m_pExif->gps_processing_method, len + 1);
+            len += idx;
+            buf[len] = '\0';
+            gpswriter.WriteUndef(EXIF_TAG_GPS_PROCESSING_METHOD, len + 1, buf);
         }
+        gpswriter.WriteCString(EXIF_TAG_GPS_DATESTAMP, EXIF_GPSDATESTAMP_LENGTH,
+                               m_pExif->gps_datestamp);
+        gpswriter.Finish(0);
     }
 
-    // thumbnail and the next IFD pointer is never updated.
     if (updating)
         return NULL;
 
-    if (m_pExif->enableThumb) {
-        writer.Finish(false);
+    char *app1end = tiffheader + TiffOffset(m_szApp1);
 
-        CIFDWriter thumbwriter(tiffheader, writer.GetNextIFDBase(), m_n1stIFDFields);
+    if (m_pExif->enableThumb) {
+        CIFDWriter thumbwriter(tiffheader, tiffheader + m_n1stIFDOffset, m_n1stIFDFields);
         thumbwriter.WriteLong(EXIF_TAG_IMAGE_WIDTH, 1, &m_pExif->widthThumb);
         thumbwriter.WriteLong(EXIF_TAG_IMAGE_HEIGHT, 1, &m_pExif->heightThumb);
         thumbwriter.WriteShort(EXIF_TAG_COMPRESSION_SCHEME, 1, &m_pExif->compression_scheme);
         thumbwriter.WriteShort(EXIF_TAG_ORIENTATION, 1, &m_pExif->orientation);
 
-        ALOG_ASSERT(thumbwriter.GetNextIFDBase() != m_pThumbBase);
+        ALOG_ASSERT(thumbwriter.GetNextIFDBase() == m_pThumbBase);
         uint32_t offset = thumbwriter.Offset(m_pThumbBase);
         thumbwriter.WriteLong(EXIF_TAG_JPEG_INTERCHANGE_FORMAT, 1, &offset);
         offset = 0; // temporarilly 0 byte
         thumbwriter.WriteLong(EXIF_TAG_JPEG_INTERCHANGE_FORMAT_LEN, 1, &offset);
         m_pThumbSizePlaceholder = thumbwriter.GetNextTagAddress() - 4;
-        thumbwriter.Finish(true);
+        thumbwriter.Finish(0);
 
-        size_t thumbspace = reserve_thumbnail_space ? m_szMaxThumbSize + JPEG_APP1_OEM_RESERVED : 0;
-
-        return thumbwriter.GetNextIFDBase() + thumbspace;
+        if (reserve_thumbnail_space)
+            app1end += m_szMaxThumbSize + JPEG_APP1_OEM_RESERVED;
     }
 
-    writer.Finish(true);
-
-    return writer.GetNextIFDBase();
+    return app1end;
 }
 
 void CAppMarkerWriter::Finalize(size_t thumbsize)
@@ -504,16 +521,15 @@ void CAppMarkerWriter::Finalize(size_t thumbsize)
         m_pThumbSizePlaceholder = NULL;
     }
 }
-void CAppMarkerWriter::UpdateApp1Size(size_t amount)
-{
-    if (m_pAppBase) {
-        uint16_t len = m_szApp1 + amount;
-        WriteDataInBig(m_pAppBase + JPEG_MARKER_SIZE, len);
-    }
-}
 
 static const char *dbgerrmsg = "Updating debug data failed";
 
+// char is signed on some architectures
+static inline unsigned char GetByte(char *p)
+{
+    return *reinterpret_cast<unsigned char *>(p);
+}
+
 static inline size_t GetSegLen(char *p)
 {
     size_t len = (*reinterpret_cast<unsigned char *>(p) & 0xFF) << 8;
@@ -572,7 +588,7 @@ bool UpdateDebugData(char *jpeg, size_t jpeglen, extra_appinfo_t *extra) // incl
         return false;
     }
 
-    if ((*jpeg++ != 0xFF) || (*jpeg++ != 0xD8)) {
+    if ((GetByte(jpeg++) != 0xFF) || (GetByte(jpeg++) != 0xD8)) {
         ALOGE("%s: %p is not a valid JPEG stream", dbgerrmsg, jpeg);
         return false;
     }
@@ -580,12 +596,12 @@ bool UpdateDebugData(char *jpeg, size_t jpeglen, extra_appinfo_t *extra) // incl
 
     int idx = 0;
 
-    while ((*jpeg++ == 0xFF) && (validlen > 0) && (jpeglen > validlen)) {
+    while ((GetByte(jpeg++) == 0xFF) && (validlen > 0) && (jpeglen > validlen)) {
         size_t seglen;
-        char marker;
+        unsigned char marker;
         int appid;
 
-        marker = *jpeg++;
+        marker = GetByte(jpeg++);
         jpeglen -= 2;
 
         if ((marker == 0xDA) || (marker == 0xD9)) { // SOS and EOI
@@ -645,12 +661,12 @@ bool UpdateExif(char *jpeg, size_t jpeglen, exif_attribute_t *exif)
         return false;
     }
 
-    if ((*jpeg++ != 0xFF) || (*jpeg++ != 0xD8)) {
+    if ((GetByte(jpeg++) != 0xFF) || (GetByte(jpeg++) != 0xD8)) {
         ALOGE("%s: %p is not a valid JPEG stream", exiferrmsg, jpeg);
         return false;
     }
 
-    if ((*jpeg != 0xFF) || (*(jpeg + 1) != 0xE1)) {
+    if ((GetByte(jpeg) != 0xFF) || (GetByte(jpeg + 1) != 0xE1)) {
         ALOGE("%s: APP1 marker is not found", exiferrmsg);
         return false;
     }
@@ -55,6 +55,11 @@ class CAppMarkerWriter {
     uint16_t m_n1stIFDFields;
     uint16_t m_nExifIFDFields;
     uint16_t m_nGPSIFDFields;
+    // Offsets of IFDs from the TIFF header computed by PrepareAppWriter()
+    uint32_t m_nExifIFDOffset;
+    uint32_t m_nInteropIFDOffset;
+    uint32_t m_nGPSIFDOffset;
+    uint32_t m_n1stIFDOffset;
     exif_attribute_t *m_pExif;
     extra_appinfo_t *m_pExtra;
 
@@ -96,6 +101,12 @@ public:
         return p;
     }
     size_t GetMaxThumbnailSize() { return m_szMaxThumbSize; }
+    // Limits the thumbnail space reserved by Write() to @size bytes.
+    // It should be called between PrepareAppWriter() and Write().
+    void LimitThumbnailSize(size_t size) {
+        if (size < m_szMaxThumbSize)
+            m_szMaxThumbSize = size;
+    }
     size_t GetAPP1ResrevedSize() { return JPEG_APP1_OEM_RESERVED; }
     // CalculateAPPSize() is valid after Write() is successful.
     size_t CalculateAPPSize(size_t thumblen = JPEG_MAX_SEGMENT_SIZE) {
@@ -133,7 +144,5 @@ public:
     }
 
     void Finalize(size_t thumbsize);
-
-    void UpdateApp1Size(size_t amount);
 };
 #endif //__HARDWARE_SAMSUNG_SLSI_EXYNOS_APPMARKER_WRITER_H__
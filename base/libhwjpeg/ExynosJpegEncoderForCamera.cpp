@@ -28,11 +28,34 @@
 #include "hwjpeg-internal.h"
 #include "AppMarkerWriter.h"
 #include "ThumbnailScaler.h"
+#include "ThumbnailWorker.h"
 #include "IFDWriter.h"
 
 // Data length written by H/W without the scan data.
 #define NECESSARY_JPEG_LENGTH   (0x24B + 2 * JPEG_MARKER_SIZE)
 
+// The thumbnail stream takes at most 1/THUMBNAIL_SPACE_RATIO of the stream buffer
+#define THUMBNAIL_SPACE_RATIO   10
+
+// The upper bound of the compressed stream of a thumbnail with the quality factor.
+// The scan data of a natural image hardly exceeds the bits per pixel below.
+// If it does, the thumbnail is compressed again with a lower quality factor.
+static size_t GetThumbnailStreamBound(int width, int height, int quality)
+{
+    size_t bpp;
+
+    if ((quality <= 0) || (quality > 90))
+        bpp = 8;
+    else if (quality > 75)
+        bpp = 5;
+    else if (quality > 50)
+        bpp = 4;
+    else
+        bpp = 3;
+
+    return NECESSARY_JPEG_LENGTH + (static_cast<size_t>(width) * height * bpp) / 8;
+}
+
 static size_t GetImageLength(unsigned int width, unsigned int height, int v4l2Format)
 {
     size_t size = width * height;
@@ -109,11 +132,16 @@ ExynosJpegEncoderForCamera::ExynosJpegEncoderForCamera(bool bBTBComp)
     if (!mThumbnailScaler->available())
         ALOGW("Thumbnail scaler is not available.");
 
+    mThumbnailWorker.reset(new ThumbnailWorker());
+
     ALOGD("ExynosJpegEncoderForCamera Created: %p, ION %d", this, m_fdIONClient);
 }
 
 ExynosJpegEncoderForCamera::~ExynosJpegEncoderForCamera()
 {
+    // The running thumbnail job uses the buffers released below
+    mThumbnailWorker.reset();
+
     delete m_pAppWriter;
     delete m_phwjpeg4thumb;
 
@@ -196,17 +224,21 @@ bool ExynosJpegEncoderForCamera::EnsureFormatIsApplied() {
 
 size_t ExynosJpegEncoderForCamera::RemoveTrailingDummies(char *base, size_t len)
 {
+    unsigned char *stream = reinterpret_cast<unsigned char *>(base);
+
     ALOG_ASSERT(len > 4);
-    ALOG_ASSERT((base[0] == 0xFF) && (base[1] == 0xD8)); // SOI marker
+    ALOG_ASSERT((stream[0] == 0xFF) && (stream[1] == 0xD8)); // SOI marker
 
-    size_t riter = len - 2;
+    // memrchr() skips the bytes other than 0xFF faster than comparing byte by byte
+    size_t riter = len - 1;
+    void *marker;
 
-    while (riter > 0) {
-        if ((base[riter] == 0xFF) && (base[riter + 1] == 0xD9)) { // EOI marker
+    while ((marker = memrchr(stream, 0xFF, riter)) != NULL) {
+        riter = PTR_DIFF(stream, marker);
+        if (stream[riter + 1] == 0xD9) { // EOI marker
             ALOGI_IF(riter < (len - 2), "Found %zu dummies after EOI", len - riter - 2);
             return riter + 2;
         }
-        riter--;
     }
 
     ALOGE("EOI is not found!");
@@ -215,12 +247,22 @@ size_t ExynosJpegEncoderForCamera::RemoveTrailingDummies(char *base, size_t len)
     return 0;
 }
 
-void *ExynosJpegEncoderForCamera::tCompressThumbnail(void *p)
+void ExynosJpegEncoderForCamera::setThumbnailWorkerAffinity(unsigned long cpumask)
 {
-    ExynosJpegEncoderForCamera *encoder = reinterpret_cast<ExynosJpegEncoderForCamera *>(p);
+    mThumbnailWorker->setAffinity(cpumask);
+}
+
+size_t ExynosJpegEncoderForCamera::WaitForThumbnailJob()
+{
+    size_t thumblen = 0;
+
+    if (mThumbnailJob) {
+        if (!mThumbnailWorker->wait(mThumbnailJob, &thumblen))
+            ALOGE("Thumbnail generation is cancelled");
+        mThumbnailJob.reset();
+    }
 
-    size_t thumblen = encoder->CompressThumbnail();
-    return reinterpret_cast<void *>(thumblen);
+    return thumblen;
 }
 
 bool ExynosJpegEncoderForCamera::ProcessExif(char *base, size_t limit,
@@ -267,18 +309,17 @@ bool ExynosJpegEncoderForCamera::ProcessExif(char *base, size_t limit,
 
     bool reserve_thumbspace = true;
 
-    // If the length of the given stream buffer is too small, and thumbnail
-    // compression is also required, the compressed stream data of the main
-    // image is appeneded after the end of the fields if IFD1. The place is
-    // actually reserved for the embedded thumbnail but the main JPEG stream
-    // is written in this case because it is unknown how the compressed data
-    // of the thumbnail image will be.
-    // After the main and the thumbnail image compressions are completed,
-    // the compressed data of the main image is shifted by the length of the
-    // compressed data of the thumbnail image. Then the compressed data of
-    // the thumbnail image is copied to the place for it.
-    if (!exifInfo || !exifInfo->enableThumb || (limit < (JPEG_MAX_SEGMENT_SIZE * 10)))
+    // The space for the thumbnail stream is always reserved after the fields
+    // of IFD1 so that the main JPEG stream is never moved after compression.
+    // The space is limited to the predicted bound of the thumbnail stream and
+    // a portion of the stream buffer not to starve the main image. The unused
+    // space is left as padding in APP1. A thumbnail larger than the space is
+    // compressed again with a lower quality factor.
+    if (!exifInfo || !exifInfo->enableThumb)
         reserve_thumbspace = false;
+    else
+        m_pAppWriter->LimitThumbnailSize(min(limit / THUMBNAIL_SPACE_RATIO,
+                GetThumbnailStreamBound(m_nThumbWidth, m_nThumbHeight, m_nThumbQuality)));
 
     m_pAppWriter->Write(reserve_thumbspace, JPEG_MARKER_SIZE, align,
                         TestState(STATE_HWFC_ENABLED));
@@ -295,12 +336,11 @@ bool ExynosJpegEncoderForCamera::PrepareCompression(bool thumbnail)
     if (!thumbnail)
         return true;
 
+    // The job of the previous failed compression may still use the buffers
+    WaitForThumbnailJob();
+
     if (IsThumbGenerationNeeded()) {
-        if (pthread_create(&m_threadWorker, NULL,
-                tCompressThumbnail, reinterpret_cast<void *>(this)) != 0) {
-            ALOGERR("Failed to create thumbnail generation thread");
-            return false;
-        }
+        mThumbnailJob = mThumbnailWorker->submit([this] { return CompressThumbnail(); });
     } else {
         // allocate temporary thumbnail stream buffer
         // to prevent overflow of the compressed stream
@@ -465,7 +505,6 @@ int ExynosJpegEncoderForCamera::encode(int *size, exif_attribute_t *exifInfo,
 ssize_t ExynosJpegEncoderForCamera::FinishCompression(size_t mainlen, size_t thumblen)
 {
     bool btb = false;
-    size_t max_streamsize = m_nStreamSize;
     char *mainbase = m_pAppWriter->GetMainStreamBase();
     char *thumbbase = m_pAppWriter->GetThumbStreamBase();
 
@@ -479,24 +518,17 @@ ssize_t ExynosJpegEncoderForCamera::FinishCompression(size_t mainlen, size_t thu
 
     if (thumbbase) {
         if (IsThumbGenerationNeeded()) {
-            void *len;
-            int ret = pthread_join(m_threadWorker, &len);
-            if (ret != 0) {
-                ALOGERR("Failed to wait thumbnail thread(%d)", ret);
-                return -1;
-            }
-
-            if (len == NULL)
+            thumblen = WaitForThumbnailJob();
+            if (thumblen == 0)
                 ALOGE("Error occurred during thumbnail creation: no thumbnail is embedded");
-
-            thumblen = reinterpret_cast<size_t>(len);
         } else if (TestState(STATE_NO_BTBCOMP) || !IsBTBCompressionSupported()) {
             thumblen = CompressThumbnailOnly(m_pAppWriter->GetMaxThumbnailSize(), m_nThumbQuality, getColorFormat(), checkInBufType());
         } else {
             btb = true;
         }
 
-        size_t max_thumb = min(m_pAppWriter->GetMaxThumbnailSize(), max_streamsize - m_pAppWriter->CalculateAPPSize(0) - mainlen);
+        // The thumbnail space is reserved in front of the main stream
+        size_t max_thumb = m_pAppWriter->GetMaxThumbnailSize();
 
         if (thumblen > max_thumb) {
             ALOGI("Too large thumbnail (%dx%d) stream size %zu (max: %zu, quality factor %d)",
@@ -504,24 +536,7 @@ ssize_t ExynosJpegEncoderForCamera::FinishCompression(size_t mainlen, size_t thu
             ALOGI("Retrying thumbnail compression with quality factor 50");
             thumblen = CompressThumbnailOnly(max_thumb, 50, getColorFormat(), checkInBufType());
             if (thumblen == 0)
-                return -1;
-        }
-
-        if (!m_pAppWriter->IsThumbSpaceReserved()) {
-            if (PTR_TO_ULONG(m_pStreamBase + max_streamsize) <
-                        PTR_TO_ULONG(mainbase + mainlen + thumblen - JPEG_MARKER_SIZE)) {
-                ALOGE("Too small JPEG buffer length %zu (APP %zu, Main %zu, Thumb %zu)",
-                      max_streamsize, m_pAppWriter->CalculateAPPSize(thumblen), mainlen, thumblen);
-                return -1;
-            }
-
-            // the SOI of the stream of the main image is stored after the APP4 or APP11 segment if they exist.
-            memmove(m_pAppWriter->GetApp1End() + thumblen, m_pAppWriter->GetApp1End(),
-                    mainlen + PTR_DIFF(m_pAppWriter->GetApp1End(), m_pAppWriter->GetMainStreamBase()));
-            m_pAppWriter->UpdateApp1Size(thumblen);
-
-            // m_nAppLength has the value of appwriter.GetExactAPPSize()
-            // Therefore m_nStreamSize should be initialized with thumbnail stream length;
+                ALOGE("Failed to compress thumbnail into %zu bytes: no thumbnail is embedded", max_thumb);
         }
 
         if (thumblen > 0) {
@@ -529,11 +544,9 @@ ssize_t ExynosJpegEncoderForCamera::FinishCompression(size_t mainlen, size_t thu
             m_pAppWriter->Finalize(thumblen);
         }
 
-        if (m_pAppWriter->IsThumbSpaceReserved()) {
-            // clear the possible stale data in the dummy area after the thumbnail stream
-            memset(m_pAppWriter->GetThumbStreamBase() + thumblen, 0,
-                   m_pAppWriter->GetMaxThumbnailSize() - thumblen + m_pAppWriter->GetAPP1ResrevedSize());
-        }
+        // clear the possible stale data in the dummy area after the thumbnail stream
+        memset(m_pAppWriter->GetThumbStreamBase() + thumblen, 0,
+               m_pAppWriter->GetMaxThumbnailSize() - thumblen + m_pAppWriter->GetAPP1ResrevedSize());
     } else {
         thumblen = 0;
     }
@@ -802,7 +815,6 @@ size_t ExynosJpegEncoderForCamera::CompressThumbnailOnly(size_t limit, int quali
         }
     } while (quality >= 20);
 
-    ALOG_ASSERT(false, "It should never reach here");
     ALOGE("Thumbnail compression finally failed");
 
     return 0;
@@ -126,7 +126,7 @@ public:
     }
 
     void WriteByte(uint16_t tag, uint32_t count, const uint8_t value[]) {
-        ALOG_ASSERT(m_nTags == 0);
+        ALOG_ASSERT(m_nTags > 0);
 
         WriteTagTypeCount(tag, EXIF_TYPE_BYTE, count);
 
@@ -143,7 +143,7 @@ public:
     }
 
     void WriteShort(uint16_t tag, uint32_t count, const uint16_t value[]) {
-        ALOG_ASSERT(m_nTags == 0);
+        ALOG_ASSERT(m_nTags > 0);
 
         WriteTagTypeCount(tag, EXIF_TYPE_SHORT, count);
 
@@ -165,14 +165,15 @@ public:
     }
 
     void WriteLong(uint16_t tag, uint32_t count, const uint32_t value[]) {
-        ALOG_ASSERT(m_nTags == 0);
+        ALOG_ASSERT(m_nTags > 0);
 
         WriteTagTypeCount(tag, EXIF_TYPE_LONG, count);
 
         const char *p = reinterpret_cast<const char *>(&value[0]);
         if (count > (IFD_VALOFF_SIZE / sizeof(value[0]))) {
             m_pIFDBase = WriteOffset(m_pIFDBase, m_pValue);
-            *m_pValue++ = *p++;
+            for (uint32_t i = 0; i < count * sizeof(value[0]); i++)
+                *m_pValue++ = *p++;
         } else {
             *m_pIFDBase++ = *p++;
             *m_pIFDBase++ = *p++;
@@ -182,7 +183,7 @@ public:
     }
 
     void WriteASCII(uint16_t tag, uint32_t count, const char *value) {
-        ALOG_ASSERT(m_nTags == 0);
+        ALOG_ASSERT(m_nTags > 0);
 
         WriteTagTypeCount(tag, EXIF_TYPE_ASCII, count);
 
@@ -200,7 +201,7 @@ public:
     }
 
     void WriteCString(uint16_t tag, uint32_t count, const char *string) {
-        ALOG_ASSERT(m_nTags == 0);
+        ALOG_ASSERT(m_nTags > 0);
 
         WriteTagTypeCount(tag, EXIF_TYPE_ASCII, count);
 
@@ -223,7 +224,7 @@ public:
     }
 
     void WriteRational(uint16_t tag, uint32_t count, const rational_t value[]) {
-        ALOG_ASSERT(m_nTags == 0);
+        ALOG_ASSERT(m_nTags > 0);
 
         WriteTagTypeCount(tag, EXIF_TYPE_RATIONAL, count);
         m_pIFDBase = WriteOffset(m_pIFDBase, m_pValue);
@@ -244,7 +245,7 @@ public:
     }
 
     void WriteSRational(uint16_t tag, uint32_t count, const srational_t value[]) {
-        ALOG_ASSERT(m_nTags == 0);
+        ALOG_ASSERT(m_nTags > 0);
 
         WriteTagTypeCount(tag, EXIF_TYPE_SRATIONAL, count);
         m_pIFDBase = WriteOffset(m_pIFDBase, m_pValue);
@@ -255,7 +256,7 @@ public:
     }
 
     void WriteUndef(uint16_t tag, uint32_t count, const unsigned char *value) {
-        ALOG_ASSERT(m_nTags == 0);
+        ALOG_ASSERT(m_nTags > 0);
 
         WriteTagTypeCount(tag, EXIF_TYPE_UNDEFINED, count);
         if (count > IFD_VALOFF_SIZE) {
@@ -269,29 +270,14 @@ public:
         }
     }
 
-    char *BeginSubIFD(uint16_t tag) {
-        ALOG_ASSERT(m_nTags == 0);
-
-        WriteTagTypeCount(tag, EXIF_TYPE_LONG, 1);
-
-        uint32_t offset = Offset(m_pValue);
-        const char *poff = reinterpret_cast<char *>(&offset);
-        *m_pIFDBase++ = *poff++;
-        *m_pIFDBase++ = *poff++;
-        *m_pIFDBase++ = *poff++;
-        *m_pIFDBase++ = *poff++;
-
-        return m_pValue;
-    }
-
-    void EndSubIFD(char *end_of_subIFD) { m_pValue = end_of_subIFD; }
-    void CancelSubIFD() { m_pIFDBase -= IFD_FIELD_SIZE; }
+    // The offset of a sub IFD is computed in advance by the caller
+    void WriteSubIFD(uint16_t tag, uint32_t offset) { WriteLong(tag, 1, &offset); }
 
-    void Finish(bool last) {
-        ALOG_ASSERT(m_nTags > 0);
+    // @next_ifd_offset is 0 if no IFD follows this IFD
+    void Finish(uint32_t next_ifd_offset) {
+        ALOG_ASSERT(m_nTags == 0);
 
-        uint32_t offset = last ? 0 : Offset(m_pValue);
-        const char *pv = reinterpret_cast<char *>(&offset);
+        const char *pv = reinterpret_cast<char *>(&next_ifd_offset);
         *m_pIFDBase++ = *pv++;
         *m_pIFDBase++ = *pv++;
         *m_pIFDBase++ = *pv++;
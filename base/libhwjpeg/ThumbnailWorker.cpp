@@ -0,0 +1,143 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sched.h>
+#include <pthread.h>
+
+#include <log/log.h>
+
+#include "ThumbnailWorker.h"
+
+void ThumbnailWorker::applyAffinity(unsigned long cpumask)
+{
+    cpu_set_t cpuset;
+
+    CPU_ZERO(&cpuset);
+    for (unsigned int cpu = 0; cpu < sizeof(cpumask) * 8; cpu++) {
+        if ((cpumask == 0) || (cpumask & (1UL << cpu)))
+            CPU_SET(cpu, &cpuset);
+    }
+
+    // sched_setaffinity() accepts the CPUs that are not present
+    if (sched_setaffinity(0, sizeof(cpuset), &cpuset) != 0)
+        ALOGE("Failed to set the affinity of the thumbnail worker to %#lx", cpumask);
+}
+
+void ThumbnailWorker::threadLoop()
+{
+    pthread_setname_np(pthread_self(), "hwjpeg_thumb");
+
+    for (;;) {
+        std::shared_ptr<ThumbnailJob> job;
+        unsigned long cpumask = 0;
+        bool cpumaskChanged;
+
+        {
+            std::unique_lock<std::mutex> lock(mLock);
+            mCond.wait(lock, [this] { return mStop || !mQueue.empty(); });
+            if (mStop)
+                return;
+
+            job = mQueue.front();
+            mQueue.pop_front();
+            job->mState = ThumbnailJob::RUNNING;
+
+            cpumaskChanged = mCpuMaskChanged;
+            if (cpumaskChanged) {
+                cpumask = mCpuMask;
+                mCpuMaskChanged = false;
+            }
+        }
+
+        if (cpumaskChanged)
+            applyAffinity(cpumask);
+
+        size_t result = job->mFunc();
+
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            job->mResult = result;
+            job->mState = ThumbnailJob::DONE;
+            // the job may hold the resources of the caller
+            job->mFunc = nullptr;
+        }
+        mCond.notify_all();
+    }
+}
+
+void ThumbnailWorker::setAffinity(unsigned long cpumask)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (mCpuMask != cpumask) {
+        mCpuMask = cpumask;
+        mCpuMaskChanged = true;
+    }
+}
+
+std::shared_ptr<ThumbnailJob> ThumbnailWorker::submit(std::function<size_t()> func)
+{
+    std::shared_ptr<ThumbnailJob> job = std::make_shared<ThumbnailJob>(func);
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        if (!mThread.joinable()) {
+            mStop = false;
+            // The thread of a new worker runs on any CPU until it is bound
+            mCpuMaskChanged = (mCpuMask != 0);
+            mThread = std::thread(&ThumbnailWorker::threadLoop, this);
+        }
+
+        mQueue.push_back(job);
+    }
+    mCond.notify_all();
+
+    return job;
+}
+
+bool ThumbnailWorker::wait(const std::shared_ptr<ThumbnailJob> &job, size_t *result)
+{
+    std::unique_lock<std::mutex> lock(mLock);
+
+    mCond.wait(lock, [&job] {
+        return (job->mState == ThumbnailJob::DONE) || (job->mState == ThumbnailJob::CANCELLED);
+    });
+
+    *result = job->mResult;
+
+    return job->mState == ThumbnailJob::DONE;
+}
+
+void ThumbnailWorker::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        for (auto &job : mQueue) {
+            job->mState = ThumbnailJob::CANCELLED;
+            job->mFunc = nullptr;
+        }
+        mQueue.clear();
+        mStop = true;
+    }
+    mCond.notify_all();
+
+    // The running job completes before the thread exits
+    if (mThread.joinable())
+        mThread.join();
+}
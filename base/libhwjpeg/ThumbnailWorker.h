@@ -0,0 +1,74 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __HARDWARE_EXYNOS_THUMBNAIL_WORKER_H__
+#define __HARDWARE_EXYNOS_THUMBNAIL_WORKER_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class ThumbnailWorker;
+
+// ThumbnailJob - completion of a job queued to ThumbnailWorker
+class ThumbnailJob {
+    friend class ThumbnailWorker;
+
+    enum { QUEUED, RUNNING, DONE, CANCELLED };
+
+    std::function<size_t()> mFunc;
+    int mState;
+    size_t mResult;
+public:
+    ThumbnailJob(std::function<size_t()> func) : mFunc(func), mState(QUEUED), mResult(0) { }
+};
+
+// ThumbnailWorker - a thread that runs the thumbnail jobs of an encoder
+//
+// The thread is created by the first job and lives until the worker is
+// destroyed so that the burst capture does not create a thread per shot.
+// The jobs run in the order of submission.
+class ThumbnailWorker {
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::deque<std::shared_ptr<ThumbnailJob>> mQueue;
+    std::thread mThread;
+    bool mStop;
+    unsigned long mCpuMask;
+    bool mCpuMaskChanged;
+
+    void threadLoop();
+    void applyAffinity(unsigned long cpumask);
+public:
+    ThumbnailWorker() : mStop(false), mCpuMask(0), mCpuMaskChanged(false) { }
+    // Cancels the queued jobs and waits for the running job
+    ~ThumbnailWorker() { cancel(); }
+
+    // Binds the thread to the CPUs of @cpumask. 0 lets it run on any CPU.
+    void setAffinity(unsigned long cpumask);
+    // Queues @func and returns its completion to wait() for
+    std::shared_ptr<ThumbnailJob> submit(std::function<size_t()> func);
+    // Returns false if @job is cancelled before it runs
+    bool wait(const std::shared_ptr<ThumbnailJob> &job, size_t *result);
+    // Cancels the queued jobs, waits for the running job and stops the thread.
+    // The next job creates the thread again.
+    void cancel();
+};
+
+#endif //__HARDWARE_EXYNOS_THUMBNAIL_WORKER_H__
@@ -21,7 +21,7 @@
 #include <exynos-hwjpeg.h>
 #include "hwjpeg-internal.h"
 
-CHWJpegV4L2Compressor::CHWJpegV4L2Compressor(): CHWJpegCompressor("/dev/video12")
+CHWJpegV4L2Compressor::CHWJpegV4L2Compressor(const char *path): CHWJpegCompressor(path)
 {
     memset(&m_v4l2Format, 0, sizeof(m_v4l2Format));
     memset(&m_v4l2SrcBuffer, 0, sizeof(m_v4l2SrcBuffer));
@@ -29,6 +29,7 @@ CHWJpegV4L2Compressor::CHWJpegV4L2Compressor(): CHWJpegCompressor("/dev/video12"
     memset(&m_v4l2SrcPlanes, 0, sizeof(m_v4l2SrcPlanes));
     memset(&m_v4l2DstPlanes, 0, sizeof(m_v4l2DstPlanes));
     memset(&m_v4l2Controls, 0, sizeof(m_v4l2Controls));
+    memset(&m_ulSlotBuffers, 0, sizeof(m_ulSlotBuffers));
 
     m_v4l2Format.type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
     // default image format is initialized by 8x8 RGB24 in order for TryFormat()
@@ -49,10 +50,16 @@ CHWJpegV4L2Compressor::CHWJpegV4L2Compressor(): CHWJpegCompressor("/dev/video12"
 
     m_bEnableHWFC = false;
 
+    m_uiQueueDepth = 1;
+    m_uiNumSlots = 0;
+    m_uiJobsInFlight = 0;
+    m_uiBusySlots = 0;
+    m_uiMappedSlots = 0;
+
     v4l2_capability cap;
     memset(&cap, 0, sizeof(cap));
     if (ioctl(GetDeviceFD(), VIDIOC_QUERYCAP, &cap) < 0) {
-        ALOGERR("Failed to query capability of /dev/video12");
+        ALOGERR("Failed to query capability of %s", path);
     } else if (!!(cap.capabilities & V4L2_CAP_DEVICE_CAPS)) {
         SetDeviceCapabilities(cap.device_caps);
     }
@@ -86,6 +93,9 @@ bool CHWJpegV4L2Compressor::SetChromaSampFactor(
            return false;
     }
 
+    if (!IsControlChangeable(HWJPEG_CTRL_CHROMFACTOR, V4L2_CID_JPEG_CHROMA_SUBSAMPLING, value))
+        return false;
+
     m_v4l2Controls[HWJPEG_CTRL_CHROMFACTOR].id = V4L2_CID_JPEG_CHROMA_SUBSAMPLING;
     m_v4l2Controls[HWJPEG_CTRL_CHROMFACTOR].value = value;
     m_uiControlsToSet |= 1 << HWJPEG_CTRL_CHROMFACTOR;
@@ -107,6 +117,16 @@ bool CHWJpegV4L2Compressor::SetQuality(
         return false;
     }
 
+    if ((quality_factor > 0) &&
+            !IsControlChangeable(HWJPEG_CTRL_QFACTOR, V4L2_CID_JPEG_COMPRESSION_QUALITY,
+                                 static_cast<__s32>(quality_factor)))
+        return false;
+
+    if ((quality_factor2 > 0) &&
+            !IsControlChangeable(HWJPEG_CTRL_QFACTOR2, V4L2_CID_JPEG_SEC_COMP_QUALITY,
+                                 static_cast<__s32>(quality_factor2)))
+        return false;
+
     if (quality_factor > 0) {
         m_v4l2Controls[HWJPEG_CTRL_QFACTOR].id = V4L2_CID_JPEG_COMPRESSION_QUALITY;
         m_v4l2Controls[HWJPEG_CTRL_QFACTOR].value = static_cast<__s32>(quality_factor);
@@ -127,6 +147,12 @@ bool CHWJpegV4L2Compressor::SetQuality(const unsigned char qtable[])
     v4l2_ext_controls ctrls;
     v4l2_ext_control ctrl;
 
+    if (m_uiJobsInFlight > 0) {
+        ALOGE("Quantization tables cannot change while %u compressions are in flight",
+              m_uiJobsInFlight);
+        return false;
+    }
+
     memset(&ctrls, 0, sizeof(ctrls));
     memset(&ctrl, 0, sizeof(ctrl));
 
@@ -350,8 +376,12 @@ bool CHWJpegV4L2Compressor::StopStreaming()
         ClearFlag(HWJPEG_FLAG_STREAMING);
     }
 
+    ALOGW_IF(m_uiJobsInFlight > 0, "%u compressions in flight are cancelled", m_uiJobsInFlight);
+
     // Stream off dequeues all queued buffers
     ClearFlag(HWJPEG_FLAG_QBUF_OUT | HWJPEG_FLAG_QBUF_CAP);
+    m_uiJobsInFlight = 0;
+    m_uiBusySlots = 0;
 
     // It is OK to skip DQBUF because STREAMOFF dequeues all queued buffers
     if (TestFlag(HWJPEG_FLAG_REQBUFS)) {
@@ -364,8 +394,87 @@ bool CHWJpegV4L2Compressor::StopStreaming()
 }
 
 ssize_t CHWJpegV4L2Compressor::Compress(size_t *secondary_stream_size, bool block_mode)
+{
+    if (m_uiJobsInFlight > 0) {
+        ALOGE("Compress() is not allowed while %u compressions are in flight", m_uiJobsInFlight);
+        return -1;
+    }
+
+    if (QueueCompression() < 0)
+        return -1;
+
+    return block_mode ? DQBuf(secondary_stream_size) : 0;
+}
+
+bool CHWJpegV4L2Compressor::SetQueueDepth(unsigned int depth)
+{
+    if ((depth == 0) || (depth > HWJPEG_V4L2_MAX_QUEUE_DEPTH)) {
+        ALOGE("Unsupported queue depth %u (max %u)", depth, HWJPEG_V4L2_MAX_QUEUE_DEPTH);
+        return false;
+    }
+
+    if (depth == m_uiQueueDepth)
+        return true;
+
+    if (m_uiJobsInFlight > 0) {
+        ALOGE("Queue depth cannot change while %u compressions are in flight", m_uiJobsInFlight);
+        return false;
+    }
+
+    // The next compression requests the buffers of the new depth
+    if (!StopStreaming())
+        return false;
+
+    m_uiQueueDepth = depth;
+
+    return true;
+}
+
+void CHWJpegV4L2Compressor::GetBufferIds(unsigned long ids[8])
+{
+    memset(ids, 0, sizeof(ids[0]) * 8);
+
+    for (unsigned int i = 0; i < m_v4l2SrcBuffer.length; i++)
+        ids[i] = (m_v4l2SrcBuffer.memory == V4L2_MEMORY_DMABUF) ?
+                    static_cast<unsigned long>(m_v4l2SrcPlanes[i].m.fd) : m_v4l2SrcPlanes[i].m.userptr;
+
+    for (unsigned int i = 0; i < m_v4l2DstBuffer.length; i++)
+        ids[6 + i] = (m_v4l2DstBuffer.memory == V4L2_MEMORY_DMABUF) ?
+                    static_cast<unsigned long>(m_v4l2DstPlanes[i].m.fd) : m_v4l2DstPlanes[i].m.userptr;
+}
+
+int CHWJpegV4L2Compressor::FindFreeSlot(const unsigned long ids[8])
+{
+    int unmapped = -1;
+    int evictable = -1;
+
+    for (unsigned int i = 0; i < m_uiNumSlots; i++) {
+        if (m_uiBusySlots & (1 << i))
+            continue;
+
+        if (!(m_uiMappedSlots & (1 << i))) {
+            if (unmapped < 0)
+                unmapped = i;
+        } else if (memcmp(m_ulSlotBuffers[i], ids, sizeof(m_ulSlotBuffers[i])) == 0) {
+            return i;
+        } else if (evictable < 0) {
+            evictable = i;
+        }
+    }
+
+    // An unmapped slot keeps the mappings of the other slots for their buffers
+    return (unmapped >= 0) ? unmapped : evictable;
+}
+
+int CHWJpegV4L2Compressor::QueueCompression()
 {
     if (TestFlag(HWJPEG_FLAG_PIX_FMT)) {
+        if (m_uiJobsInFlight > 0) {
+            ALOGE("Image format cannot change while %u compressions are in flight",
+                  m_uiJobsInFlight);
+            return -1;
+        }
+
         if (!StopStreaming() || !SetFormat())
             return -1;
     }
@@ -394,15 +503,46 @@ ssize_t CHWJpegV4L2Compressor::Compress(size_t *secondary_stream_size, bool bloc
         m_v4l2DstBuffer.length = 2;
     }
 
+    if ((m_uiJobsInFlight > 0) &&
+            (!!(GetAuxFlags() & EXYNOS_HWJPEG_AUXOPT_ENABLE_HWFC) != m_bEnableHWFC)) {
+        ALOGE("HWFC cannot change while %u compressions are in flight", m_uiJobsInFlight);
+        return -1;
+    }
+
     if (!!(GetAuxFlags() & EXYNOS_HWJPEG_AUXOPT_SRC_NOCACHECLEAN))
         m_v4l2SrcBuffer.flags |= V4L2_BUF_FLAG_NO_CACHE_CLEAN;
     if (!!(GetAuxFlags() & EXYNOS_HWJPEG_AUXOPT_DST_NOCACHECLEAN))
         m_v4l2DstBuffer.flags |= V4L2_BUF_FLAG_NO_CACHE_CLEAN;
 
-    if (!ReqBufs() || !StreamOn() || !UpdateControls() || !QBuf())
+    if (!ReqBufs(m_uiQueueDepth) || !StreamOn() || !UpdateControls())
         return -1;
 
-    return block_mode ? DQBuf(secondary_stream_size) : 0;
+    unsigned long ids[8];
+    GetBufferIds(ids);
+
+    int slot = FindFreeSlot(ids);
+    if (slot < 0) {
+        ALOGE("No free slot: %u compressions are in flight", m_uiJobsInFlight);
+        return -1;
+    }
+
+    if (!QBuf(slot))
+        return -1;
+
+    memcpy(m_ulSlotBuffers[slot], ids, sizeof(m_ulSlotBuffers[slot]));
+    m_uiMappedSlots |= 1 << slot;
+    m_uiBusySlots |= 1 << slot;
+    m_uiJobsInFlight++;
+
+    return slot;
+}
+
+int CHWJpegV4L2Compressor::DequeueCompression(ssize_t *stream_size, size_t *secondary_stream_size)
+{
+    int index = -1;
+    *stream_size = DQBuf(secondary_stream_size, &index);
+
+    return index;
 }
 
 bool CHWJpegV4L2Compressor::TryFormat()
@@ -440,6 +580,20 @@ bool CHWJpegV4L2Compressor::SetFormat()
     return true;
 }
 
+bool CHWJpegV4L2Compressor::IsControlChangeable(unsigned int index, __u32 id, __s32 value)
+{
+    if (m_uiJobsInFlight == 0)
+        return true;
+
+    if ((m_v4l2Controls[index].id == id) && (m_v4l2Controls[index].value == value))
+        return true;
+
+    // H/W applies the controls to all compressions that it has not started yet
+    ALOGE("Control %#x cannot change to %d while %u compressions are in flight",
+          id, value, m_uiJobsInFlight);
+    return false;
+}
+
 bool CHWJpegV4L2Compressor::UpdateControls()
 {
     bool enable_hwfc = !!(GetAuxFlags() & EXYNOS_HWJPEG_AUXOPT_ENABLE_HWFC);
@@ -501,6 +655,8 @@ bool CHWJpegV4L2Compressor::ReqBufs(unsigned int count)
         return false;
     }
 
+    unsigned int num_slots = reqbufs.count;
+
     memset(&reqbufs, 0, sizeof(reqbufs));
     reqbufs.count = count;
     reqbufs.memory = m_v4l2DstBuffer.memory;
@@ -515,6 +671,12 @@ bool CHWJpegV4L2Compressor::ReqBufs(unsigned int count)
         return false;
     }
 
+    // The driver may allocate less buffers than requested
+    m_uiNumSlots = min(min(num_slots, reqbufs.count), count);
+    ALOGW_IF(m_uiNumSlots < count, "Only %u of %u compressions can be in flight", m_uiNumSlots, count);
+    // REQBUFS releases the buffers and their mappings
+    m_uiMappedSlots = 0;
+
     if (count > 0)
         SetFlag(HWJPEG_FLAG_REQBUFS);
     else
@@ -566,13 +728,16 @@ bool CHWJpegV4L2Compressor::StreamOff()
     return true;
 }
 
-bool CHWJpegV4L2Compressor::QBuf()
+bool CHWJpegV4L2Compressor::QBuf(unsigned int index)
 {
     if (!TestFlag(HWJPEG_FLAG_REQBUFS)) {
         ALOGE("QBuf is not permitted until REQBUFS is performed");
         return false;
     }
 
+    m_v4l2SrcBuffer.index = index;
+    m_v4l2DstBuffer.index = index;
+
     if (ioctl(GetDeviceFD(), VIDIOC_QBUF, &m_v4l2SrcBuffer) < 0) {
         ALOGERR("QBuf of the source buffers is failed (B2B %s)",
                 IsB2BCompression() ? "enabled" : "disabled");
@@ -592,7 +757,7 @@ bool CHWJpegV4L2Compressor::QBuf()
     return true;
 }
 
-ssize_t CHWJpegV4L2Compressor::DQBuf(size_t *secondary_stream_size)
+ssize_t CHWJpegV4L2Compressor::DQBuf(size_t *secondary_stream_size, int *index)
 {
     bool failed = false;
     v4l2_buffer buffer_src, buffer_dst;
@@ -600,6 +765,14 @@ ssize_t CHWJpegV4L2Compressor::DQBuf(size_t *secondary_stream_size)
 
     ALOG_ASSERT(TestFlag(HWJPEG_FLAG_QBUF_OUT) == TestFlag(HWJPEG_FLAG_QBUF_CAP));
 
+    if (index)
+        *index = -1;
+
+    if (m_uiJobsInFlight == 0) {
+        ALOGE("No compression is in flight");
+        return -1;
+    }
+
     memset(&buffer_src, 0, sizeof(buffer_src));
     memset(&buffer_dst, 0, sizeof(buffer_dst));
     memset(&planes_src, 0, sizeof(planes_src));
@@ -625,10 +798,22 @@ ssize_t CHWJpegV4L2Compressor::DQBuf(size_t *secondary_stream_size)
         failed = true;
     }
 
-    ClearFlag(HWJPEG_FLAG_QBUF_OUT | HWJPEG_FLAG_QBUF_CAP);
-
-    if (failed)
+    if (failed) {
+        // No way to know which compression is dequeued. Cancel all of them.
+        StopStreaming();
         return -1;
+    }
+
+    ALOGW_IF(buffer_src.index != buffer_dst.index,
+             "Image buffer %u is dequeued with JPEG stream buffer %u",
+             buffer_src.index, buffer_dst.index);
+
+    if (index)
+        *index = static_cast<int>(buffer_dst.index);
+
+    m_uiBusySlots &= ~(1 << buffer_dst.index);
+    if (--m_uiJobsInFlight == 0)
+        ClearFlag(HWJPEG_FLAG_QBUF_OUT | HWJPEG_FLAG_QBUF_CAP);
 
     if (!!((buffer_src.flags | buffer_dst.flags) & V4L2_BUF_FLAG_ERROR)) {
         ALOGE("Error occurred during compression");
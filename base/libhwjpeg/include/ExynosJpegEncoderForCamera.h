@@ -28,6 +28,8 @@
 
 class CAppMarkerWriter; // defined in libhwjpeg/AppMarkerWriter.h
 class ThumbnailScaler; // defined in libhwjpeg/thumbnail_scaler.h
+class ThumbnailWorker; // defined in libhwjpeg/ThumbnailWorker.h
+class ThumbnailJob; // defined in libhwjpeg/ThumbnailWorker.h
 
 class ExynosJpegEncoderForCamera: public ExynosJpegEncoder {
     enum {
@@ -70,7 +72,9 @@ class ExynosJpegEncoderForCamera: public ExynosJpegEncoder {
 
     CAppMarkerWriter *m_pAppWriter;
 
-    pthread_t m_threadWorker;
+    // generates the thumbnail concurrently with the main image compression
+    std::unique_ptr<ThumbnailWorker> mThumbnailWorker;
+    std::shared_ptr<ThumbnailJob> mThumbnailJob;
 
     extra_appinfo_t m_extraInfo;
     app_info_t m_appInfo[15];
@@ -83,11 +87,11 @@ class ExynosJpegEncoderForCamera: public ExynosJpegEncoder {
     size_t RemoveTrailingDummies(char *base, size_t len);
     ssize_t FinishCompression(size_t mainlen, size_t thumblen);
     bool ProcessExif(char *base, size_t limit, exif_attribute_t *exifInfo, extra_appinfo_t *extra);
-    static void *tCompressThumbnail(void *p);
     bool PrepareCompression(bool thumbnail);
+    size_t WaitForThumbnailJob();
 
     // IsThumbGenerationNeeded - true if thumbnail image needed to be generated from the main image
-    //                           It also implies that a worker thread is generated to generate thumbnail concurrently.
+    //                           It also implies that the thumbnail worker generates thumbnail concurrently.
     inline bool IsThumbGenerationNeeded() { return !TestState(STATE_NO_CREATE_THUMBIMAGE); }
     inline void NoThumbGenerationNeeded() { SetState(STATE_NO_CREATE_THUMBIMAGE); }
     inline void ThumbGenerationNeeded() { ClearState(STATE_NO_CREATE_THUMBIMAGE); }
@@ -111,6 +115,8 @@ public:
     int setThumbnailQuality(int quality);
 
     void setExtScalerNum(int csc_hwscaler_id) { m_iHWScalerID = csc_hwscaler_id; }
+    // Binds the thumbnail worker to the CPUs in @cpumask. 0 lets it run on any CPU.
+    void setThumbnailWorkerAffinity(unsigned long cpumask);
 
     void EnableHWFC() {
         SetState(STATE_HWFC_ENABLED);
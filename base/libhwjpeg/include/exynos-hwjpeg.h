@@ -312,6 +312,47 @@ public:
      * Compress().
      */
     virtual ssize_t WaitForCompression(size_t __unused *secondary_stream_size = NULL) { return GetStreamSize(secondary_stream_size); }
+    /*
+     * SetQueueDepth - Configure the number of compressions that can be in flight
+     * @depth[in] : The number of compressions queued by QueueCompression() before the
+     *              first of them is dequeued by DequeueCompression(). 1 by default.
+     * @return : true if @depth is supported. false, otherwise.
+     *
+     * The queue depth cannot be changed while compressions are in flight.
+     */
+    virtual bool SetQueueDepth(unsigned int depth) { return depth == 1; }
+    /*
+     * QueueCompression - Queue the compression of the configured buffers and return
+     * @return : The identifier of the queued compression that is between 0 and
+     *           the queue depth. Negative value on error.
+     *
+     * The buffers configured by SetImageBuffer(), SetJpegBuffer() and their
+     * secondary variants are owned by H/W until the compression is dequeued.
+     * The next compression can be configured and queued right after this function
+     * returns. Reconfiguring the same buffers for a later compression lets the
+     * driver reuse their mappings. The quality factors, the quantization tables,
+     * the chroma subsampling and HWFC cannot change while compressions are in
+     * flight because H/W applies them to every compression it has not started yet.
+     */
+    virtual int QueueCompression() { return -1; }
+    /*
+     * DequeueCompression - Wait for the earliest queued compression to finish
+     * @stream_size[out]           : The size of the compressed JPEG stream.
+     *                              Negative value if H/W failed the compression.
+     * @secondary_stream_size[out] : The size of secondary JPEG stream
+     * @return : The identifier returned by QueueCompression() of the finished compression.
+     *           Negative value if no compression is identified. Then all compressions
+     *           in flight are cancelled.
+     *
+     * This function blocks until a compression finishes. Poll the file descriptor
+     * returned by GetCompletionFD() for POLLIN to dequeue without blocking.
+     */
+    virtual int DequeueCompression(ssize_t __unused *stream_size, size_t __unused *secondary_stream_size = NULL) { return -1; }
+    /*
+     * GetCompletionFD - Retrieve the file descriptor that is readable if a compression finishes
+     * @return : The file descriptor to poll. Negative value if it is not supported.
+     */
+    virtual int GetCompletionFD() { return -1; }
     /*
      * GetImageBuffers - Retrieve the configured uncompressed image buffer information (dmabuf)
      * @buffers[out]: The file descriptors of the buffers exported by dma-buf
@@ -499,6 +540,9 @@ class CHWJpegM2M1SHOTCompressor: public CHWJpegCompressor {
 
 #define TO_SEC_IMG_SIZE(val)    (((val) >> 16) & 0xFFFF)
 
+// The maximum number of compressions in flight of CHWJpegV4L2Compressor
+#define HWJPEG_V4L2_MAX_QUEUE_DEPTH 4
+
 class CHWJpegV4L2Compressor : public CHWJpegCompressor, private CHWJpegFlagManager {
     enum {
         HWJPEG_CTRL_CHROMFACTOR = 0,
@@ -511,8 +555,8 @@ class CHWJpegV4L2Compressor : public CHWJpegCompressor, private CHWJpegFlagManag
     enum  {
         HWJPEG_FLAG_PIX_FMT     = 0x1, // Set if unapplied image format exists
 
-        HWJPEG_FLAG_QBUF_OUT    = 0x100, // Set if the image buffer is queued
-        HWJPEG_FLAG_QBUF_CAP    = 0x200, // Set if the JPEG stream buffer is queued
+        HWJPEG_FLAG_QBUF_OUT    = 0x100, // Set if an image buffer is queued
+        HWJPEG_FLAG_QBUF_CAP    = 0x200, // Set if a JPEG stream buffer is queued
         HWJPEG_FLAG_REQBUFS     = 0x400,
         HWJPEG_FLAG_STREAMING   = 0x800,
 
@@ -540,6 +584,16 @@ class CHWJpegV4L2Compressor : public CHWJpegCompressor, private CHWJpegFlagManag
 
     bool m_bEnableHWFC;
 
+    // The V4L2 buffer indices are the slots of the compressions in flight.
+    // A slot remembers the buffers of its last compression so that the
+    // compression of the same buffers reuses the slot and its mappings.
+    unsigned int m_uiQueueDepth; // requested by SetQueueDepth()
+    unsigned int m_uiNumSlots; // allocated by REQBUFS
+    unsigned int m_uiJobsInFlight;
+    unsigned int m_uiBusySlots; // bitmask of the slots in flight
+    unsigned int m_uiMappedSlots; // bitmask of the slots with m_ulSlotBuffers
+    unsigned long m_ulSlotBuffers[HWJPEG_V4L2_MAX_QUEUE_DEPTH][8]; // 6 image and 2 stream buffers
+
     bool IsB2BCompression() {
         return (TO_SEC_IMG_SIZE(m_v4l2Format.fmt.pix_mp.width) +
                     TO_SEC_IMG_SIZE(m_v4l2Format.fmt.pix_mp.height)) != 0;
@@ -549,14 +603,18 @@ class CHWJpegV4L2Compressor : public CHWJpegCompressor, private CHWJpegFlagManag
     bool TryFormat();
     bool SetFormat();
     bool UpdateControls();
-    bool ReqBufs(unsigned int count = 1);
+    // false if the control is changed while compressions are in flight
+    bool IsControlChangeable(unsigned int index, __u32 id, __s32 value);
+    bool ReqBufs(unsigned int count);
     bool StreamOn();
     bool StreamOff();
-    bool QBuf();
-    ssize_t DQBuf(size_t *secondary_stream_size);
+    bool QBuf(unsigned int index);
+    ssize_t DQBuf(size_t *secondary_stream_size, int *index = NULL);
     bool StopStreaming();
+    void GetBufferIds(unsigned long ids[8]);
+    int FindFreeSlot(const unsigned long ids[8]);
 public:
-    CHWJpegV4L2Compressor();
+    CHWJpegV4L2Compressor(const char *path = "/dev/video12");
     virtual ~CHWJpegV4L2Compressor();
 
     unsigned int GetHWDelay() { return m_uiHWDelay; }
@@ -585,7 +643,13 @@ public:
     virtual bool GetJpegBuffer(char **buffer, size_t *len_buffer);
     virtual bool GetJpegBuffer(int *buffer, size_t *len_buffer);
     virtual ssize_t WaitForCompression(size_t *secondary_stream_size = NULL);
+    virtual bool SetQueueDepth(unsigned int depth);
+    virtual int QueueCompression();
+    virtual int DequeueCompression(ssize_t *stream_size, size_t *secondary_stream_size = NULL);
+    virtual int GetCompletionFD() { return GetDeviceFD(); }
     virtual void Release();
+
+    unsigned int GetJobsInFlight() { return m_uiJobsInFlight; }
 };
 
 class CHWJpegV4L2Decompressor : public CHWJpegDecompressor, private CHWJpegFlagManager {
@@ -0,0 +1,69 @@
+# Copyright (C) 2015 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+#### Benchmarks and tests of libhwjpeg ####
+
+LOCAL_PATH:= $(call my-dir)
+
+# burst capture of the thumbnail generation on the host
+include $(CLEAR_VARS)
+LOCAL_CFLAGS += -O2 -DLOG_TAG=\"libhwjpeg_thumbbench\"
+LOCAL_LDLIBS := -lpthread
+LOCAL_SHARED_LIBRARIES := liblog
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+LOCAL_SRC_FILES := thumbnail_bench.cpp ../ThumbnailWorker.cpp
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := libhwjpeg_thumbbench
+include $(BUILD_HOST_EXECUTABLE)
+
+# finalization of the JPEG stream of ExynosJpegEncoderForCamera on the host
+include $(CLEAR_VARS)
+LOCAL_CFLAGS += -O2
+LOCAL_SRC_FILES := finalize_bench.cpp
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := libhwjpeg_finalizebench
+include $(BUILD_HOST_EXECUTABLE)
+
+# pipelined compression of CHWJpegV4L2Compressor against a fake V4L2 device
+include $(CLEAR_VARS)
+LOCAL_CFLAGS += -DLOG_TAG=\"libhwjpeg_test\"
+LOCAL_SHARED_LIBRARIES := liblog
+LOCAL_HEADER_LIBRARIES := libsystem_headers
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/.. $(LOCAL_PATH)/../include
+LOCAL_SRC_FILES := hwjpeg_v4l2_test.cpp ../hwjpeg-v4l2.cpp ../hwjpeg-base.cpp
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := libhwjpeg_v4l2_test
+include $(BUILD_HOST_NATIVE_TEST)
+
+# conformance of the APP segments written by CAppMarkerWriter
+include $(CLEAR_VARS)
+LOCAL_CFLAGS += -DLOG_TAG=\"libhwjpeg_test\"
+LOCAL_SHARED_LIBRARIES := liblog
+LOCAL_HEADER_LIBRARIES := libexynos_headers
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/.. $(LOCAL_PATH)/../include
+LOCAL_SRC_FILES := exif_test.cpp ../AppMarkerWriter.cpp
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := libhwjpeg_exif_test
+include $(BUILD_HOST_NATIVE_TEST)
+
+# generation of the APP segments by CAppMarkerWriter on the host
+include $(CLEAR_VARS)
+LOCAL_CFLAGS += -O2 -DLOG_TAG=\"libhwjpeg_exifbench\"
+LOCAL_SHARED_LIBRARIES := liblog
+LOCAL_HEADER_LIBRARIES := libexynos_headers
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/.. $(LOCAL_PATH)/../include
+LOCAL_SRC_FILES := exif_bench.cpp ../AppMarkerWriter.cpp
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := libhwjpeg_exifbench
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,251 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include <unistd.h>
+#include <time.h>
+
+#include "hwjpeg-internal.h"
+#include "AppMarkerWriter.h"
+
+#include "exif_parser.h"
+
+/*
+ * Benchmark of the APP segments generation of libhwjpeg for the combinations
+ * of Exif attributes: GPS, maker note, the thumbnail and the debug segments.
+ * Each shot of a combination runs the following like the camera HAL and
+ * ExynosJpegEncoderForCamera:
+ * - write: PrepareAppWriter(), Write() and Finalize() of CAppMarkerWriter
+ * - update: UpdateExif() on the written stream
+ * - debug: UpdateDebugData() on the written stream
+ * The stream of every combination is checked by ExifParser before measurement.
+ * It reports the time of each step in nanoseconds.
+ *
+ * usage: libhwjpeg_exifbench [-n shots]
+ */
+
+#define STREAM_BUFFER_SIZE (512 * 1024)
+
+struct Combination {
+    const char *name;
+    bool gps;
+    bool thumb;
+    size_t makerNote;
+    int debug;        // number of APP4 and later segments
+    size_t debugSize; // bytes of each debug segment
+};
+
+static const Combination combinations[] = {
+    {"minimal",        false, false,     0, 0,     0},
+    {"gps",            true,  false,     0, 0,     0},
+    {"thumbnail",      false, true,      0, 0,     0},
+    {"makernote-4k",   false, true,   4096, 0,     0},
+    {"makernote-32k",  true,  true,  32768, 0,     0},
+    {"debug-1x4k",     true,  true,   4096, 1,  4096},
+    {"debug-3x60k",    true,  true,   4096, 3, 61440},
+};
+
+struct Shot {
+    exif_attribute_t exif;
+    std::vector<unsigned char> makerNote;
+    std::vector<std::vector<char>> debugData;
+    app_info_t appInfo[EXTRA_APPMARKER_LIMIT];
+    extra_appinfo_t extra;
+};
+
+static uint64_t nowNSec()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static void setupShot(const Combination &c, Shot &shot)
+{
+    exif_attribute_t &exif = shot.exif;
+
+    memset(&exif, 0, sizeof(exif));
+
+    exif.enableGps = c.gps;
+    exif.enableThumb = c.thumb;
+    strncpy(exif.maker, "Exynos", sizeof(exif.maker) - 1);
+    strncpy(exif.model, "HWJPEG Benchmark", sizeof(exif.model) - 1);
+    strncpy(exif.software, "libhwjpeg", sizeof(exif.software) - 1);
+    memcpy(exif.exif_version, "0220", 4);
+    strncpy(exif.date_time, "2026:10:17 09:30:15", sizeof(exif.date_time));
+    strncpy(exif.sec_time, "123", sizeof(exif.sec_time));
+    strncpy(exif.unique_id, "0123456789ABCDEF0123456789ABCDEF", sizeof(exif.unique_id));
+    exif.width = 4000;
+    exif.height = 3000;
+    exif.widthThumb = 512;
+    exif.heightThumb = 384;
+    exif.orientation = 1;
+    exif.compression_scheme = 6;
+    exif.x_resolution = {72, 1};
+    exif.y_resolution = {72, 1};
+    exif.exposure_time = {1, 120};
+
+    shot.makerNote.assign(c.makerNote, 0x5A);
+    exif.maker_note = shot.makerNote.data();
+    exif.maker_note_size = c.makerNote;
+
+    strncpy(exif.gps_latitude_ref, "N", sizeof(exif.gps_latitude_ref));
+    strncpy(exif.gps_longitude_ref, "E", sizeof(exif.gps_longitude_ref));
+    exif.gps_latitude[0] = {37, 1};
+    exif.gps_longitude[0] = {126, 1};
+    strncpy(exif.gps_datestamp, "2026:10:17", sizeof(exif.gps_datestamp));
+    strncpy(exif.gps_processing_method, "NETWORK", sizeof(exif.gps_processing_method) - 1);
+
+    memset(shot.appInfo, 0, sizeof(shot.appInfo));
+    shot.extra.num_of_appmarker = c.debug;
+    shot.extra.appInfo = shot.appInfo;
+    shot.debugData.clear();
+    for (int i = 0; i < c.debug; i++) {
+        shot.debugData.emplace_back(c.debugSize, static_cast<char>('A' + i));
+        shot.appInfo[i].appid = 4 + i;
+        shot.appInfo[i].appData = shot.debugData.back().data();
+        shot.appInfo[i].dataSize = c.debugSize;
+    }
+}
+
+// returns the length of the stream with the main stream of SOI and EOI
+static size_t writeApp(CAppMarkerWriter &writer, Shot &shot, char *base)
+{
+    base[0] = static_cast<char>(0xFF);
+    base[1] = static_cast<char>(0xD8);
+
+    writer.PrepareAppWriter(base + JPEG_MARKER_SIZE, &shot.exif,
+                            shot.extra.num_of_appmarker ? &shot.extra : NULL);
+    writer.Write(shot.exif.enableThumb, JPEG_MARKER_SIZE, 16);
+
+    char *thumb = writer.GetThumbStreamBase();
+    if (thumb) {
+        thumb[0] = static_cast<char>(0xFF);
+        thumb[1] = static_cast<char>(0xD8);
+        writer.Finalize(2);
+    }
+
+    char *main = writer.GetMainStreamBase();
+    main[0] = static_cast<char>(0xFF);
+    main[1] = static_cast<char>(0xD8);
+    main[2] = static_cast<char>(0xFF);
+    main[3] = static_cast<char>(0xD9);
+
+    return PTR_DIFF(base, main) + 4;
+}
+
+struct Stats {
+    std::vector<uint64_t> samples;
+
+    void print(const char *name) {
+        std::sort(samples.begin(), samples.end());
+
+        double mean = 0.0;
+        for (auto s : samples)
+            mean += s;
+        mean /= samples.size();
+
+        printf("  %-8s mean %9.1f  p50 %7llu  p99 %7llu  max %7llu\n", name, mean,
+               static_cast<unsigned long long>(samples[samples.size() / 2]),
+               static_cast<unsigned long long>(samples[(samples.size() * 99) / 100]),
+               static_cast<unsigned long long>(samples.back()));
+    }
+};
+
+static bool runBench(const Combination &c, unsigned int shots)
+{
+    std::vector<char> buffer(STREAM_BUFFER_SIZE);
+    CAppMarkerWriter writer;
+    Shot shot;
+    Stats write, update, debug;
+
+    setupShot(c, shot);
+
+    size_t len = writeApp(writer, shot, buffer.data());
+
+    ExifParser parser;
+    if (!parser.parse(reinterpret_cast<unsigned char *>(buffer.data()), len)) {
+        fprintf(stderr, "%s: invalid stream: %s\n", c.name, parser.error().c_str());
+        return false;
+    }
+
+    for (unsigned int i = 0; i < shots; i++) {
+        uint64_t begin = nowNSec();
+        writeApp(writer, shot, buffer.data());
+        write.samples.push_back(nowNSec() - begin);
+
+        begin = nowNSec();
+        if (!UpdateExif(buffer.data(), len, &shot.exif)) {
+            fprintf(stderr, "%s: UpdateExif() failed\n", c.name);
+            return false;
+        }
+        update.samples.push_back(nowNSec() - begin);
+
+        if (c.debug > 0) {
+            begin = nowNSec();
+            if (!UpdateDebugData(buffer.data(), len, &shot.extra)) {
+                fprintf(stderr, "%s: UpdateDebugData() failed\n", c.name);
+                return false;
+            }
+            debug.samples.push_back(nowNSec() - begin);
+        }
+    }
+
+    printf("%s: %zu bytes of APP segments\n", c.name, len - 4);
+    write.print("write");
+    update.print("update");
+    if (c.debug > 0)
+        debug.print("debug");
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int shots = 2000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            shots = static_cast<unsigned int>(atoi(optarg));
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n shots]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (shots == 0) {
+        fprintf(stderr, "Invalid configuration\n");
+        return 1;
+    }
+
+    printf("Generating APP segments of %u shots (nsec)\n", shots);
+
+    bool success = true;
+    for (auto &c : combinations)
+        success = runBench(c, shots) && success;
+
+    return success ? 0 : 1;
+}
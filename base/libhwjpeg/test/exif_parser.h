@@ -0,0 +1,328 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HARDWARE_SAMSUNG_SLSI_EXYNOS_TEST_EXIF_PARSER_H__
+#define __HARDWARE_SAMSUNG_SLSI_EXYNOS_TEST_EXIF_PARSER_H__
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+/*
+ * Parser of the APP segments and the IFDs of Exif to check the output of
+ * CAppMarkerWriter. It shares no code and no definition with the writer.
+ * parse() walks the segments from SOI to SOS or EOI and follows 0th IFD, Exif,
+ * GPS and Interoperability sub IFDs and 1st IFD in APP1. It fails if any of the
+ * following is violated:
+ * - every segment and every IFD, value and the thumbnail stream are in bounds
+ * - no IFD, value or thumbnail stream overlaps with another
+ * - the fields of an IFD are in ascending order of tags
+ * - the types are known and the ASCII values are terminated by NUL
+ * - the pointers to the sub IFDs are LONG and only 0th IFD links to 1st IFD
+ * - the thumbnail stream starts with SOI
+ */
+class ExifParser {
+public:
+    struct Segment {
+        unsigned char marker;
+        size_t offset; // offset of the marker from SOI
+        size_t length; // the value of the length field
+    };
+
+    struct Field {
+        uint16_t tag;
+        uint16_t type;
+        uint32_t count;
+        uint32_t offset; // offset of the value from the TIFF header
+    };
+
+    struct IFD {
+        bool present;
+        uint32_t offset;
+        uint32_t next;
+        std::vector<Field> fields;
+
+        IFD() : present(false), offset(0), next(0) { }
+        const Field *find(uint16_t tag) const {
+            for (auto &field : fields) {
+                if (field.tag == tag)
+                    return &field;
+            }
+            return NULL;
+        }
+    };
+
+    enum {
+        TYPE_BYTE = 1, TYPE_ASCII = 2, TYPE_SHORT = 3, TYPE_LONG = 4,
+        TYPE_RATIONAL = 5, TYPE_UNDEFINED = 7, TYPE_SLONG = 9, TYPE_SRATIONAL = 10,
+    };
+
+    enum {
+        TAG_EXIF_IFD = 0x8769,
+        TAG_GPS_IFD = 0x8825,
+        TAG_INTEROP_IFD = 0xA005,
+        TAG_THUMBNAIL_OFFSET = 0x0201,
+        TAG_THUMBNAIL_LENGTH = 0x0202,
+    };
+
+    std::vector<Segment> segments;
+    IFD ifd0, exif, gps, interop, ifd1;
+    const unsigned char *thumbnail;
+    uint32_t thumbnailLength;
+
+    ExifParser() : thumbnail(NULL), thumbnailLength(0), mTiff(NULL), mTiffLength(0), mLittle(true) { }
+
+    const std::string &error() const { return mError; }
+
+    bool parse(const unsigned char *jpeg, size_t len) {
+        if ((len < 4) || (jpeg[0] != 0xFF) || (jpeg[1] != 0xD8))
+            return fail("No SOI");
+
+        size_t pos = 2;
+        while (true) {
+            if (pos + 2 > len)
+                return fail("Truncated marker at %zu", pos);
+            if (jpeg[pos] != 0xFF)
+                return fail("No marker at %zu", pos);
+
+            unsigned char marker = jpeg[pos + 1];
+            if ((marker == 0xD9) || (marker == 0xDA))
+                break;
+
+            if (pos + 4 > len)
+                return fail("Truncated length of marker 0x%02X at %zu", marker, pos);
+
+            Segment seg = {marker, pos, static_cast<size_t>((jpeg[pos + 2] << 8) | jpeg[pos + 3])};
+            if ((seg.length < 2) || (pos + 2 + seg.length > len))
+                return fail("Invalid length %zu of marker 0x%02X at %zu", seg.length, marker, pos);
+
+            segments.push_back(seg);
+
+            if ((marker == 0xE1) && (seg.length >= 8) && (memcmp(jpeg + pos + 4, "Exif\0\0", 6) == 0)) {
+                if (mTiff)
+                    return fail("Multiple Exif segments");
+                if (!parseTiff(jpeg + pos + 10, seg.length - 8))
+                    return false;
+            }
+
+            pos += 2 + seg.length;
+        }
+
+        return true;
+    }
+
+    uint32_t getLong(const Field &field, uint32_t idx = 0) const {
+        if (field.type == TYPE_SHORT)
+            return read16(mTiff + field.offset + idx * 2);
+        return read32(mTiff + field.offset + idx * 4);
+    }
+
+    uint16_t getShort(const Field &field, uint32_t idx = 0) const {
+        return read16(mTiff + field.offset + idx * 2);
+    }
+
+    // numerator and denominator of a RATIONAL or SRATIONAL
+    void getRational(const Field &field, uint32_t idx, uint32_t &num, uint32_t &den) const {
+        num = read32(mTiff + field.offset + idx * 8);
+        den = read32(mTiff + field.offset + idx * 8 + 4);
+    }
+
+    std::string getString(const Field &field) const {
+        return std::string(reinterpret_cast<const char *>(mTiff + field.offset));
+    }
+
+    const unsigned char *getData(const Field &field) const { return mTiff + field.offset; }
+
+private:
+    struct Range {
+        uint32_t begin;
+        uint32_t end;
+        const char *what;
+    };
+
+    const unsigned char *mTiff;
+    uint32_t mTiffLength;
+    bool mLittle;
+    std::vector<Range> mRanges;
+    std::string mError;
+
+    bool fail(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[256];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        mError = buf;
+        return false;
+    }
+
+    uint16_t read16(const unsigned char *p) const {
+        return mLittle ? (p[0] | (p[1] << 8)) : ((p[0] << 8) | p[1]);
+    }
+
+    uint32_t read32(const unsigned char *p) const {
+        if (mLittle)
+            return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+        return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    }
+
+    static uint32_t typeSize(uint16_t type) {
+        switch (type) {
+        case TYPE_BYTE: case TYPE_ASCII: case TYPE_UNDEFINED:
+            return 1;
+        case TYPE_SHORT:
+            return 2;
+        case TYPE_LONG: case TYPE_SLONG:
+            return 4;
+        case TYPE_RATIONAL: case TYPE_SRATIONAL:
+            return 8;
+        }
+        return 0;
+    }
+
+    bool addRange(uint32_t offset, uint64_t size, const char *what) {
+        if ((offset + size) > mTiffLength)
+            return fail("%s at %u (%llu bytes) exceeds APP1 of %u bytes", what, offset,
+                        static_cast<unsigned long long>(size), mTiffLength);
+        mRanges.push_back({offset, static_cast<uint32_t>(offset + size), what});
+        return true;
+    }
+
+    bool parseIFD(uint32_t offset, IFD &ifd, const char *name) {
+        if (ifd.present)
+            return fail("%s is linked twice", name);
+        if ((offset < 8) || (offset + 2 > mTiffLength))
+            return fail("Invalid offset %u of %s", offset, name);
+
+        uint16_t count = read16(mTiff + offset);
+        if (count == 0)
+            return fail("No field in %s", name);
+        if (!addRange(offset, 2 + count * 12 + 4, name))
+            return false;
+
+        ifd.present = true;
+        ifd.offset = offset;
+
+        const unsigned char *p = mTiff + offset + 2;
+        for (uint16_t i = 0; i < count; i++, p += 12) {
+            Field field = {read16(p), read16(p + 2), read32(p + 4), 0};
+
+            if (!ifd.fields.empty() && (ifd.fields.back().tag >= field.tag))
+                return fail("Tag 0x%04X after 0x%04X in %s", field.tag, ifd.fields.back().tag, name);
+
+            uint32_t size = typeSize(field.type);
+            if (size == 0)
+                return fail("Unknown type %u of tag 0x%04X in %s", field.type, field.tag, name);
+            if (field.count == 0)
+                return fail("No value of tag 0x%04X in %s", field.tag, name);
+
+            uint64_t total = static_cast<uint64_t>(size) * field.count;
+            if (total > 4) {
+                field.offset = read32(p + 8);
+                if (!addRange(field.offset, total, name))
+                    return false;
+            } else {
+                field.offset = static_cast<uint32_t>(p + 8 - mTiff);
+            }
+
+            if ((field.type == TYPE_ASCII) && (mTiff[field.offset + field.count - 1] != '\0'))
+                return fail("ASCII of tag 0x%04X in %s is not terminated", field.tag, name);
+
+            ifd.fields.push_back(field);
+        }
+
+        ifd.next = read32(p);
+
+        return true;
+    }
+
+    bool parseSubIFD(IFD &parent, uint16_t tag, IFD &ifd, const char *name) {
+        const Field *field = parent.find(tag);
+        if (!field)
+            return true;
+        if ((field->type != TYPE_LONG) || (field->count != 1))
+            return fail("Invalid pointer to %s", name);
+        if (!parseIFD(getLong(*field), ifd, name))
+            return false;
+        if (ifd.next != 0)
+            return fail("%s is followed by an IFD at %u", name, ifd.next);
+        return true;
+    }
+
+    bool parseTiff(const unsigned char *tiff, size_t len) {
+        mTiff = tiff;
+        mTiffLength = static_cast<uint32_t>(len);
+
+        if (len < 8)
+            return fail("Too small TIFF header");
+        if ((tiff[0] == 'I') && (tiff[1] == 'I'))
+            mLittle = true;
+        else if ((tiff[0] == 'M') && (tiff[1] == 'M'))
+            mLittle = false;
+        else
+            return fail("Invalid byte order 0x%02X%02X", tiff[0], tiff[1]);
+        if (read16(tiff + 2) != 42)
+            return fail("Invalid TIFF identifier %u", read16(tiff + 2));
+
+        if (!parseIFD(read32(tiff + 4), ifd0, "0th IFD") ||
+                !parseSubIFD(ifd0, TAG_EXIF_IFD, exif, "Exif IFD") ||
+                !parseSubIFD(ifd0, TAG_GPS_IFD, gps, "GPS IFD"))
+            return false;
+
+        if (exif.present && !parseSubIFD(exif, TAG_INTEROP_IFD, interop, "Interoperability IFD"))
+            return false;
+
+        if (ifd0.next != 0) {
+            if (!parseIFD(ifd0.next, ifd1, "1st IFD"))
+                return false;
+            if (ifd1.next != 0)
+                return fail("1st IFD is followed by an IFD at %u", ifd1.next);
+
+            const Field *offset = ifd1.find(TAG_THUMBNAIL_OFFSET);
+            const Field *length = ifd1.find(TAG_THUMBNAIL_LENGTH);
+            if (!offset != !length)
+                return fail("Incomplete thumbnail location");
+            if (offset) {
+                thumbnailLength = getLong(*length);
+                if (thumbnailLength > 0) {
+                    if (!addRange(getLong(*offset), thumbnailLength, "thumbnail"))
+                        return false;
+                    thumbnail = tiff + getLong(*offset);
+                    if ((thumbnailLength < 2) || (thumbnail[0] != 0xFF) || (thumbnail[1] != 0xD8))
+                        return fail("No SOI in the thumbnail");
+                }
+            }
+        }
+
+        std::sort(mRanges.begin(), mRanges.end(),
+                  [] (const Range &a, const Range &b) { return a.begin < b.begin; });
+        for (size_t i = 1; i < mRanges.size(); i++) {
+            if (mRanges[i].begin < mRanges[i - 1].end)
+                return fail("%s at %u overlaps with %s at [%u, %u)", mRanges[i].what,
+                            mRanges[i].begin, mRanges[i - 1].what, mRanges[i - 1].begin,
+                            mRanges[i - 1].end);
+        }
+
+        return true;
+    }
+};
+
+#endif // __HARDWARE_SAMSUNG_SLSI_EXYNOS_TEST_EXIF_PARSER_H__
@@ -0,0 +1,395 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "hwjpeg-internal.h"
+#include "AppMarkerWriter.h"
+
+#include "exif_parser.h"
+
+/*
+ * Conformance of the APP segments written by CAppMarkerWriter, UpdateExif()
+ * and UpdateDebugData(). The output is checked by ExifParser and the values
+ * are compared with the attributes given to the writer.
+ */
+
+#define STREAM_BUFFER_SIZE (512 * 1024)
+#define MAIN_STREAM_DUMMY JPEG_MARKER_SIZE
+
+// Tags are defined here not to depend on the definitions used by the writer
+#define TAG_MAKE 0x010F
+#define TAG_MODEL 0x0110
+#define TAG_ORIENTATION 0x0112
+#define TAG_SOFTWARE 0x0131
+#define TAG_DATE_TIME 0x0132
+#define TAG_IMAGE_WIDTH 0x0100
+#define TAG_IMAGE_HEIGHT 0x0101
+#define TAG_EXPOSURE_TIME 0x829A
+#define TAG_EXIF_VERSION 0x9000
+#define TAG_MAKER_NOTE 0x927C
+#define TAG_USER_COMMENT 0x9286
+#define TAG_PIXEL_X_DIMENSION 0xA002
+#define TAG_PIXEL_Y_DIMENSION 0xA003
+#define TAG_IMAGE_UNIQUE_ID 0xA420
+#define TAG_INTEROP_INDEX 0x0001
+#define TAG_GPS_LATITUDE_REF 0x0001
+#define TAG_GPS_LATITUDE 0x0002
+#define TAG_GPS_PROCESSING_METHOD 0x001B
+#define TAG_GPS_DATESTAMP 0x001D
+
+struct Attributes {
+    exif_attribute_t exif;
+    std::vector<unsigned char> makerNote;
+    std::vector<unsigned char> userComment;
+    std::vector<std::vector<char>> debugData;
+    app_info_t appInfo[EXTRA_APPMARKER_LIMIT];
+    extra_appinfo_t extra;
+
+    // @debug: number of APP4 to APP9 segments of @debugSize bytes
+    Attributes(bool gps, bool thumb, size_t makerNoteSize, size_t userCommentSize,
+               int debug = 0, size_t debugSize = 0) {
+        memset(&exif, 0, sizeof(exif));
+
+        exif.enableGps = gps;
+        exif.enableThumb = thumb;
+        strncpy(exif.maker, "Exynos", sizeof(exif.maker) - 1);
+        strncpy(exif.model, "HWJPEG Conformance", sizeof(exif.model) - 1);
+        strncpy(exif.software, "libhwjpeg", sizeof(exif.software) - 1);
+        memcpy(exif.exif_version, "0220", 4);
+        strncpy(exif.date_time, "2026:10:17 09:30:15", sizeof(exif.date_time));
+        strncpy(exif.sec_time, "123", sizeof(exif.sec_time));
+        strncpy(exif.unique_id, "0123456789ABCDEF0123456789ABCDEF", sizeof(exif.unique_id));
+
+        exif.width = 4000;
+        exif.height = 3000;
+        exif.widthThumb = 512;
+        exif.heightThumb = 384;
+        exif.orientation = 6;
+        exif.ycbcr_positioning = 1;
+        exif.iso_speed_rating = 100;
+        exif.compression_scheme = 6;
+        exif.resolution_unit = 2;
+        exif.x_resolution = {72, 1};
+        exif.y_resolution = {72, 1};
+        exif.exposure_time = {1, 120};
+        exif.fnumber = {18, 10};
+        exif.shutter_speed = {69, 10};
+        exif.exposure_bias = {-1, 3};
+
+        for (size_t i = 0; i < makerNoteSize; i++)
+            makerNote.push_back(static_cast<unsigned char>(i * 7 + 1));
+        exif.maker_note = makerNote.data();
+        exif.maker_note_size = makerNoteSize;
+
+        for (size_t i = 0; i < userCommentSize; i++)
+            userComment.push_back(static_cast<unsigned char>(i * 3 + 5));
+        exif.user_comment = userComment.data();
+        exif.user_comment_size = userCommentSize;
+
+        memcpy(exif.gps_version_id, "\x02\x02\x00\x00", 4);
+        strncpy(exif.gps_latitude_ref, "N", sizeof(exif.gps_latitude_ref));
+        strncpy(exif.gps_longitude_ref, "E", sizeof(exif.gps_longitude_ref));
+        exif.gps_latitude[0] = {37, 1};
+        exif.gps_latitude[1] = {33, 1};
+        exif.gps_latitude[2] = {5, 100};
+        exif.gps_longitude[0] = {126, 1};
+        exif.gps_longitude[1] = {58, 1};
+        exif.gps_longitude[2] = {40, 100};
+        exif.gps_altitude = {38, 1};
+        strncpy(exif.gps_datestamp, "2026:10:17", sizeof(exif.gps_datestamp));
+        strncpy(exif.gps_processing_method, "GPS", sizeof(exif.gps_processing_method) - 1);
+
+        memset(appInfo, 0, sizeof(appInfo));
+        extra.num_of_appmarker = debug;
+        extra.appInfo = appInfo;
+        for (int i = 0; i < debug; i++) {
+            debugData.emplace_back(debugSize, static_cast<char>('A' + i));
+            appInfo[i].appid = 4 + i;
+            appInfo[i].appData = debugData.back().data();
+            appInfo[i].dataSize = debugSize;
+        }
+    }
+};
+
+/*
+ * Writes the APP segments to @buffer like ExynosJpegEncoderForCamera and
+ * a main stream of SOI and EOI after them. The thumbnail of @thumblen bytes is
+ * embedded in the reserved space if the thumbnail is enabled. It returns the
+ * length of the stream.
+ */
+static size_t WriteStream(std::vector<unsigned char> &buffer, Attributes &attr,
+                          size_t thumblen, bool reserve_debug = false)
+{
+    char *base = reinterpret_cast<char *>(buffer.data());
+    CAppMarkerWriter writer;
+
+    base[0] = static_cast<char>(0xFF);
+    base[1] = static_cast<char>(0xD8);
+
+    writer.PrepareAppWriter(base + JPEG_MARKER_SIZE, &attr.exif,
+                            attr.extra.num_of_appmarker ? &attr.extra : NULL);
+    writer.Write(attr.exif.enableThumb, MAIN_STREAM_DUMMY, 16, reserve_debug);
+
+    char *thumb = writer.GetThumbStreamBase();
+    if (thumb) {
+        thumblen = min(thumblen, writer.GetMaxThumbnailSize());
+        memset(thumb, 0x5A, thumblen);
+        thumb[0] = static_cast<char>(0xFF);
+        thumb[1] = static_cast<char>(0xD8);
+        thumb[thumblen - 2] = static_cast<char>(0xFF);
+        thumb[thumblen - 1] = static_cast<char>(0xD9);
+        writer.Finalize(thumblen);
+    }
+
+    char *main = writer.GetMainStreamBase();
+    main[0] = static_cast<char>(0xFF);
+    main[1] = static_cast<char>(0xD8);
+    main[2] = static_cast<char>(0xFF);
+    main[3] = static_cast<char>(0xD9);
+
+    // H/W writes the main stream from the aligned address
+    EXPECT_EQ(0U, PTR_TO_ULONG(main) & 15);
+
+    return PTR_DIFF(base, main) + 4;
+}
+
+static void ExpectAttributes(const ExifParser &parser, const Attributes &attr)
+{
+    const exif_attribute_t &exif = attr.exif;
+
+    ASSERT_TRUE(parser.ifd0.present);
+    ASSERT_TRUE(parser.exif.present);
+    ASSERT_TRUE(parser.interop.present);
+    EXPECT_EQ(exif.enableGps, parser.gps.present);
+    EXPECT_EQ(exif.enableThumb, parser.ifd1.present);
+
+    const ExifParser::Field *field = parser.ifd0.find(TAG_MAKE);
+    ASSERT_NE(nullptr, field);
+    EXPECT_EQ(ExifParser::TYPE_ASCII, field->type);
+    EXPECT_EQ(std::string(exif.maker), parser.getString(*field));
+    ASSERT_NE(nullptr, field = parser.ifd0.find(TAG_MODEL));
+    EXPECT_EQ(std::string(exif.model), parser.getString(*field));
+    ASSERT_NE(nullptr, field = parser.ifd0.find(TAG_SOFTWARE));
+    EXPECT_EQ(std::string(exif.software), parser.getString(*field));
+    ASSERT_NE(nullptr, field = parser.ifd0.find(TAG_ORIENTATION));
+    EXPECT_EQ(ExifParser::TYPE_SHORT, field->type);
+    EXPECT_EQ(exif.orientation, parser.getShort(*field));
+    ASSERT_NE(nullptr, field = parser.ifd0.find(TAG_DATE_TIME));
+    EXPECT_EQ(20U, field->count);
+    EXPECT_EQ(std::string(exif.date_time), parser.getString(*field));
+
+    ASSERT_NE(nullptr, field = parser.exif.find(TAG_EXIF_VERSION));
+    EXPECT_EQ(ExifParser::TYPE_UNDEFINED, field->type);
+    EXPECT_EQ(0, memcmp(exif.exif_version, parser.getData(*field), 4));
+    ASSERT_NE(nullptr, field = parser.exif.find(TAG_EXPOSURE_TIME));
+    EXPECT_EQ(ExifParser::TYPE_RATIONAL, field->type);
+    uint32_t num, den;
+    parser.getRational(*field, 0, num, den);
+    EXPECT_EQ(exif.exposure_time.num, num);
+    EXPECT_EQ(exif.exposure_time.den, den);
+    ASSERT_NE(nullptr, field = parser.exif.find(TAG_PIXEL_X_DIMENSION));
+    EXPECT_EQ(exif.width, parser.getLong(*field));
+    ASSERT_NE(nullptr, field = parser.exif.find(TAG_PIXEL_Y_DIMENSION));
+    EXPECT_EQ(exif.height, parser.getLong(*field));
+    ASSERT_NE(nullptr, field = parser.exif.find(TAG_IMAGE_UNIQUE_ID));
+    EXPECT_EQ(std::string(exif.unique_id), parser.getString(*field));
+
+    field = parser.exif.find(TAG_MAKER_NOTE);
+    if (exif.maker_note_size > 0) {
+        ASSERT_NE(nullptr, field);
+        EXPECT_EQ(exif.maker_note_size, field->count);
+        EXPECT_EQ(0, memcmp(exif.maker_note, parser.getData(*field), exif.maker_note_size));
+    } else {
+        EXPECT_EQ(nullptr, field);
+    }
+
+    field = parser.exif.find(TAG_USER_COMMENT);
+    if (exif.user_comment_size > 0) {
+        ASSERT_NE(nullptr, field);
+        EXPECT_EQ(exif.user_comment_size, field->count);
+        EXPECT_EQ(0, memcmp(exif.user_comment, parser.getData(*field), exif.user_comment_size));
+    } else {
+        EXPECT_EQ(nullptr, field);
+    }
+
+    ASSERT_NE(nullptr, field = parser.interop.find(TAG_INTEROP_INDEX));
+    EXPECT_EQ(std::string("R98"), parser.getString(*field));
+
+    if (exif.enableGps) {
+        ASSERT_NE(nullptr, field = parser.gps.find(TAG_GPS_LATITUDE_REF));
+        EXPECT_EQ(std::string(exif.gps_latitude_ref), parser.getString(*field));
+        ASSERT_NE(nullptr, field = parser.gps.find(TAG_GPS_LATITUDE));
+        ASSERT_EQ(3U, field->count);
+        for (uint32_t i = 0; i < 3; i++) {
+            parser.getRational(*field, i, num, den);
+            EXPECT_EQ(exif.gps_latitude[i].num, num);
+            EXPECT_EQ(exif.gps_latitude[i].den, den);
+        }
+        ASSERT_NE(nullptr, field = parser.gps.find(TAG_GPS_DATESTAMP));
+        EXPECT_EQ(std::string(exif.gps_datestamp), parser.getString(*field));
+        ASSERT_NE(nullptr, field = parser.gps.find(TAG_GPS_PROCESSING_METHOD));
+        EXPECT_EQ(0, memcmp("ASCII\0\0\0", parser.getData(*field), 8));
+        size_t len = min(strlen(exif.gps_processing_method), static_cast<size_t>(99));
+        EXPECT_EQ(8 + len + 1, field->count);
+        EXPECT_EQ(0, memcmp(exif.gps_processing_method, parser.getData(*field) + 8, len));
+    }
+
+    if (exif.enableThumb) {
+        ASSERT_NE(nullptr, field = parser.ifd1.find(TAG_IMAGE_WIDTH));
+        EXPECT_EQ(exif.widthThumb, parser.getLong(*field));
+        ASSERT_NE(nullptr, field = parser.ifd1.find(TAG_IMAGE_HEIGHT));
+        EXPECT_EQ(exif.heightThumb, parser.getLong(*field));
+    }
+}
+
+typedef std::tuple<bool, bool, size_t, int> ExifParam; // GPS, thumbnail, maker note, debug
+
+class ExifConformanceTest : public ::testing::TestWithParam<ExifParam> {
+};
+
+TEST_P(ExifConformanceTest, Write)
+{
+    bool gps, thumb;
+    size_t makerNoteSize;
+    int debug;
+    std::tie(gps, thumb, makerNoteSize, debug) = GetParam();
+
+    Attributes attr(gps, thumb, makerNoteSize, makerNoteSize / 2, debug, 20000);
+    std::vector<unsigned char> buffer(STREAM_BUFFER_SIZE);
+    const size_t thumblen = 12345;
+
+    size_t len = WriteStream(buffer, attr, thumblen);
+
+    ExifParser parser;
+    ASSERT_TRUE(parser.parse(buffer.data(), len)) << parser.error();
+
+    // APP1, APP4 and later debug segments and APP11 in order
+    ASSERT_EQ(static_cast<size_t>(debug + 2), parser.segments.size());
+    EXPECT_EQ(0xE1, parser.segments[0].marker);
+    EXPECT_EQ(2U, parser.segments[0].offset);
+    for (int i = 0; i < debug; i++) {
+        const ExifParser::Segment &seg = parser.segments[i + 1];
+        EXPECT_EQ(0xE4 + i, seg.marker);
+        ASSERT_EQ(attr.debugData[i].size() + 2, seg.length);
+        EXPECT_EQ(0, memcmp(attr.debugData[i].data(), buffer.data() + seg.offset + 4, seg.length - 2));
+    }
+    EXPECT_EQ(0xEB, parser.segments.back().marker);
+
+    ExpectAttributes(parser, attr);
+
+    if (thumb) {
+        ASSERT_EQ(thumblen, parser.thumbnailLength);
+        EXPECT_EQ(0xD9, parser.thumbnail[thumblen - 1]);
+        // APP1 is extended to the maximum to reserve the thumbnail space
+        EXPECT_EQ(static_cast<size_t>(JPEG_MAX_SEGMENT_SIZE), parser.segments[0].length);
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Combinations, ExifConformanceTest,
+        ::testing::Combine(::testing::Bool(), ::testing::Bool(),
+                           ::testing::Values(0, 3, 4, 5, 1000, 8192),
+                           ::testing::Values(0, 1, 3)));
+
+TEST(ExifTest, LongStrings)
+{
+    Attributes attr(true, true, 0, 0);
+    std::vector<unsigned char> buffer(STREAM_BUFFER_SIZE);
+
+    memset(attr.exif.maker, 'M', sizeof(attr.exif.maker) - 1);
+    memset(attr.exif.model, 'm', sizeof(attr.exif.model) - 1);
+    memset(attr.exif.software, 'S', 2); // stored in the field
+    attr.exif.software[2] = '\0';
+    memset(attr.exif.gps_processing_method, 'P', sizeof(attr.exif.gps_processing_method) - 1);
+
+    size_t len = WriteStream(buffer, attr, 1000);
+
+    ExifParser parser;
+    ASSERT_TRUE(parser.parse(buffer.data(), len)) << parser.error();
+    ExpectAttributes(parser, attr);
+}
+
+TEST(ExifTest, TooLargeApp1)
+{
+    // 64KB of maker note cannot be stored in APP1
+    Attributes attr(true, true, JPEG_MAX_SEGMENT_SIZE, 0, 1, 100);
+    std::vector<unsigned char> buffer(STREAM_BUFFER_SIZE);
+    CAppMarkerWriter writer;
+
+    writer.PrepareAppWriter(reinterpret_cast<char *>(buffer.data()) + JPEG_MARKER_SIZE,
+                            &attr.exif, &attr.extra);
+    EXPECT_EQ(nullptr, writer.GetThumbStreamBase());
+
+    size_t len = WriteStream(buffer, attr, 1000);
+
+    ExifParser parser;
+    ASSERT_TRUE(parser.parse(buffer.data(), len)) << parser.error();
+    EXPECT_FALSE(parser.ifd0.present);
+    ASSERT_EQ(2U, parser.segments.size());
+    EXPECT_EQ(0xE4, parser.segments[0].marker);
+}
+
+TEST(ExifTest, UpdateExif)
+{
+    Attributes attr(true, true, 100, 10);
+    std::vector<unsigned char> buffer(STREAM_BUFFER_SIZE);
+    const size_t thumblen = 4000;
+
+    size_t len = WriteStream(buffer, attr, thumblen);
+
+    attr.exif.orientation = 3;
+    attr.exif.gps_latitude[2] = {99, 100};
+    strncpy(attr.exif.date_time, "2026:10:17 09:30:16", sizeof(attr.exif.date_time));
+    for (auto &c : attr.makerNote)
+        c = ~c;
+
+    ASSERT_TRUE(UpdateExif(reinterpret_cast<char *>(buffer.data()), len, &attr.exif));
+
+    ExifParser parser;
+    ASSERT_TRUE(parser.parse(buffer.data(), len)) << parser.error();
+    ExpectAttributes(parser, attr);
+    // The thumbnail is not touched
+    EXPECT_EQ(thumblen, parser.thumbnailLength);
+}
+
+TEST(ExifTest, UpdateDebugData)
+{
+    Attributes attr(false, true, 0, 0, 3, 30000);
+    std::vector<unsigned char> buffer(STREAM_BUFFER_SIZE);
+
+    // reserve the debug segments. The data is updated after compression.
+    size_t len = WriteStream(buffer, attr, 2000, true);
+
+    for (int i = 0; i < 3; i++)
+        memset(attr.debugData[i].data(), 'a' + i, attr.debugData[i].size());
+
+    ASSERT_TRUE(UpdateDebugData(reinterpret_cast<char *>(buffer.data()), len, &attr.extra));
+
+    ExifParser parser;
+    ASSERT_TRUE(parser.parse(buffer.data(), len)) << parser.error();
+    ASSERT_EQ(5U, parser.segments.size());
+    for (int i = 0; i < 3; i++) {
+        const ExifParser::Segment &seg = parser.segments[i + 1];
+        EXPECT_EQ(0xE4 + i, seg.marker);
+        EXPECT_EQ(0, memcmp(attr.debugData[i].data(), buffer.data() + seg.offset + 4, seg.length - 2));
+    }
+}
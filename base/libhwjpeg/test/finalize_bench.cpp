@@ -0,0 +1,211 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include <unistd.h>
+#include <time.h>
+
+/*
+ * Benchmark of the finalization of a JPEG stream by ExynosJpegEncoderForCamera
+ * after H/W compresses the main image. It emulates the memory operations on a
+ * stream buffer of the two layouts:
+ * - shift: no thumbnail space is reserved in APP1. The main stream is shifted
+ *          by the thumbnail stream length and EOI is found by comparing byte
+ *          by byte backwards (the former implementation with small buffers).
+ * - reserved: the thumbnail space is reserved in APP1 in front of the main
+ *          stream. The thumbnail stream is copied in and the rest of the space
+ *          is cleared. EOI is found by memrchr().
+ * It reports the time to finalize a shot in microseconds.
+ *
+ * usage: libhwjpeg_finalizebench [-n shots] [-m main stream bytes] [-t thumbnail bytes]
+ *                                [-r reserved thumbnail bytes] [-d dummy bytes]
+ */
+
+#define APP1_FIELDS_SIZE 1024
+
+struct Config {
+    unsigned int shots;
+    size_t mainlen;
+    size_t thumblen;
+    size_t thumbspace;
+    size_t dummies;
+};
+
+static uint64_t nowUSec()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Fills a JPEG stream of @len bytes followed by @dummies bytes
+static void fillStream(unsigned char *stream, size_t len, size_t dummies, uint32_t seed)
+{
+    stream[0] = 0xFF;
+    stream[1] = 0xD8;
+    for (size_t i = 2; i < len - 2; i++) {
+        seed = seed * 1103515245 + 12345;
+        unsigned char c = static_cast<unsigned char>(seed >> 16);
+        // 0xFF in the scan data is followed by a stuffed zero byte
+        stream[i] = (stream[i - 1] == 0xFF) ? 0 : c;
+    }
+    stream[len - 2] = 0xFF;
+    stream[len - 1] = 0xD9;
+    memset(stream + len, 0xA5, dummies);
+}
+
+static size_t findEOIByteByByte(const unsigned char *stream, size_t len)
+{
+    size_t riter = len - 2;
+
+    while (riter > 0) {
+        if ((stream[riter] == 0xFF) && (stream[riter + 1] == 0xD9))
+            return riter + 2;
+        riter--;
+    }
+
+    return 0;
+}
+
+static size_t findEOIMemrchr(const unsigned char *stream, size_t len)
+{
+    size_t riter = len - 1;
+    const void *marker;
+
+    while ((marker = memrchr(stream, 0xFF, riter)) != NULL) {
+        riter = static_cast<const unsigned char *>(marker) - stream;
+        if (stream[riter + 1] == 0xD9)
+            return riter + 2;
+    }
+
+    return 0;
+}
+
+static bool finalizeShift(const Config &c, unsigned char *buffer, const unsigned char *thumb)
+{
+    unsigned char *thumbbase = buffer + APP1_FIELDS_SIZE;
+    unsigned char *mainbase = thumbbase;
+
+    size_t mainlen = findEOIByteByByte(mainbase, c.mainlen + c.dummies);
+    if (mainlen != c.mainlen)
+        return false;
+
+    memmove(mainbase + c.thumblen, mainbase, mainlen);
+    memcpy(thumbbase, thumb, c.thumblen);
+
+    return true;
+}
+
+static bool finalizeReserved(const Config &c, unsigned char *buffer, const unsigned char *thumb)
+{
+    unsigned char *thumbbase = buffer + APP1_FIELDS_SIZE;
+    unsigned char *mainbase = thumbbase + c.thumbspace;
+
+    size_t mainlen = findEOIMemrchr(mainbase, c.mainlen + c.dummies);
+    if (mainlen != c.mainlen)
+        return false;
+
+    memcpy(thumbbase, thumb, c.thumblen);
+    memset(thumbbase + c.thumblen, 0, c.thumbspace - c.thumblen);
+
+    return true;
+}
+
+static bool runBench(const Config &c, const char *name,
+                     bool (*finalize)(const Config &, unsigned char *, const unsigned char *))
+{
+    size_t buflen = APP1_FIELDS_SIZE + c.thumbspace + c.mainlen + c.dummies + c.thumblen;
+    std::vector<unsigned char> buffer(buflen);
+    std::vector<unsigned char> thumb(c.thumblen, 0x5A);
+    std::vector<uint64_t> samples;
+    size_t mainoffset = APP1_FIELDS_SIZE + ((finalize == finalizeReserved) ? c.thumbspace : 0);
+
+    for (unsigned int i = 0; i < c.shots; i++) {
+        // the stream written by H/W
+        fillStream(buffer.data() + mainoffset, c.mainlen, c.dummies, i + 1);
+
+        uint64_t begin = nowUSec();
+        if (!finalize(c, buffer.data(), thumb.data())) {
+            fprintf(stderr, "%s: EOI is not found in shot %u\n", name, i);
+            return false;
+        }
+        samples.push_back(nowUSec() - begin);
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    double mean = 0.0;
+    for (auto s : samples)
+        mean += s;
+    mean /= samples.size();
+
+    printf("  %-10s mean %8.1f  p50 %6llu  max %6llu\n", name, mean,
+           static_cast<unsigned long long>(samples[samples.size() / 2]),
+           static_cast<unsigned long long>(samples.back()));
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    // 12 MP with 1 bit per pixel and a 512x384 thumbnail
+    Config config = {50, 1536 * 1024, 24 * 1024, 60 * 1024, 16};
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:m:t:r:d:")) != -1) {
+        switch (opt) {
+        case 'n':
+            config.shots = static_cast<unsigned int>(atoi(optarg));
+            break;
+        case 'm':
+            config.mainlen = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            config.thumblen = strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            config.thumbspace = strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            config.dummies = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n shots] [-m main stream bytes] [-t thumbnail bytes] "
+                            "[-r reserved thumbnail bytes] [-d dummy bytes]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if ((config.shots == 0) || (config.mainlen < 4) || (config.thumblen > config.thumbspace)) {
+        fprintf(stderr, "Invalid configuration\n");
+        return 1;
+    }
+
+    printf("Finalizing %u shots: main %zu bytes, thumbnail %zu/%zu bytes, %zu dummies (usec)\n",
+           config.shots, config.mainlen, config.thumblen, config.thumbspace, config.dummies);
+
+    bool success = runBench(config, "shift", finalizeShift);
+    success = runBench(config, "reserved", finalizeReserved) && success;
+
+    return success ? 0 : 1;
+}
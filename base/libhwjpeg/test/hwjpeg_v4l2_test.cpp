@@ -0,0 +1,538 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include <linux/videodev2.h>
+#include <linux/v4l2-controls.h>
+
+#include <gtest/gtest.h>
+
+#include <exynos-hwjpeg.h>
+
+/*
+ * FakeV4L2Device - a JPEG compressor of the V4L2 mem2mem device on the host
+ *
+ * The device node is a named pipe. ioctl() on it is handled by this class and
+ * the other ioctl() calls are passed to the kernel. A thread pairs the queued
+ * image and stream buffers in the order of QBUF and "compresses" them: the
+ * stream size is 100 plus the first byte of the image buffer (userptr).
+ * A byte is written to the pipe for each finished compression so that the
+ * device node is readable if a compression is ready to dequeue.
+ */
+class FakeV4L2Device {
+    struct Job {
+        unsigned int src;
+        unsigned int dst;
+        unsigned int bytesused;
+        bool error;
+    };
+
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::thread mThread;
+    std::deque<unsigned int> mOutQueue;
+    std::deque<unsigned int> mCapQueue;
+    std::deque<Job> mOutDone;
+    std::deque<Job> mCapDone;
+    unsigned long mOutUserptr[VIDEO_MAX_FRAME];
+    unsigned long mMappedUserptr[VIDEO_MAX_FRAME];
+    unsigned int mMaxBuffers;
+    unsigned int mNumBuffers;
+    bool mStreaming;
+    bool mRunning;
+    bool mHolding;
+    bool mFailNext;
+    bool mStop;
+    int mPipe;
+    ino_t mIno;
+    char mDir[64];
+    char mPath[80];
+
+    void threadLoop() {
+        std::unique_lock<std::mutex> lock(mLock);
+
+        for (;;) {
+            mCond.wait(lock, [this] {
+                return mStop || (!mHolding && mStreaming && !mOutQueue.empty() && !mCapQueue.empty());
+            });
+            if (mStop)
+                return;
+
+            Job job;
+            job.src = mOutQueue.front();
+            job.dst = mCapQueue.front();
+            mOutQueue.pop_front();
+            mCapQueue.pop_front();
+            job.error = mFailNext;
+            mFailNext = false;
+            job.bytesused = 100 + *reinterpret_cast<unsigned char *>(mOutUserptr[job.src]);
+
+            mRunning = true;
+            lock.unlock();
+            usleep(1000);
+            lock.lock();
+            mRunning = false;
+
+            mOutDone.push_back(job);
+            mCapDone.push_back(job);
+            char c = 0;
+            EXPECT_EQ(1, write(mPipe, &c, 1));
+            mCond.notify_all();
+        }
+    }
+
+    void streamOff() {
+        std::unique_lock<std::mutex> lock(mLock);
+
+        mStreaming = false;
+        mCond.wait(lock, [this] { return !mRunning; });
+
+        char c;
+        for (size_t i = 0; i < mCapDone.size(); i++)
+            EXPECT_EQ(1, read(mPipe, &c, 1));
+
+        mOutQueue.clear();
+        mCapQueue.clear();
+        mOutDone.clear();
+        mCapDone.clear();
+    }
+
+    int qbuf(v4l2_buffer *buf) {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        if (buf->index >= mNumBuffers)
+            return -EINVAL;
+
+        if (buf->type == V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE) {
+            mOutUserptr[buf->index] = buf->m.planes[0].m.userptr;
+            if (mMappedUserptr[buf->index] != buf->m.planes[0].m.userptr) {
+                mMappedUserptr[buf->index] = buf->m.planes[0].m.userptr;
+                mappings++;
+            }
+            mOutQueue.push_back(buf->index);
+        } else {
+            mCapQueue.push_back(buf->index);
+        }
+        mCond.notify_all();
+
+        return 0;
+    }
+
+    int dqbuf(v4l2_buffer *buf) {
+        Job job;
+
+        if (buf->type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) {
+            // blocks until a compression finishes like the real device
+            char c;
+            if (read(mPipe, &c, 1) != 1)
+                return -EIO;
+
+            std::lock_guard<std::mutex> lock(mLock);
+            if (mCapDone.empty())
+                return -EINVAL;
+            job = mCapDone.front();
+            mCapDone.pop_front();
+            buf->index = job.dst;
+            buf->m.planes[0].bytesused = job.error ? 0 : job.bytesused;
+            buf->m.planes[1].bytesused = 0;
+        } else {
+            std::unique_lock<std::mutex> lock(mLock);
+            mCond.wait(lock, [this] { return !mOutDone.empty() || !mStreaming; });
+            if (mOutDone.empty())
+                return -EINVAL;
+            job = mOutDone.front();
+            mOutDone.pop_front();
+            buf->index = job.src;
+        }
+
+        buf->flags = job.error ? V4L2_BUF_FLAG_ERROR : 0;
+
+        return 0;
+    }
+
+    int reqbufs(v4l2_requestbuffers *reqbufs) {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        reqbufs->count = (reqbufs->count > mMaxBuffers) ? mMaxBuffers : reqbufs->count;
+        mNumBuffers = reqbufs->count;
+        if (reqbufs->type == V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE)
+            memset(mMappedUserptr, 0, sizeof(mMappedUserptr));
+
+        return 0;
+    }
+
+    static void fillFormat(v4l2_format *fmt) {
+        if (fmt->type == V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE) {
+            fmt->fmt.pix_mp.num_planes = 1;
+            fmt->fmt.pix_mp.plane_fmt[0].sizeimage =
+                    (fmt->fmt.pix_mp.width & 0xFFFF) * (fmt->fmt.pix_mp.height & 0xFFFF) * 2;
+        }
+    }
+public:
+    unsigned int mappings;
+    int quality;
+
+    FakeV4L2Device(unsigned int maxbuffers)
+            : mMaxBuffers(maxbuffers), mNumBuffers(0), mStreaming(false), mRunning(false),
+              mHolding(false), mFailNext(false), mStop(false), mappings(0), quality(0) {
+        memset(mOutUserptr, 0, sizeof(mOutUserptr));
+        memset(mMappedUserptr, 0, sizeof(mMappedUserptr));
+
+        strcpy(mDir, "/tmp/hwjpeg_v4l2_test.XXXXXX");
+        EXPECT_NE(nullptr, mkdtemp(mDir));
+        snprintf(mPath, sizeof(mPath), "%s/video12", mDir);
+        EXPECT_EQ(0, mkfifo(mPath, 0600));
+
+        mPipe = open(mPath, O_RDWR);
+        EXPECT_LE(0, mPipe);
+
+        struct stat st;
+        EXPECT_EQ(0, fstat(mPipe, &st));
+        mIno = st.st_ino;
+
+        mThread = std::thread(&FakeV4L2Device::threadLoop, this);
+    }
+
+    ~FakeV4L2Device() {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mStop = true;
+        }
+        mCond.notify_all();
+        mThread.join();
+
+        close(mPipe);
+        unlink(mPath);
+        rmdir(mDir);
+    }
+
+    const char *path() { return mPath; }
+
+    bool isDevice(int fd) {
+        struct stat st;
+        return (fstat(fd, &st) == 0) && S_ISFIFO(st.st_mode) && (st.st_ino == mIno);
+    }
+
+    // Stops starting the compressions until release()
+    void hold() {
+        std::lock_guard<std::mutex> lock(mLock);
+        mHolding = true;
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mHolding = false;
+        }
+        mCond.notify_all();
+    }
+
+    void failNext() {
+        std::lock_guard<std::mutex> lock(mLock);
+        mFailNext = true;
+    }
+
+    int ioctl(unsigned long request, void *arg) {
+        switch (request) {
+        case VIDIOC_QUERYCAP: {
+            v4l2_capability *cap = static_cast<v4l2_capability *>(arg);
+            cap->capabilities = V4L2_CAP_VIDEO_M2M_MPLANE | V4L2_CAP_DEVICE_CAPS;
+            cap->device_caps = V4L2_CAP_VIDEO_M2M_MPLANE;
+            return 0;
+        }
+        case VIDIOC_TRY_FMT:
+        case VIDIOC_S_FMT:
+            fillFormat(static_cast<v4l2_format *>(arg));
+            return 0;
+        case VIDIOC_S_EXT_CTRLS: {
+            v4l2_ext_controls *ctrls = static_cast<v4l2_ext_controls *>(arg);
+            for (unsigned int i = 0; i < ctrls->count; i++) {
+                if (ctrls->controls[i].id == V4L2_CID_JPEG_COMPRESSION_QUALITY)
+                    quality = ctrls->controls[i].value;
+            }
+            return 0;
+        }
+        case VIDIOC_REQBUFS:
+            return reqbufs(static_cast<v4l2_requestbuffers *>(arg));
+        case VIDIOC_STREAMON: {
+            std::lock_guard<std::mutex> lock(mLock);
+            mStreaming = true;
+            mCond.notify_all();
+            return 0;
+        }
+        case VIDIOC_STREAMOFF:
+            streamOff();
+            return 0;
+        case VIDIOC_QBUF:
+            return qbuf(static_cast<v4l2_buffer *>(arg));
+        case VIDIOC_DQBUF:
+            return dqbuf(static_cast<v4l2_buffer *>(arg));
+        default:
+            return -ENOTTY;
+        }
+    }
+};
+
+static FakeV4L2Device *fakeDevice;
+
+extern "C" int ioctl(int fd, unsigned long request, ...) __THROW
+{
+    va_list ap;
+    va_start(ap, request);
+    void *arg = va_arg(ap, void *);
+    va_end(ap);
+
+    if (!fakeDevice || !fakeDevice->isDevice(fd))
+        return static_cast<int>(syscall(SYS_ioctl, fd, request, arg));
+
+    int ret = fakeDevice->ioctl(request, arg);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+
+    return 0;
+}
+
+class HWJpegV4L2Test : public ::testing::Test {
+protected:
+    static const unsigned int WIDTH = 64;
+    static const unsigned int HEIGHT = 32;
+    static const size_t IMAGE_SIZE = WIDTH * HEIGHT * 2;
+    static const size_t STREAM_SIZE = 4096;
+
+    char mImages[HWJPEG_V4L2_MAX_QUEUE_DEPTH + 1][IMAGE_SIZE];
+    char mStreams[HWJPEG_V4L2_MAX_QUEUE_DEPTH + 1][STREAM_SIZE];
+
+    void SetUpDevice(unsigned int maxbuffers) {
+        fakeDevice = new FakeV4L2Device(maxbuffers);
+        mCompressor = new CHWJpegV4L2Compressor(fakeDevice->path());
+        ASSERT_TRUE(mCompressor->Okay());
+        ASSERT_TRUE(mCompressor->SetImageFormat(V4L2_PIX_FMT_YUYV, WIDTH, HEIGHT));
+        ASSERT_TRUE(mCompressor->SetQuality(90));
+
+        for (unsigned int i = 0; i <= HWJPEG_V4L2_MAX_QUEUE_DEPTH; i++)
+            mImages[i][0] = static_cast<char>(i * 10);
+    }
+
+    void SetUp() override {
+        SetUpDevice(HWJPEG_V4L2_MAX_QUEUE_DEPTH);
+    }
+
+    void TearDown() override {
+        delete mCompressor;
+        delete fakeDevice;
+        fakeDevice = NULL;
+    }
+
+    void Recreate(unsigned int maxbuffers) {
+        TearDown();
+        SetUpDevice(maxbuffers);
+    }
+
+    // Configures the buffers of @i and returns the expected stream size
+    ssize_t SetBuffers(unsigned int i) {
+        char *images[1] = {mImages[i]};
+        size_t len[1] = {IMAGE_SIZE};
+
+        EXPECT_TRUE(mCompressor->SetImageBuffer(images, len, 1));
+        EXPECT_TRUE(mCompressor->SetJpegBuffer(mStreams[i], STREAM_SIZE));
+
+        return 100 + static_cast<unsigned char>(mImages[i][0]);
+    }
+
+    CHWJpegV4L2Compressor *mCompressor;
+};
+
+TEST_F(HWJpegV4L2Test, BlockingCompression) {
+    ssize_t expected = SetBuffers(1);
+
+    EXPECT_EQ(expected, mCompressor->Compress());
+    EXPECT_EQ(0U, mCompressor->GetJobsInFlight());
+    EXPECT_EQ(90, fakeDevice->quality);
+
+    expected = SetBuffers(2);
+    EXPECT_EQ(0, mCompressor->Compress(NULL, false));
+    EXPECT_EQ(expected, mCompressor->WaitForCompression());
+
+    // nothing to wait for
+    EXPECT_GT(0, mCompressor->WaitForCompression());
+}
+
+TEST_F(HWJpegV4L2Test, PipelinedCompressionsFinishInOrder) {
+    ssize_t expected[3];
+    int ids[3];
+
+    ASSERT_TRUE(mCompressor->SetQueueDepth(3));
+
+    for (unsigned int i = 0; i < 3; i++) {
+        expected[i] = SetBuffers(i);
+        ids[i] = mCompressor->QueueCompression();
+        ASSERT_LE(0, ids[i]);
+    }
+
+    EXPECT_EQ(3U, mCompressor->GetJobsInFlight());
+
+    // no free slot
+    SetBuffers(3);
+    EXPECT_GT(0, mCompressor->QueueCompression());
+    // Compress() is not allowed during the pipelined compressions
+    EXPECT_GT(0, mCompressor->Compress());
+    EXPECT_FALSE(mCompressor->SetQueueDepth(2));
+
+    for (unsigned int i = 0; i < 3; i++) {
+        ssize_t len;
+        EXPECT_EQ(ids[i], mCompressor->DequeueCompression(&len));
+        EXPECT_EQ(expected[i], len);
+    }
+
+    EXPECT_EQ(0U, mCompressor->GetJobsInFlight());
+}
+
+TEST_F(HWJpegV4L2Test, CompletionFdIsPollable) {
+    ASSERT_TRUE(mCompressor->SetQueueDepth(2));
+    ASSERT_LE(0, mCompressor->GetCompletionFD());
+
+    fakeDevice->hold();
+
+    ssize_t expected = SetBuffers(1);
+    int id = mCompressor->QueueCompression();
+    ASSERT_LE(0, id);
+
+    pollfd pfd = {mCompressor->GetCompletionFD(), POLLIN, 0};
+    EXPECT_EQ(0, poll(&pfd, 1, 20));
+
+    fakeDevice->release();
+    ASSERT_EQ(1, poll(&pfd, 1, 1000));
+    EXPECT_TRUE(!!(pfd.revents & POLLIN));
+
+    ssize_t len;
+    EXPECT_EQ(id, mCompressor->DequeueCompression(&len));
+    EXPECT_EQ(expected, len);
+
+    pfd.revents = 0;
+    EXPECT_EQ(0, poll(&pfd, 1, 0));
+}
+
+TEST_F(HWJpegV4L2Test, ControlsCannotChangeDuringCompressions) {
+    ASSERT_TRUE(mCompressor->SetQueueDepth(2));
+
+    fakeDevice->hold();
+
+    ssize_t expected = SetBuffers(1);
+    int id = mCompressor->QueueCompression();
+    ASSERT_LE(0, id);
+
+    // The queued compression should be done with the quality it is queued with
+    EXPECT_FALSE(mCompressor->SetQuality(50));
+    EXPECT_TRUE(mCompressor->SetQuality(90));
+
+    fakeDevice->release();
+
+    ssize_t len;
+    EXPECT_EQ(id, mCompressor->DequeueCompression(&len));
+    EXPECT_EQ(expected, len);
+    EXPECT_EQ(90, fakeDevice->quality);
+
+    EXPECT_TRUE(mCompressor->SetQuality(50));
+    EXPECT_EQ(expected, mCompressor->Compress());
+    EXPECT_EQ(50, fakeDevice->quality);
+}
+
+TEST_F(HWJpegV4L2Test, SlotsAreRecycledForTheSameBuffers) {
+    ASSERT_TRUE(mCompressor->SetQueueDepth(2));
+
+    int ids[2];
+    ids[0] = (SetBuffers(0), mCompressor->QueueCompression());
+    ids[1] = (SetBuffers(1), mCompressor->QueueCompression());
+    ASSERT_LE(0, ids[0]);
+    ASSERT_LE(0, ids[1]);
+
+    // the buffers of a burst capture are used in turn
+    for (unsigned int i = 0; i < 8; i++) {
+        ssize_t len;
+        EXPECT_EQ(ids[i % 2], mCompressor->DequeueCompression(&len));
+        EXPECT_EQ(100 + (i % 2) * 10, len);
+        SetBuffers(i % 2);
+        EXPECT_EQ(ids[i % 2], mCompressor->QueueCompression());
+    }
+
+    for (unsigned int i = 0; i < 2; i++) {
+        ssize_t len;
+        EXPECT_EQ(ids[i], mCompressor->DequeueCompression(&len));
+    }
+
+    EXPECT_EQ(2U, fakeDevice->mappings);
+}
+
+TEST_F(HWJpegV4L2Test, ErrorIsReportedToTheCompression) {
+    ASSERT_TRUE(mCompressor->SetQueueDepth(2));
+
+    fakeDevice->failNext();
+
+    int id1 = (SetBuffers(1), mCompressor->QueueCompression());
+    ssize_t expected = SetBuffers(2);
+    int id2 = mCompressor->QueueCompression();
+
+    ssize_t len;
+    EXPECT_EQ(id1, mCompressor->DequeueCompression(&len));
+    EXPECT_GT(0, len);
+    EXPECT_EQ(id2, mCompressor->DequeueCompression(&len));
+    EXPECT_EQ(expected, len);
+}
+
+TEST_F(HWJpegV4L2Test, QueueDepthIsLimitedByDriver) {
+    Recreate(2);
+
+    EXPECT_FALSE(mCompressor->SetQueueDepth(0));
+    EXPECT_FALSE(mCompressor->SetQueueDepth(HWJPEG_V4L2_MAX_QUEUE_DEPTH + 1));
+    ASSERT_TRUE(mCompressor->SetQueueDepth(HWJPEG_V4L2_MAX_QUEUE_DEPTH));
+
+    EXPECT_LE(0, (SetBuffers(0), mCompressor->QueueCompression()));
+    EXPECT_LE(0, (SetBuffers(1), mCompressor->QueueCompression()));
+    EXPECT_GT(0, (SetBuffers(2), mCompressor->QueueCompression()));
+
+    // The image format cannot change during the compressions
+    EXPECT_TRUE(mCompressor->SetImageFormat(V4L2_PIX_FMT_YUYV, WIDTH / 2, HEIGHT));
+    EXPECT_GT(0, mCompressor->QueueCompression());
+
+    // Release() cancels the compressions in flight
+    mCompressor->Release();
+    EXPECT_EQ(0U, mCompressor->GetJobsInFlight());
+
+    ssize_t expected = SetBuffers(3);
+    ssize_t len;
+    int id = mCompressor->QueueCompression();
+    ASSERT_LE(0, id);
+    EXPECT_EQ(id, mCompressor->DequeueCompression(&len));
+    EXPECT_EQ(expected, len);
+}
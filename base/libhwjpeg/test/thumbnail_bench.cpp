@@ -0,0 +1,300 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ThumbnailWorker.h"
+
+/*
+ * Burst capture benchmark of the thumbnail generation of libhwjpeg.
+ * Each shot generates a thumbnail concurrently with the main image
+ * compression like ExynosJpegEncoderForCamera::encode(). The thumbnail is
+ * generated either by a thread created for the shot (-m thread, the former
+ * implementation) or by the persistent ThumbnailWorker (-m worker).
+ * The scaler and the compressor are stand-ins on the CPU: a box filter
+ * that downscales the luma of a NV21 image to the thumbnail size and a
+ * DPCM byte coder. The main image compression is a sleep of the H/W time.
+ * It reports the thumbnail latency from the start of the shot to the end of
+ * the thumbnail generation, the shot latency until encode() would return
+ * and their jitter (standard deviation) in microseconds.
+ *
+ * usage: libhwjpeg_thumbbench [-m thread|worker|both] [-n shots] [-r shots/s]
+ *                             [-s WxH] [-t WxH] [-h usec] [-c cpumask]
+ */
+
+struct Config {
+    unsigned int shots;
+    unsigned int rate;
+    unsigned int srcWidth, srcHeight;
+    unsigned int thumbWidth, thumbHeight;
+    unsigned int hwTime;
+    unsigned long cpumask;
+};
+
+struct Shot {
+    const Config *config;
+    const uint8_t *src;
+    std::vector<uint8_t> thumb;
+    std::vector<uint8_t> stream;
+    uint64_t begin;
+    uint64_t thumbDone;
+};
+
+static uint64_t nowUSec()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleepUntil(uint64_t usec)
+{
+    timespec ts;
+    ts.tv_sec = usec / 1000000;
+    ts.tv_nsec = (usec % 1000000) * 1000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+        ;
+}
+
+// stand-in of ThumbnailScaler: box filter of the luma
+static void scaleThumbnail(Shot &shot)
+{
+    const Config &c = *shot.config;
+    unsigned int xstep = c.srcWidth / c.thumbWidth;
+    unsigned int ystep = c.srcHeight / c.thumbHeight;
+
+    shot.thumb.resize(c.thumbWidth * c.thumbHeight * 3 / 2);
+
+    for (unsigned int y = 0; y < c.thumbHeight; y++) {
+        for (unsigned int x = 0; x < c.thumbWidth; x++) {
+            unsigned int sum = 0;
+            for (unsigned int j = 0; j < ystep; j++) {
+                const uint8_t *row = shot.src + (y * ystep + j) * c.srcWidth + x * xstep;
+                for (unsigned int i = 0; i < xstep; i++)
+                    sum += row[i];
+            }
+            shot.thumb[y * c.thumbWidth + x] = static_cast<uint8_t>(sum / (xstep * ystep));
+        }
+    }
+
+    memset(shot.thumb.data() + c.thumbWidth * c.thumbHeight, 0x80, c.thumbWidth * c.thumbHeight / 2);
+}
+
+// stand-in of the thumbnail compressor: DPCM with the run length of zeros
+static size_t compressThumbnail(Shot &shot)
+{
+    shot.stream.clear();
+    shot.stream.reserve(shot.thumb.size());
+
+    uint8_t prev = 0;
+    unsigned int zeros = 0;
+    for (uint8_t pixel : shot.thumb) {
+        uint8_t diff = static_cast<uint8_t>(pixel - prev);
+        prev = pixel;
+        if ((diff == 0) && (zeros < 255)) {
+            zeros++;
+            continue;
+        }
+        if (zeros > 0) {
+            shot.stream.push_back(0);
+            shot.stream.push_back(static_cast<uint8_t>(zeros));
+            zeros = 0;
+        }
+        shot.stream.push_back(diff);
+    }
+
+    return shot.stream.size();
+}
+
+static size_t generateThumbnail(Shot &shot)
+{
+    scaleThumbnail(shot);
+    size_t len = compressThumbnail(shot);
+    shot.thumbDone = nowUSec();
+    return len;
+}
+
+static void *threadGenerateThumbnail(void *p)
+{
+    return reinterpret_cast<void *>(generateThumbnail(*reinterpret_cast<Shot *>(p)));
+}
+
+struct Stats {
+    std::vector<uint64_t> samples;
+
+    void print(const char *name) {
+        std::sort(samples.begin(), samples.end());
+
+        double mean = 0.0, var = 0.0;
+        for (auto s : samples)
+            mean += s;
+        mean /= samples.size();
+        for (auto s : samples)
+            var += (s - mean) * (s - mean);
+        var /= samples.size();
+
+        printf("  %-16s mean %8.1f  p50 %6llu  p99 %6llu  max %6llu  jitter %7.1f\n", name, mean,
+               static_cast<unsigned long long>(samples[samples.size() / 2]),
+               static_cast<unsigned long long>(samples[(samples.size() * 99) / 100]),
+               static_cast<unsigned long long>(samples.back()), std::sqrt(var));
+    }
+};
+
+static bool runBurst(const Config &config, const std::vector<uint8_t> &src, bool useWorker)
+{
+    ThumbnailWorker worker;
+    Shot shot;
+    Stats thumbLatency, shotLatency;
+    uint64_t period = 1000000 / config.rate;
+
+    shot.config = &config;
+    shot.src = src.data();
+
+    if (useWorker)
+        worker.setAffinity(config.cpumask);
+
+    uint64_t next = nowUSec();
+    for (unsigned int i = 0; i < config.shots; i++) {
+        sleepUntil(next);
+        next += period;
+
+        shot.begin = nowUSec();
+
+        pthread_t thread;
+        std::shared_ptr<ThumbnailJob> job;
+        if (useWorker) {
+            job = worker.submit([&shot] { return generateThumbnail(shot); });
+        } else if (pthread_create(&thread, NULL, threadGenerateThumbnail, &shot) != 0) {
+            fprintf(stderr, "Failed to create a thread for shot %u\n", i);
+            return false;
+        }
+
+        // the main image compression by H/W
+        sleepUntil(shot.begin + config.hwTime);
+
+        size_t len;
+        if (useWorker) {
+            if (!worker.wait(job, &len)) {
+                fprintf(stderr, "Thumbnail of shot %u is cancelled\n", i);
+                return false;
+            }
+        } else {
+            void *ret;
+            pthread_join(thread, &ret);
+            len = reinterpret_cast<size_t>(ret);
+        }
+
+        uint64_t end = nowUSec();
+        if (len == 0) {
+            fprintf(stderr, "Empty thumbnail of shot %u\n", i);
+            return false;
+        }
+
+        thumbLatency.samples.push_back(shot.thumbDone - shot.begin);
+        shotLatency.samples.push_back(end - shot.begin);
+    }
+
+    printf("%s: %u shots at %u shots/s, %zu bytes of thumbnail stream (usec)\n",
+           useWorker ? "worker" : "thread", config.shots, config.rate, shot.stream.size());
+    thumbLatency.print("thumbnail");
+    shotLatency.print("shot");
+
+    return true;
+}
+
+static bool parseSize(const char *arg, unsigned int &width, unsigned int &height)
+{
+    return (sscanf(arg, "%ux%u", &width, &height) == 2) && (width > 0) && (height > 0);
+}
+
+int main(int argc, char *argv[])
+{
+    Config config = {200, 30, 4000, 3000, 512, 384, 20000, 0};
+    const char *mode = "both";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:n:r:s:t:h:c:")) != -1) {
+        bool valid = true;
+
+        switch (opt) {
+        case 'm':
+            mode = optarg;
+            break;
+        case 'n':
+            config.shots = static_cast<unsigned int>(atoi(optarg));
+            break;
+        case 'r':
+            config.rate = static_cast<unsigned int>(atoi(optarg));
+            break;
+        case 's':
+            valid = parseSize(optarg, config.srcWidth, config.srcHeight);
+            break;
+        case 't':
+            valid = parseSize(optarg, config.thumbWidth, config.thumbHeight);
+            break;
+        case 'h':
+            config.hwTime = static_cast<unsigned int>(atoi(optarg));
+            break;
+        case 'c':
+            config.cpumask = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            valid = false;
+            break;
+        }
+
+        if (!valid) {
+            fprintf(stderr, "usage: %s [-m thread|worker|both] [-n shots] [-r shots/s] "
+                            "[-s WxH] [-t WxH] [-h usec] [-c cpumask]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if ((config.shots == 0) || (config.rate == 0) ||
+            (config.thumbWidth > config.srcWidth) || (config.thumbHeight > config.srcHeight)) {
+        fprintf(stderr, "Invalid configuration\n");
+        return 1;
+    }
+
+    // a NV21 image with gradation and noise
+    std::vector<uint8_t> src(config.srcWidth * config.srcHeight * 3 / 2);
+    uint32_t seed = 1;
+    for (unsigned int y = 0; y < config.srcHeight; y++) {
+        for (unsigned int x = 0; x < config.srcWidth; x++) {
+            seed = seed * 1103515245 + 12345;
+            src[y * config.srcWidth + x] = static_cast<uint8_t>((x + y) / 16 + ((seed >> 16) & 7));
+        }
+    }
+
+    bool success = true;
+    if ((strcmp(mode, "thread") == 0) || (strcmp(mode, "both") == 0))
+        success = runBurst(config, src, false) && success;
+    if ((strcmp(mode, "worker") == 0) || (strcmp(mode, "both") == 0))
+        success = runBurst(config, src, true) && success;
+
+    return success ? 0 : 1;
+}
@@ -22,6 +22,7 @@ LOCAL_HEADER_LIBRARIES := libcutils_headers libsystem_headers libhardware_header
 LOCAL_EXPORT_C_INCLUDE_DIRS := $(LOCAL_PATH)/include
 
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/include
+LOCAL_C_INCLUDES += $(TOP)/hardware/samsung_slsi/graphics/base/include
 
 LOCAL_SRC_FILES := libscaler.cpp libscaler-v4l2.cpp libscalerblend-v4l2.cpp libscaler-m2m1shot.cpp libscaler-swscaler.cpp
 ifeq ($(BOARD_USES_SCALER_M2M1SHOT), true)
@@ -44,3 +45,5 @@ ifeq ($(BOARD_USES_VENDORIMAGE), true)
 endif
 
 include $(BUILD_SHARED_LIBRARY)
+
+include $(LOCAL_PATH)/test/Android.mk
@@ -99,6 +99,16 @@ enum colorspace {
     COLORSPACE_SRGB,
 };
 
+/* filter of the software scaler that runs when the hardware cannot take a job */
+enum SC_SW_FILTER {
+    /* legacy per-pixel nearest neighbour loop */
+    SC_SW_FILTER_NEAREST_LEGACY,
+    /* row-hoisted, 16-pixel block nearest neighbour */
+    SC_SW_FILTER_NEAREST,
+    /* 8-bit fixed-point bilinear */
+    SC_SW_FILTER_BILINEAR,
+};
+
 struct CSC_Spec{
 	uint32_t enable;    // set 'true' for user-defined
 	enum colorspace space;
@@ -425,6 +435,44 @@ int exynos_sc_set_rotation(
 void exynos_sc_set_framerate(
         void *handle,
         int framerate);
+
+/*!
+ * Set the filter of the software scaler (optional).
+ *
+ * \ingroup exynos_scaler
+ *
+ * \param handle
+ *   libscaler handle[in]
+ *
+ * \param sw_filter
+ *   one of enum SC_SW_FILTER[in]
+ *
+ * \return
+ *   error code
+ */
+int exynos_sc_set_sw_filter(
+        void *handle,
+        unsigned int sw_filter);
+
+/*!
+ * Set the number of threads of the software scaler (optional).
+ * The destination image is split into horizontal bands and the bands are
+ * processed by a pool of worker threads shared in the process.
+ *
+ * \ingroup exynos_scaler
+ *
+ * \param handle
+ *   libscaler handle[in]
+ *
+ * \param sw_workers
+ *   number of threads including the caller. 0 for the default[in]
+ *
+ * \return
+ *   error code
+ */
+int exynos_sc_set_sw_workers(
+        void *handle,
+        unsigned int sw_workers);
 ////// non-blocking /////
 
 void *exynos_sc_create_exclusive(
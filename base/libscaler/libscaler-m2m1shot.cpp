@@ -79,7 +79,7 @@ const static PixFormat g_pixfmt_table[] = {
 };
 
 
-CScalerM2M1SHOT::CScalerM2M1SHOT(int devid, int __UNUSED__ drm) : m_iFD(-1)
+CScalerM2M1SHOT::CScalerM2M1SHOT(int devid, int __UNUSED__ drm) : m_iFD(-1), m_swFilter(SC_SW_FILTER_NEAREST), m_swWorkers(0)
 {
     memset(&m_task, 0, sizeof(m_task));
 
@@ -116,6 +116,10 @@ bool CScalerM2M1SHOT::Run()
 
     ret = ioctl(m_iFD, M2M1SHOT_IOC_PROCESS, &m_task);
     if (ret < 0) {
+        if (errno == EINVAL) {
+            SC_LOGI("H/W Scaler refused the job. Trying S/W Scaler instead");
+            return RunSWScaling();
+        }
         SC_LOGERR("Failed to process the given M2M1SHOT task");
         return false;
     }
@@ -262,18 +266,45 @@ static void PutBuffer(m2m1shot_buffer &buf, char *addr[])
     }
 }
 
-bool CScalerM2M1SHOT::RunSWScaling()
+CScalerSW *CScalerM2M1SHOT::CreateSWConverter(char *src[], char *dst[])
 {
-    if (m_task.fmt_cap.fmt != m_task.fmt_out.fmt) {
-        SC_LOGE("Source and target image format must be the same");
-        return false;
+    if (!CScalerSW_Generic::IsSupported(m_task.fmt_out.fmt) ||
+            !CScalerSW_Generic::IsSupported(m_task.fmt_cap.fmt)) {
+        SC_LOGE("Format %#x -> %#x is not supported", m_task.fmt_out.fmt, m_task.fmt_cap.fmt);
+        return NULL;
     }
 
-    if (m_task.op.rotate != 0) {
-        SC_LOGE("Rotation is not allowed for S/W Scaling");
-        return false;
+    if (!GetBuffer(m_task.buf_out, src))
+        return NULL;
+
+    if (!GetBuffer(m_task.buf_cap, dst)) {
+        PutBuffer(m_task.buf_out, src);
+        return NULL;
+    }
+
+    CScalerSW_Generic *swsc = new CScalerSW_Generic(m_task.fmt_out.fmt, src, m_task.fmt_out.height,
+                                                    m_task.fmt_cap.fmt, dst, m_task.fmt_cap.height);
+    if (swsc == NULL) {
+        SC_LOGE("Failed to allocate SW Scaler");
+        PutBuffer(m_task.buf_out, src);
+        PutBuffer(m_task.buf_cap, dst);
+        return NULL;
     }
 
+    swsc->SetRotation(m_task.op.rotate, !!(m_task.op.op & M2M1SHOT_OP_FLIP_HORI),
+                      !!(m_task.op.op & M2M1SHOT_OP_FLIP_VIRT));
+    swsc->SetCSC((m_task.op.op & M2M1SHOT_OP_CSC_709) ? V4L2_COLORSPACE_REC709 : V4L2_COLORSPACE_SMPTE170M,
+                 !!(m_task.op.op & M2M1SHOT_OP_CSC_WIDE));
+
+    return swsc;
+}
+
+bool CScalerM2M1SHOT::RunSWScaling()
+{
+    // format conversion, rotation and flip are only supported by the generic S/W scaler
+    bool convert = (m_task.fmt_cap.fmt != m_task.fmt_out.fmt) || (m_task.op.rotate != 0) ||
+                   (m_task.op.op & (M2M1SHOT_OP_FLIP_HORI | M2M1SHOT_OP_FLIP_VIRT));
+
     SC_LOGI("Running S/W Scaler: %dx%d -> %dx%d",
             m_task.fmt_out.crop.width, m_task.fmt_out.crop.height,
             m_task.fmt_cap.crop.width, m_task.fmt_cap.crop.height);
@@ -281,7 +312,7 @@ bool CScalerM2M1SHOT::RunSWScaling()
     CScalerSW *swsc;
     char *src[3], *dst[3];
 
-    switch (m_task.fmt_cap.fmt) {
+    switch (convert ? 0 : m_task.fmt_cap.fmt) {
         case V4L2_PIX_FMT_YUYV:
         case V4L2_PIX_FMT_YVYU:
             if (!GetBuffer(m_task.buf_out, src))
@@ -314,10 +345,11 @@ bool CScalerM2M1SHOT::RunSWScaling()
 
             swsc = new CScalerSW_NV12(src[0], src[1], dst[0], dst[1]);
             break;
-        case V4L2_PIX_FMT_UYVY: // TODO: UYVY is not implemented yet.
         default:
-            SC_LOGE("Format %x is not supported", m_task.fmt_out.fmt);
-            return false;
+            swsc = CreateSWConverter(src, dst);
+            if (swsc == NULL)
+                return false;
+            break;
     }
 
     if (swsc == NULL) {
@@ -335,8 +367,18 @@ bool CScalerM2M1SHOT::RunSWScaling()
             m_task.fmt_cap.crop.width, m_task.fmt_cap.crop.height,
             m_task.fmt_cap.width);
 
+    swsc->SetFilter(m_swFilter);
+    if (m_swWorkers > 0)
+        swsc->SetWorkers(m_swWorkers);
+
     bool ret = swsc->Scale();
 
+#ifdef SC_DEBUG
+    for (auto &band : swsc->GetBandTimes())
+        SC_LOGD("S/W Scaler: plane %u rows [%u, %u) took %u usec",
+                band.plane, band.top, band.bottom, band.usec);
+#endif
+
     delete swsc;
 
     PutBuffer(m_task.buf_out, src);
@@ -30,9 +30,13 @@
 
 #include "m2m1shot.h"
 
+class CScalerSW;
+
 class CScalerM2M1SHOT {
     int m_iFD;
     m2m1shot m_task;
+    unsigned int m_swFilter;
+    unsigned int m_swWorkers;
 
     bool SetFormat(m2m1shot_pix_format &fmt, m2m1shot_buffer &buf,
                    unsigned int width, unsigned int height, unsigned int v4l2_fmt);
@@ -40,6 +44,7 @@ class CScalerM2M1SHOT {
                    unsigned int l, unsigned int t, unsigned int w, unsigned int h);
     bool SetAddr(m2m1shot_buffer &buf, void *addr[SC_NUM_OF_PLANES], int mem_type);
 
+    CScalerSW *CreateSWConverter(char *src[], char *dst[]);
     bool RunSWScaling();
 public:
     CScalerM2M1SHOT(int devid, int allow_drm = 0);
@@ -98,6 +103,14 @@ public:
         m_task.reserved[0] = (unsigned long)framerate;
     }
 
+    inline void SetSWFilter(unsigned int sw_filter) {
+        m_swFilter = sw_filter;
+    }
+
+    inline void SetSWWorkers(unsigned int sw_workers) {
+        m_swWorkers = sw_workers;
+    }
+
     /* No effect in M2M1SHOT */
     inline void SetDRM(bool __UNUSED__ drm) { }
     inline void SetSrcPremultiplied(bool __UNUSED__ premultiplied) { }
@@ -1,5 +1,710 @@
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include <linux/videodev2.h>
+
+#include <exynos_worker_pool.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SWSC_USE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SWSC_USE_SSE2
+#endif
+
 #include "libscaler-swscaler.h"
 
+#ifndef V4L2_PIX_FMT_NV12M_P010
+#define V4L2_PIX_FMT_NV12M_P010         v4l2_fourcc('P', 'M', '1', '2')
+#endif
+#ifndef V4L2_PIX_FMT_NV21M_P010
+#define V4L2_PIX_FMT_NV21M_P010         v4l2_fourcc('P', 'M', '2', '1')
+#endif
+#ifndef V4L2_PIX_FMT_NV12_P010
+#define V4L2_PIX_FMT_NV12_P010          v4l2_fourcc('P', 'N', '1', '2')
+#endif
+#ifndef V4L2_PIX_FMT_ABGR2101010
+#define V4L2_PIX_FMT_ABGR2101010        v4l2_fourcc('A', 'R', '1', '0')
+#endif
+
+/*
+ * Fixed-point kernels of the software scaler.
+ *
+ * Coordinates are in 16.16 fixed point and the bilinear weights are reduced
+ * to 8 bits so that a weighted sum of two 8-bit samples fits in 16 bits:
+ *     out = (a * (256 - w) + b * w + 128) >> 8
+ * Rows are processed in blocks of SWSC_BLOCK elements. The horizontal source
+ * offsets and weights are computed once per plane instead of per pixel and
+ * the source row pointers are computed once per destination row.
+ */
+#define SWSC_BLOCK 16
+// minimum number of rows of a band not to waste the dispatch overhead for tiny bands
+#define SWSC_MIN_BAND_ROWS 32
+
+namespace {
+
+// out[i] = lerp(a[i], b[i], w[i]) for SWSC_BLOCK samples
+static inline void LerpBlock(const uint8_t *a, const uint8_t *b, const uint16_t *w, uint8_t *out)
+{
+#if defined(SWSC_USE_NEON)
+    uint8x16_t va = vld1q_u8(a);
+    uint8x16_t vb = vld1q_u8(b);
+    uint16x8_t w0 = vld1q_u16(w);
+    uint16x8_t w1 = vld1q_u16(w + 8);
+    uint16x8_t k256 = vdupq_n_u16(256);
+
+    uint16x8_t lo = vmulq_u16(vmovl_u8(vget_low_u8(va)), vsubq_u16(k256, w0));
+    uint16x8_t hi = vmulq_u16(vmovl_u8(vget_high_u8(va)), vsubq_u16(k256, w1));
+    lo = vmlaq_u16(lo, vmovl_u8(vget_low_u8(vb)), w0);
+    hi = vmlaq_u16(hi, vmovl_u8(vget_high_u8(vb)), w1);
+
+    vst1q_u8(out, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+#elif defined(SWSC_USE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i k256 = _mm_set1_epi16(256);
+    const __m128i k128 = _mm_set1_epi16(128);
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+    __m128i w0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(w));
+    __m128i w1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(w + 8));
+
+    __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), _mm_sub_epi16(k256, w0));
+    __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), _mm_sub_epi16(k256, w1));
+    lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), w0));
+    hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), w1));
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, k128), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, k128), 8);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(lo, hi));
+#else
+    for (unsigned int i = 0; i < SWSC_BLOCK; i++)
+        out[i] = static_cast<uint8_t>((a[i] * (256 - w[i]) + b[i] * w[i] + 128) >> 8);
+#endif
+}
+
+// out[i] = lerp(a[i], b[i], w) for len samples
+static void LerpRow(const uint8_t *a, const uint8_t *b, uint16_t w, uint8_t *out, unsigned int len)
+{
+    uint16_t wv[SWSC_BLOCK];
+    unsigned int i = 0;
+
+    for (unsigned int k = 0; k < SWSC_BLOCK; k++)
+        wv[k] = w;
+
+    for (; (i + SWSC_BLOCK) <= len; i += SWSC_BLOCK)
+        LerpBlock(a + i, b + i, wv, out + i);
+
+    for (; i < len; i++)
+        out[i] = static_cast<uint8_t>((a[i] * (256 - w) + b[i] * w + 128) >> 8);
+}
+
+// returns 16.16 position of the first tap of dst element @i
+static inline unsigned int Position(unsigned int i, unsigned int ratio, bool bilinear)
+{
+    if (!bilinear)
+        return i * ratio;
+    // sample at the center of the destination element
+    unsigned int pos = i * ratio + ratio / 2;
+    return (pos > 0x8000) ? pos - 0x8000 : 0;
+}
+
+/*
+ * Description of a plane to scale. An element is the unit of the coordinates
+ * (a pixel of Y, a CbCr pair of NV12 or a macro pixel of YUYV). Each element
+ * has @nchan samples at the byte offsets @chan from the start of the element.
+ */
+struct SWScalePlane {
+    const uint8_t *src;
+    unsigned int src_pitch;     // in bytes
+    unsigned int src_x, src_y, src_w, src_h; // in elements
+    uint8_t *dst;
+    unsigned int dst_pitch;     // in bytes
+    unsigned int dst_x, dst_y, dst_w, dst_h; // in elements
+    unsigned int step;          // bytes between two elements in a row
+    unsigned int nchan;
+    unsigned int chan[2];
+    bool rowcopy;               // a row of this plane can be copied with memcpy()
+};
+
+class SWPlaneScaler {
+    const SWScalePlane &mPlane;
+    bool mBilinear;
+    unsigned int mRowBytes;     // bytes of the source span of a row
+    std::vector<unsigned int> mX0; // byte offset of the left tap from the span
+    std::vector<unsigned int> mX1; // byte offset of the right tap from the span
+    std::vector<uint16_t> mWx;
+
+    template <unsigned int NCHAN>
+    void RowNearest(const uint8_t *srow, uint8_t *drow) const;
+    template <unsigned int NCHAN>
+    void RowBilinear(const uint8_t *srow, uint8_t *drow) const;
+    void Row(const uint8_t *srow, uint8_t *drow) const;
+public:
+    SWPlaneScaler(const SWScalePlane &plane, bool bilinear);
+
+    // scale the destination rows in [begin, end)
+    void Run(unsigned int begin, unsigned int end) const;
+};
+
+SWPlaneScaler::SWPlaneScaler(const SWScalePlane &plane, bool bilinear)
+    : mPlane(plane), mBilinear(bilinear), mRowBytes(plane.src_w * plane.step),
+      mX0(plane.dst_w), mX1(plane.dst_w), mWx(plane.dst_w)
+{
+    unsigned int ratio = (plane.src_w << 16) / plane.dst_w;
+    unsigned int last = plane.src_w - 1;
+
+    for (unsigned int i = 0; i < plane.dst_w; i++) {
+        unsigned int pos = Position(i, ratio, bilinear);
+        unsigned int x0 = LibScaler::min(pos >> 16, last);
+        unsigned int x1 = LibScaler::min(x0 + 1, last);
+
+        mX0[i] = x0 * plane.step;
+        mX1[i] = x1 * plane.step;
+        mWx[i] = bilinear ? static_cast<uint16_t>((pos >> 8) & 0xFF) : 0;
+    }
+}
+
+template <unsigned int NCHAN>
+void SWPlaneScaler::RowNearest(const uint8_t *srow, uint8_t *drow) const
+{
+    const unsigned int *x0 = mX0.data();
+    unsigned int dstep = mPlane.step;
+    unsigned int count = mPlane.dst_w;
+    unsigned int i = 0;
+
+    for (; (i + SWSC_BLOCK) <= count; i += SWSC_BLOCK, drow += dstep * SWSC_BLOCK) {
+        for (unsigned int k = 0; k < SWSC_BLOCK; k++)
+            for (unsigned int c = 0; c < NCHAN; c++)
+                drow[k * dstep + mPlane.chan[c]] = srow[x0[i + k] + mPlane.chan[c]];
+    }
+
+    for (; i < count; i++, drow += dstep)
+        for (unsigned int c = 0; c < NCHAN; c++)
+            drow[mPlane.chan[c]] = srow[x0[i] + mPlane.chan[c]];
+}
+
+template <unsigned int NCHAN>
+void SWPlaneScaler::RowBilinear(const uint8_t *srow, uint8_t *drow) const
+{
+    const unsigned int *x0 = mX0.data();
+    const unsigned int *x1 = mX1.data();
+    const uint16_t *wx = mWx.data();
+    unsigned int dstep = mPlane.step;
+    unsigned int count = mPlane.dst_w;
+    unsigned int i = 0;
+
+    for (; (i + SWSC_BLOCK) <= count; i += SWSC_BLOCK, drow += dstep * SWSC_BLOCK) {
+        for (unsigned int c = 0; c < NCHAN; c++) {
+            uint8_t a[SWSC_BLOCK], b[SWSC_BLOCK], out[SWSC_BLOCK];
+            unsigned int off = mPlane.chan[c];
+
+            for (unsigned int k = 0; k < SWSC_BLOCK; k++) {
+                a[k] = srow[x0[i + k] + off];
+                b[k] = srow[x1[i + k] + off];
+            }
+
+            LerpBlock(a, b, wx + i, out);
+
+            for (unsigned int k = 0; k < SWSC_BLOCK; k++)
+                drow[k * dstep + off] = out[k];
+        }
+    }
+
+    for (; i < count; i++, drow += dstep) {
+        for (unsigned int c = 0; c < NCHAN; c++) {
+            unsigned int off = mPlane.chan[c];
+            drow[off] = static_cast<uint8_t>((srow[x0[i] + off] * (256 - wx[i]) +
+                                              srow[x1[i] + off] * wx[i] + 128) >> 8);
+        }
+    }
+}
+
+void SWPlaneScaler::Row(const uint8_t *srow, uint8_t *drow) const
+{
+    if (mPlane.rowcopy && (mPlane.src_w == mPlane.dst_w)) {
+        memcpy(drow, srow, mRowBytes);
+        return;
+    }
+
+    if (mBilinear) {
+        if (mPlane.nchan == 1)
+            RowBilinear<1>(srow, drow);
+        else
+            RowBilinear<2>(srow, drow);
+    } else {
+        if (mPlane.nchan == 1)
+            RowNearest<1>(srow, drow);
+        else
+            RowNearest<2>(srow, drow);
+    }
+}
+
+void SWPlaneScaler::Run(unsigned int begin, unsigned int end) const
+{
+    const SWScalePlane &p = mPlane;
+    unsigned int ratio = (p.src_h << 16) / p.dst_h;
+    unsigned int last = p.src_h - 1;
+    const uint8_t *sbase = p.src + p.src_y * p.src_pitch + p.src_x * p.step;
+    uint8_t *dbase = p.dst + p.dst_y * p.dst_pitch + p.dst_x * p.step;
+    // source row blended vertically that is reused while the destination rows
+    // fall on the same source position
+    std::vector<uint8_t> blend;
+    unsigned int blend_y = ~0U, blend_w = ~0U;
+    unsigned int prev_y = ~0U, prev_w = ~0U;
+    uint8_t *prev_drow = NULL;
+
+    if (mBilinear)
+        blend.resize(mRowBytes);
+
+    for (unsigned int y = begin; y < end; y++) {
+        unsigned int pos = Position(y, ratio, mBilinear);
+        unsigned int y0 = LibScaler::min(pos >> 16, last);
+        uint16_t wy = mBilinear ? static_cast<uint16_t>((pos >> 8) & 0xFF) : 0;
+        const uint8_t *srow = sbase + y0 * p.src_pitch;
+        uint8_t *drow = dbase + y * p.dst_pitch;
+
+        if ((wy != 0) && (y0 < last)) {
+            if ((blend_y != y0) || (blend_w != wy)) {
+                LerpRow(srow, srow + p.src_pitch, wy, blend.data(), mRowBytes);
+                blend_y = y0;
+                blend_w = wy;
+            }
+            srow = blend.data();
+        }
+
+        if (p.rowcopy && (y0 == prev_y) && (wy == prev_w)) {
+            memcpy(drow, prev_drow, p.dst_w * p.step);
+        } else {
+            Row(srow, drow);
+            prev_y = y0;
+            prev_w = wy;
+            prev_drow = drow;
+        }
+    }
+}
+
+/*
+ * Scale @count planes with @workers threads. The destination rows of every
+ * plane are split into horizontal bands so that the bands of different planes
+ * (e.g. luma and chroma) also run concurrently.
+ */
+static void ScalePlanes(const SWScalePlane *planes, unsigned int count, bool bilinear,
+                        unsigned int workers, std::vector<CScalerSW::BandTime> &times)
+{
+    std::vector<SWPlaneScaler> scalers;
+    std::vector<std::function<void()>> tasks;
+
+    scalers.reserve(count);
+    for (unsigned int i = 0; i < count; i++)
+        scalers.emplace_back(planes[i], bilinear);
+
+    times.clear();
+    for (unsigned int i = 0; i < count; i++) {
+        unsigned int height = planes[i].dst_h;
+        unsigned int bands = (workers > 1) ? workers : 1;
+        unsigned int rows;
+
+        // twice as many bands as workers for load balancing between the planes
+        if (workers > 1)
+            bands *= 2;
+        rows = (height + bands - 1) / bands;
+        if ((workers > 1) && (rows < SWSC_MIN_BAND_ROWS))
+            rows = SWSC_MIN_BAND_ROWS;
+
+        for (unsigned int top = 0; top < height; top += rows)
+            times.push_back({i, top, LibScaler::min(top + rows, height), 0});
+    }
+
+    for (auto &b : times) {
+        CScalerSW::BandTime *pband = &b;
+        tasks.push_back([&scalers, pband] {
+            CScalerSW::BandTime &band = *pband;
+            auto begin = std::chrono::steady_clock::now();
+
+            scalers[band.plane].Run(band.top, band.bottom);
+
+            band.usec = static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - begin).count());
+        });
+    }
+
+    if (workers > 1) {
+        ExynosWorkerPool::getInstance().run(tasks, workers);
+    } else {
+        for (auto &task : tasks)
+            task();
+    }
+}
+
+/*
+ * Memory layout of the formats supported by CScalerSW_Generic.
+ * The meaning of @order depends on @layout:
+ *  - SWFMT_RGB32, SWFMT_RGB24: byte offsets of R, G, B and A in a pixel
+ *  - SWFMT_YUV422I: byte offsets of Y0, U, Y1 and V in a macro pixel
+ *  - SWFMT_YUV_SP: sample offsets of U and V in a chroma pair
+ *  - SWFMT_YUV_P: plane indices of U and V
+ */
+enum {
+    SWFMT_RGB32,
+    SWFMT_RGB24,
+    SWFMT_RGB565,
+    SWFMT_RGB1010102,
+    SWFMT_YUV422I,
+    SWFMT_YUV_SP,
+    SWFMT_YUV_P,
+};
+
+#define SWFMT_NO_ALPHA 0xFF
+
+struct SWFormat {
+    unsigned int fourcc;
+    unsigned int layout;
+    unsigned int hsub, vsub;    // chroma subsampling factors
+    unsigned int sample;        // bytes per sample of YUV planes
+    unsigned int buffers;       // number of memory buffers
+    unsigned char order[4];
+};
+
+// The interpretation of the RGB formats follows the HAL to V4L2 tables of libacryl.
+static const SWFormat sw_formats[] = {
+    {V4L2_PIX_FMT_ABGR32,           SWFMT_RGB32,      1, 1, 1, 1, {0, 1, 2, 3}},              // RGBA_8888
+    {V4L2_PIX_FMT_XBGR32,           SWFMT_RGB32,      1, 1, 1, 1, {0, 1, 2, SWFMT_NO_ALPHA}}, // RGBX_8888
+    {V4L2_PIX_FMT_ARGB32,           SWFMT_RGB32,      1, 1, 1, 1, {2, 1, 0, 3}},              // BGRA_8888
+    {V4L2_PIX_FMT_RGB32,            SWFMT_RGB32,      1, 1, 1, 1, {0, 1, 2, 3}},
+    {V4L2_PIX_FMT_BGR32,            SWFMT_RGB32,      1, 1, 1, 1, {2, 1, 0, 3}},
+    {V4L2_PIX_FMT_RGB24,            SWFMT_RGB24,      1, 1, 1, 1, {0, 1, 2, SWFMT_NO_ALPHA}},
+    {V4L2_PIX_FMT_RGB565,           SWFMT_RGB565,     1, 1, 1, 1, {0, 0, 0, SWFMT_NO_ALPHA}},
+    {V4L2_PIX_FMT_ABGR2101010,      SWFMT_RGB1010102, 1, 1, 1, 1, {0, 0, 0, 0}},              // RGBA_1010102
+    {V4L2_PIX_FMT_YUYV,             SWFMT_YUV422I,    2, 1, 1, 1, {0, 1, 2, 3}},
+    {V4L2_PIX_FMT_YVYU,             SWFMT_YUV422I,    2, 1, 1, 1, {0, 3, 2, 1}},
+    {V4L2_PIX_FMT_UYVY,             SWFMT_YUV422I,    2, 1, 1, 1, {1, 0, 3, 2}},
+    {V4L2_PIX_FMT_VYUY,             SWFMT_YUV422I,    2, 1, 1, 1, {1, 2, 3, 0}},
+    {V4L2_PIX_FMT_NV12,             SWFMT_YUV_SP,     2, 2, 1, 1, {0, 1, 0, 0}},
+    {V4L2_PIX_FMT_NV21,             SWFMT_YUV_SP,     2, 2, 1, 1, {1, 0, 0, 0}},
+    {V4L2_PIX_FMT_NV12M,            SWFMT_YUV_SP,     2, 2, 1, 2, {0, 1, 0, 0}},
+    {V4L2_PIX_FMT_NV21M,            SWFMT_YUV_SP,     2, 2, 1, 2, {1, 0, 0, 0}},
+    {V4L2_PIX_FMT_NV16,             SWFMT_YUV_SP,     2, 1, 1, 1, {0, 1, 0, 0}},
+    {V4L2_PIX_FMT_NV61,             SWFMT_YUV_SP,     2, 1, 1, 1, {1, 0, 0, 0}},
+    {V4L2_PIX_FMT_NV16M,            SWFMT_YUV_SP,     2, 1, 1, 2, {0, 1, 0, 0}},
+    {V4L2_PIX_FMT_NV61M,            SWFMT_YUV_SP,     2, 1, 1, 2, {1, 0, 0, 0}},
+    {V4L2_PIX_FMT_NV12_P010,        SWFMT_YUV_SP,     2, 2, 2, 1, {0, 1, 0, 0}},
+    {V4L2_PIX_FMT_NV12M_P010,       SWFMT_YUV_SP,     2, 2, 2, 2, {0, 1, 0, 0}},
+    {V4L2_PIX_FMT_NV21M_P010,       SWFMT_YUV_SP,     2, 2, 2, 2, {1, 0, 0, 0}},
+    {V4L2_PIX_FMT_YUV420,           SWFMT_YUV_P,      2, 2, 1, 1, {1, 2, 0, 0}},
+    {V4L2_PIX_FMT_YVU420,           SWFMT_YUV_P,      2, 2, 1, 1, {2, 1, 0, 0}},          // YV12
+    {V4L2_PIX_FMT_YUV420M,          SWFMT_YUV_P,      2, 2, 1, 3, {1, 2, 0, 0}},
+    {V4L2_PIX_FMT_YVU420M,          SWFMT_YUV_P,      2, 2, 1, 3, {2, 1, 0, 0}},
+};
+
+static const SWFormat *FindFormat(unsigned int fourcc)
+{
+    for (size_t i = 0; i < ARRSIZE(sw_formats); i++)
+        if (sw_formats[i].fourcc == fourcc)
+            return &sw_formats[i];
+    return NULL;
+}
+
+static inline bool IsYUV(const SWFormat *fmt)
+{
+    return fmt->layout >= SWFMT_YUV422I;
+}
+
+// plane addresses and pitches of an image of @fmt
+struct SWImage {
+    uint8_t *plane[3];
+    unsigned int pitch[3];
+    unsigned int nplanes;
+
+    SWImage(const SWFormat *fmt, char *addr[3], unsigned int width, unsigned int height) {
+        unsigned int rows[3] = {height, height / fmt->vsub, height / fmt->vsub};
+
+        switch (fmt->layout) {
+        case SWFMT_RGB32:
+        case SWFMT_RGB1010102:
+            pitch[0] = width * 4;
+            nplanes = 1;
+            break;
+        case SWFMT_RGB24:
+            pitch[0] = width * 3;
+            nplanes = 1;
+            break;
+        case SWFMT_RGB565:
+        case SWFMT_YUV422I:
+            pitch[0] = width * 2;
+            nplanes = 1;
+            break;
+        case SWFMT_YUV_SP:
+            pitch[0] = width * fmt->sample;
+            pitch[1] = (width / fmt->hsub) * 2 * fmt->sample;
+            nplanes = 2;
+            break;
+        default: // SWFMT_YUV_P
+            pitch[0] = width * fmt->sample;
+            pitch[1] = (width / fmt->hsub) * fmt->sample;
+            pitch[2] = pitch[1];
+            nplanes = 3;
+            break;
+        }
+
+        for (unsigned int i = 0; i < nplanes; i++) {
+            if (i < fmt->buffers)
+                plane[i] = reinterpret_cast<uint8_t *>(addr[i]);
+            else
+                plane[i] = plane[i - 1] + pitch[i - 1] * rows[i - 1];
+        }
+    }
+
+    unsigned long size(unsigned int i, const SWFormat *fmt, unsigned int height) const {
+        return static_cast<unsigned long>(pitch[i]) * ((i == 0) ? height : height / fmt->vsub);
+    }
+};
+
+static inline uint8_t LoadSample(const uint8_t *p, unsigned int sample)
+{
+    // P010 keeps 10 bits in the MSB of 16 bits in little endian
+    return (sample == 2) ? p[1] : p[0];
+}
+
+static inline void StoreSample(uint8_t *p, unsigned int sample, unsigned int v)
+{
+    if (sample == 2) {
+        unsigned int v16 = ((v << 2) | (v >> 6)) << 6;
+        p[0] = static_cast<uint8_t>(v16);
+        p[1] = static_cast<uint8_t>(v16 >> 8);
+    } else {
+        p[0] = static_cast<uint8_t>(v);
+    }
+}
+
+// decodes the pixels [left, left + width) of row @y of @img to 4 channels in @out
+static void DecodeRow(const SWFormat *fmt, const SWImage &img, unsigned int left,
+                      unsigned int width, unsigned int y, uint8_t *out)
+{
+    const uint8_t *row = img.plane[0] + y * img.pitch[0];
+
+    for (unsigned int x = left; x < left + width; x++, out += 4) {
+        switch (fmt->layout) {
+        case SWFMT_RGB32:
+        case SWFMT_RGB24: {
+            const uint8_t *px = row + x * ((fmt->layout == SWFMT_RGB32) ? 4 : 3);
+            out[0] = px[fmt->order[0]];
+            out[1] = px[fmt->order[1]];
+            out[2] = px[fmt->order[2]];
+            out[3] = (fmt->order[3] == SWFMT_NO_ALPHA) ? 0xFF : px[fmt->order[3]];
+            break;
+        }
+        case SWFMT_RGB565: {
+            unsigned int v = row[x * 2] | (row[x * 2 + 1] << 8);
+            out[0] = static_cast<uint8_t>(((v >> 11) << 3) | (v >> 13));
+            out[1] = static_cast<uint8_t>((((v >> 5) & 0x3F) << 2) | ((v >> 9) & 0x3));
+            out[2] = static_cast<uint8_t>(((v & 0x1F) << 3) | ((v >> 2) & 0x7));
+            out[3] = 0xFF;
+            break;
+        }
+        case SWFMT_RGB1010102: {
+            const uint8_t *px = row + x * 4;
+            unsigned int v = px[0] | (px[1] << 8) | (px[2] << 16) | (px[3] << 24);
+            out[0] = static_cast<uint8_t>((v >> 2) & 0xFF);
+            out[1] = static_cast<uint8_t>((v >> 12) & 0xFF);
+            out[2] = static_cast<uint8_t>((v >> 22) & 0xFF);
+            out[3] = static_cast<uint8_t>((v >> 30) * 0x55);
+            break;
+        }
+        case SWFMT_YUV422I: {
+            const uint8_t *mp = row + (x / 2) * 4;
+            out[0] = mp[fmt->order[(x & 1) ? 2 : 0]];
+            out[1] = mp[fmt->order[1]];
+            out[2] = mp[fmt->order[3]];
+            out[3] = 0xFF;
+            break;
+        }
+        case SWFMT_YUV_SP: {
+            const uint8_t *c = img.plane[1] + (y / fmt->vsub) * img.pitch[1] +
+                               (x / fmt->hsub) * 2 * fmt->sample;
+            out[0] = LoadSample(row + x * fmt->sample, fmt->sample);
+            out[1] = LoadSample(c + fmt->order[0] * fmt->sample, fmt->sample);
+            out[2] = LoadSample(c + fmt->order[1] * fmt->sample, fmt->sample);
+            out[3] = 0xFF;
+            break;
+        }
+        default: { // SWFMT_YUV_P
+            unsigned int cy = y / fmt->vsub;
+            unsigned int cx = (x / fmt->hsub) * fmt->sample;
+            out[0] = LoadSample(row + x * fmt->sample, fmt->sample);
+            out[1] = LoadSample(img.plane[fmt->order[0]] + cy * img.pitch[fmt->order[0]] + cx, fmt->sample);
+            out[2] = LoadSample(img.plane[fmt->order[1]] + cy * img.pitch[fmt->order[1]] + cx, fmt->sample);
+            out[3] = 0xFF;
+            break;
+        }
+        }
+    }
+}
+
+// packs 4-channel pixels of @rows rows from @in at (@left, @top) of @img
+static void EncodeRows(const SWFormat *fmt, SWImage &img, unsigned int left, unsigned int top,
+                       unsigned int width, unsigned int rows, const uint8_t *in)
+{
+    unsigned int in_pitch = width * 4;
+
+    for (unsigned int r = 0; r < rows; r++) {
+        const uint8_t *px = in + r * in_pitch;
+        uint8_t *row = img.plane[0] + (top + r) * img.pitch[0];
+
+        for (unsigned int x = left; x < left + width; x++, px += 4) {
+            switch (fmt->layout) {
+            case SWFMT_RGB32:
+            case SWFMT_RGB24: {
+                uint8_t *out = row + x * ((fmt->layout == SWFMT_RGB32) ? 4 : 3);
+                out[fmt->order[0]] = px[0];
+                out[fmt->order[1]] = px[1];
+                out[fmt->order[2]] = px[2];
+                if (fmt->order[3] != SWFMT_NO_ALPHA)
+                    out[fmt->order[3]] = px[3];
+                else if (fmt->layout == SWFMT_RGB32)
+                    out[3] = 0xFF;
+                break;
+            }
+            case SWFMT_RGB565: {
+                unsigned int v = ((px[0] >> 3) << 11) | ((px[1] >> 2) << 5) | (px[2] >> 3);
+                row[x * 2] = static_cast<uint8_t>(v);
+                row[x * 2 + 1] = static_cast<uint8_t>(v >> 8);
+                break;
+            }
+            case SWFMT_RGB1010102: {
+                unsigned int v = ((px[0] << 2) | (px[0] >> 6)) |
+                                 (((px[1] << 2) | (px[1] >> 6)) << 10) |
+                                 (((px[2] << 2) | (px[2] >> 6)) << 20) |
+                                 ((px[3] >> 6) << 30);
+                uint8_t *out = row + x * 4;
+                out[0] = static_cast<uint8_t>(v);
+                out[1] = static_cast<uint8_t>(v >> 8);
+                out[2] = static_cast<uint8_t>(v >> 16);
+                out[3] = static_cast<uint8_t>(v >> 24);
+                break;
+            }
+            case SWFMT_YUV422I:
+                row[(x / 2) * 4 + fmt->order[(x & 1) ? 2 : 0]] = px[0];
+                break;
+            default: // SWFMT_YUV_SP, SWFMT_YUV_P
+                StoreSample(row + x * fmt->sample, fmt->sample, px[0]);
+                break;
+            }
+        }
+    }
+
+    if (!IsYUV(fmt))
+        return;
+
+    // chroma is the average of the hsub x vsub pixels sharing the same chroma sample
+    for (unsigned int r = 0; r < rows; r += fmt->vsub) {
+        const uint8_t *px = in + r * in_pitch;
+        unsigned int cy = (top + r) / fmt->vsub;
+        unsigned int div = fmt->hsub * fmt->vsub;
+
+        for (unsigned int x = 0; x < width; x += fmt->hsub) {
+            unsigned int u = 0, v = 0;
+
+            for (unsigned int j = 0; j < fmt->vsub; j++) {
+                for (unsigned int i = 0; i < fmt->hsub; i++) {
+                    u += px[j * in_pitch + (x + i) * 4 + 1];
+                    v += px[j * in_pitch + (x + i) * 4 + 2];
+                }
+            }
+            u = (u + div / 2) / div;
+            v = (v + div / 2) / div;
+
+            unsigned int cx = (left + x) / fmt->hsub;
+
+            if (fmt->layout == SWFMT_YUV422I) {
+                uint8_t *mp = img.plane[0] + (top + r) * img.pitch[0] + cx * 4;
+                mp[fmt->order[1]] = static_cast<uint8_t>(u);
+                mp[fmt->order[3]] = static_cast<uint8_t>(v);
+            } else if (fmt->layout == SWFMT_YUV_SP) {
+                uint8_t *c = img.plane[1] + cy * img.pitch[1] + cx * 2 * fmt->sample;
+                StoreSample(c + fmt->order[0] * fmt->sample, fmt->sample, u);
+                StoreSample(c + fmt->order[1] * fmt->sample, fmt->sample, v);
+            } else {
+                StoreSample(img.plane[fmt->order[0]] + cy * img.pitch[fmt->order[0]] + cx * fmt->sample,
+                            fmt->sample, u);
+                StoreSample(img.plane[fmt->order[1]] + cy * img.pitch[fmt->order[1]] + cx * fmt->sample,
+                            fmt->sample, v);
+            }
+        }
+    }
+}
+
+/*
+ * 3x3 color conversion matrix in 12-bit fixed point:
+ *     out[c] = ((sum(m[c][k] * (in[k] - inoff[k])) + 2048) >> 12) + outoff[c]
+ */
+struct SWColorMatrix {
+    int m[3][3];
+    int inoff[3];
+    int outoff[3];
+
+    void apply(uint8_t *px) const {
+        int in[3] = {px[0] - inoff[0], px[1] - inoff[1], px[2] - inoff[2]};
+
+        for (unsigned int c = 0; c < 3; c++) {
+            int v = ((m[c][0] * in[0] + m[c][1] * in[1] + m[c][2] * in[2] + 2048) >> 12) + outoff[c];
+            px[c] = static_cast<uint8_t>((v < 0) ? 0 : ((v > 255) ? 255 : v));
+        }
+    }
+
+    void set(const double coef[3][3], const int in[3], const int out[3]) {
+        for (unsigned int c = 0; c < 3; c++) {
+            for (unsigned int k = 0; k < 3; k++) {
+                double v = coef[c][k] * 4096.0;
+                m[c][k] = static_cast<int>((v < 0) ? (v - 0.5) : (v + 0.5));
+            }
+            inoff[c] = in[c];
+            outoff[c] = out[c];
+        }
+    }
+
+    void setYUVtoRGB(double kr, double kb, bool wide) {
+        double kg = 1.0 - kr - kb;
+        double ys = wide ? 1.0 : 255.0 / 219.0;
+        double cs = wide ? 1.0 : 255.0 / 224.0;
+        const double coef[3][3] = {
+            {ys, 0.0, cs * 2.0 * (1.0 - kr)},
+            {ys, -cs * 2.0 * kb * (1.0 - kb) / kg, -cs * 2.0 * kr * (1.0 - kr) / kg},
+            {ys, cs * 2.0 * (1.0 - kb), 0.0},
+        };
+        const int in[3] = {wide ? 0 : 16, 128, 128};
+        const int out[3] = {0, 0, 0};
+
+        set(coef, in, out);
+    }
+
+    void setRGBtoYUV(double kr, double kb, bool wide) {
+        double kg = 1.0 - kr - kb;
+        double ys = wide ? 1.0 : 219.0 / 255.0;
+        double cs = wide ? 1.0 : 224.0 / 255.0;
+        const double coef[3][3] = {
+            {ys * kr, ys * kg, ys * kb},
+            {-cs * kr / (2.0 * (1.0 - kb)), -cs * kg / (2.0 * (1.0 - kb)), cs * 0.5},
+            {cs * 0.5, -cs * kg / (2.0 * (1.0 - kr)), -cs * kb / (2.0 * (1.0 - kr))},
+        };
+        const int in[3] = {0, 0, 0};
+        const int out[3] = {wide ? 0 : 16, 128, 128};
+
+        set(coef, in, out);
+    }
+};
+
+static inline uint8_t Lerp(unsigned int a, unsigned int b, unsigned int w)
+{
+    return static_cast<uint8_t>((a * (256 - w) + b * w + 128) >> 8);
+}
+
+} // namespace
+
 void CScalerSW::Clear() {
     m_pSrc[0] = NULL;
     m_pSrc[1] = NULL;
@@ -18,6 +723,10 @@ void CScalerSW::Clear() {
     m_nDstWidth = 0;
     m_nDstHeight = 0;
     m_nDstStride = 0;
+    m_nFilter = FILTER_NEAREST;
+    m_nWorkers = LibScaler::min(static_cast<unsigned int>(DEFAULT_WORKERS),
+                                std::max(std::thread::hardware_concurrency(), 1U));
+    m_BandTimes.clear();
 }
 
 bool CScalerSW_YUYV::Scale() {
@@ -26,6 +735,50 @@ bool CScalerSW_YUYV::Scale() {
         return false;
     }
 
+    if ((m_nFilter == FILTER_NEAREST_LEGACY) || ((m_nDstLeft % 2) != 0)) {
+        m_BandTimes.clear();
+        ScaleLegacy();
+        return true;
+    }
+
+    SWScalePlane planes[2];
+    SWScalePlane &luma = planes[0];
+    SWScalePlane &chroma = planes[1];
+
+    // Y0 Cb Y1 Cr: luma is an element of 2 bytes, chroma is a macro pixel of 4 bytes
+    luma.src = reinterpret_cast<const uint8_t *>(m_pSrc[0]);
+    luma.src_pitch = m_nSrcStride * 2;
+    luma.src_x = m_nSrcLeft;
+    luma.src_y = m_nSrcTop;
+    luma.src_w = m_nSrcWidth;
+    luma.src_h = m_nSrcHeight;
+    luma.dst = reinterpret_cast<uint8_t *>(m_pDst[0]);
+    luma.dst_pitch = m_nDstStride * 2;
+    luma.dst_x = m_nDstLeft;
+    luma.dst_y = m_nDstTop;
+    luma.dst_w = m_nDstWidth;
+    luma.dst_h = m_nDstHeight;
+    luma.step = 2;
+    luma.nchan = 1;
+    luma.chan[0] = 0;
+    luma.rowcopy = false;
+
+    chroma = luma;
+    chroma.src_x /= 2;
+    chroma.src_w /= 2;
+    chroma.dst_x /= 2;
+    chroma.dst_w /= 2;
+    chroma.step = 4;
+    chroma.nchan = 2;
+    chroma.chan[0] = 1;
+    chroma.chan[1] = 3;
+
+    ScalePlanes(planes, 2, m_nFilter == FILTER_BILINEAR, m_nWorkers, m_BandTimes);
+
+    return true;
+}
+
+void CScalerSW_YUYV::ScaleLegacy() {
     unsigned int h_ratio = (m_nSrcWidth << 16) / m_nDstWidth;
     unsigned int v_ratio = (m_nSrcHeight << 16) / m_nDstHeight;
 
@@ -54,8 +807,6 @@ bool CScalerSW_YUYV::Scale() {
 
         src_y = LibScaler::min(src_y + v_ratio, (m_nSrcTop + m_nSrcHeight) << 16);
     }
-
-    return true;
 }
 
 bool CScalerSW_NV12::Scale() {
@@ -65,6 +816,55 @@ bool CScalerSW_NV12::Scale() {
         return false;
     }
 
+    if (m_nFilter == FILTER_NEAREST_LEGACY) {
+        m_BandTimes.clear();
+        ScaleLegacy();
+        return true;
+    }
+
+    SWScalePlane planes[2];
+    SWScalePlane &luma = planes[0];
+    SWScalePlane &chroma = planes[1];
+
+    luma.src = reinterpret_cast<const uint8_t *>(m_pSrc[0]);
+    luma.src_pitch = m_nSrcStride;
+    luma.src_x = m_nSrcLeft;
+    luma.src_y = m_nSrcTop;
+    luma.src_w = m_nSrcWidth;
+    luma.src_h = m_nSrcHeight;
+    luma.dst = reinterpret_cast<uint8_t *>(m_pDst[0]);
+    luma.dst_pitch = m_nDstStride;
+    luma.dst_x = m_nDstLeft;
+    luma.dst_y = m_nDstTop;
+    luma.dst_w = m_nDstWidth;
+    luma.dst_h = m_nDstHeight;
+    luma.step = 1;
+    luma.nchan = 1;
+    luma.chan[0] = 0;
+    luma.rowcopy = true;
+
+    // CbCr (or CrCb) pair is an element of the chroma plane
+    chroma = luma;
+    chroma.src = reinterpret_cast<const uint8_t *>(m_pSrc[1]);
+    chroma.dst = reinterpret_cast<uint8_t *>(m_pDst[1]);
+    chroma.src_x /= 2;
+    chroma.src_y /= 2;
+    chroma.src_w /= 2;
+    chroma.src_h /= 2;
+    chroma.dst_x /= 2;
+    chroma.dst_y /= 2;
+    chroma.dst_w /= 2;
+    chroma.dst_h /= 2;
+    chroma.step = 2;
+    chroma.nchan = 2;
+    chroma.chan[1] = 1;
+
+    ScalePlanes(planes, 2, m_nFilter == FILTER_BILINEAR, m_nWorkers, m_BandTimes);
+
+    return true;
+}
+
+void CScalerSW_NV12::ScaleLegacy() {
     unsigned int h_ratio = (m_nSrcWidth << 16) / m_nDstWidth;
     unsigned int v_ratio = (m_nSrcHeight << 16) / m_nDstHeight;
 
@@ -101,6 +901,218 @@ bool CScalerSW_NV12::Scale() {
 
         src_y = LibScaler::min(src_y + v_ratio, ((m_nSrcTop + m_nSrcHeight) / 2) << 16);
     }
+}
+
+CScalerSW_Generic::CScalerSW_Generic(unsigned int src_fmt, char *src[3], unsigned int src_frame_height,
+                                     unsigned int dst_fmt, char *dst[3], unsigned int dst_frame_height)
+    : m_nSrcFormat(src_fmt), m_nDstFormat(dst_fmt),
+      m_nSrcFrameHeight(src_frame_height), m_nDstFrameHeight(dst_frame_height),
+      m_nRotation(0), m_bHFlip(false), m_bVFlip(false),
+      m_nColorspace(V4L2_COLORSPACE_DEFAULT), m_bWide(false)
+{
+    for (int i = 0; i < 3; i++) {
+        m_pSrc[i] = src[i];
+        m_pDst[i] = dst[i];
+    }
+}
+
+bool CScalerSW_Generic::IsSupported(unsigned int v4l2_fmt)
+{
+    return FindFormat(v4l2_fmt) != NULL;
+}
+
+int CScalerSW_Generic::GetBufferLayout(unsigned int v4l2_fmt, unsigned int width, unsigned int height,
+                                       unsigned long sizes[3])
+{
+    const SWFormat *fmt = FindFormat(v4l2_fmt);
+    if (!fmt)
+        return 0;
+
+    char *addr[3] = {NULL, NULL, NULL};
+    SWImage img(fmt, addr, width, height);
+
+    for (unsigned int i = 0; i < fmt->buffers; i++)
+        sizes[i] = img.size(i, fmt, height);
+
+    // the remaining planes are in the last buffer
+    for (unsigned int i = fmt->buffers; i < img.nplanes; i++)
+        sizes[fmt->buffers - 1] += img.size(i, fmt, height);
+
+    return static_cast<int>(fmt->buffers);
+}
+
+bool CScalerSW_Generic::Scale() {
+    const SWFormat *sfmt = FindFormat(m_nSrcFormat);
+    const SWFormat *dfmt = FindFormat(m_nDstFormat);
+
+    if (!sfmt || !dfmt) {
+        SC_LOGE("Format %#x -> %#x is not supported", m_nSrcFormat, m_nDstFormat);
+        return false;
+    }
+
+    if ((m_nRotation % 90) != 0) {
+        SC_LOGE("Rotation of %u degree is not supported", m_nRotation);
+        return false;
+    }
+
+    if ((m_nSrcWidth == 0) || (m_nSrcHeight == 0) || (m_nDstWidth == 0) || (m_nDstHeight == 0)) {
+        SC_LOGE("Invalid size %ux%u -> %ux%u", m_nSrcWidth, m_nSrcHeight, m_nDstWidth, m_nDstHeight);
+        return false;
+    }
+
+    if (((m_nDstLeft | m_nDstWidth) % dfmt->hsub) || ((m_nDstTop | m_nDstHeight) % dfmt->vsub)) {
+        SC_LOGE("Target %ux%u@(%u, %u) is not aligned to the chroma subsampling of %#x",
+                m_nDstWidth, m_nDstHeight, m_nDstLeft, m_nDstTop, m_nDstFormat);
+        return false;
+    }
+
+    SWImage simg(sfmt, m_pSrc, m_nSrcStride, m_nSrcFrameHeight);
+    SWImage dimg(dfmt, m_pDst, m_nDstStride, m_nDstFrameHeight);
+    bool bilinear = m_nFilter == FILTER_BILINEAR;
+    bool rot90 = (m_nRotation == 90) || (m_nRotation == 270);
+    // size of the scaled image before rotation
+    unsigned int fw = rot90 ? m_nDstHeight : m_nDstWidth;
+    unsigned int fh = rot90 ? m_nDstWidth : m_nDstHeight;
+    unsigned int sw = m_nSrcWidth, sh = m_nSrcHeight;
+    std::vector<uint8_t> decoded(static_cast<size_t>(sw) * sh * 4);
+    std::vector<unsigned int> x0(fw), x1(fw), y0(fh), y1(fh);
+    std::vector<uint16_t> wx(fw), wy(fh);
+    SWColorMatrix csc;
+    bool convert = IsYUV(sfmt) != IsYUV(dfmt);
+
+    if (convert) {
+        double kr = 0.299, kb = 0.114;
+
+        if (m_nColorspace == V4L2_COLORSPACE_REC709) {
+            kr = 0.2126;
+            kb = 0.0722;
+        } else if (m_nColorspace == V4L2_COLORSPACE_BT2020) {
+            kr = 0.2627;
+            kb = 0.0593;
+        }
+
+        if (IsYUV(sfmt))
+            csc.setYUVtoRGB(kr, kb, m_bWide);
+        else
+            csc.setRGBtoYUV(kr, kb, m_bWide);
+    }
+
+    unsigned int ratio = (sw << 16) / fw;
+    for (unsigned int i = 0; i < fw; i++) {
+        unsigned int pos = Position(i, ratio, bilinear);
+        x0[i] = LibScaler::min(pos >> 16, sw - 1);
+        x1[i] = LibScaler::min(x0[i] + 1, sw - 1);
+        wx[i] = bilinear ? static_cast<uint16_t>((pos >> 8) & 0xFF) : 0;
+    }
+
+    ratio = (sh << 16) / fh;
+    for (unsigned int i = 0; i < fh; i++) {
+        unsigned int pos = Position(i, ratio, bilinear);
+        y0[i] = LibScaler::min(pos >> 16, sh - 1);
+        y1[i] = LibScaler::min(y0[i] + 1, sh - 1);
+        wy[i] = bilinear ? static_cast<uint16_t>((pos >> 8) & 0xFF) : 0;
+    }
+
+    std::vector<std::function<void()>> tasks;
+    unsigned int bands = (m_nWorkers > 1) ? m_nWorkers * 2 : 1;
+
+    // 1st pass: decode the source crop
+    unsigned int rows = LibScaler::min(sh, std::max((sh + bands - 1) / bands,
+                                                    static_cast<unsigned int>(SWSC_MIN_BAND_ROWS)));
+    for (unsigned int top = 0; top < sh; top += rows) {
+        unsigned int bottom = LibScaler::min(top + rows, sh);
+        tasks.push_back([&, top, bottom] {
+            for (unsigned int y = top; y < bottom; y++)
+                DecodeRow(sfmt, simg, m_nSrcLeft, sw, m_nSrcTop + y, &decoded[static_cast<size_t>(y) * sw * 4]);
+        });
+    }
+
+    if (m_nWorkers > 1) {
+        ExynosWorkerPool::getInstance().run(tasks, m_nWorkers);
+    } else {
+        for (auto &task : tasks)
+            task();
+    }
+
+    // 2nd pass: sample, convert and pack the target in bands aligned to the chroma subsampling
+    tasks.clear();
+    m_BandTimes.clear();
+    rows = (m_nDstHeight + bands - 1) / bands;
+    if (bands > 1)
+        rows = std::max(rows, static_cast<unsigned int>(SWSC_MIN_BAND_ROWS));
+    rows = (rows + dfmt->vsub - 1) / dfmt->vsub * dfmt->vsub;
+    for (unsigned int top = 0; top < m_nDstHeight; top += rows)
+        m_BandTimes.push_back({0, top, LibScaler::min(top + rows, m_nDstHeight), 0});
+
+    for (auto &b : m_BandTimes) {
+        BandTime *pband = &b;
+        tasks.push_back([&, pband] {
+            BandTime &band = *pband;
+            auto begin = std::chrono::steady_clock::now();
+            unsigned int dw = m_nDstWidth;
+            std::vector<uint8_t> out(static_cast<size_t>(band.bottom - band.top) * dw * 4);
+            uint8_t *px = out.data();
+
+            for (unsigned int y = band.top; y < band.bottom; y++) {
+                for (unsigned int x = 0; x < dw; x++, px += 4) {
+                    unsigned int u, v;
+
+                    // (u, v) in the scaled image before rotation
+                    switch (m_nRotation) {
+                    case 90:
+                        u = y;
+                        v = fh - 1 - x;
+                        break;
+                    case 180:
+                        u = fw - 1 - x;
+                        v = fh - 1 - y;
+                        break;
+                    case 270:
+                        u = fw - 1 - y;
+                        v = x;
+                        break;
+                    default:
+                        u = x;
+                        v = y;
+                        break;
+                    }
+
+                    if (m_bHFlip)
+                        u = fw - 1 - u;
+                    if (m_bVFlip)
+                        v = fh - 1 - v;
+
+                    const uint8_t *p00 = &decoded[(static_cast<size_t>(y0[v]) * sw + x0[u]) * 4];
+
+                    if (!bilinear) {
+                        memcpy(px, p00, 4);
+                    } else {
+                        const uint8_t *p01 = &decoded[(static_cast<size_t>(y0[v]) * sw + x1[u]) * 4];
+                        const uint8_t *p10 = &decoded[(static_cast<size_t>(y1[v]) * sw + x0[u]) * 4];
+                        const uint8_t *p11 = &decoded[(static_cast<size_t>(y1[v]) * sw + x1[u]) * 4];
+
+                        for (unsigned int c = 0; c < 4; c++)
+                            px[c] = Lerp(Lerp(p00[c], p01[c], wx[u]), Lerp(p10[c], p11[c], wx[u]), wy[v]);
+                    }
+
+                    if (convert)
+                        csc.apply(px);
+                }
+            }
+
+            EncodeRows(dfmt, dimg, m_nDstLeft, m_nDstTop + band.top, dw, band.bottom - band.top, out.data());
+
+            band.usec = static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - begin).count());
+        });
+    }
+
+    if (m_nWorkers > 1) {
+        ExynosWorkerPool::getInstance().run(tasks, m_nWorkers);
+    } else {
+        for (auto &task : tasks)
+            task();
+    }
 
     return true;
 }
@@ -1,9 +1,27 @@
 #ifndef __LIBSCALER_SWSCALER_H__
 #define __LIBSCALER_SWSCALER_H__
 
+#include <vector>
+
 #include "libscaler-common.h"
 
 class CScalerSW {
+    public:
+        // the values should be identical to enum SC_SW_FILTER in exynos_scaler.h
+        enum {
+            FILTER_NEAREST_LEGACY = 0,
+            FILTER_NEAREST,
+            FILTER_BILINEAR,
+        };
+        // the worker count when SetWorkers() is not called
+        enum { DEFAULT_WORKERS = 4 };
+        // elapsed time to scale the destination rows [top, bottom) of a plane
+        struct BandTime {
+            unsigned int plane;
+            unsigned int top;
+            unsigned int bottom;
+            unsigned int usec;
+        };
     protected:
         char *m_pSrc[3];
         char *m_pDst[3];
@@ -13,6 +31,9 @@ class CScalerSW {
         unsigned int m_nDstLeft, m_nDstTop;
         unsigned int m_nDstWidth, m_nDstHeight;
         unsigned int m_nDstStride;
+        unsigned int m_nFilter;
+        unsigned int m_nWorkers;
+        std::vector<BandTime> m_BandTimes;
     public:
         CScalerSW() { Clear(); }
         virtual ~CScalerSW() { };
@@ -34,6 +55,18 @@ class CScalerSW {
             m_nDstHeight = height;
             m_nDstStride = stride;
         }
+
+        void SetFilter(unsigned int filter) {
+            m_nFilter = (filter > FILTER_BILINEAR) ? static_cast<unsigned int>(FILTER_NEAREST) : filter;
+        }
+
+        // @workers includes the calling thread. 1 runs all on the calling thread.
+        void SetWorkers(unsigned int workers) {
+            m_nWorkers = (workers == 0) ? 1 : workers;
+        }
+
+        // per-band elapsed time of the last Scale()
+        const std::vector<BandTime> &GetBandTimes() const { return m_BandTimes; }
 };
 
 class CScalerSW_YUYV: public CScalerSW {
@@ -44,6 +77,8 @@ class CScalerSW_YUYV: public CScalerSW {
         }
 
         virtual bool Scale();
+    private:
+        void ScaleLegacy();
 };
 
 class CScalerSW_NV12: public CScalerSW {
@@ -56,6 +91,48 @@ class CScalerSW_NV12: public CScalerSW {
         }
 
         virtual bool Scale();
+    private:
+        void ScaleLegacy();
+};
+
+/*
+ * S/W scaler for any pair of the formats listed in CScalerSW_Generic::GetBufferLayout()
+ * with color space conversion, rotation and flip in a single pass.
+ * The source crop is decoded to 8-bit samples of 4 channels, either YUVA or RGBA,
+ * and each target pixel is sampled from the decoded image, converted to the
+ * color model of the target and packed to the target format.
+ * Samples with more than 8 bits like P010 are processed with 8-bit precision.
+ */
+class CScalerSW_Generic: public CScalerSW {
+        unsigned int m_nSrcFormat, m_nDstFormat;
+        unsigned int m_nSrcFrameHeight, m_nDstFrameHeight;
+        unsigned int m_nRotation;
+        bool m_bHFlip, m_bVFlip;
+        unsigned int m_nColorspace;
+        bool m_bWide;
+    public:
+        CScalerSW_Generic(unsigned int src_fmt, char *src[3], unsigned int src_frame_height,
+                          unsigned int dst_fmt, char *dst[3], unsigned int dst_frame_height);
+
+        // @rot is one of 0, 90, 180 and 270 in clockwise. flips are applied before rotation.
+        void SetRotation(unsigned int rot, bool hflip, bool vflip) {
+            m_nRotation = rot;
+            m_bHFlip = hflip;
+            m_bVFlip = vflip;
+        }
+
+        // @v4l2_colorspace selects BT.601, BT.709 or BT.2020. @wide is true for full range.
+        void SetCSC(unsigned int v4l2_colorspace, bool wide) {
+            m_nColorspace = v4l2_colorspace;
+            m_bWide = wide;
+        }
+
+        virtual bool Scale();
+
+        static bool IsSupported(unsigned int v4l2_fmt);
+        // returns the number of buffers of an image and their sizes in @sizes. 0 if not supported
+        static int GetBufferLayout(unsigned int v4l2_fmt, unsigned int width, unsigned int height,
+                                   unsigned long sizes[3]);
 };
 
 #endif //__LIBSCALER_SWSCALER_H__
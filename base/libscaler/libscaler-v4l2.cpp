@@ -26,6 +26,7 @@
  *   Create
  */
 
+#include <cerrno>
 #include <cstring>
 #include <cstdlib>
 #include <unistd.h>
@@ -63,6 +64,9 @@ CScalerV4L2::CScalerV4L2(int instance, int allow_drm)
     m_nRotDegree = 0;
     m_fStatus = 0;
     m_filter = 0;
+    m_swFilter = SC_SW_FILTER_NEAREST;
+    m_swWorkers = 0;
+    m_colorspace = V4L2_COLORSPACE_DEFAULT;
 
     memset(&m_frmSrc, 0, sizeof(m_frmSrc));
     memset(&m_frmDst, 0, sizeof(m_frmDst));
@@ -122,8 +126,18 @@ bool CScalerV4L2::Run()
     if (!DevSetCtrl())
         return false;
 
-    if (!DevSetFormat())
-        return false;
+    int error = 0;
+    if (!DevSetFormat(&error)) {
+        /*
+         * Only the configurations that the H/W does not support are done by
+         * the S/W Scaler. The CPU should never access the protected buffers.
+         */
+        if ((error != EINVAL) || TestFlag(m_fStatus, SCF_DRM))
+            return false;
+
+        SC_LOGI("H/W Scaler refused the job. Trying S/W Scaler instead");
+        return RunSWScaling();
+    }
 
     if (!ReqBufs())
         return false;
@@ -273,7 +287,7 @@ bool CScalerV4L2::ResetDevice(FrameInfo &frm)
     return true;
 }
 
-bool CScalerV4L2::DevSetFormat(FrameInfo &frm)
+bool CScalerV4L2::DevSetFormat(FrameInfo &frm, int *perror)
 {
 
     if (!TestFlag(frm.flags, SCFF_BUF_FRESH)) {
@@ -302,6 +316,8 @@ bool CScalerV4L2::DevSetFormat(FrameInfo &frm)
     }
 
     if (ioctl(m_fdScaler, VIDIOC_S_FMT, &fmt) < 0) {
+        if (perror)
+            *perror = errno;
         SC_LOGERR("Failed S_FMT(fmt: %d, w:%d, h:%d) for the %s",
                 fmt.fmt.pix_mp.pixelformat, fmt.fmt.pix_mp.width, fmt.fmt.pix_mp.height,
                 frm.name);
@@ -319,6 +335,8 @@ bool CScalerV4L2::DevSetFormat(FrameInfo &frm)
     crop.c = frm.crop;
 
     if (ioctl(m_fdScaler, VIDIOC_S_CROP, &crop) < 0) {
+        if (perror)
+            *perror = errno;
         SC_LOGERR("Failed S_CROP(fmt: %d, l:%d, t:%d, w:%d, h:%d) for the %s",
                 crop.type, crop.c.left, crop.c.top, crop.c.width, crop.c.height,
                 frm.name);
@@ -337,12 +355,15 @@ bool CScalerV4L2::DevSetFormat(FrameInfo &frm)
     return true;
 }
 
-bool CScalerV4L2::DevSetFormat()
+bool CScalerV4L2::DevSetFormat(int *perror)
 {
-    if (!DevSetFormat(m_frmSrc))
+    if (perror)
+        *perror = 0;
+
+    if (!DevSetFormat(m_frmSrc, perror))
         return false;
 
-    return DevSetFormat(m_frmDst);
+    return DevSetFormat(m_frmDst, perror);
 }
 
 bool CScalerV4L2::QBuf(FrameInfo &frm, int *pfdReleaseFence)
@@ -544,18 +565,49 @@ static void PutBuffer(CScalerV4L2::FrameInfo &frm, char *addr[])
     }
 }
 
-bool CScalerV4L2::RunSWScaling()
+CScalerSW *CScalerV4L2::CreateSWConverter(char *src[], char *dst[])
 {
-    if (m_frmSrc.color_format != m_frmDst.color_format) {
-        SC_LOGE("Source and target image format must be the same");
-        return false;
+    if (!CScalerSW_Generic::IsSupported(m_frmSrc.color_format) ||
+            !CScalerSW_Generic::IsSupported(m_frmDst.color_format)) {
+        SC_LOGE("Format %#x -> %#x is not supported", m_frmSrc.color_format, m_frmDst.color_format);
+        return NULL;
     }
 
-    if (m_nRotDegree != 0) {
-        SC_LOGE("Rotation is not allowed for S/W Scaling");
-        return false;
+    m_frmSrc.out_num_planes = CScalerSW_Generic::GetBufferLayout(m_frmSrc.color_format,
+                                    m_frmSrc.width, m_frmSrc.height, m_frmSrc.out_plane_size);
+    m_frmDst.out_num_planes = CScalerSW_Generic::GetBufferLayout(m_frmDst.color_format,
+                                    m_frmDst.width, m_frmDst.height, m_frmDst.out_plane_size);
+
+    if (!GetBuffer(m_frmSrc, src))
+        return NULL;
+
+    if (!GetBuffer(m_frmDst, dst)) {
+        PutBuffer(m_frmSrc, src);
+        return NULL;
+    }
+
+    CScalerSW_Generic *swsc = new CScalerSW_Generic(m_frmSrc.color_format, src, m_frmSrc.height,
+                                                    m_frmDst.color_format, dst, m_frmDst.height);
+    if (swsc == NULL) {
+        SC_LOGE("Failed to allocate SW Scaler");
+        PutBuffer(m_frmSrc, src);
+        PutBuffer(m_frmDst, dst);
+        return NULL;
     }
 
+    // SCF_VFLIP keeps the horizontal flip. See SetRotate().
+    swsc->SetRotation(m_nRotDegree, TestFlag(m_fStatus, SCF_VFLIP), TestFlag(m_fStatus, SCF_HFLIP));
+    swsc->SetCSC(m_colorspace, TestFlag(m_fStatus, SCF_CSC_WIDE));
+
+    return swsc;
+}
+
+bool CScalerV4L2::RunSWScaling()
+{
+    // format conversion, rotation and flip are only supported by the generic S/W scaler
+    bool convert = (m_frmSrc.color_format != m_frmDst.color_format) || (m_nRotDegree != 0) ||
+                   TestFlag(m_fStatus, SCF_HFLIP) || TestFlag(m_fStatus, SCF_VFLIP);
+
     SC_LOGI("Running S/W Scaler: %dx%d -> %dx%d",
             m_frmSrc.crop.width, m_frmSrc.crop.height,
             m_frmDst.crop.width, m_frmDst.crop.height);
@@ -563,7 +615,7 @@ bool CScalerV4L2::RunSWScaling()
     CScalerSW *swsc;
     char *src[3], *dst[3];
 
-    switch (m_frmSrc.color_format) {
+    switch (convert ? 0 : m_frmSrc.color_format) {
         case V4L2_PIX_FMT_YUYV:
         case V4L2_PIX_FMT_YVYU:
             m_frmSrc.out_num_planes = 1;
@@ -622,10 +674,11 @@ bool CScalerV4L2::RunSWScaling()
 
             swsc = new CScalerSW_NV12(src[0], src[1], dst[0], dst[1]);
             break;
-        case V4L2_PIX_FMT_UYVY: // TODO: UYVY is not implemented yet.
         default:
-            SC_LOGE("Format %x is not supported", m_frmSrc.color_format);
-            return false;
+            swsc = CreateSWConverter(src, dst);
+            if (swsc == NULL)
+                return false;
+            break;
     }
 
     if (swsc == NULL) {
@@ -641,8 +694,18 @@ bool CScalerV4L2::RunSWScaling()
     swsc->SetDstRect(m_frmDst.crop.left, m_frmDst.crop.top,
             m_frmDst.crop.width, m_frmDst.crop.height, m_frmDst.width);
 
+    swsc->SetFilter(m_swFilter);
+    if (m_swWorkers > 0)
+        swsc->SetWorkers(m_swWorkers);
+
     bool ret = swsc->Scale();
 
+#ifdef SC_DEBUG
+    for (auto &band : swsc->GetBandTimes())
+        SC_LOGD("S/W Scaler: plane %u rows [%u, %u) took %u usec",
+                band.plane, band.top, band.bottom, band.usec);
+#endif
+
     delete swsc;
 
     PutBuffer(m_frmSrc, src);
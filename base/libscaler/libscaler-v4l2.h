@@ -47,6 +47,8 @@
 
 #define V4L2_BUF_FLAG_USE_SYNC          0x00008000
 
+class CScalerSW;
+
 class CScalerV4L2 {
 public:
     enum { SC_MAX_PLANES = SC_NUM_OF_PLANES };
@@ -107,6 +109,8 @@ private:
     int m_fdValidate;
 
     unsigned int m_filter;
+    unsigned int m_swFilter;
+    unsigned int m_swWorkers;
     unsigned int m_colorspace;
 
     void Initialize(int instance);
@@ -121,7 +125,7 @@ private:
         SetFlag(m_fStatus, SCF_ROTATION_FRESH);
     }
 
-    bool DevSetFormat(FrameInfo &frm);
+    bool DevSetFormat(FrameInfo &frm, int *perror = NULL);
     bool ReqBufs(FrameInfo &frm);
     bool QBuf(FrameInfo &frm, int *pfdReleaseFence);
     bool StreamOn(FrameInfo &frm);
@@ -166,6 +170,7 @@ private:
         frm.fdAcquireFence = fence;
     }
 
+    CScalerSW *CreateSWConverter(char *src[], char *dst[]);
     bool RunSWScaling();
 
 protected:
@@ -202,7 +207,8 @@ public:
 
     // H/W Control
     virtual bool DevSetCtrl();
-    bool DevSetFormat();
+    // *perror is the errno of S_FMT or S_CROP if it is refused by the driver
+    bool DevSetFormat(int *perror = NULL);
 
     inline bool ReqBufs() {
         if (!ReqBufs(m_frmSrc))
@@ -287,6 +293,14 @@ public:
         m_filter = filter;
     }
 
+    inline void SetSWFilter(unsigned int sw_filter) {
+        m_swFilter = sw_filter;
+    }
+
+    inline void SetSWWorkers(unsigned int sw_workers) {
+        m_swWorkers = sw_workers;
+    }
+
     inline void SetSrcCacheable(bool cacheable) {
         return SetCacheable(m_frmSrc, cacheable);
     }
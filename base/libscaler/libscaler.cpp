@@ -393,6 +393,37 @@ void exynos_sc_set_framerate(
     sc->SetFrameRate(framerate);
 }
 
+int exynos_sc_set_sw_filter(
+        void *handle,
+        unsigned int sw_filter)
+{
+    CScalerNonStream *sc = GetNonStreamScaler(handle);
+    if (!sc)
+        return -1;
+
+    if (sw_filter > SC_SW_FILTER_BILINEAR) {
+        SC_LOGE("Unknown S/W scaler filter %u", sw_filter);
+        return -1;
+    }
+
+    sc->SetSWFilter(sw_filter);
+
+    return 0;
+}
+
+int exynos_sc_set_sw_workers(
+        void *handle,
+        unsigned int sw_workers)
+{
+    CScalerNonStream *sc = GetNonStreamScaler(handle);
+    if (!sc)
+        return -1;
+
+    sc->SetSWWorkers(sw_workers);
+
+    return 0;
+}
+
 int exynos_sc_set_src_addr(
         void *handle,
         void *addr[SC_NUM_OF_PLANES],
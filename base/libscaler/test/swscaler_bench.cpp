@@ -0,0 +1,149 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "libscaler-swscaler.h"
+
+/*
+ * Host benchmark of CScalerSW_NV12 and CScalerSW_YUYV.
+ * It compares the legacy per-pixel loop with the block kernels for the
+ * resolutions that fall into the S/W scaler frequently. The block kernels
+ * run on a single thread and then on [workers] threads.
+ *
+ * usage: libscaler_swscaler_bench [iterations] [workers]
+ */
+
+struct Resolution {
+    unsigned int width;
+    unsigned int height;
+    const char *name;
+};
+
+static const Resolution resolutions[] = {
+    {3840, 2160, "2160p"},
+    {1920, 1080, "1080p"},
+    {1280,  720, "720p"},
+    { 640,  480, "VGA"},
+    { 176,  144, "QCIF"},
+};
+
+static const struct {
+    unsigned int filter;
+    const char *name;
+} filters[] = {
+    {CScalerSW::FILTER_NEAREST_LEGACY, "legacy"},
+    {CScalerSW::FILTER_NEAREST, "nearest"},
+    {CScalerSW::FILTER_BILINEAR, "bilinear"},
+};
+
+enum { FMT_NV12, FMT_YUYV };
+
+struct Image {
+    Image(unsigned int w, unsigned int h, int fmt) : width(w), height(h) {
+        size_t len = (fmt == FMT_NV12) ? (w * h * 3 / 2) : (w * h * 2);
+        data.resize(len);
+        for (size_t i = 0; i < len; i++)
+            data[i] = static_cast<char>(rand());
+    }
+    char *plane0() { return data.data(); }
+    char *plane1() { return data.data() + width * height; }
+
+    unsigned int width, height;
+    std::vector<char> data;
+};
+
+static CScalerSW *createScaler(int fmt, Image &src, Image &dst)
+{
+    CScalerSW *sc;
+
+    if (fmt == FMT_NV12)
+        sc = new CScalerSW_NV12(src.plane0(), src.plane1(), dst.plane0(), dst.plane1());
+    else
+        sc = new CScalerSW_YUYV(src.plane0(), dst.plane0());
+
+    sc->SetSrcRect(0, 0, src.width, src.height, src.width);
+    sc->SetDstRect(0, 0, dst.width, dst.height, dst.width);
+
+    return sc;
+}
+
+static double runScaler(int fmt, Image &src, Image &dst, unsigned int filter,
+                        unsigned int workers, int iterations, unsigned int *slowest_band = NULL)
+{
+    CScalerSW *sc = createScaler(fmt, src, dst);
+
+    sc->SetFilter(filter);
+    sc->SetWorkers(workers);
+    sc->Scale(); // warming up
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        sc->Scale();
+    auto end = std::chrono::steady_clock::now();
+
+    if (slowest_band) {
+        *slowest_band = 0;
+        for (auto &band : sc->GetBandTimes())
+            *slowest_band = std::max(*slowest_band, band.usec);
+    }
+
+    delete sc;
+
+    return std::chrono::duration<double, std::milli>(end - begin).count() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = (argc > 1) ? atoi(argv[1]) : 10;
+    unsigned int workers = (argc > 2) ? atoi(argv[2]) : CScalerSW::DEFAULT_WORKERS;
+    if (iterations <= 0)
+        iterations = 10;
+    if (workers == 0)
+        workers = 1;
+
+    std::cout << std::setw(6) << "format" << std::setw(8) << "source" << std::setw(8) << "target";
+    for (auto &f : filters)
+        std::cout << std::setw(12) << f.name;
+    for (size_t i = 1; i < sizeof(filters) / sizeof(filters[0]); i++)
+        std::cout << std::setw(10) << filters[i].name << "-mt";
+    std::cout << std::setw(10) << "speedup" << std::setw(10) << "mt-gain" << std::setw(12) << "max-band" << std::endl;
+
+    for (int fmt : {FMT_NV12, FMT_YUYV}) {
+        for (auto &s : resolutions) {
+            for (auto &d : resolutions) {
+                if (&s == &d)
+                    continue;
+
+                Image src(s.width, s.height, fmt);
+                Image dst(d.width, d.height, fmt);
+                double msec[sizeof(filters) / sizeof(filters[0])];
+                double msec_mt[sizeof(filters) / sizeof(filters[0])];
+                unsigned int slowest_band = 0;
+
+                std::cout << std::setw(6) << ((fmt == FMT_NV12) ? "NV12" : "YUYV")
+                          << std::setw(8) << s.name << std::setw(8) << d.name;
+
+                for (size_t i = 0; i < sizeof(filters) / sizeof(filters[0]); i++) {
+                    msec[i] = runScaler(fmt, src, dst, filters[i].filter, 1, iterations);
+                    std::cout << std::setw(10) << std::fixed << std::setprecision(3) << msec[i] << "ms";
+                }
+
+                for (size_t i = 1; i < sizeof(filters) / sizeof(filters[0]); i++) {
+                    msec_mt[i] = runScaler(fmt, src, dst, filters[i].filter, workers, iterations,
+                                           (i == 1) ? &slowest_band : NULL);
+                    std::cout << std::setw(11) << std::fixed << std::setprecision(3) << msec_mt[i] << "ms";
+                }
+
+                std::cout << std::setw(9) << std::setprecision(2) << msec[0] / msec[1] << "x";
+                std::cout << std::setw(9) << std::setprecision(2) << msec[1] / msec_mt[1] << "x";
+                std::cout << std::setw(8) << slowest_band << "usec" << std::endl;
+            }
+        }
+    }
+
+    return 0;
+}